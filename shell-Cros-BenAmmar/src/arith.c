@@ -0,0 +1,514 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : parser.h func.h cmd.h ringbuf.h
+ *
+ *  Expressions arithmetiques entieres (implementation)
+ */
+
+#include "arith.h"
+#include "parser.h"
+#include "func.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Operateurs binaires
+enum ArithOpType
+{
+    OP_POW = 0, OP_MUL, OP_DIV, OP_MOD, OP_ADD, OP_SUB, OP_SHL, OP_SHR, OP_LE, OP_GE, OP_LT, OP_GT, OP_EQ, OP_NE,
+    OP_AND, OP_OR, OP_BIT_AND, OP_BIT_XOR, OP_BIT_OR
+};
+
+// Operateur binaire :
+// - token : l'operateur dans l'expression
+// - type : type de l'operateur
+// - priority : priorite de l'operateur (les plus prioritaires ont la valeur la plus grande)
+// - rightAssoc : vrai si l'operateur est associatif a droite
+typedef struct
+{
+    const char* token;
+    int type;
+    int priority;
+    int rightAssoc;
+} ArithOp;
+
+// Operateurs binaires, les plus longs en premier (pour ne pas reconnaitre "<" dans "<=", par exemple)
+static const ArithOp ALL_OPERATORS[] =
+{
+    { "**", OP_POW, 11, 1 },
+    { "<<", OP_SHL, 8, 0 },
+    { ">>", OP_SHR, 8, 0 },
+    { "<=", OP_LE, 7, 0 },
+    { ">=", OP_GE, 7, 0 },
+    { "==", OP_EQ, 6, 0 },
+    { "!=", OP_NE, 6, 0 },
+    { "&&", OP_AND, 2, 0 },
+    { "||", OP_OR, 1, 0 },
+    { "*", OP_MUL, 10, 0 },
+    { "/", OP_DIV, 10, 0 },
+    { "%", OP_MOD, 10, 0 },
+    { "+", OP_ADD, 9, 0 },
+    { "-", OP_SUB, 9, 0 },
+    { "<", OP_LT, 7, 0 },
+    { ">", OP_GT, 7, 0 },
+    { "&", OP_BIT_AND, 5, 0 },
+    { "^", OP_BIT_XOR, 4, 0 },
+    { "|", OP_BIT_OR, 3, 0 }
+};
+static const int OPERATOR_COUNT = sizeof( ALL_OPERATORS ) / sizeof( ArithOp );
+
+// Operateurs d'affectation, les plus longs en premier (le type est celui de l'operation effectuee avant
+// l'affectation, -1 pour une affectation simple)
+static const ArithOp ALL_ASSIGNMENTS[] =
+{
+    { "+=", OP_ADD, 0, 1 },
+    { "-=", OP_SUB, 0, 1 },
+    { "*=", OP_MUL, 0, 1 },
+    { "/=", OP_DIV, 0, 1 },
+    { "%=", OP_MOD, 0, 1 },
+    { "=", -1, 0, 1 }
+};
+static const int ASSIGNMENT_COUNT = sizeof( ALL_ASSIGNMENTS ) / sizeof( ArithOp );
+
+// Etat de l'analyse d'une expression :
+// - pos : position courante dans l'expression
+// - skip : si non nul, l'expression est analysee sans etre evaluee (branche non retenue d'un court-circuit ou
+//          d'une condition) : pas d'affectation, et pas d'erreur de division par zero
+typedef struct
+{
+    const char* pos;
+    int skip;
+} ArithParser;
+
+/*
+ * Analyse et evalue une expression complete (condition, ou expression binaire)
+ *
+ * parser : etat de l'analyse
+ * value : en sortie, la valeur de l'expression
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseExpr( ArithParser* parser, int64_t* value );
+
+/*
+ * Analyse et evalue une suite d'operations binaires dont les operateurs ont une priorite au moins egale a
+ * 'minPriority' (precedence climbing)
+ *
+ * parser : etat de l'analyse
+ * minPriority : priorite minimale des operateurs acceptes
+ * value : en sortie, la valeur de l'expression
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseBinary( ArithParser* parser, int minPriority, int64_t* value );
+
+/*
+ * Analyse et evalue une operation unaire, ou un operande
+ *
+ * parser : etat de l'analyse
+ * value : en sortie, la valeur de l'expression
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseUnary( ArithParser* parser, int64_t* value );
+
+/*
+ * Analyse et evalue un operande : nombre, variable (eventuellement affectee), ou expression entre parentheses
+ *
+ * parser : etat de l'analyse
+ * value : en sortie, la valeur de l'operande
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseOperand( ArithParser* parser, int64_t* value );
+
+/*
+ * Analyse et evalue une variable, et son eventuelle affectation
+ *
+ * parser : etat de l'analyse (positionne sur le nom de la variable)
+ * value : en sortie, la valeur de la variable (apres affectation)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseVariable( ArithParser* parser, int64_t* value );
+
+/*
+ * Recherche un operateur au debut d'une chaine
+ *
+ * str : la chaine
+ * operators : operateurs recherches
+ * count : nombre d'operateurs
+ * retourne l'operateur trouve, ou NULL
+ */
+static const ArithOp* findOperator( const char* str, const ArithOp* operators, int count );
+
+/*
+ * Applique un operateur binaire (hors operateurs logiques, evalues en court-circuit par parseBinary())
+ *
+ * parser : etat de l'analyse
+ * type : type de l'operateur
+ * left, right : operandes
+ * value : en sortie, le resultat
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int applyOperator( const ArithParser* parser, int type, int64_t left, int64_t right, int64_t* value );
+
+/*
+ * Lit un nombre entier (decimal, octal avec un zero en tete, ou hexadecimal avec le prefixe "0x")
+ *
+ * str : position du nombre
+ * value : en sortie, la valeur du nombre
+ * retourne la position qui suit le nombre, ou NULL si la chaine ne commence pas par un nombre
+ */
+static const char* readNumber( const char* str, int64_t* value );
+
+/*
+ * Convertit la valeur d'une variable en nombre entier (une variable inexistante ou vide vaut 0)
+ *
+ * str : valeur de la variable (peut etre NULL)
+ * value : en sortie, le nombre
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int convertValue( const char* str, int64_t* value );
+
+/*
+ * Saute les espaces et tabulations
+ *
+ * parser : etat de l'analyse
+ */
+static void skipBlanks( ArithParser* parser );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int evalArith( const char* expr, int64_t* value )
+{
+    // Une expression vide vaut 0
+    ArithParser parser = { expr, 0 };
+    *value = 0;
+    skipBlanks( &parser );
+    if( *parser.pos == '\0' ) return( ARITH_OK );
+
+    // L'expression doit etre analysee en entier
+    const int status = parseExpr( &parser, value );
+    if( status != ARITH_OK ) return( status );
+    skipBlanks( &parser );
+
+    return( *parser.pos == '\0' ? ARITH_OK : ARITH_SYNTAX );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int parseExpr( ArithParser* parser, int64_t* value )
+{
+    // Condition, ou expression binaire
+    int64_t condition = 0;
+    int status = parseBinary( parser, 1, &condition );
+    if( status != ARITH_OK ) return( status );
+    skipBlanks( parser );
+    if( *parser->pos != '?' )
+    {
+        *value = condition;
+        return( ARITH_OK );
+    }
+    ++parser->pos;
+
+    // Seule la branche retenue est evaluee
+    int64_t ifTrue = 0;
+    parser->skip += ( condition == 0 );
+    status = parseExpr( parser, &ifTrue );
+    parser->skip -= ( condition == 0 );
+    if( status != ARITH_OK ) return( status );
+
+    // Separateur des deux branches
+    skipBlanks( parser );
+    if( *parser->pos != ':' ) return( ARITH_SYNTAX );
+    ++parser->pos;
+
+    // La seconde branche est associative a droite ("a ? b : c ? d : e")
+    int64_t ifFalse = 0;
+    parser->skip += ( condition != 0 );
+    status = parseExpr( parser, &ifFalse );
+    parser->skip -= ( condition != 0 );
+    if( status != ARITH_OK ) return( status );
+
+    *value = ( condition != 0 ? ifTrue : ifFalse );
+    return( ARITH_OK );
+}
+
+
+static int parseBinary( ArithParser* parser, int minPriority, int64_t* value )
+{
+    // Operande de gauche
+    int status = parseUnary( parser, value );
+    if( status != ARITH_OK ) return( status );
+
+    // Tant que l'operateur suivant est assez prioritaire
+    for( ;; )
+    {
+        skipBlanks( parser );
+        const ArithOp* op = findOperator( parser->pos, ALL_OPERATORS, OPERATOR_COUNT );
+        if( op == NULL || op->priority < minPriority ) break;
+        parser->pos += strlen( op->token );
+
+        // Un operateur logique dont le resultat est deja connu n'evalue pas son operande de droite
+        const int shortCircuit = ( ( op->type == OP_AND && *value == 0 ) || ( op->type == OP_OR && *value != 0 ) );
+
+        // Operande de droite : operations plus prioritaires (ou de meme priorite si l'operateur est associatif a
+        // droite)
+        int64_t right = 0;
+        parser->skip += shortCircuit;
+        status = parseBinary( parser, op->rightAssoc ? op->priority : op->priority + 1, &right );
+        parser->skip -= shortCircuit;
+        if( status != ARITH_OK ) return( status );
+
+        // Calcul de l'operation
+        if( op->type == OP_AND ) *value = ( *value != 0 && right != 0 );
+        else if( op->type == OP_OR ) *value = ( *value != 0 || right != 0 );
+        else status = applyOperator( parser, op->type, *value, right, value );
+        if( status != ARITH_OK ) return( status );
+    }
+
+    return( ARITH_OK );
+}
+
+
+static int parseUnary( ArithParser* parser, int64_t* value )
+{
+    // Operateur unaire eventuel
+    skipBlanks( parser );
+    const char op = *parser->pos;
+    if( op != '-' && op != '+' && op != '!' && op != '~' ) return( parseOperand( parser, value ) );
+    ++parser->pos;
+
+    // L'operateur s'applique a l'operation unaire qui suit
+    const int status = parseUnary( parser, value );
+    if( status != ARITH_OK ) return( status );
+    if( op == '-' ) *value = (int64_t)( 0 - (uint64_t)*value );
+    else if( op == '!' ) *value = ( *value == 0 );
+    else if( op == '~' ) *value = ~*value;
+
+    return( ARITH_OK );
+}
+
+
+static int parseOperand( ArithParser* parser, int64_t* value )
+{
+    // Expression entre parentheses (une expansion "$((...))" imbriquee se comporte de la meme facon)
+    if( parser->pos[0] == '$' && parser->pos[1] == '(' ) ++parser->pos;
+    if( *parser->pos == '(' )
+    {
+        ++parser->pos;
+        const int status = parseExpr( parser, value );
+        if( status != ARITH_OK ) return( status );
+        skipBlanks( parser );
+        if( *parser->pos != ')' ) return( ARITH_SYNTAX );
+        ++parser->pos;
+        return( ARITH_OK );
+    }
+
+    // Nombre
+    const char* end = readNumber( parser->pos, value );
+    if( end != NULL )
+    {
+        // Un nombre ne peut pas etre suivi d'une lettre ("12ab")
+        if( isalnum( (unsigned char)*end ) || *end == '_' ) return( ARITH_SYNTAX );
+        parser->pos = end;
+        return( ARITH_OK );
+    }
+
+    // Variable
+    return( parseVariable( parser, value ) );
+}
+
+
+static int parseVariable( ArithParser* parser, int64_t* value )
+{
+    // Parametre d'une fonction ou variable precedee de "$" ("$1", "$#", "$NOM"), qui ne peut pas etre affecte
+    const int dollar = ( *parser->pos == '$' );
+    if( dollar ) ++parser->pos;
+    const char* name = parser->pos;
+    if( dollar && ( isdigit( (unsigned char)*name ) || *name == '#' ) )
+    {
+        char param[MAX_LINE_SIZE];
+        size_t length = 1;
+        while( *name != '#' && isdigit( (unsigned char)name[length] ) ) ++length;
+        snprintf( param, MAX_LINE_SIZE, "%.*s", (int)length, name );
+        parser->pos += length;
+        return( convertValue( getVar( param ), value ) );
+    }
+
+    // Nom de la variable : lettres, chiffres et '_', sans commencer par un chiffre
+    if( ! isalpha( (unsigned char)*name ) && *name != '_' ) return( ARITH_SYNTAX );
+    size_t length = 1;
+    while( isalnum( (unsigned char)name[length] ) || name[length] == '_' ) ++length;
+    if( length >= MAX_LINE_SIZE ) return( ARITH_SYNTAX );
+    char varName[MAX_LINE_SIZE];
+    memcpy( varName, name, length );
+    varName[length] = '\0';
+    parser->pos += length;
+
+    // Valeur courante de la variable
+    int status = convertValue( getVar( varName ), value );
+
+    // Affectation eventuelle ("==" est une comparaison)
+    skipBlanks( parser );
+    const ArithOp* op = findOperator( parser->pos, ALL_ASSIGNMENTS, ASSIGNMENT_COUNT );
+    if( op == NULL || ( op->type == -1 && parser->pos[1] == '=' ) ) return( status );
+    parser->pos += strlen( op->token );
+
+    // Valeur affectee (l'affectation est associative a droite : "a = b = 1")
+    int64_t right = 0;
+    if( status == ARITH_OK ) status = parseExpr( parser, &right );
+    if( status == ARITH_OK && op->type != -1 ) status = applyOperator( parser, op->type, *value, right, &right );
+    if( status != ARITH_OK ) return( status );
+    *value = right;
+
+    // Modification de la variable (sauf dans une branche non evaluee)
+    if( parser->skip ) return( ARITH_OK );
+    char varValue[32];
+    snprintf( varValue, sizeof( varValue ), "%" PRId64, *value );
+    return( setVar( varName, varValue ) == FUNC_OK ? ARITH_OK : ARITH_BAD_ASSIGN );
+}
+
+
+static const ArithOp* findOperator( const char* str, const ArithOp* operators, int count )
+{
+    // Le premier operateur qui correspond est le plus long
+    for( int i = 0; i < count; ++i )
+    {
+        if( strncmp( str, operators[i].token, strlen( operators[i].token ) ) == 0 ) return( operators + i );
+    }
+
+    return( NULL );
+}
+
+
+static int applyOperator( const ArithParser* parser, int type, int64_t left, int64_t right, int64_t* value )
+{
+    // Les calculs sont faits sur des entiers non signes, pour que le depassement de capacite boucle
+    const uint64_t uLeft = (uint64_t)left;
+    const uint64_t uRight = (uint64_t)right;
+
+    switch( type )
+    {
+        case OP_POW:
+        {
+            // Puissance par carres successifs (l'exposant ne peut pas etre negatif)
+            if( right < 0 ) return( ARITH_SYNTAX );
+            uint64_t result = 1;
+            for( uint64_t base = uLeft, exponent = uRight; exponent != 0; exponent >>= 1, base *= base )
+            {
+                if( exponent & 1 ) result *= base;
+            }
+            *value = (int64_t)result;
+            break;
+        }
+
+        case OP_MUL: *value = (int64_t)( uLeft * uRight ); break;
+        case OP_ADD: *value = (int64_t)( uLeft + uRight ); break;
+        case OP_SUB: *value = (int64_t)( uLeft - uRight ); break;
+
+        case OP_DIV:
+        case OP_MOD:
+            // Division par zero (ignoree dans une branche non evaluee)
+            if( right == 0 )
+            {
+                *value = 0;
+                return( parser->skip ? ARITH_OK : ARITH_DIV_ZERO );
+            }
+
+            // INT64_MIN / -1 depasse la capacite : le resultat boucle
+            if( right == -1 ) *value = ( type == OP_DIV ? (int64_t)( 0 - uLeft ) : 0 );
+            else *value = ( type == OP_DIV ? left / right : left % right );
+            break;
+
+        // Decalages (le nombre de bits est pris modulo 64)
+        case OP_SHL: *value = (int64_t)( uLeft << ( uRight & 63 ) ); break;
+        case OP_SHR: *value = left >> ( uRight & 63 ); break;
+
+        // Comparaisons
+        case OP_LE: *value = ( left <= right ); break;
+        case OP_GE: *value = ( left >= right ); break;
+        case OP_LT: *value = ( left < right ); break;
+        case OP_GT: *value = ( left > right ); break;
+        case OP_EQ: *value = ( left == right ); break;
+        case OP_NE: *value = ( left != right ); break;
+
+        // Operations bit a bit
+        case OP_BIT_AND: *value = left & right; break;
+        case OP_BIT_XOR: *value = left ^ right; break;
+        case OP_BIT_OR: *value = left | right; break;
+
+        default:
+            return( ARITH_SYNTAX );
+    }
+
+    return( ARITH_OK );
+}
+
+
+static const char* readNumber( const char* str, int64_t* value )
+{
+    // Hexadecimal
+    uint64_t number = 0;
+    if( str[0] == '0' && ( str[1] == 'x' || str[1] == 'X' ) && isxdigit( (unsigned char)str[2] ) )
+    {
+        for( str += 2; isxdigit( (unsigned char)*str ); ++str )
+        {
+            number = number * 16 + ( isdigit( (unsigned char)*str ) ? *str - '0' : tolower( *str ) - 'a' + 10 );
+        }
+        *value = (int64_t)number;
+        return( str );
+    }
+
+    // Octal, avec un zero en tete (comme dans bash, un chiffre 8 ou 9 rend le nombre invalide)
+    if( str[0] == '0' && isdigit( (unsigned char)str[1] ) )
+    {
+        for( ++str; *str >= '0' && *str <= '7'; ++str ) number = number * 8 + ( *str - '0' );
+        *value = (int64_t)number;
+        return( str );
+    }
+
+    // Decimal
+    if( ! isdigit( (unsigned char)*str ) ) return( NULL );
+    for( ; isdigit( (unsigned char)*str ); ++str ) number = number * 10 + ( *str - '0' );
+    *value = (int64_t)number;
+
+    return( str );
+}
+
+
+static int convertValue( const char* str, int64_t* value )
+{
+    // Variable inexistante ou vide
+    *value = 0;
+    if( str == NULL ) return( ARITH_OK );
+    while( *str == ' ' || *str == '\t' ) ++str;
+    if( *str == '\0' ) return( ARITH_OK );
+
+    // Signe eventuel, puis nombre (eventuellement suivi d'espaces)
+    const int negative = ( *str == '-' );
+    if( *str == '-' || *str == '+' ) ++str;
+    const char* end = readNumber( str, value );
+    if( end == NULL ) return( ARITH_BAD_VALUE );
+    while( *end == ' ' || *end == '\t' ) ++end;
+    if( *end != '\0' ) return( ARITH_BAD_VALUE );
+    if( negative ) *value = (int64_t)( 0 - (uint64_t)*value );
+
+    return( ARITH_OK );
+}
+
+
+static void skipBlanks( ArithParser* parser )
+{
+    while( *parser->pos == ' ' || *parser->pos == '\t' ) ++parser->pos;
+}
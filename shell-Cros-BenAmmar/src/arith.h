@@ -0,0 +1,61 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Expressions arithmetiques entieres, evaluees dans le minishell (sans lancer de processus comme 'expr') :
+ *  - Expansion "$(( EXPR ))" dans les mots de la ligne de commande, remplacee par la valeur de l'expression (voir
+ *    param.h)
+ *  - Commande "(( EXPR ))", qui reussit si la valeur de l'expression est non nulle
+ *
+ *  Les calculs se font sur des entiers signes de 64 bits (le depassement de capacite boucle, comme en C sur des
+ *  entiers non signes). L'expression est analysee par "precedence climbing" : chaque operateur binaire a une
+ *  priorite, et une seule fonction recursive analyse tous les niveaux de priorite. Operateurs supportes, du
+ *  moins prioritaire au plus prioritaire :
+ *  - "=", "+=", "-=", "*=", "/=", "%=" : affectation d'une variable (associatifs a droite)
+ *  - "? :" : condition
+ *  - "||", "&&" : OU et ET logiques (evalues en court-circuit)
+ *  - "|", "^", "&" : operations bit a bit
+ *  - "==", "!=", "<", "<=", ">", ">=" : comparaisons (valent 1 ou 0)
+ *  - "<<", ">>" : decalages
+ *  - "+", "-", "*", "/", "%" : operations arithmetiques
+ *  - "**" : puissance (associatif a droite)
+ *  - "-", "+", "!", "~" : operateurs unaires
+ *  Les operandes sont des nombres (decimaux, octaux avec un zero en tete comme "010", ou hexadecimaux avec le
+ *  prefixe "0x"), des variables ("NOM", ou "$NOM" et les parametres "$1", "$#"... des fonctions), et des
+ *  expressions entre parentheses. Une variable inexistante ou vide vaut 0. Une affectation modifie la variable
+ *  locale de l'appel de fonction en cours si elle existe, sinon la variable d'environnement (voir func.h).
+ */
+
+#ifndef _ARITH_H_
+#define _ARITH_H_
+
+#include <stdint.h>
+
+
+// Codes d'erreur
+enum ArithError
+{
+    ARITH_OK = 0,               // Pas d'erreur
+    ARITH_SYNTAX = 220,         // Expression incorrecte
+    ARITH_DIV_ZERO,             // Division (ou modulo) par zero
+    ARITH_BAD_VALUE,            // Valeur d'une variable qui n'est pas un nombre entier
+    ARITH_BAD_ASSIGN            // Affectation impossible (parametre d'une fonction, allocation)
+};
+
+
+/*
+ * Evalue une expression arithmetique
+ *
+ * expr : l'expression (sans "$((" ni "))")
+ * value : en sortie, la valeur de l'expression
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int evalArith( const char* expr, int64_t* value );
+
+
+#endif // _ARITH_H_
@@ -7,7 +7,7 @@
  *  Groupe de projet :  Groupe 1
  *  Date :              30/10/2023
  *
- *  Dependances : cmd.h
+ *  Dependances : cmd.h parser.h arith.h func.h lineread.h memo.h memstat.h options.h placement.h ringbuf.h watch.h
  *
  *  Gestion des commandes internes du minishell (implementation).
  */
@@ -20,6 +20,15 @@
 #include <unistd.h>
 
 #include "parser.h"
+#include "arith.h"
+#include "func.h"
+#include "lineread.h"
+#include "memo.h"
+#include "memstat.h"
+#include "options.h"
+#include "placement.h"
+#include "ringbuf.h"
+#include "watch.h"
 
 
 //--- Declaration des types et fonctions locales --------------------------------------------------------------
@@ -27,10 +36,12 @@
 // Structure de donnees associees a une commande builtin:
 // - name : nom de la commande
 // - func : fonction qui execute la commande
+// - inShell : flag indiquant si la commande s'execute dans le processus du minishell
 typedef struct
 {
     char name[MAX_LINE_SIZE];
     int (*func)( cmd_t* cmd );
+    int inShell;
 } BuiltinCmd;
 
 /*
@@ -42,13 +53,49 @@ typedef struct
 static int changeDir( cmd_t* cmd );
 static int exportVar( cmd_t* cmd );
 static int unsetVar( cmd_t* cmd );
+static int runWithPlacement( cmd_t* cmd );
+static int listJobs( cmd_t* cmd );
+static int setOptions( cmd_t* cmd );
+static int execCommand( cmd_t* cmd );
+static int explainPlan( cmd_t* cmd );
+static int runWithTimeout( cmd_t* cmd );
+static int declareLocal( cmd_t* cmd );
+static int evalArithCmd( cmd_t* cmd );
+static int readVars( cmd_t* cmd );
+static int printMemStats( cmd_t* cmd );
+static int runMemoized( cmd_t* cmd );
+static int watchPaths( cmd_t* cmd );
+
+/*
+ * Extrait le champ suivant d'une ligne lue par la builtin 'read' : les espaces et tabulations separent les
+ * champs, et sauf en mode brut, '\' protege le caractere qui le suit
+ *
+ * str : position courante dans la ligne
+ * raw : vrai en mode brut (option -r)
+ * last : vrai pour le dernier champ, qui comprend le reste de la ligne (sans les espaces de fin)
+ * field : en sortie, le champ (au plus MAX_LINE_SIZE caracteres)
+ * retourne la position qui suit le champ
+ */
+static const char* nextField( const char* str, int raw, int last, char* field );
 
 // Liste des commandes builtin supportees
 static const BuiltinCmd ALL_BUILTINS[] =
 {
-    { "cd", changeDir },
-    { "export", exportVar },
-    { "unset", unsetVar }
+    { "cd", changeDir, 1 },
+    { "export", exportVar, 1 },
+    { "unset", unsetVar, 1 },
+    { "run", runWithPlacement, 0 },
+    { "jobs", listJobs, 1 },
+    { "set", setOptions, 1 },
+    { "exec", execCommand, 1 },
+    { "explain", explainPlan, 1 },
+    { "timeout", runWithTimeout, 0 },
+    { "local", declareLocal, 1 },
+    { "((", evalArithCmd, 1 },
+    { "read", readVars, 1 },
+    { "memstat", printMemStats, 1 },
+    { "memo", runMemoized, 0 },
+    { "watch", watchPaths, 1 }
 };
 static const int BUILTIN_COUNT = sizeof( ALL_BUILTINS ) / sizeof( BuiltinCmd );
 
@@ -69,6 +116,26 @@ int isBuiltin( const char* cmd )
 }
 
 
+int isShellBuiltin( const char* cmd )
+{
+    // Pour chaque builtin supportee
+    for( int i = 0; i < BUILTIN_COUNT; ++i )
+    {
+        // Si les noms correspondent, on retourne le flag de la commande
+        if( strcmp( ALL_BUILTINS[i].name, cmd ) == 0 ) return( ALL_BUILTINS[i].inShell );
+    }
+
+    // Builtin non trouvee
+    return( 0 );
+}
+
+
+const char* getBuiltinName( int index )
+{
+    return( index >= 0 && index < BUILTIN_COUNT ? ALL_BUILTINS[index].name : NULL );
+}
+
+
 int execBuiltin( cmd_t* cmd )
 {
     // Recherche de la commande builtin
@@ -139,16 +206,17 @@ static int exportVar( cmd_t* cmd )
     // On extrait le nom de la variable
     char varName[MAX_LINE_SIZE] = {'\0'};
     const char* sep = "=";
-    char* token = strtok( arg, sep );
+    char* savePtr = NULL;
+    char* token = strtok_r( arg, sep, &savePtr );
     if( token != NULL ) strcpy( varName, token );
 
     // On extrait la valeur de la variable
     char varValue[MAX_LINE_SIZE] = {'\0'};
-    token = strtok( NULL, sep );
+    token = strtok_r( NULL, sep, &savePtr );
     if( token != NULL ) strcpy( varValue, token );
 
     // On verifie qu'il n'y a plus de '=' (token doit etre NULL )
-    token = strtok( NULL, sep );
+    token = strtok_r( NULL, sep, &savePtr );
 
     // Verification du format
     if( strlen( varName ) == 0 || strlen( varValue ) == 0 || token != NULL )
@@ -185,3 +253,431 @@ static int unsetVar( cmd_t* cmd )
 }
 
 
+static int runWithPlacement( cmd_t* cmd )
+{
+    // Message d'utilisation
+    const char* usage = "ERREUR - Usage: run [--cpus LISTE] [--nice N] [--ionice CLASSE[:NIVEAU]] "
+                        "[--rlimit RES=SOFT[:HARD]]... [--] CMD [ARGS...]\n";
+
+    // Decodage des options
+    Placement placement;
+    initPlacement( &placement );
+    int iArg = 1;
+    while( cmd->argv[iArg] != NULL && strncmp( cmd->argv[iArg], "--", 2 ) == 0 )
+    {
+        // Option et valeur associee
+        const char* option = cmd->argv[iArg++];
+        const char* value = cmd->argv[iArg];
+
+        // Fin des options
+        if( strcmp( option, "--" ) == 0 ) break;
+
+        // Toutes les options ont une valeur
+        if( value == NULL )
+        {
+            fprintf( stderr, "%s", usage );
+            return( BUILTIN_BAD_ARGS );
+        }
+        ++iArg;
+
+        // Suivant l'option
+        int status = PLACEMENT_OK;
+        if( strcmp( option, "--cpus" ) == 0 )
+        {
+            status = parseCpuList( value, &placement.cpus );
+            placement.hasCpus = 1;
+        }
+        else if( strcmp( option, "--nice" ) == 0 )
+        {
+            // La valeur doit etre un nombre entier, sans caractere en trop (ni vide)
+            char* end = NULL;
+            placement.nice = (int)strtol( value, &end, 10 );
+            placement.hasNice = 1;
+            if( end == value || *end != '\0' ) status = PLACEMENT_BAD_SPEC;
+        }
+        else if( strcmp( option, "--ionice" ) == 0 )
+        {
+            status = parseIoPriority( value, &placement );
+        }
+        else if( strcmp( option, "--rlimit" ) == 0 )
+        {
+            status = parseRlimit( value, &placement );
+        }
+        else
+        {
+            status = PLACEMENT_BAD_SPEC;
+        }
+
+        // Option incorrecte
+        if( status != PLACEMENT_OK )
+        {
+            fprintf( stderr, "ERREUR - Option %s incorrecte : %s\n", option, value );
+            fprintf( stderr, "%s", usage );
+            return( BUILTIN_BAD_ARGS );
+        }
+    }
+
+    // Il doit rester une commande a executer
+    if( cmd->argv[iArg] == NULL )
+    {
+        fprintf( stderr, "%s", usage );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Application du placement au processus courant (qui est le processus d'execution de la commande)
+    const int status = applyPlacement( &placement );
+    if( status != PLACEMENT_OK ) return( status );
+
+    // On retire les options de la liste des arguments : la commande devient la commande a executer
+    int iDst = 0;
+    while( cmd->argv[iArg] != NULL ) cmd->argv[iDst++] = cmd->argv[iArg++];
+    cmd->argc = iDst;
+    while( iDst < iArg ) cmd->argv[iDst++] = NULL;
+    strcpy( cmd->path, cmd->argv[0] );
+
+    // Execution de la commande (builtin ou binaire)
+    if( isBuiltin( cmd->path ) ) return( execBuiltin( cmd ) );
+    execvp( cmd->path, cmd->argv );
+
+    // Ici, on a forcement une erreur d'execution
+    fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", cmd->path );
+    return( CMD_EXEC_FAILED );
+}
+
+
+static int listJobs( cmd_t* cmd )
+{
+    // Message d'utilisation
+    const char* usage = "ERREUR - Usage: jobs [-o %N]\n";
+
+    // Sans argument, affichage de toutes les commandes en background
+    if( cmd->argv[1] == NULL )
+    {
+        for( const BgCmd* bgCmd = getBgCmds(); bgCmd != NULL; bgCmd = bgCmd->next )
+        {
+            // Etat de la commande
+            if( bgCmd->finished ) printf( "[%d]   Fini (status = %d)   %s", bgCmd->number, bgCmd->exitStatus, bgCmd->cmdLine );
+            else printf( "[%d]   En cours             %s", bgCmd->number, bgCmd->cmdLine );
+
+            // Taille des sorties capturees
+            if( bgCmd->output != NULL ) printf( " (%zu octets captures)", bgCmd->output->length );
+            printf( "\n" );
+        }
+        return( BUILTIN_OK );
+    }
+
+    // Sinon, seule l'option '-o %N' est supportee
+    if( strcmp( cmd->argv[1], "-o" ) != 0 || cmd->argv[2] == NULL || cmd->argv[3] != NULL )
+    {
+        fprintf( stderr, "%s", usage );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Recherche de la commande (le '%' est optionnel)
+    const char* spec = cmd->argv[2];
+    if( *spec == '%' ) ++spec;
+    char* end = NULL;
+    const int number = (int)strtol( spec, &end, 10 );
+    BgCmd* bgCmd = ( *spec != '\0' && *end == '\0' ? findBgCmd( number ) : NULL );
+    if( bgCmd == NULL )
+    {
+        fprintf( stderr, "ERREUR - Commande en background inconnue : %s\n", cmd->argv[2] );
+        return( BUILTIN_BAD_ARGS );
+    }
+    if( bgCmd->output == NULL )
+    {
+        fprintf( stderr, "ERREUR - Les sorties de la commande [%d] ne sont pas capturees (set -o bgcapture)\n",
+                 bgCmd->number );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Affichage des sorties capturees (apres lecture de celles en attente dans le pipe)
+    drainBgCmdOutputs();
+    fflush( stdout );
+    if( bgCmd->output->dropped > 0 )
+    {
+        fprintf( stderr, "[%d] %zu octets perdus (buffer de capture plein)\n", bgCmd->number, bgCmd->output->dropped );
+    }
+    dumpRingBuffer( bgCmd->output, STDOUT_FILENO );
+
+    // Une fois ses sorties consultees, une commande terminee est oubliee
+    if( bgCmd->finished ) freeBgCmd( removeBgCmd( bgCmd->pid ) );
+
+    return( BUILTIN_OK );
+}
+
+
+static int setOptions( cmd_t* cmd )
+{
+    // Sans argument, affichage des options
+    if( cmd->argv[1] == NULL )
+    {
+        printOptions();
+        return( BUILTIN_OK );
+    }
+
+    // Sinon, une liste de '-o NOM[=VALEUR]' (activation) ou de '+o NOM' (desactivation)
+    for( int iArg = 1; cmd->argv[iArg] != NULL; iArg += 2 )
+    {
+        const char* flag = cmd->argv[iArg];
+        const char* spec = cmd->argv[iArg + 1];
+        if( spec == NULL || ( strcmp( flag, "-o" ) != 0 && strcmp( flag, "+o" ) != 0 ) )
+        {
+            fprintf( stderr, "ERREUR - Usage: set [-o NOM[=VALEUR]] [+o NOM]...\n" );
+            return( BUILTIN_BAD_ARGS );
+        }
+
+        // Modification de l'option
+        const int status = setOption( spec, flag[0] == '-' );
+        if( status == OPTION_UNKNOWN ) fprintf( stderr, "ERREUR - Option inconnue : %s\n", spec );
+        else if( status != OPTION_OK ) fprintf( stderr, "ERREUR - Valeur incorrecte : %s\n", spec );
+        if( status != OPTION_OK ) return( BUILTIN_BAD_ARGS );
+    }
+
+    return( BUILTIN_OK );
+}
+
+
+static int execCommand( cmd_t* cmd )
+{
+    // Sans commande, seules les redirections sont appliquees (durablement, par le minishell : voir
+    // execInShell() dans cmd.c)
+    if( cmd->argv[1] == NULL ) return( BUILTIN_OK );
+
+    // Sinon, la commande remplace le processus courant
+    fflush( stdout );
+    execvp( cmd->argv[1], cmd->argv + 1 );
+
+    // Ici, on a forcement une erreur d'execution
+    fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", cmd->argv[1] );
+    return( CMD_EXEC_FAILED );
+}
+
+
+static int explainPlan( cmd_t* cmd )
+{
+    // 'explain' est traite lors de l'analyse de la ligne de commande (voir runCmdLine() dans shell.c), a
+    // condition d'en etre le premier mot
+    fprintf( stderr, "ERREUR - Usage: explain LIGNE (en debut de ligne de commande)\n" );
+    return( BUILTIN_BAD_ARGS );
+}
+
+
+static int runWithTimeout( cmd_t* cmd )
+{
+    // 'timeout' est traite avant l'execution de la commande (voir execCmd() dans cmd.c), par le minishell qui
+    // surveille le delai : il doit donc etre le premier mot de la commande
+    fprintf( stderr, "ERREUR - Usage: timeout DUREE [-s SIGNAL] [-k DELAI] CMD [ARGS...] (en debut de commande)\n" );
+    return( BUILTIN_BAD_ARGS );
+}
+
+
+static int declareLocal( cmd_t* cmd )
+{
+    // Message d'utilisation
+    const char* usage = "ERREUR - Usage: local NAME[=VALUE]... (dans une fonction)\n";
+    if( cmd->argc < 2 )
+    {
+        fprintf( stderr, "%s", usage );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Pour chaque variable (sans valeur, la variable est vide)
+    for( int i = 1; i < cmd->argc; ++i )
+    {
+        // Nom et valeur de la variable
+        char varName[MAX_LINE_SIZE];
+        snprintf( varName, MAX_LINE_SIZE, "%s", cmd->argv[i] );
+        char* sep = strchr( varName, '=' );
+        const char* varValue = "";
+        if( sep != NULL )
+        {
+            *sep = '\0';
+            varValue = sep + 1;
+        }
+
+        // Declaration de la variable dans l'appel de fonction courant
+        const int status = setLocalVar( varName, varValue );
+        if( status == FUNC_NOT_IN_CALL || status == FUNC_BAD_NAME )
+        {
+            fprintf( stderr, "%s", usage );
+            return( BUILTIN_BAD_ARGS );
+        }
+        if( status != FUNC_OK ) return( status );
+    }
+
+    return( BUILTIN_OK );
+}
+
+
+static int evalArithCmd( cmd_t* cmd )
+{
+    // La commande "((...))" est decoupee lors de l'analyse en "((" suivi de l'expression
+    if( cmd->argc != 2 )
+    {
+        fprintf( stderr, "ERREUR - Usage: (( EXPR ))\n" );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Evaluation de l'expression
+    int64_t value = 0;
+    const int status = evalArith( cmd->argv[1], &value );
+    if( status != ARITH_OK )
+    {
+        fprintf( stderr, "ERREUR - Expression arithmetique incorrecte : %s [code = %d]\n", cmd->argv[1], status );
+        return( status );
+    }
+
+    // La commande reussit si la valeur est non nulle
+    return( value != 0 ? BUILTIN_OK : 1 );
+}
+
+
+static int readVars( cmd_t* cmd )
+{
+    // Message d'utilisation
+    const char* usage = "ERREUR - Usage: read [-r] [-d DELIM] [NAME...]\n";
+
+    // Options
+    int raw = 0;
+    char delim = '\n';
+    int iArg = 1;
+    for( ; iArg < cmd->argc && cmd->argv[iArg][0] == '-'; ++iArg )
+    {
+        if( strcmp( cmd->argv[iArg], "-r" ) == 0 ) raw = 1;
+        else if( strcmp( cmd->argv[iArg], "-d" ) == 0 && iArg + 1 < cmd->argc ) delim = cmd->argv[++iArg][0];
+        else
+        {
+            fprintf( stderr, "%s", usage );
+            return( BUILTIN_BAD_ARGS );
+        }
+    }
+
+    // Noms des variables ('REPLY' par defaut)
+    char* defaultNames[] = { "REPLY", NULL };
+    char** names = ( iArg < cmd->argc ? cmd->argv + iArg : defaultNames );
+    for( char** name = names; *name != NULL; ++name )
+    {
+        if( ! isValidName( *name ) )
+        {
+            fprintf( stderr, "%s", usage );
+            return( BUILTIN_BAD_ARGS );
+        }
+    }
+
+    // Lecture d'une ligne sur l'entree de la commande (installee sur l'entree standard)
+    char line[MAX_LINE_SIZE];
+    size_t length = 0;
+    int status = readInputLine( STDIN_FILENO, delim, line, MAX_LINE_SIZE, &length );
+
+    // Sauf en mode brut, une ligne terminee par un '\' (non protege) continue sur la ligne suivante
+    for( ;; )
+    {
+        size_t backslashes = 0;
+        while( backslashes < length && line[length - 1 - backslashes] == '\\' ) ++backslashes;
+        if( raw || status != LINEREAD_OK || backslashes % 2 == 0 ) break;
+
+        // Le '\' final est remplace par la ligne suivante
+        size_t nextLength = 0;
+        --length;
+        status = readInputLine( STDIN_FILENO, delim, line + length, MAX_LINE_SIZE - length, &nextLength );
+        length += nextLength;
+    }
+    if( status == LINEREAD_IO_ERROR )
+    {
+        perror( "ERREUR - read" );
+        return( status );
+    }
+
+    // Un champ par variable, la derniere recevant le reste de la ligne
+    const char* position = line;
+    for( char** name = names; *name != NULL; ++name )
+    {
+        char field[MAX_LINE_SIZE];
+        position = nextField( position, raw, name[1] == NULL, field );
+        const int varStatus = setVar( *name, field );
+        if( varStatus != FUNC_OK ) return( varStatus );
+    }
+
+    // Echec si la fin de l'entree a ete atteinte avant le delimiteur
+    return( status == LINEREAD_OK ? BUILTIN_OK : 1 );
+}
+
+
+static int printMemStats( cmd_t* cmd )
+{
+    // Seule l'option '-r' (remise a zero des pics apres l'affichage) est supportee
+    const int reset = ( cmd->argv[1] != NULL && strcmp( cmd->argv[1], "-r" ) == 0 );
+    if( cmd->argv[1 + reset] != NULL )
+    {
+        fprintf( stderr, "ERREUR - Usage: memstat [-r]\n" );
+        return( BUILTIN_BAD_ARGS );
+    }
+
+    // Compteurs de chaque sous-systeme, et leur total
+    MemStats total = { 0, 0, 0, 0 };
+    printf( "%-12s %12s %12s %10s %12s\n", "", "octets", "pic", "blocs", "allocations" );
+    for( int i = 0; i < MEM_SUBSYSTEM_COUNT; ++i )
+    {
+        MemStats stats;
+        getMemStats( i, &stats );
+        printf( "%-12s %12zu %12zu %10zu %12zu\n", getMemSubsystemName( i ), stats.bytes, stats.peakBytes, stats.blocks,
+                stats.allocs );
+        total.bytes += stats.bytes;
+        total.peakBytes += stats.peakBytes;
+        total.blocks += stats.blocks;
+        total.allocs += stats.allocs;
+    }
+    printf( "%-12s %12zu %12zu %10zu %12zu\n", "total", total.bytes, total.peakBytes, total.blocks, total.allocs );
+
+    // Memoire residente du processus
+    long rss = 0;
+    long peakRss = 0;
+    if( readProcessMemory( &rss, &peakRss ) == MEMSTAT_OK ) printf( "RSS : %ld kio (pic : %ld kio)\n", rss, peakRss );
+    else fprintf( stderr, "ERREUR - Lecture de /proc/self/status impossible\n" );
+
+    if( reset ) resetMemPeaks();
+    return( BUILTIN_OK );
+}
+
+
+static int runMemoized( cmd_t* cmd )
+{
+    // Execute dans le processus de la commande : le cache est partage par fichiers (voir memo.h)
+    return( runMemo( cmd ) );
+}
+
+
+static int watchPaths( cmd_t* cmd )
+{
+    // La ligne re-executee a ete analysee avec la commande (voir watch.h)
+    return( runWatch( cmd ) );
+}
+
+
+static const char* nextField( const char* str, int raw, int last, char* field )
+{
+    // Espaces avant le champ
+    while( *str == ' ' || *str == '\t' ) ++str;
+
+    // Caracteres du champ, jusqu'au prochain espace (ou jusqu'a la fin de la ligne pour le dernier champ). La
+    // longueur utile exclut les espaces de fin non proteges.
+    size_t length = 0;
+    size_t usefulLength = 0;
+    for( ; *str != '\0' && ( last || ( *str != ' ' && *str != '\t' ) ); ++str )
+    {
+        // Caractere protege par '\'
+        int escaped = 0;
+        if( ! raw && *str == '\\' && str[1] != '\0' )
+        {
+            ++str;
+            escaped = 1;
+        }
+
+        field[length++] = *str;
+        if( escaped || ( *str != ' ' && *str != '\t' ) ) usefulLength = length;
+    }
+    field[usefulLength] = '\0';
+
+    return( str );
+}
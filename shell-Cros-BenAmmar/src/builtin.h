@@ -33,6 +33,23 @@ enum BuilinError
  */
 int isBuiltin( const char* cmd );
 
+/*
+ * Teste si une commande est une builtin qui doit s'executer dans le processus du minishell (parce qu'elle
+ * modifie son etat : repertoire courant, variables d'environnement, options...)
+ *
+ * cmd : nom de la commande a tester
+ * Retourne 1 si la commande doit s'executer dans le processus du minishell, sinon 0
+ */
+int isShellBuiltin( const char* cmd );
+
+/*
+ * Retourne le nom d'une builtin (pour parcourir la liste des builtins)
+ *
+ * index : index de la builtin
+ * Retourne le nom de la builtin, ou NULL si l'index depasse le nombre de builtins
+ */
+const char* getBuiltinName( int index );
+
 /*
  * Execute la commande (supposee builtin) specifiee
  *
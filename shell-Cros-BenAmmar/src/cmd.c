@@ -7,21 +7,42 @@
  *  Groupe de projet :  Groupe 1
  *  Date :              30/10/2023
  *
- *  Dependances : parser.h
+ *  Dependances : parser.h ringbuf.h builtin.h deadline.h expand.h fanout.h func.h jobs.h lineread.h
+ *                memstat.h metrics.h options.h param.h placement.h replay.h stage.h zygote.h
  *
  *  Modelisation d'une commande (implementation)
  */
 
+#define _GNU_SOURCE
 
 #include "cmd.h"
 #include "builtin.h"
+#include "deadline.h"
+#include "expand.h"
+#include "fanout.h"
+#include "func.h"
+#include "jobs.h"
+#include "lineread.h"
+#include "memstat.h"
+#include "metrics.h"
+#include "options.h"
+#include "param.h"
+#include "placement.h"
+#include "replay.h"
+#include "stage.h"
+#include "zygote.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <unistd.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 
 
@@ -41,7 +62,8 @@ enum SepType
 {
     SEP_NONE = -1,          // Pas de separateur
     SEP_SIMPLE = 0,         // Simple separateur de commande (";")
-    SEP_REDIRECT,           // Redirections ("<", ">", "1>", ">>", "1>>", "2>", "2>>", "&>", "&>>")
+    SEP_REDIRECT,           // Redirections ("<", ">", ">>", "<&", ">&", eventuellement precedes d'un numero de
+                            // descripteur, ainsi que "&>" et "&>>")
     SEP_LOGICAL,            // Operateurs logiques ("&&", "||")
     SEP_PIPE,               // Pipe ("|")
     SEP_BACKGROUND,         // Execution en background ("&")
@@ -57,13 +79,159 @@ enum RedirectType
     REDIRECT_ERR            // Redirection de l'erreur standard
 };
 
+// Modes de redirection (donnes par l'operateur de redirection)
+enum RedirectMode
+{
+    MODE_NONE = -1,         // Pas de redirection
+    MODE_READ = 0,          // Lecture d'un fichier ("<")
+    MODE_WRITE,             // Ecriture d'un fichier, ecrase ("N>")
+    MODE_APPEND,            // Ecriture en fin de fichier ("N>>")
+    MODE_DUP_IN,            // Duplication d'un descripteur en lecture ("N<&M")
+    MODE_DUP_OUT,           // Duplication d'un descripteur en ecriture ("N>&M")
+    MODE_ALL,               // Ecriture des sorties standard et d'erreur dans un fichier, ecrase ("&>")
+    MODE_ALL_APPEND         // Ecriture des sorties standard et d'erreur en fin de fichier ("&>>")
+};
+
 // Index des files descriptors d'entree et de sortie d'un pipe
 #define PIPE_IN  1  // Entree du pipe (cote en ecriture)
 #define PIPE_OUT 0  // Sortie du pipe (cote en lecture)
 
 
-// Liste des commandes en background en cours d'execution
-static BgCmd* backgroundCommands = NULL;
+// Liste des commandes en background en cours d'execution. L'etat d'execution des lignes de commande est propre a
+// chaque thread, pour qu'une application qui integre le moteur (voir libminishell.h) puisse executer des lignes
+// en parallele : chaque thread a ses propres commandes en background.
+static _Thread_local BgCmd* backgroundCommands = NULL;
+
+// Descripteurs (de 3 a 9) ouverts dans le minishell par la builtin 'exec', un bit par descripteur. Ces
+// descripteurs restent ouverts d'une ligne de commande a l'autre, et sont herites par les commandes.
+static int shellFds = 0;
+
+// Commandes de la derniere ligne analysee
+static _Thread_local cmd_t* lineCmds = NULL;
+static _Thread_local int lineCmdCount = 0;
+
+// Vrai dans le processus d'execution d'un groupe de commandes (sous-shell, ou groupe '{ ... ; }' execute dans
+// un pipeline ou en background)
+static _Thread_local int inGroupProcess = 0;
+
+// Vrai quand la liste de commandes en cours est la derniere chose qu'execute le processus d'un groupe (ou d'une
+// fonction) : ce n'est plus le cas dans un groupe '{ ... ; }' ou un appel de fonction suivi d'autres commandes
+static _Thread_local int lastInProcess = 0;
+
+// Execution integree a une autre application (voir setEmbeddedExec()) : environnement des programmes lances (NULL
+// pour celui du processus), et vrai si 'exit' a termine la ligne de commande en cours
+static _Thread_local int embeddedExec = 0;
+static _Thread_local char** embeddedEnv = NULL;
+static _Thread_local int lineExited = 0;
+
+// Descripteur des sorties non redirigees des commandes en background (voir setBgCmdOutput()), ou -1 pour celles
+// du minishell
+static _Thread_local int bgOutputFd = -1;
+
+// Nombre de signaux SIGIO recus (donnees disponibles sur un pipe de capture), seule donnee modifiee par le
+// callback, et valeur deja traitee par le thread courant (voir pollBgCmdOutputs())
+static int bgOutputSignals = 0;
+static _Thread_local int bgOutputSeen = 0;
+
+// Analyse a blanc des lignes de commande (voir setDryRunParse()), et fichiers de redirection remplaces par /dev/null
+// (descripteur et nom)
+static _Thread_local int dryRunParse = 0;
+static _Thread_local int dryRunFds[MAX_CMD_SIZE];
+static _Thread_local char* dryRunFiles[MAX_CMD_SIZE];
+static _Thread_local int dryRunFileCount = 0;
+
+// Vrai pendant l'analyse du corps d'une fonction : ses commandes sont des modeles, dont les tokens sont conserves
+// bruts, et dont les pipes ne sont crees qu'a chaque appel
+static _Thread_local int parsingFunction = 0;
+
+// Commandes d'une ligne (ou du corps d'une fonction) dont l'execution est en cours
+//
+// cmds : tableau des commandes
+// count : nombre de commandes du tableau
+// caller : ligne qui a appele la fonction en cours d'execution dans la ligne, ou NULL
+typedef struct CallerLine
+{
+    cmd_t* cmds;
+    int count;
+    const struct CallerLine* caller;
+} CallerLine;
+
+// Lignes dont l'execution est suspendue par l'appel d'une fonction (la plus recente en premier) : leurs pipes
+// doivent aussi etre refermes par les processus des groupes et des fonctions
+static _Thread_local const CallerLine* callerLines = NULL;
+
+// Les redirections des commandes executees dans le minishell modifient ses descripteurs standards, partages par
+// tous les threads : elles sont serialisees (le verrou est recursif, pour les groupes '{ ... ; }')
+static pthread_mutex_t inShellLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+/*
+ * Analyse une liste de commandes (ligne de commande, ou commandes d'un groupe) et remplit le tableau des
+ * commandes. Les groupes rencontres sont analyses recursivement.
+ *
+ * position : en entree, pointeur sur le premier token de la liste. En sortie, pointeur sur le token de fin du
+ *            groupe (ou sur le NULL final pour la ligne de commande)
+ * cmds : le tableau des commandes
+ * cmdCount : nombre de commandes utilisees dans le tableau (mis a jour)
+ * closing : token de fin du groupe (")" ou "}"), ou NULL pour la ligne de commande
+ * retourne 0 ou un code d'erreur
+ */
+static int parseCmdList( char*** position, cmd_t* cmds, int* cmdCount, const char* closing );
+
+/*
+ * Teste si les tokens specifies commencent la definition d'une fonction ("nom ( ) {"), le nom etant la commande
+ * courante (sans arguments ni redirections)
+ *
+ * cmd : la commande courante (peut etre NULL)
+ * tokens : les tokens qui suivent le nom
+ * retourne 1 si les tokens commencent une definition de fonction, sinon 0
+ */
+static int isFunctionDef( const cmd_t* cmd, char** tokens );
+
+/*
+ * Analyse la definition d'une fonction. Le corps est analyse en commandes modeles, rangees temporairement apres
+ * la commande de definition, puis deplacees dans la fonction. La commande de definition enregistre la fonction
+ * lors de son execution.
+ *
+ * position : en entree, pointeur sur le token "(" qui suit le nom. En sortie, pointeur sur le token "}" de fin
+ *            du corps
+ * cmd : la commande de definition (dont le nom est celui de la fonction)
+ * cmds : le tableau des commandes
+ * cmdCount : nombre de commandes utilisees dans le tableau (mis a jour)
+ * retourne 0 ou un code d'erreur
+ */
+static int parseFunctionDef( char*** position, cmd_t* cmd, cmd_t* cmds, int* cmdCount );
+
+/*
+ * Teste si le token specifie commence la ligne re-executee par la builtin 'watch' ("--" parmi les arguments
+ * d'une commande 'watch', en dehors des groupes et des corps de fonctions)
+ *
+ * cmd : la commande courante (peut etre NULL)
+ * token : le token courant
+ * closing : token de fin du groupe en cours d'analyse (NULL en dehors des groupes)
+ * retourne 1 si le token commence la ligne re-executee, sinon 0
+ */
+static int isWatchBody( const cmd_t* cmd, const char* token, const char* closing );
+
+/*
+ * Analyse la ligne re-executee par la builtin 'watch' (jusqu'a la fin de la ligne de commande) en commandes
+ * modeles, rangees temporairement apres la commande 'watch', puis deplacees dans une fonction anonyme conservee
+ * par la commande
+ *
+ * position : en entree, pointeur sur le token "--". En sortie, pointeur sur la fin de la ligne
+ * cmd : la commande 'watch'
+ * cmds : le tableau des commandes
+ * cmdCount : nombre de commandes utilisees dans le tableau (mis a jour)
+ * retourne 0 ou un code d'erreur
+ */
+static int parseWatchBody( char*** position, cmd_t* cmd, cmd_t* cmds, int* cmdCount );
+
+/*
+ * Retourne le type de groupe commence par le token specifie
+ *
+ * token : token a tester
+ * retourne GROUP_SUBSHELL pour "(", GROUP_CURRENT pour "{", sinon GROUP_NONE
+ */
+static CmdGroup getGroupType( const char* token );
 
 /*
  * Teste si le token specifie est un separateur de commande
@@ -87,6 +255,64 @@ static int isSeparator( const char* token );
  */
 static int processCmdRedirection( const char* sep, cmd_t* cmd, const char* fileName );
 
+/*
+ * Traite une redirection dont le fichier cible est un mot de la ligne de commande : ses variables sont d'abord
+ * substituees (voir processCmdRedirection())
+ *
+ * sep : le separateur de redirection
+ * cmd : la commande mise a jour
+ * word : le mot qui donne le fichier cible (peut etre NULL)
+ * retourne 0 en cas de succes, ou sinon un code d'erreur
+ */
+static int processWordRedirection( const char* sep, cmd_t* cmd, const char* word );
+
+/*
+ * Analyse un separateur de redirection
+ *
+ * sep : le separateur (operateur de redirection, eventuellement precede d'un numero de descripteur)
+ * fd : en sortie, le descripteur redirige (celui du separateur, sinon celui par defaut de l'operateur, ou -1
+ *      pour les redirections de la sortie et de l'erreur standards). Peut etre NULL.
+ * retourne le mode de redirection, ou MODE_NONE si le separateur n'est pas une redirection
+ */
+static int parseRedirection( const char* sep, int* fd );
+
+/*
+ * Ajoute une duplication de descripteur ("N>&M", "N>&-") a une commande
+ *
+ * cmd : la commande
+ * target : descripteur cible
+ * word : descripteur source (un chiffre), ou "-" pour fermer le descripteur cible
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int processFdDuplication( cmd_t* cmd, int target, const char* word );
+
+/*
+ * Ajoute une duplication a la liste des duplications de descripteurs d'une commande
+ *
+ * cmd : la commande
+ * target : descripteur cible
+ * source : descripteur source, ou FD_CLOSED
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addFdDuplication( cmd_t* cmd, int target, int source );
+
+/*
+ * Teste si un descripteur est la cible d'une duplication d'une commande
+ *
+ * cmd : la commande
+ * fd : le descripteur
+ * retourne 1 si le descripteur est une cible, sinon 0
+ */
+static int isFdDuplicationTarget( const cmd_t* cmd, int fd );
+
+/*
+ * Effectue une duplication de descripteur
+ *
+ * target : descripteur cible
+ * source : descripteur source, ou FD_CLOSED pour fermer la cible
+ */
+static void duplicateFd( int target, int source );
+
 /*
  * Met a jour le chainage des commande dans une sequence de commandes interruptible.
  *
@@ -102,7 +328,8 @@ static void updateCmdChaining( cmd_t* start, cmd_t* end );
 
 /*
  * Creation d'un pipe entre 2 commandes. L'entree du pipe est associee a la sortie standard de la premiere
- * commande, et sa sortie a l'entree standard de la deuxieme commande
+ * commande, et sa sortie a l'entree standard de la deuxieme commande (dans le corps d'une fonction en cours
+ * d'analyse, seul le chainage des commandes est memorise)
  *
  * firstCmd : premiere commande (avant le pipe)
  * secondCmd : seconde commande (apres le pipe)
@@ -110,6 +337,67 @@ static void updateCmdChaining( cmd_t* start, cmd_t* end );
  */
 static int createPipe( cmd_t* firstCmd, cmd_t* secondCmd );
 
+/*
+ * Ajoute un pipeline alimente par une commande de diffusion ('|+', voir fanout.h). Pour le premier pipeline, la
+ * commande de diffusion est d'abord inseree a la place de la nouvelle commande, entre la commande precedente et
+ * le pipeline. Les pipelines sont chaines les uns a la suite des autres (via 'nextSuccess' et 'pipePrev'), de
+ * sorte que seule la derniere commande du dernier pipeline soit attendue directement.
+ *
+ * fanout : commande de diffusion en cours (NULL pour le premier pipeline, mise a jour)
+ * previous : commande precedant le separateur '|+'
+ * current : premiere commande du nouveau pipeline (mise a jour si la commande de diffusion est inseree)
+ * cmds : tableau des commandes de la ligne
+ * cmdCount : nombre de commandes du tableau (mis a jour)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addFanoutBranch( cmd_t** fanout, cmd_t* previous, cmd_t** current, cmd_t* cmds, int* cmdCount );
+
+/*
+ * Rajoute un argument en fin de liste des arguments d'une commande (la liste est agrandie si besoin)
+ *
+ * cmd : la commande mise a jour
+ * arg : l'argument a rajouter (alloue via memAlloc(), la commande en devient proprietaire)
+ * retourne 0 en cas de succes, sinon un code d'erreur (l'argument est alors libere)
+ */
+static int addCmdArg( cmd_t* cmd, char* arg );
+
+/*
+ * Rajoute les arguments produits par un mot de la ligne de commande : les variables du mot sont substituees (une
+ * valeur avec des espaces donne plusieurs mots), puis chaque mot est expanse (voir expand.h)
+ *
+ * cmd : la commande mise a jour
+ * word : le mot
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addCmdWord( cmd_t* cmd, const char* word );
+
+/*
+ * Rajoute un token brut en fin de liste des arguments d'une commande modele (corps d'une fonction)
+ *
+ * cmd : la commande mise a jour
+ * token : le token (recopie)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addRawArg( cmd_t* cmd, const char* token );
+
+/*
+ * Teste si un token est une commande arithmetique "((...))"
+ *
+ * token : le token
+ * retourne 1 si le token est une commande arithmetique, sinon 0
+ */
+static int isArithCmd( const char* token );
+
+/*
+ * Rajoute les arguments d'une commande arithmetique : la builtin "((" suivie de l'expression brute (ses variables
+ * sont lues lors de l'evaluation, a l'execution de la commande)
+ *
+ * cmd : la commande mise a jour
+ * token : la commande arithmetique "((...))"
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addArithCmd( cmd_t* cmd, const char* token );
+
 /*
  * Rajoute un file descriptor dans la liste des file descriptor a refermer d'une commande
  *
@@ -118,6 +406,15 @@ static int createPipe( cmd_t* firstCmd, cmd_t* secondCmd );
  */
 static void addFileDescriptor( cmd_t* cmd, int fd );
 
+/*
+ * Memorise le nom du fichier de redirection remplace par /dev/null lors d'une analyse a blanc (le nom n'est pas
+ * memorise si la liste est pleine)
+ *
+ * fd : descripteur de /dev/null utilise par la commande
+ * fileName : nom du fichier de redirection
+ */
+static void addDryRunFile( int fd, const char* fileName );
+
 /*
  * Referme tous les fichiers et pipes ouverts de la commande
  *
@@ -126,9 +423,200 @@ static void addFileDescriptor( cmd_t* cmd, int fd );
 static void closeCmdFiles( cmd_t* cmd );
 
 /*
- * TODO
+ * Enregistre une nouvelle commande en background dans la liste globale
+ *
+ * cmd : la commande lancee en background
+ * outputFd : sortie du pipe de capture des sorties de la commande, ou -1 si pas de capture
+ * retourne la commande en background enregistree
+ */
+static const BgCmd* addBgCmd( cmd_t* cmd, int outputFd );
+
+/*
+ * Execute une builtin, un groupe '{ ... ; }' ou un appel de fonction directement dans le processus du minishell
+ * (pour que ses effets, comme le changement de repertoire courant, soient conserves). Les redirections de la
+ * commande sont mises en place le temps de l'execution (une seule fois pour toutes les commandes d'un groupe ou
+ * du corps de la fonction).
+ *
+ * cmd : la commande builtin, le groupe, ou l'appel de fonction
+ * function : la fonction appelee, ou NULL
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int execInShell( cmd_t* cmd, Function* function );
+
+/*
+ * Execute les commandes d'un groupe dans le processus d'execution du groupe (apres la mise en place de ses
+ * redirections)
+ *
+ * cmd : le groupe
+ * retourne le code de retour de la derniere commande executee du groupe
+ */
+static int execGroupProcess( const cmd_t* cmd );
+
+/*
+ * Execute un appel de fonction dans le processus cree pour l'appel (dans un pipeline ou en background), apres la
+ * mise en place de ses redirections
+ *
+ * cmd : l'appel de fonction
+ * function : la fonction appelee
+ * retourne le code de retour de la derniere commande executee du corps de la fonction
+ */
+static int execFunctionProcess( const cmd_t* cmd, Function* function );
+
+/*
+ * Referme, dans le processus d'execution d'un groupe ou d'une fonction, les pipes des commandes de la ligne en
+ * cours (sauf ceux des commandes du groupe) et des lignes appelantes : ce processus n'execute pas de programme,
+ * et ces pipes (fermes automatiquement lors d'un exec) retarderaient les fins de fichier
+ *
+ * cmd : le groupe, ou l'appel de fonction
+ */
+static void closeLinePipes( const cmd_t* cmd );
+
+/*
+ * Appelle une fonction : son corps est instancie (copie des commandes modeles, avec leurs propres pipes), puis
+ * execute avec les arguments de l'appel comme parametres positionnels
+ *
+ * cmd : l'appel de fonction
+ * function : la fonction appelee
+ * retourne le code de retour de la derniere commande executee du corps de la fonction
+ */
+static int callFunction( const cmd_t* cmd, Function* function );
+
+/*
+ * Instancie le corps d'une fonction : chaque commande reprend le type et les enchainements de sa commande
+ * modele, et les pipes du corps sont crees. Les arguments des commandes restent a traiter (voir 'source').
+ *
+ * function : la fonction
+ * body : les commandes du corps (initialisees, autant que de commandes modeles)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int instantiateBody( const Function* function, cmd_t* body );
+
+/*
+ * Execute une commande du corps d'une fonction : ses arguments et redirections sont traites juste avant
+ * l'execution, et les fichiers des redirections sont refermes des la commande lancee (son processus en a sa
+ * propre copie)
+ *
+ * cmd : la commande
+ * retourne 0 ou un code d'erreur
+ */
+static int execBodyCmd( cmd_t* cmd );
+
+/*
+ * Traite les arguments bruts d'une commande du corps d'une fonction (voir 'source') : substitution des
+ * variables, expansion, redirections
+ *
+ * cmd : la commande
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int bindCmd( cmd_t* cmd );
+
+/*
+ * Referme, dans le minishell, l'eventuel pipe de la commande
+ *
+ * cmd : commande dont il faut refermer le pipe
+ */
+static void closeCmdPipe( cmd_t* cmd );
+
+/*
+ * Recherche la commande suivante a executer en fonction de la commande courante et du resultat de son execution.
+ *
+ * current : pointeur sur la commande courante
+ *
+ * Retourne un pointeur sur la nouvelle commande courante (ou NULL si plus de commande)
+ */
+static cmd_t* nextCmd( cmd_t* current );
+
+/*
+ * Met en place la capture des sorties standard et d'erreur (non redirigees) d'une commande en background :
+ * elles sont associees a l'entree d'un pipe, dont la sortie est lue sans attente par le minishell apres la
+ * reception du signal SIGIO (voir pollBgCmdOutputs()).
+ *
+ * cmd : la commande mise a jour
+ * captureIn : en sortie, entree du pipe de capture (a refermer par le minishell apres le lancement)
+ * retourne la sortie du pipe de capture, ou -1 si aucune capture n'est necessaire (ou en cas d'erreur)
+ */
+static int openCaptureOutput( cmd_t* cmd, int* captureIn );
+
+/*
+ * Retourne la place occupee par une liste d'arguments dans l'espace reserve par le noyau aux arguments et a
+ * l'environnement d'un nouveau programme (chaines et pointeurs)
+ *
+ * argv : liste d'arguments (terminee par NULL)
+ * retourne la place occupee, en octets
+ */
+static size_t getArgsSize( char* const argv[] );
+
+/*
+ * Retourne la place disponible pour les arguments d'un nouveau programme (limite ARG_MAX, diminuee de la place
+ * occupee par l'environnement et d'une marge de securite)
+ */
+static size_t getArgsLimit( void );
+
+/*
+ * Execute une commande externe dont la liste d'arguments est trop longue pour un seul exec, en plusieurs
+ * invocations (comme xargs). Les arguments produits par le mot le plus expanse (voir 'batchStart') sont
+ * repartis entre les invocations, les autres arguments sont repetes dans chacune. Jusqu'a "argbatch-jobs"
+ * invocations s'executent simultanement.
+ *
+ * Cette fonction est appelee dans le processus d'execution de la commande.
+ *
+ * cmd : la commande
+ * retourne 0 si toutes les invocations ont reussi, sinon le code de retour de la premiere invocation en echec
+ */
+static int execBatches( const cmd_t* cmd );
+
+/*
+ * Callback sur la reception du signal SIGIO : les pipes de capture seront vides dans leurs buffers au prochain
+ * appel de pollBgCmdOutputs() (le callback ne fait que compter le signal)
+ *
+ * sigNum : numero du signal a l'origine de l'appel
+ */
+static void onBgCmdOutput( int sigNum );
+
+/*
+ * Retourne l'index d'une commande dans son pipeline (0 pour la premiere commande du pipeline)
+ *
+ * cmd : la commande
+ * retourne l'index de la commande dans le pipeline
+ */
+static int getPipeStage( const cmd_t* cmd );
+
+/*
+ * Se synchronise avec la terminaison des commandes qui precedent la commande specifiee dans son pipeline
+ * (et qui ont ete lancees sans attente, en parallele de la commande)
+ *
+ * cmd : derniere commande du pipeline
+ */
+static void waitPipeline( const cmd_t* cmd );
+
+/*
+ * Execute une etape de pipeline dans un thread du minishell (voir stage.h). Comme pour un processus, le minishell
+ * n'attend que la derniere etape du pipeline.
+ *
+ * cmd : la commande (voir canRunStage())
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int execStage( cmd_t* cmd );
+
+/*
+ * Se synchronise avec la terminaison du processus d'execution d'une commande, qu'il ait ete cree par le
+ * minishell ou par le zygote, en faisant respecter l'eventuel delai de la commande (voir deadline.h)
+ *
+ * cmd : la commande
+ * status : en sortie, code de terminaison du processus (au format de waitpid())
+ * usage : en sortie, ressources consommees par le processus (a zero si le processus a ete cree par le zygote)
+ * retourne le PID du processus, ou -1 en cas d'erreur
+ */
+static pid_t waitCmdProcess( cmd_t* cmd, int* status, struct rusage* usage );
+
+/*
+ * Attend la fin du processus d'une commande tant que des sorties de commandes en background sont capturees :
+ * l'attente (via poll(), que le signal SIGIO interrompt) laisse vider les pipes de capture. Sans capture en
+ * cours, ou en cas d'erreur, la fonction retourne aussitot (l'attente se fait alors avec waitpid()).
+ *
+ * cmd : la commande
  */
-static const BgCmd* addBgCmd( cmd_t* cmd );
+static void waitCmdCapturing( const cmd_t* cmd );
 
 
 //--- Implementation des fonctions publiques -------------------------------------------------------------------
@@ -152,19 +640,21 @@ int initCmd( cmd_t* p )
     // Pas de commande
     strcpy( p->path, "" );
 
-    // Initialisation des tableaux (meme tailles)
-    for( int i = 0; i < MAX_CMD_SIZE; ++i )
+    // Liberation des arguments (la liste elle-meme est conservee pour les commandes suivantes)
+    for( int i = 0; i < p->argc; ++i )
     {
-        // Si l'argument existe, on le libere et on le reinitialise (a NULL)
-        if( p->argv[i] != NULL )
-        {
-            free( p->argv[i] );
-            p->argv[i] = NULL;
-        }
-
-        // Pas de descripteur de fichier valide
-        p->fdclose[i] = -1;
+        memFree( p->argv[i] );
+        p->argv[i] = NULL;
     }
+    p->argc = 0;
+    p->batchStart = 0;
+    p->batchCount = 0;
+
+    // Pas de duplication de descripteur
+    p->fddupCount = 0;
+
+    // Pas de descripteur de fichier valide
+    for( int i = 0; i < MAX_CMD_SIZE; ++i ) p->fdclose[i] = -1;
 
     // Pas de pipe ouvert
     p->fdpipe[0] = -1;
@@ -174,7 +664,42 @@ int initCmd( cmd_t* p )
     p->next = NULL;
     p->nextSuccess = NULL;
     p->nextFailure = NULL;
+    p->pipePrev = NULL;
     p->nextCmdLink = LINK_NONE;
+    p->startTime = 0;
+
+    // Commande ordinaire
+    p->group = GROUP_NONE;
+    p->elided = 0;
+    p->groupEnd = NULL;
+    p->stage = NULL;
+
+    // Delai par defaut
+    p->timeout = 0;
+    p->timeoutSignal = SIGTERM;
+    p->timeoutKillAfter = -1;
+    p->deadline = 0;
+    p->expired = 0;
+
+    // Pas de diffusion
+    p->fanoutCount = 0;
+
+    // Pas encore executee, pas de ressources consommees
+    p->executed = 0;
+    memset( &p->usage, 0, sizeof( p->usage ) );
+
+    // Pas de pipe en entree
+    p->pipeSource = NULL;
+
+    // Destruction de l'eventuelle fonction definie par la commande, si elle n'a pas ete enregistree, et de
+    // l'eventuelle ligne re-executee par la builtin 'watch'
+    releaseFunction( p->funcDef );
+    p->funcDef = NULL;
+    releaseFunction( p->watchBody );
+    p->watchBody = NULL;
+
+    // Arguments deja traites
+    p->source = NULL;
 
     return 0;
 }
@@ -182,187 +707,182 @@ int initCmd( cmd_t* p )
 
 int parseCmd( char* tokens[], cmd_t* cmds, int* cmdCount )
 {
-    // Commande courante
-    cmd_t* current = NULL;
-
-    // Commande precedant la commande courante
-    cmd_t* previous = NULL;
-
-    // Premiere commande d'un enchainement conditionnel de commandes (pipe ou operateurs logiques)
-    cmd_t* sequenceStart = NULL;
-
     // Aucune commande au depart
     *cmdCount = 0;
 
-    // Dernier separateur rencontre et type correspondant. On considere ici que les types de separateurs
-    // qui marque vraiment une fin de commande (donc pas les redirections ni les executions en background)
-    char lastSep[4] = {'\0'};
-    int lastSepType = SEP_NONE;
-
-    // Index de l'argument courant de la commande courante
-    int iArg = 0;
+    // Commandes de la ligne (referencees par les processus d'execution des groupes)
+    lineCmds = cmds;
 
-    // Pointeur sur le token courant
+    // Analyse de la ligne de commande, a partir du premier token
     char** pToken = tokens;
+    const int status = parseCmdList( &pToken, cmds, cmdCount, NULL );
+    lineCmdCount = *cmdCount;
 
-    // Tant qu'on a un token courant
-    while( *pToken != NULL )
-    {
-        // Si on est sur un separateur
-        const int sepType = isSeparator( *pToken );
-        if( sepType != SEP_NONE )
-        {
-            // Si pas de commande courante, erreur
-            if( current == NULL ) return( CMD_BAD_SEP );
+    return( status );
+}
 
-            // Si le separateur est l'execution en background
-            if( sepType == SEP_BACKGROUND )
-            {
-                // On met a jour la commande
-                current->wait = 0;
-            }
 
-            // Si le separateur est une redirection
-            else if( sepType == SEP_REDIRECT )
-            {
-                // On recupere le separateur et le token suivant, qui doit donner le fichier de redirection
-                const char* sep = *pToken++;
-                const char* fileName = *pToken;
+int execCmd( cmd_t* cmd )
+{
+    // Commande supprimee par l'optimisation du plan d'execution (son code de retour est deja connu)
+    if( cmd->elided ) return( CMD_OK );
 
-                // On traite la redirection
-                const int status = processCmdRedirection( sep, current, fileName );
-                if( status != CMD_OK ) return( status );
-            }
+    // Commande du corps d'une fonction : ses arguments sont d'abord traites
+    if( cmd->source != NULL ) return( execBodyCmd( cmd ) );
 
-            // Sinon, pour tout autre type de separateur
-            else
-            {
-                // La commande courante est terminee et devient la commande precedente
-                previous = current;
-                current = NULL;
+    // Debut de l'execution de la commande
+    cmd->executed = 1;
 
-                // Mise a jour du dernier (vrai) separateur rencontre
-                strcpy( lastSep, *pToken );
-                lastSepType = sepType;
-            }
-        }
+    // Definition d'une fonction : la fonction est enregistree (a la place de l'eventuelle fonction de meme nom)
+    if( cmd->funcDef != NULL )
+    {
+        defineFunction( cmd->funcDef );
+        cmd->funcDef = NULL;
+        cmd->status = 0;
+        return( CMD_OK );
+    }
 
-        // Sinon, on est sur un argument de la commande courante
-        else
-        {
-            // Si pas de commande courante, on debute une nouvelle commande
-            if( current == NULL )
-            {
-                // Une commande supplementaire
-                ++( *cmdCount );
+    // Commande sans arguments (variables vides) : il n'y a rien a executer
+    if( cmd->argc == 0 && cmd->group == GROUP_NONE )
+    {
+        cmd->status = 0;
+        return( CMD_OK );
+    }
 
-                // Si on a une commande precedente, on prend la suivante (dans le tableau),
-                // sinon la toute premiere
-                current = ( previous != NULL ? previous + 1 : cmds );
+    // Les fonctions sont prioritaires sur les builtins (y compris 'timeout' et 'exit') et sur les programmes
+    Function* function = ( cmd->group == GROUP_NONE ? findFunction( cmd->path ) : NULL );
 
-                // Si on a une commande precedente
-                if( previous != NULL )
-                {
-                    // Suivant le type du dernier separateur
-                    switch( lastSepType )
-                    {
-                        // Simple separateur
-                        case SEP_SIMPLE:
-                            // La commande precedente est chainee inconditionnellement avec la nouvelle commande
-                            previous->next = current;
-                            previous->nextCmdLink = LINK_NEXT;
-
-                            // Si on a un sequence interruptible de commandes en cours
-                            if( sequenceStart != NULL )
-                            {
-                                // On met a jour les enchainements de commande dans la sequence (la commande
-                                // courante etant la premiere commande apres la sequence)
-                                updateCmdChaining( sequenceStart, current );
-
-                                // Pas de sequence interruptible de commandes en cours
-                                sequenceStart = NULL;
-                            }
-                            break;
-
-                        // Pipe
-                        case SEP_PIPE:
-                            // La commande precedente est chainee en cas de succes avec la nouvelle commande.
-                            previous->nextSuccess = current;
-                            previous->nextCmdLink = LINK_PIPE;
-
-                            // Creation du pipe entre la commande precedente et la nouvelle commande
-                            const int status = createPipe( previous, current );
-                            if( status != CMD_OK ) return( status );
-
-                            // S'il n'y a pas de sequence interruptible de commandes en cours, on l'initialise
-                            if( sequenceStart == NULL ) sequenceStart = previous;
-                            break;
-
-                        // Operateur logique
-                        case SEP_LOGICAL:
-                            // Si ET logique, les 2 commandes doivent reussir
-                            if( strcmp( lastSep, "&&" ) == 0 )
-                            {
-                                // La commande precedente est chainee en cas de succes avec la nouvelle commande
-                                previous->nextSuccess = current;
-                                previous->nextCmdLink = LINK_AND;
-                            }
+    // Builtin 'timeout' : la commande a executer (eventuellement une fonction) est precedee de son delai
+    if( function == NULL && strcmp( cmd->path, "timeout" ) == 0 )
+    {
+        if( parseTimeout( cmd ) != DEADLINE_OK )
+        {
+            cmd->status = DEADLINE_BAD_ARGS;
+            return( CMD_OK );
+        }
+        function = findFunction( cmd->path );
+    }
 
-                            // Si OU logique, on n'execute la commande suivante qui si la precedente a echoue
-                            else if( strcmp( lastSep, "||" ) == 0 )
-                            {
-                                // La commande precedente est chainee en cas de d'echec avec la nouvelle commande
-                                previous->nextFailure = current;
-                                previous->nextCmdLink = LINK_OR;
-                            }
+    // On traite eventuellement la commande 'exit' qui termine le minishell (et qui doit etre executee
+    // dans le processus parent)
+    if( function == NULL && strcmp( cmd->path, "exit" ) == 0 )
+    {
+        // Dans le processus d'execution d'un groupe, seul ce processus se termine
+        if( inGroupProcess ) _exit( 0 );
 
-                            // S'il n'y a pas de sequence interruptible de commandes en cours, on l'initialise
-                            if( sequenceStart == NULL ) sequenceStart = previous;
-                            break;
+        // Dans une application qui integre le moteur, seule la ligne de commande se termine
+        if( embeddedExec )
+        {
+            lineExited = 1;
+            cmd->status = 0;
+            return( CMD_OK );
+        }
 
-                        // Type de separateur non-prevu
-                        default:
-                            assert( 0 && "Type de separateur non-prevu" );
-                    }
-                }
+        // On termine le minishell (apres une derniere ecriture des metriques)
+        writeMetrics();
+        printf( "Bye bye!\n" );
+        _exit( 0 );
+    }
 
-                // On recopie le nom de la commande (premier argument)
-                iArg = 0;
-                strcpy( current->path, *pToken );
-            }
+    // Les builtins qui modifient l'etat du minishell, les groupes '{ ... ; }' et les appels de fonctions
+    // s'executent dans son processus, sauf s'ils font partie d'un pipeline ou sont lances en background (ou, pour
+    // une fonction, s'ils ont un delai a faire respecter)
+    const int inPipeline = ( cmd->pipePrev != NULL || cmd->nextCmdLink == LINK_PIPE );
+    const int inShell = ( function != NULL ? cmd->timeout == 0 :
+                          isShellBuiltin( cmd->path ) || cmd->group == GROUP_CURRENT );
+    if( inShell && cmd->wait && ! inPipeline )
+    {
+        recordCommandSpawn( cmd->path );
+        cmd->startTime = getMetricsTime();
+        const int wasLast = lastInProcess;
+        lastInProcess = ( wasLast && cmd->next == NULL && cmd->nextSuccess == NULL && cmd->nextFailure == NULL );
+        const int status = execInShell( cmd, function );
+        lastInProcess = wasLast;
+        recordCommand( cmd->path, cmd->startTime, W_EXITCODE( cmd->status, 0 ), NULL );
+        return( status );
+    }
 
-            // On rajoute le token dans la liste des arguments de la commande courante
-            current->argv[iArg] = (char*)malloc( ( strlen( *pToken ) + 1 ) * sizeof( char ) );
-            strcpy( current->argv[iArg++], *pToken );
-        }
+    // Les etapes simples d'un pipeline au premier plan s'executent dans un thread du minishell
+    if( canRunStage( cmd ) ) return( execStage( cmd ) );
 
-        // Token suivant
-        ++pToken;
+    // Un nouveau job en background attend qu'un emplacement se libere (nombre de jobs en cours, charge)
+    if( isJobStart( cmd ) && waitJobSlot() != JOBS_OK )
+    {
+        fprintf( stderr, "ERREUR - Impossible d'attendre la fin des commandes en background\n" );
     }
 
-    return 0;
-}
-
+    // Capture eventuelle des sorties d'une commande en background (les etapes intermediaires d'un pipeline
+    // en background ecrivent dans leur pipe)
+    int captureIn = -1;
+    int captureFd = -1;
+    if( ! cmd->wait && cmd->nextCmdLink != LINK_PIPE && getOption( OPTION_BG_CAPTURE ) )
+    {
+        captureFd = openCaptureOutput( cmd, &captureIn );
+    }
 
-int execCmd( cmd_t* cmd )
-{
-    // On traite eventuellement la commande 'exit' qui termine le minishell (et qui doit etre executee
-    // dans le processus parent)
-    if( strcmp( cmd->path, "exit" ) == 0 )
+    // Sorties restantes d'une commande en background (ou d'une etape d'un pipeline en background) eventuellement
+    // detournees de celles du minishell (une commande de diffusion n'utilise pas sa sortie standard)
+    const cmd_t* jobLast = cmd;
+    while( jobLast->nextCmdLink == LINK_PIPE && jobLast->nextSuccess != NULL ) jobLast = jobLast->nextSuccess;
+    if( ! jobLast->wait && bgOutputFd != -1 )
     {
-        // On termine le minishell
-        printf( "Bye bye!\n" );
-        _exit( 0 );
+        if( cmd->out == -1 && cmd->fanoutCount == 0 ) cmd->out = bgOutputFd;
+        if( cmd->err == -1 ) cmd->err = bgOutputFd;
     }
 
-    // Creation d'un nouveau processus
-    cmd->pid = fork();
+    // Decoupage eventuel en plusieurs invocations d'une commande externe dont les arguments sont trop longs
+    const int batched = ( getOption( OPTION_ARG_BATCH ) && ! isBuiltin( cmd->path ) && function == NULL &&
+                          cmd->group == GROUP_NONE && getArgsSize( cmd->argv ) > getArgsLimit() );
+
+    // Dans le processus d'execution d'un groupe, la derniere commande du groupe s'execute directement dans ce
+    // processus, s'il n'a plus rien d'autre a faire que d'attendre sa terminaison (groupes englobants compris)
+    const int inPlace = ( lastInProcess && cmd->wait && ! inPipeline && captureFd == -1 &&
+                          cmd->next == NULL && cmd->nextSuccess == NULL && cmd->nextFailure == NULL );
+
+    // Creation d'un nouveau processus. Si le zygote est actif, les commandes externes sont lancees par
+    // le zygote (les builtins, les groupes, les fonctions, les commandes decoupees et celles dont les arguments
+    // sont trop longs pour une demande au zygote doivent en revanche s'executer dans un processus fils du
+    // minishell, tout comme les commandes qui utilisent d'autres descripteurs que l'entree/sortie/erreur
+    // standards, que le zygote ne connait pas)
+    recordCommandSpawn( cmd->path );
+    cmd->startTime = getMetricsTime();
+    startDeadline( cmd );
+    const int64_t spawnStart = getReplayTime();
+    const int stubbed = ( getOption( OPTION_STUB_EXEC ) && ! isBuiltin( cmd->path ) && function == NULL &&
+                          cmd->group == GROUP_NONE );
+    if( inPlace )
+    {
+        // Le processus courant tient lieu de processus fils
+        cmd->pid = 0;
+    }
+    else if( ! isBuiltin( cmd->path ) && function == NULL && cmd->group == GROUP_NONE && cmd->fanoutCount == 0 &&
+             ! batched && ! stubbed && cmd->fddupCount == 0 && shellFds == 0 && embeddedEnv == NULL &&
+             zygoteCanSpawn( cmd->argv ) )
+    {
+        const int stdFds[3] =
+        {
+            cmd->in != -1 ? cmd->in : STDIN_FILENO,
+            cmd->out != -1 ? cmd->out : STDOUT_FILENO,
+            cmd->err != -1 ? cmd->err : STDERR_FILENO
+        };
+        cmd->pid = zygoteSpawn( cmd->argv, stdFds, inPipeline ? getPipeStage( cmd ) : -1, ! cmd->wait );
+    }
+    else
+    {
+        cmd->pid = fork();
+    }
 
     // Suivant le PID
     switch( cmd->pid )
     {
         // Erreur
         case -1:
+            if( captureFd != -1 )
+            {
+                close( captureIn );
+                close( captureFd );
+            }
+            recordCommandError( cmd->path, CMD_FORK_FAILED );
             return( CMD_FORK_FAILED );
             break;
 
@@ -373,26 +893,52 @@ int execCmd( cmd_t* cmd )
             if( cmd->out != -1 ) dup2( cmd->out, STDOUT_FILENO );
             if( cmd->err != -1 ) dup2( cmd->err, STDERR_FILENO );
 
-            // Fermeture des fichiers/pipes ouverts
+            // Duplications de descripteurs, dans l'ordre de la ligne de commande
+            for( int i = 0; i < cmd->fddupCount; ++i ) duplicateFd( cmd->fddup[i][0], cmd->fddup[i][1] );
+
+            // Fermeture des fichiers/pipes ouverts, et des descripteurs des etapes executees dans des threads
             closeCmdFiles( cmd );
+            closeStageFds();
+
+            // Environnement fourni par l'application qui integre le moteur
+            if( embeddedEnv != NULL ) environ = embeddedEnv;
+
+            // Si la commande fait partie d'un pipeline, placement eventuel de l'etape sur son propre coeur
+            if( inPipeline ) pinPipeStage( getPipeStage( cmd ) );
+
+            // Si la commande est un groupe, ses commandes s'executent dans ce processus
+            if( cmd->group != GROUP_NONE ) _exit( execGroupProcess( cmd ) );
+
+            // Si la commande est un appel de fonction, le corps de la fonction s'execute dans ce processus
+            if( function != NULL ) _exit( execFunctionProcess( cmd, function ) );
+
+            // Si la commande est une diffusion vers plusieurs pipelines, ce processus copie les donnees
+            if( cmd->fanoutCount > 0 ) _exit( runFanout( cmd ) );
 
             // Si la commande a executer est builtin
             if( isBuiltin( cmd->path ) )
             {
                 // Appel de la fonction builtin
                 const int status = execBuiltin( cmd );
-                if( status == BUILTIN_NOT_FOUND ) return( CMD_NOT_FOUND );
+                if( status == BUILTIN_NOT_FOUND ) _exit( CMD_NOT_FOUND );
 
-                // Mise a jour du code de retour de la commande
-                cmd->status = status;
+                // Le processus fils se termine avec le code de retour de la commande
+                _exit( status );
             }
             else
             {
+                // Commande externe remplacee par un processus qui se termine aussitot (rejeu sans effet de bord)
+                if( stubbed ) _exit( 0 );
+
+                // Si les arguments sont trop longs, la commande est executee en plusieurs invocations
+                if( batched ) _exit( execBatches( cmd ) );
+
                 // Execution du binaire de la commande
                 execvp( cmd->path, cmd->argv );
 
-                // Ici, on a forcement une erreur d'execution
+                // Ici, on a forcement une erreur d'execution (signalee aux metriques)
                 fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", cmd->path );
+                reportExecFailure();
 
                 // On force la terminaison du processus fils
                 _exit( CMD_EXEC_FAILED );
@@ -402,10 +948,25 @@ int execCmd( cmd_t* cmd )
         // Processus pere
         default:
             //printf( "INFO - Executing cmd %s (PID = %d)...\n", cmd->path, cmd->pid );
+            recordReplaySample( REPLAY_SPAWN, spawnStart );
+
+            // On ferme les eventuels pipes ouvert, ainsi que ceux des commandes d'un groupe (qui sont utilises par
+            // le processus d'execution du groupe)
+            closeCmdPipe( cmd );
+            if( cmd->group != GROUP_NONE )
+            {
+                for( cmd_t* inner = cmd + 1; inner < cmd->groupEnd; ++inner ) closeCmdPipe( inner );
+            }
+
+            // L'entree de l'eventuel pipe de capture n'est utilisee que par la commande
+            if( captureIn != -1 ) close( captureIn );
 
-            // On ferme les eventuels pipes ouvert
-            if( cmd->fdpipe[0] != -1 ) close( cmd->fdpipe[0] );
-            if( cmd->fdpipe[1] != -1 ) close( cmd->fdpipe[1] );
+            // Si la commande ecrit dans un pipe, elle s'execute en parallele de la commande suivante du pipeline
+            // (qui sera attendue a sa place)
+            if( cmd->nextCmdLink == LINK_PIPE )
+            {
+                return( CMD_OK );
+            }
 
             // Si la commande s'execute au premier plan
             if( cmd->wait )
@@ -413,24 +974,34 @@ int execCmd( cmd_t* cmd )
                 // On se synchronise avec la fin du processus d'execution de la commande
                 //printf( "INFO - Waiting for process %d to complete...\n", cmd->pid );
                 int status = 0;
-                if( waitpid( cmd->pid, &status, 0 ) == -1 )
+                struct rusage usage;
+                if( waitCmdProcess( cmd, &status, &usage ) == -1 )
                 {
                     fprintf( stderr, "Impossible de se synchroniser avec la fin de la commande %s (PID = %d)\n",
                              cmd->path, cmd->pid );
+                    recordCommandError( cmd->path, CMD_WAIT_FAILED );
                     return( CMD_WAIT_FAILED );
                 }
 
                 // On met a jour le code de retour de la commande
                 cmd->status = WEXITSTATUS( status );
+                recordCommand( cmd->path, cmd->startTime, status, &usage );
+
+                // On se synchronise egalement avec les commandes precedentes du pipeline
+                waitPipeline( cmd );
                 //printf( "INFO - Process %d has exited with code %d\n", cmd->pid, cmd->status );
             }
             else
             {
                 // On enregistre la commande en background
-                const BgCmd* bgCmd = addBgCmd( cmd );
+                const BgCmd* bgCmd = addBgCmd( cmd, captureFd );
+
+                // Les sorties eventuellement produites avant l'enregistrement sont recuperees
+                if( captureFd != -1 ) drainBgCmdOutputs();
 
-                // On affiche le numero et le PID de la nouvelle commande en background
-                printf( "[%d] %d\n", bgCmd->number, bgCmd->pid );
+                // On affiche le numero et le PID de la nouvelle commande en background (sauf sur la sortie d'une
+                // application qui integre le moteur)
+                if( ! embeddedExec ) printf( "[%d] %d\n", bgCmd->number, bgCmd->pid );
             }
             break;
     }
@@ -439,6 +1010,92 @@ int execCmd( cmd_t* cmd )
 }
 
 
+int execCmdList( cmd_t* first )
+{
+    // Code de retour de la derniere commande executee
+    int status = 0;
+
+    // Execution des commandes dans l'ordre etabli lors du parsing
+    cmd_t* current = first;
+    while( current != NULL && ! lineExited )
+    {
+        // Execution de la commande courante
+        const int execStatus = execCmd( current );
+        if( execStatus != CMD_OK )
+        {
+            fprintf( stderr, "ERREUR - Erreur d'exécution [code = %d]\n", execStatus );
+        }
+
+        // Code de retour de la derniere commande executee
+        status = current->status;
+
+        // Sorties des commandes en background arrivees pendant l'execution
+        pollBgCmdOutputs();
+
+        // Passage a la commande suivante
+        current = nextCmd( current );
+    }
+
+    return( status );
+}
+
+
+int execWatchBody( const cmd_t* cmd )
+{
+    // Le corps est re-execute : aucune de ses commandes ne peut remplacer le processus courant
+    const int wasLast = lastInProcess;
+    lastInProcess = 0;
+    const int status = callFunction( cmd, cmd->watchBody );
+    lastInProcess = wasLast;
+
+    return( status );
+}
+
+
+void setEmbeddedExec( int embedded, char** env )
+{
+    embeddedExec = embedded;
+    embeddedEnv = env;
+    lineExited = 0;
+}
+
+
+int isEmbeddedExec( void )
+{
+    return( embeddedExec );
+}
+
+
+void setBgCmdOutput( int fd )
+{
+    bgOutputFd = fd;
+}
+
+
+void setDryRunParse( int dryRun )
+{
+    // Les noms memorises lors de la precedente analyse a blanc sont oublies au debut d'une nouvelle
+    if( dryRun )
+    {
+        for( int i = 0; i < dryRunFileCount; ++i ) memFree( dryRunFiles[i] );
+        dryRunFileCount = 0;
+    }
+    dryRunParse = dryRun;
+}
+
+
+const char* getDryRunFile( int fd )
+{
+    // Recherche du descripteur parmi les fichiers remplaces
+    for( int i = 0; i < dryRunFileCount; ++i )
+    {
+        if( dryRunFds[i] == fd ) return( dryRunFiles[i] );
+    }
+
+    return( NULL );
+}
+
+
 BgCmd* removeBgCmd( pid_t pid )
 {
     // Recherche de la commande avec le meme PID
@@ -492,6 +1149,100 @@ BgCmd* removeBgCmd( pid_t pid )
 }
 
 
+BgCmd* endBgCmd( pid_t pid, int status, const struct rusage* usage )
+{
+    // Recherche de la commande avec le meme PID
+    BgCmd* bgCmd = backgroundCommands;
+    while( bgCmd != NULL && bgCmd->pid != pid ) bgCmd = bgCmd->next;
+    if( bgCmd == NULL ) return( NULL );
+
+    // Metriques de la commande
+    recordCommand( bgCmd->path, bgCmd->startTime, status, usage );
+    recordBgCmdReaped();
+
+    // Mise a jour de la commande
+    bgCmd->finished = 1;
+    bgCmd->exitStatus = WEXITSTATUS( status );
+
+    // Recuperation des dernieres sorties, puis fermeture du pipe de capture
+    if( bgCmd->outputFd != -1 )
+    {
+        fillRingBuffer( bgCmd->output, bgCmd->outputFd );
+        close( bgCmd->outputFd );
+        bgCmd->outputFd = -1;
+    }
+
+    return( bgCmd );
+}
+
+
+BgCmd* findBgCmd( int number )
+{
+    // Recherche de la commande avec le meme numero
+    BgCmd* bgCmd = backgroundCommands;
+    while( bgCmd != NULL && bgCmd->number != number ) bgCmd = bgCmd->next;
+
+    return( bgCmd );
+}
+
+
+const BgCmd* getBgCmds( void )
+{
+    return( backgroundCommands );
+}
+
+
+void freeBgCmd( BgCmd* bgCmd )
+{
+    if( bgCmd == NULL ) return;
+
+    // Fermeture de l'eventuel pipe de capture et liberation du buffer
+    if( bgCmd->outputFd != -1 ) close( bgCmd->outputFd );
+    freeRingBuffer( bgCmd->output );
+    memFree( bgCmd );
+}
+
+
+void drainBgCmdOutputs( void )
+{
+    // Les signaux recus jusqu'ici sont traites
+    bgOutputSeen = __atomic_load_n( &bgOutputSignals, __ATOMIC_ACQUIRE );
+
+    // Pour chaque commande dont le pipe de capture est encore ouvert
+    for( BgCmd* bgCmd = backgroundCommands; bgCmd != NULL; bgCmd = bgCmd->next )
+    {
+        if( bgCmd->outputFd == -1 ) continue;
+
+        // Lecture sans attente des donnees disponibles. A la fermeture du pipe (fin de la commande et de
+        // ses eventuels descendants), il est inutile de le surveiller davantage.
+        if( fillRingBuffer( bgCmd->output, bgCmd->outputFd ) )
+        {
+            close( bgCmd->outputFd );
+            bgCmd->outputFd = -1;
+        }
+    }
+}
+
+
+void pollBgCmdOutputs( void )
+{
+    if( __atomic_load_n( &bgOutputSignals, __ATOMIC_ACQUIRE ) != bgOutputSeen ) drainBgCmdOutputs();
+}
+
+
+int moveShellFd( int fd )
+{
+    // Rien a faire si le descripteur est deja au-dela des descripteurs des redirections
+    if( fd < 0 || fd >= MAX_CMD_FD ) return( fd );
+
+    // Copie du descripteur, et fermeture de l'original
+    const int newFd = fcntl( fd, F_DUPFD_CLOEXEC, MAX_CMD_FD );
+    close( fd );
+
+    return( newFd );
+}
+
+
 void printCmd( const cmd_t* cmd )
 {
     // Affichage de champs de la commande
@@ -499,12 +1250,15 @@ void printCmd( const cmd_t* cmd )
     printf( "  + in/out/err  = %d/%d/%d\n", cmd->in, cmd->out, cmd->err );
     printf( "  + argv        = " );
     int i = 0;
-    while( cmd->argv[i] != NULL ) printf( "'%s' ", cmd->argv[i++] );
+    for( i = 0; i < cmd->argc; ++i ) printf( "'%s' ", cmd->argv[i] );
     printf( "\n" );
     printf( "  + fdclose     = " );
     i = 0;
     while( cmd->fdclose[i] != -1 ) printf( "%d ", cmd->fdclose[i++] );
     printf( "\n" );
+    printf( "  + fddup       = " );
+    for( i = 0; i < cmd->fddupCount; ++i ) printf( "%d<-%d ", cmd->fddup[i][0], cmd->fddup[i][1] );
+    printf( "\n" );
     printf( "  + fpipe       = " );
     if( cmd->fdpipe[0] != -1 ) printf( "%d ", cmd->fdpipe[0] );
     if( cmd->fdpipe[1] != -1 ) printf( "%d ", cmd->fdpipe[1] );
@@ -518,122 +1272,611 @@ void printCmd( const cmd_t* cmd )
 
 //--- Implementation des fonctions locales ---------------------------------------------------------------------
 
-static int isSeparator( const char* token )
+static int parseCmdList( char*** position, cmd_t* cmds, int* cmdCount, const char* closing )
 {
-    // Liste des separateurs de commandes supportes, tries par type
-    static char* SEPS_SIMPLE[] = { ";", NULL };
-    static char* SEPS_REDIRECT[] = { "<", ">", "1>", ">>", "1>>", "2>", "2>>", "&>", "&>>", NULL };
-    static char* SEPS_LOGICAL[] = { "&&", "||", NULL };
-    static char* SEPS_PIPE[] = { "|", NULL };
-    static char* SEPS_BACKGROUND[] = { "&", NULL };
-    static char** ALL_SEPS[SEP_LAST] =
-    {
-        SEPS_SIMPLE,
-        SEPS_REDIRECT,
-        SEPS_LOGICAL,
-        SEPS_PIPE,
-        SEPS_BACKGROUND
-    };
+    // Commande courante
+    cmd_t* current = NULL;
 
-    // Pour chaque type de separateurs de commandes
-    for( int type = SEP_SIMPLE; type < SEP_LAST; ++type )
-    {
-        // Pour chaque separateur correspondant au type
-        char** sep = ALL_SEPS[type];
-        while( *sep != NULL )
-        {
-            // Si le token correspond
-            if( strcmp( token, *sep ) == 0 )
-            {
-                // Test positif, on retourne le type du separateur
-                return( type );
-            }
+    // Commande precedant la commande courante
+    cmd_t* previous = NULL;
 
-            // Separateur suivant
-            ++sep;
-        }
-    }
+    // Premiere commande d'un enchainement conditionnel de commandes (pipe ou operateurs logiques)
+    cmd_t* sequenceStart = NULL;
 
-    // Test negatif
-    return( SEP_NONE );
-}
+    // Dernier separateur rencontre et type correspondant. On considere ici que les types de separateurs
+    // qui marque vraiment une fin de commande (donc pas les redirections ni les executions en background)
+    char lastSep[4] = {'\0'};
+    int lastSepType = SEP_NONE;
 
+    // Commande de diffusion ('|+') en cours : les pipelines suivants introduits par '|+' sont alimentes par
+    // cette meme commande
+    cmd_t* fanout = NULL;
 
-static int processCmdRedirection( const char* sep, cmd_t* cmd, const char* fileName )
+    // Pointeur sur le token courant
+    char** pToken = *position;
+
+    // Tant qu'on a un token courant
+    while( *pToken != NULL )
+    {
+        // Si on est sur la fin du groupe en cours d'analyse : ")" termine toujours un sous-shell, alors que "}"
+        // n'est reconnu qu'a la place d'une commande (ailleurs, c'est un argument ordinaire)
+        if( closing != NULL && strcmp( *pToken, closing ) == 0 && ( current == NULL || *closing == ')' ) )
+        {
+            // Le groupe ne peut pas etre vide, ni se terminer par un separateur autre que ";"
+            if( current == NULL && ( previous == NULL || lastSepType != SEP_SIMPLE ) ) return( CMD_BAD_SEP );
+
+            // Le token de fin est traite par l'appelant
+            *position = pToken;
+            return( CMD_OK );
+        }
+
+        // Une fin de sous-shell qui ne correspond a aucun debut est une erreur
+        if( strcmp( *pToken, ")" ) == 0 ) return( CMD_BAD_SEP );
+
+        // Si on est sur un separateur
+        const int sepType = isSeparator( *pToken );
+        if( sepType != SEP_NONE )
+        {
+            // Si pas de commande courante, erreur
+            if( current == NULL ) return( CMD_BAD_SEP );
+
+            // Si le separateur est l'execution en background
+            if( sepType == SEP_BACKGROUND )
+            {
+                // On met a jour la commande
+                current->wait = 0;
+            }
+
+            // Si le separateur est une redirection
+            else if( sepType == SEP_REDIRECT )
+            {
+                // Une definition de fonction n'a pas de redirections
+                if( current->funcDef != NULL ) return( CMD_BAD_SEP );
+
+                // On recupere le separateur et le token suivant, qui doit donner le fichier de redirection
+                const char* sep = *pToken++;
+                const char* fileName = *pToken;
+
+                // On traite la redirection (dans le corps d'une fonction, elle est conservee avec les arguments
+                // bruts, et traitee a chaque execution de la commande)
+                int status = CMD_OK;
+                if( parsingFunction && fileName != NULL )
+                {
+                    status = addRawArg( current, sep );
+                    if( status == CMD_OK ) status = addRawArg( current, fileName );
+                }
+                else
+                {
+                    status = processWordRedirection( sep, current, fileName );
+                }
+                if( status != CMD_OK ) return( status );
+            }
+
+            // Sinon, pour tout autre type de separateur
+            else
+            {
+                // La commande courante est terminee et devient la commande precedente
+                previous = current;
+                current = NULL;
+
+                // Mise a jour du dernier (vrai) separateur rencontre
+                strcpy( lastSep, *pToken );
+                lastSepType = sepType;
+            }
+        }
+
+        // Sinon, on est sur un argument de la commande courante (ou sur le debut d'un groupe)
+        else
+        {
+            // Definition d'une fonction : la commande courante est son nom
+            if( isFunctionDef( current, pToken ) )
+            {
+                const int status = parseFunctionDef( &pToken, current, cmds, cmdCount );
+                if( status != CMD_OK ) return( status );
+
+                // Token suivant (apres la fin du corps)
+                ++pToken;
+                continue;
+            }
+
+            // Ligne re-executee par la builtin 'watch' : la suite de la ligne de commande
+            if( isWatchBody( current, *pToken, closing ) )
+            {
+                const int status = parseWatchBody( &pToken, current, cmds, cmdCount );
+                if( status != CMD_OK ) return( status );
+                continue;
+            }
+
+            // Un debut de groupe n'est reconnu qu'a la place d'une commande, et un groupe (comme une definition de
+            // fonction) n'a pas d'arguments
+            const CmdGroup group = ( current == NULL ? getGroupType( *pToken ) : GROUP_NONE );
+            if( current != NULL &&
+                ( current->group != GROUP_NONE || current->funcDef != NULL || strcmp( *pToken, "(" ) == 0 ) )
+            {
+                return( CMD_BAD_SEP );
+            }
+
+            // Si pas de commande courante, on debute une nouvelle commande
+            if( current == NULL )
+            {
+                // On prend la premiere commande libre du tableau (les commandes d'un groupe sont rangees juste
+                // apres celui-ci, et donc avant la commande qui suit le groupe)
+                current = cmds + ( *cmdCount )++;
+
+                // Si on a une commande precedente
+                if( previous != NULL )
+                {
+                    // Suivant le type du dernier separateur
+                    switch( lastSepType )
+                    {
+                        // Simple separateur
+                        case SEP_SIMPLE:
+                            // La commande precedente est chainee inconditionnellement avec la nouvelle commande
+                            previous->next = current;
+                            previous->nextCmdLink = LINK_NEXT;
+                            fanout = NULL;
+
+                            // Si on a un sequence interruptible de commandes en cours
+                            if( sequenceStart != NULL )
+                            {
+                                // On met a jour les enchainements de commande dans la sequence (la commande
+                                // courante etant la premiere commande apres la sequence)
+                                updateCmdChaining( sequenceStart, current );
+
+                                // Pas de sequence interruptible de commandes en cours
+                                sequenceStart = NULL;
+                            }
+                            break;
+
+                        // Pipe
+                        case SEP_PIPE:
+                            // S'il n'y a pas de sequence interruptible de commandes en cours, on l'initialise
+                            if( sequenceStart == NULL ) sequenceStart = previous;
+
+                            // Diffusion vers un nouveau pipeline
+                            if( strcmp( lastSep, "|+" ) == 0 )
+                            {
+                                const int status = addFanoutBranch( &fanout, previous, &current, cmds, cmdCount );
+                                if( status != CMD_OK ) return( status );
+                                break;
+                            }
+
+                            // La commande precedente est chainee en cas de succes avec la nouvelle commande.
+                            previous->nextSuccess = current;
+                            previous->nextCmdLink = LINK_PIPE;
+
+                            // Creation du pipe entre la commande precedente et la nouvelle commande
+                            const int status = createPipe( previous, current );
+                            if( status != CMD_OK ) return( status );
+                            break;
+
+                        // Operateur logique
+                        case SEP_LOGICAL:
+                            // Fin de l'eventuelle diffusion en cours
+                            fanout = NULL;
+
+                            // Si ET logique, les 2 commandes doivent reussir
+                            if( strcmp( lastSep, "&&" ) == 0 )
+                            {
+                                // La commande precedente est chainee en cas de succes avec la nouvelle commande
+                                previous->nextSuccess = current;
+                                previous->nextCmdLink = LINK_AND;
+                            }
+
+                            // Si OU logique, on n'execute la commande suivante qui si la precedente a echoue
+                            else if( strcmp( lastSep, "||" ) == 0 )
+                            {
+                                // La commande precedente est chainee en cas de d'echec avec la nouvelle commande
+                                previous->nextFailure = current;
+                                previous->nextCmdLink = LINK_OR;
+                            }
+
+                            // S'il n'y a pas de sequence interruptible de commandes en cours, on l'initialise
+                            if( sequenceStart == NULL ) sequenceStart = previous;
+                            break;
+
+                        // Type de separateur non-prevu
+                        default:
+                            assert( 0 && "Type de separateur non-prevu" );
+                    }
+                }
+
+            }
+
+            // Si on est sur le debut d'un groupe
+            if( group != GROUP_NONE )
+            {
+                // Le nom du groupe est utilise pour l'affichage et les metriques
+                current->group = group;
+                strcpy( current->path, group == GROUP_SUBSHELL ? "(...)" : "{...}" );
+
+                // Analyse des commandes du groupe, jusqu'au token de fin du groupe
+                ++pToken;
+                const int status = parseCmdList( &pToken, cmds, cmdCount, group == GROUP_SUBSHELL ? ")" : "}" );
+                if( status != CMD_OK ) return( status );
+                current->groupEnd = cmds + *cmdCount;
+
+                // Token suivant
+                ++pToken;
+                continue;
+            }
+
+            // On rajoute les arguments produits par le token (dans le corps d'une fonction, le token est conserve
+            // brut). Une commande arithmetique "((...))" ne produit qu'un nom et une expression, evaluee a
+            // l'execution.
+            int status = CMD_OK;
+            if( parsingFunction ) status = addRawArg( current, *pToken );
+            else if( current->argc == 0 && isArithCmd( *pToken ) ) status = addArithCmd( current, *pToken );
+            else status = addCmdWord( current, *pToken );
+            if( status != CMD_OK ) return( status );
+
+            // Le nom de la commande est son premier argument
+            if( current->path[0] == '\0' && current->argc > 0 )
+            {
+                snprintf( current->path, MAX_LINE_SIZE, "%s", current->argv[0] );
+            }
+        }
+
+        // Token suivant
+        ++pToken;
+    }
+
+    // Un groupe doit etre termine sur la meme ligne
+    if( closing != NULL ) return( CMD_BAD_SEP );
+
+    *position = pToken;
+    return( CMD_OK );
+}
+
+
+static int isFunctionDef( const cmd_t* cmd, char** tokens )
 {
-    // Flags d'ouverture du fichier (en fonction du type de redirection)
-    int flags = 0;
+    // Commande reduite a un nom
+    if( cmd == NULL || cmd->argc != 1 || cmd->group != GROUP_NONE || cmd->funcDef != NULL ||
+        cmd->fdclose[0] != -1 || cmd->fddupCount != 0 )
+    {
+        return( 0 );
+    }
+
+    // Suivie de "( ) {"
+    return( strcmp( tokens[0], "(" ) == 0 && tokens[1] != NULL && strcmp( tokens[1], ")" ) == 0 &&
+            tokens[2] != NULL && strcmp( tokens[2], "{" ) == 0 );
+}
 
-    // Flags qui donnes les redirections a traiter
-    int redirections[3] = {0, 0, 0};
 
-    // Selon le type de redirection
-    if( strcmp( sep, "<" ) == 0 )
+static int parseFunctionDef( char*** position, cmd_t* cmd, cmd_t* cmds, int* cmdCount )
+{
+    // Pas de definition imbriquee dans le corps d'une fonction
+    if( parsingFunction ) return( CMD_BAD_SEP );
+
+    // Nom de la fonction
+    const char* name = cmd->argv[0];
+    if( ! isValidName( name ) )
     {
-        // Redirection entree standard
-        flags |= O_RDONLY;
-        redirections[REDIRECT_IN] = 1;
+        fprintf( stderr, "ERREUR - Nom de fonction %s invalide\n", name );
+        return( FUNC_BAD_NAME );
     }
-    else if( strcmp( sep, ">" ) == 0 || strcmp( sep, "1>" ) == 0 )
+
+    // Analyse du corps (apres "( ) {"), jusqu'au "}" de fin, en commandes modeles rangees apres la definition
+    char** pToken = *position + 3;
+    const int first = *cmdCount;
+    parsingFunction = 1;
+    int status = parseCmdList( &pToken, cmds, cmdCount, "}" );
+    parsingFunction = 0;
+    if( status != CMD_OK ) return( status );
+
+    // Les commandes modeles sont deplacees dans la fonction : leurs places sont liberees pour la suite de la ligne
+    Function* function = NULL;
+    status = createFunction( name, cmds + first, *cmdCount - first, &function );
+    if( status != FUNC_OK ) return( status );
+    *cmdCount = first;
+
+    // La commande de definition porte le nom de la fonction
+    cmd->funcDef = function;
+    snprintf( cmd->path, MAX_LINE_SIZE, "%s()", function->name );
+
+    *position = pToken;
+    return( CMD_OK );
+}
+
+
+static int isWatchBody( const cmd_t* cmd, const char* token, const char* closing )
+{
+    // Commande 'watch' (une fonction de meme nom est prioritaire), dont la ligne n'a pas encore ete analysee
+    if( cmd == NULL || parsingFunction || closing != NULL || cmd->argc == 0 || cmd->watchBody != NULL ||
+        strcmp( cmd->argv[0], "watch" ) != 0 || findFunction( "watch" ) != NULL )
     {
-        // Redirection sortie standard (ecrasement du fichier)
-        flags |= O_WRONLY | O_CREAT;
-        redirections[REDIRECT_OUT] = 1;
+        return( 0 );
     }
-    else if( strcmp( sep, ">>" ) == 0 || strcmp( sep, "1>>" ) == 0 )
+
+    return( strcmp( token, "--" ) == 0 );
+}
+
+
+static int parseWatchBody( char*** position, cmd_t* cmd, cmd_t* cmds, int* cmdCount )
+{
+    // Analyse de la ligne (apres "--") en commandes modeles, rangees apres la commande 'watch'
+    char** pToken = *position + 1;
+    const int first = *cmdCount;
+    parsingFunction = 1;
+    int status = parseCmdList( &pToken, cmds, cmdCount, NULL );
+    parsingFunction = 0;
+    if( status != CMD_OK ) return( status );
+    if( *cmdCount == first )
     {
-        // Redirection sortie standard (ajout en fin de fichier)
-        flags |= O_WRONLY | O_CREAT | O_APPEND;
-        redirections[REDIRECT_OUT] = 1;
+        fprintf( stderr, "ERREUR - Ligne a re-executer manquante apres 'watch ... --'\n" );
+        return( CMD_BAD_SEP );
     }
-    else if( strcmp( sep, "2>" ) == 0 )
+
+    // Les commandes modeles sont deplacees dans une fonction anonyme, conservee par la commande 'watch'
+    Function* function = NULL;
+    status = createFunction( "watch", cmds + first, *cmdCount - first, &function );
+    if( status != FUNC_OK ) return( status );
+    *cmdCount = first;
+    cmd->watchBody = function;
+
+    *position = pToken;
+    return( CMD_OK );
+}
+
+
+static CmdGroup getGroupType( const char* token )
+{
+    if( strcmp( token, "(" ) == 0 ) return( GROUP_SUBSHELL );
+    if( strcmp( token, "{" ) == 0 ) return( GROUP_CURRENT );
+
+    return( GROUP_NONE );
+}
+
+
+static int isSeparator( const char* token )
+{
+    // Liste des separateurs de commandes supportes, tries par type
+    static char* SEPS_SIMPLE[] = { ";", NULL };
+    static char* SEPS_REDIRECT[] = { NULL };
+    static char* SEPS_LOGICAL[] = { "&&", "||", NULL };
+    static char* SEPS_PIPE[] = { "|", "|+", NULL };
+    static char* SEPS_BACKGROUND[] = { "&", NULL };
+    static char** ALL_SEPS[SEP_LAST] =
     {
-        // Redirection erreur standard (ecrasement du fichier)
-        flags |= O_WRONLY | O_CREAT;
-        redirections[REDIRECT_ERR] = 1;
+        SEPS_SIMPLE,
+        SEPS_REDIRECT,
+        SEPS_LOGICAL,
+        SEPS_PIPE,
+        SEPS_BACKGROUND
+    };
+
+    // Les redirections sont reconnues a part (elles peuvent etre precedees d'un numero de descripteur)
+    if( parseRedirection( token, NULL ) != MODE_NONE ) return( SEP_REDIRECT );
+
+    // Pour chaque type de separateurs de commandes
+    for( int type = SEP_SIMPLE; type < SEP_LAST; ++type )
+    {
+        // Pour chaque separateur correspondant au type
+        char** sep = ALL_SEPS[type];
+        while( *sep != NULL )
+        {
+            // Si le token correspond
+            if( strcmp( token, *sep ) == 0 )
+            {
+                // Test positif, on retourne le type du separateur
+                return( type );
+            }
+
+            // Separateur suivant
+            ++sep;
+        }
     }
-    else if( strcmp( sep, "2>>" ) == 0 )
+
+    // Test negatif
+    return( SEP_NONE );
+}
+
+
+static int processCmdRedirection( const char* sep, cmd_t* cmd, const char* fileName )
+{
+    // Mode de redirection, et descripteur redirige
+    int fd = -1;
+    int mode = parseRedirection( sep, &fd );
+
+    // Le fichier (ou le descripteur) cible doit etre specifie
+    if( fileName == NULL )
     {
-        // Redirection erreur standard (ajout en fin de fichier)
-        flags |= O_WRONLY | O_CREAT | O_APPEND;
-        redirections[REDIRECT_ERR] = 1;
+        fprintf( stderr, "ERREUR - Redirection %s sans fichier\n", sep );
+        return( CMD_BAD_REDIRECTION );
     }
-    else if( strcmp( sep, "&>" ) == 0 )
+
+    // ">&fichier" (sans numero de descripteur, et vers un fichier) est equivalent a "&>fichier" (comme bash)
+    if( mode == MODE_DUP_OUT && sep[0] == '>' && strcmp( fileName, "-" ) != 0 &&
+        ! ( fileName[0] >= '0' && fileName[0] <= '9' && fileName[1] == '\0' ) )
     {
-        // Redirection sortie et erreur standards (ecrasement du fichier)
-        flags |= O_WRONLY | O_CREAT;
-        redirections[REDIRECT_OUT] = 1;
-        redirections[REDIRECT_ERR] = 1;
+        mode = MODE_ALL;
+        fd = -1;
     }
-    else if( strcmp( sep, "&>>" ) == 0 )
+
+    // Duplication d'un descripteur
+    if( mode == MODE_DUP_IN || mode == MODE_DUP_OUT ) return( processFdDuplication( cmd, fd, fileName ) );
+
+    // Flags d'ouverture du fichier (en fonction du mode de redirection)
+    int flags = 0;
+    switch( mode )
     {
-        // Redirection sortie et erreur standards (ajout en fin de fichier)
-        flags |= O_WRONLY | O_CREAT | O_APPEND;
-        redirections[REDIRECT_OUT] = 1;
-        redirections[REDIRECT_ERR] = 1;
+        // Lecture
+        case MODE_READ:
+            flags = O_RDONLY;
+            break;
+
+        // Ecriture (ecrasement du fichier)
+        case MODE_WRITE:
+        case MODE_ALL:
+            flags = O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+
+        // Ecriture (ajout en fin de fichier)
+        default:
+            flags = O_WRONLY | O_CREAT | O_APPEND;
+            break;
     }
 
-    // Ouverture du fichier avec les flags positionne
-    int fd = open( fileName, flags, 0644 );
-    if( fd == -1 )
+    // Ouverture du fichier avec les flags positionne. Le descripteur est ferme automatiquement lors d'un exec : seules
+    // les copies installees via dup2() sur les descripteurs de la commande restent ouvertes dans les programmes
+    // Lors d'une analyse a blanc, le fichier n'est ni cree ni tronque : /dev/null en tient lieu
+    int fileFd = ( dryRunParse ? open( "/dev/null", ( flags & O_ACCMODE ) | O_CLOEXEC ) :
+                                 open( fileName, flags | O_CLOEXEC, 0644 ) );
+    if( fileFd == -1 )
     {
        // Erreur d'ouverture du fichier
        fprintf( stderr, "ERREUR - Echec d'ouverture du fichier %s\n", fileName );
        return( CMD_BAD_REDIRECTION );
     }
 
+    // Redirection d'un autre descripteur que l'entree/sortie/erreur standards, ou redirection qui suit une
+    // duplication (les redirections s'appliquent dans l'ordre de la ligne : "2>&1 >fichier" laisse l'erreur sur
+    // la sortie d'origine) : le fichier est deplace hors des descripteurs utilisables dans les redirections (il ne
+    // doit pas etre ecrase par une autre duplication), puis duplique sur le descripteur cible dans le processus
+    // de la commande, a son rang dans la liste des duplications
+    if( fd > STDERR_FILENO || cmd->fddupCount > 0 )
+    {
+        fileFd = moveShellFd( fileFd );
+        if( fileFd == -1 ) return( CMD_BAD_REDIRECTION );
+        addFileDescriptor( cmd, fileFd );
+        if( dryRunParse ) addDryRunFile( fileFd, fileName );
+        int status = addFdDuplication( cmd, fd != -1 ? fd : STDOUT_FILENO, fileFd );
+        if( status == CMD_OK && fd == -1 ) status = addFdDuplication( cmd, STDERR_FILENO, fileFd );
+        return( status );
+    }
+
     // Mise a jour de la commande (qui de in/out/err doit etre redirigee vers le fichier)
-    if( redirections[REDIRECT_IN] ) cmd->in = fd;
-    if( redirections[REDIRECT_OUT] ) cmd->out = fd;
-    if( redirections[REDIRECT_ERR] ) cmd->err = fd;
+    if( fd == STDIN_FILENO ) cmd->in = fileFd;
+    if( fd == STDOUT_FILENO || fd == -1 ) cmd->out = fileFd;
+    if( fd == STDERR_FILENO || fd == -1 ) cmd->err = fileFd;
 
     // Ajout du file descriptor dans la liste des fichiers a fermer par la commande
-    addFileDescriptor( cmd, fd );
+    addFileDescriptor( cmd, fileFd );
+    if( dryRunParse ) addDryRunFile( fileFd, fileName );
 
     return( CMD_OK );
 }
 
 
+static int processWordRedirection( const char* sep, cmd_t* cmd, const char* word )
+{
+    // Sans variable, le mot est directement le fichier cible
+    if( word == NULL || strchr( word, '$' ) == NULL ) return( processCmdRedirection( sep, cmd, word ) );
+
+    // Substitution des expansions et variables du mot
+    char fileName[MAX_LINE_SIZE];
+    snprintf( fileName, MAX_LINE_SIZE, "%s", word );
+    const int status = expandParams( fileName );
+    if( status != PARAM_OK ) return( status );
+
+    return( processCmdRedirection( sep, cmd, fileName ) );
+}
+
+
+static int parseRedirection( const char* sep, int* fd )
+{
+    // Operateurs de redirection, avec le mode et le descripteur redirige par defaut correspondants
+    static const struct { const char* op; int mode; int fd; } OPERATORS[] =
+    {
+        { "<", MODE_READ, STDIN_FILENO },
+        { ">", MODE_WRITE, STDOUT_FILENO },
+        { ">>", MODE_APPEND, STDOUT_FILENO },
+        { "<&", MODE_DUP_IN, STDIN_FILENO },
+        { ">&", MODE_DUP_OUT, STDOUT_FILENO },
+        { "&>", MODE_ALL, -1 },
+        { "&>>", MODE_ALL_APPEND, -1 }
+    };
+
+    // Numero eventuel du descripteur redirige (un seul chiffre)
+    int sepFd = -1;
+    if( sep[0] >= '0' && sep[0] <= '9' ) sepFd = *sep++ - '0';
+
+    // Recherche de l'operateur
+    for( size_t i = 0; i < sizeof( OPERATORS ) / sizeof( OPERATORS[0] ); ++i )
+    {
+        if( strcmp( sep, OPERATORS[i].op ) != 0 ) continue;
+
+        // Les redirections de la sortie et de l'erreur standards ne peuvent pas avoir de numero de descripteur
+        if( sepFd != -1 && OPERATORS[i].fd == -1 ) return( MODE_NONE );
+
+        if( fd != NULL ) *fd = ( sepFd != -1 ? sepFd : OPERATORS[i].fd );
+        return( OPERATORS[i].mode );
+    }
+
+    // Pas une redirection
+    return( MODE_NONE );
+}
+
+
+static int processFdDuplication( cmd_t* cmd, int target, const char* word )
+{
+    // Fermeture du descripteur cible
+    if( strcmp( word, "-" ) == 0 ) return( addFdDuplication( cmd, target, FD_CLOSED ) );
+
+    // Sinon, le descripteur source doit etre un chiffre
+    if( word[0] < '0' || word[0] > '9' || word[1] != '\0' )
+    {
+        fprintf( stderr, "ERREUR - Descripteur de fichier %s invalide\n", word );
+        return( CMD_BAD_REDIRECTION );
+    }
+
+    // Au-dela de l'entree/sortie/erreur standards, le descripteur source doit avoir ete ouvert par la builtin
+    // 'exec', ou par une redirection precedente de la commande
+    const int source = word[0] - '0';
+    if( source > STDERR_FILENO && ! ( shellFds & ( 1 << source ) ) && ! isFdDuplicationTarget( cmd, source ) )
+    {
+        fprintf( stderr, "ERREUR - Descripteur de fichier %d non ouvert\n", source );
+        return( CMD_BAD_REDIRECTION );
+    }
+
+    return( addFdDuplication( cmd, target, source ) );
+}
+
+
+static int addFdDuplication( cmd_t* cmd, int target, int source )
+{
+    // Nombre de duplications limite
+    if( cmd->fddupCount == MAX_FD_DUPS )
+    {
+        fprintf( stderr, "ERREUR - Trop de redirections pour la commande %s\n", cmd->path );
+        return( CMD_BAD_REDIRECTION );
+    }
+
+    // Ajout de la duplication en fin de liste
+    cmd->fddup[cmd->fddupCount][0] = target;
+    cmd->fddup[cmd->fddupCount][1] = source;
+    ++cmd->fddupCount;
+
+    return( CMD_OK );
+}
+
+
+static int isFdDuplicationTarget( const cmd_t* cmd, int fd )
+{
+    // Recherche du descripteur parmi les cibles
+    for( int i = 0; i < cmd->fddupCount; ++i )
+    {
+        if( cmd->fddup[i][0] == fd ) return( 1 );
+    }
+
+    return( 0 );
+}
+
+
+static void duplicateFd( int target, int source )
+{
+    // Fermeture
+    if( source == FD_CLOSED ) close( target );
+
+    // Descripteur duplique sur lui-meme : il doit seulement rester ouvert lors d'un exec
+    else if( source == target ) fcntl( target, F_SETFD, 0 );
+
+    // Duplication
+    else dup2( source, target );
+}
+
+
 static void updateCmdChaining( cmd_t* start, cmd_t* end )
 {
     // Pour chaque commande de la sequence
@@ -659,32 +1902,174 @@ static void updateCmdChaining( cmd_t* start, cmd_t* end )
                 break;
         }
 
-        // Commande suivante
-        ++current;
+        // Commande suivante (les commandes d'un groupe ne font pas partie de la sequence)
+        current = ( current->group != GROUP_NONE ? current->groupEnd : current + 1 );
+    }
+}
+
+
+static int createPipe( cmd_t* firstCmd, cmd_t* secondCmd )
+{
+    // Dans le corps d'une fonction, seul le chainage est memorise : le pipe est cree a chaque appel
+    secondCmd->pipePrev = firstCmd;
+    secondCmd->pipeSource = firstCmd;
+    if( parsingFunction ) return( CMD_OK );
+
+    // Creation du pipe. Les descripteurs sont fermes automatiquement lors de l'exec, de sorte que seules
+    // les copies installees via dup2() sur l'entree/sortie standard restent ouvertes dans les commandes
+    int pipeFD[2] = {-1, -1};
+    if( pipe2( pipeFD, O_CLOEXEC ) == -1 )
+    {
+        return( CMD_PIPE_FAILED );
+    }
+
+    // Le pipe appartient au minishell : la builtin 'read' peut le lire par blocs
+    addShellPipe( pipeFD[PIPE_OUT] );
+
+    // La sortie standard de la premiere commande est associee a l'entree du pipe
+    firstCmd->out = pipeFD[PIPE_IN];
+
+    // L'entree standard de la deuxieme commande est associee à la sortie du pipe
+    secondCmd->in = pipeFD[PIPE_OUT];
+
+    // Ajout du pipe a refermer dans la deuxieme commande (en sortie du pipe)
+    secondCmd->fdpipe[0] = pipeFD[0];
+    secondCmd->fdpipe[1] = pipeFD[1];
+
+    return( CMD_OK );
+}
+
+
+static int addFanoutBranch( cmd_t** fanout, cmd_t* previous, cmd_t** current, cmd_t* cmds, int* cmdCount )
+{
+    // Premier pipeline : la commande de diffusion prend la place de la nouvelle commande, et lit la sortie de la
+    // commande precedente
+    if( *fanout == NULL )
+    {
+        cmd_t* node = *current;
+        snprintf( node->path, MAX_LINE_SIZE, "|+" );
+        char* arg = memStrdup( MEM_COMMANDS, "|+" );
+        int status = ( arg != NULL ? addCmdArg( node, arg ) : EXPAND_NO_MEMORY );
+        if( status != CMD_OK ) return( status );
+        previous->nextSuccess = node;
+        previous->nextCmdLink = LINK_PIPE;
+        status = createPipe( previous, node );
+        if( status != CMD_OK ) return( status );
+
+        // Le pipeline commence a la commande suivante, chainee a la commande de diffusion
+        *current = cmds + ( *cmdCount )++;
+        *fanout = node;
+        previous = node;
+    }
+
+    // Nombre de pipelines limite
+    if( ( *fanout )->fanoutCount == MAX_FANOUT ) return( CMD_TOO_MANY_FANOUTS );
+
+    // Le pipeline est chaine a la commande precedente (la commande de diffusion, ou la derniere commande du
+    // pipeline precedent), mais son entree est une nouvelle sortie de la commande de diffusion
+    previous->nextSuccess = *current;
+    previous->nextCmdLink = LINK_PIPE;
+    const int status = createPipe( *fanout, *current );
+    if( status != CMD_OK ) return( status );
+    ( *fanout )->fanoutFds[( *fanout )->fanoutCount++] = ( *fanout )->out;
+    ( *fanout )->out = -1;
+    ( *current )->pipePrev = previous;
+
+    return( CMD_OK );
+}
+
+
+static int addCmdArg( cmd_t* cmd, char* arg )
+{
+    // Agrandissement de la liste si besoin (avec la place du NULL final)
+    if( cmd->argc == cmd->argvCapacity )
+    {
+        const int capacity = ( cmd->argvCapacity == 0 ? 16 : cmd->argvCapacity * 2 );
+        char** argv = (char**)memRealloc( MEM_COMMANDS, cmd->argv, ( capacity + 1 ) * sizeof( char* ) );
+        if( argv == NULL )
+        {
+            memFree( arg );
+            return( EXPAND_NO_MEMORY );
+        }
+        cmd->argv = argv;
+        cmd->argvCapacity = capacity;
+    }
+
+    // Ajout de l'argument
+    cmd->argv[cmd->argc++] = arg;
+    cmd->argv[cmd->argc] = NULL;
+
+    return( CMD_OK );
+}
+
+
+static int addCmdWord( cmd_t* cmd, const char* word )
+{
+    // Substitution des variables : la valeur obtenue est redecoupee en mots, comme l'etait la ligne de commande
+    // lorsque les variables y etaient substituees avant son decoupage
+    char buffer[MAX_LINE_SIZE];
+    snprintf( buffer, MAX_LINE_SIZE, "%s", word );
+    if( strchr( buffer, '$' ) != NULL )
+    {
+        const int status = expandParams( buffer );
+        if( status != PARAM_OK ) return( status );
+    }
+
+    // Pour chaque mot obtenu (aucun si les variables sont vides)
+    char* savePtr = NULL;
+    for( char* part = strtok_r( buffer, " ", &savePtr ); part != NULL; part = strtok_r( NULL, " ", &savePtr ) )
+    {
+        // On expanse le mot, et on rajoute les mots obtenus dans la liste des arguments de la commande (la liste
+        // des mots ne fait que transmettre les mots aux arguments)
+        WordList words;
+        initWordList( &words );
+        int status = expandWord( part, &words );
+
+        // Memorisation du mot qui produit le plus d'arguments
+        if( words.count > cmd->batchCount )
+        {
+            cmd->batchStart = cmd->argc;
+            cmd->batchCount = words.count;
+        }
+        for( int i = 0; i < words.count; ++i )
+        {
+            if( status == EXPAND_OK ) status = addCmdArg( cmd, words.words[i] );
+            else memFree( words.words[i] );
+        }
+        memFree( words.words );
+        if( status != EXPAND_OK ) return( status );
     }
+
+    return( CMD_OK );
 }
 
 
-static int createPipe( cmd_t* firstCmd, cmd_t* secondCmd )
+static int addRawArg( cmd_t* cmd, const char* token )
 {
-    // Creation du pipe
-    int pipeFD[2] = {-1, -1};
-    if( pipe( pipeFD ) == -1 )
-    {
-        return( CMD_PIPE_FAILED );
-    }
+    char* arg = memStrdup( MEM_COMMANDS, token );
+    return( arg != NULL ? addCmdArg( cmd, arg ) : EXPAND_NO_MEMORY );
+}
 
-    // La sortie standard de la premiere commande est associee a l'entree du pipe
-    firstCmd->out = pipeFD[PIPE_IN];
 
-    // L'entree standard de la deuxieme commande est associee à la sortie du pipe
-    secondCmd->in = pipeFD[PIPE_OUT];
+static int isArithCmd( const char* token )
+{
+    return( strncmp( token, "((", 2 ) == 0 && getArithLength( token ) == (int)strlen( token ) );
+}
 
-    // Ajout du pipe a refermer dans la deuxieme commande (en sortie du pipe)
-    secondCmd->fdpipe[0] = pipeFD[0];
-    secondCmd->fdpipe[1] = pipeFD[1];
 
-    return( CMD_OK );
+static int addArithCmd( cmd_t* cmd, const char* token )
+{
+    // Nom de la builtin
+    int status = addRawArg( cmd, "((" );
+    if( status != CMD_OK ) return( status );
+
+    // Expression, entre "((" et "))" (liberee avec les arguments de la commande, par memFree())
+    const size_t length = strlen( token ) - 4;
+    char* expr = (char*)memAlloc( MEM_COMMANDS, length + 1 );
+    if( expr == NULL ) return( EXPAND_NO_MEMORY );
+    memcpy( expr, token + 2, length );
+    expr[length] = '\0';
+    return( addCmdArg( cmd, expr ) );
 }
 
 
@@ -699,41 +2084,77 @@ static void addFileDescriptor( cmd_t* cmd, int fd )
 }
 
 
+static void addDryRunFile( int fd, const char* fileName )
+{
+    // Liste pleine : le fichier sera affiche par son seul descripteur
+    if( dryRunFileCount == MAX_CMD_SIZE ) return;
+
+    // Memorisation du descripteur et du nom
+    char* name = memStrdup( MEM_PARSER, fileName );
+    if( name == NULL ) return;
+    dryRunFds[dryRunFileCount] = fd;
+    dryRunFiles[dryRunFileCount++] = name;
+}
+
+
 static void closeCmdFiles( cmd_t* cmd )
 {
-    // Fermeture des fichiers ouverts
+    // Fermeture des fichiers ouverts (sauf ceux dont le numero vient d'etre attribue par une duplication)
     int i = 0;
     while( i < MAX_CMD_SIZE && cmd->fdclose[i] != -1 )
     {
         // Fermeture du fichier, et passage au descripteur suivant
-        close( cmd->fdclose[i++] );
+        if( ! isFdDuplicationTarget( cmd, cmd->fdclose[i] ) ) close( cmd->fdclose[i] );
+        ++i;
     }
 
     // Fermeture du pipe (si ouvert)
-    if( cmd->fdpipe[0] != -1 ) close( cmd->fdpipe[0] );
-    if( cmd->fdpipe[1] != -1 ) close( cmd->fdpipe[1] );
+    if( cmd->fdpipe[0] != -1 && ! isFdDuplicationTarget( cmd, cmd->fdpipe[0] ) ) close( cmd->fdpipe[0] );
+    if( cmd->fdpipe[1] != -1 && ! isFdDuplicationTarget( cmd, cmd->fdpipe[1] ) ) close( cmd->fdpipe[1] );
 }
 
 
-static const BgCmd* addBgCmd( cmd_t* cmd )
+static const BgCmd* addBgCmd( cmd_t* cmd, int outputFd )
 {
     // Numero attribue a la derniere commande en background qui a ete rajoute
-    static int lastCmdNumber = 1;
+    static _Thread_local int lastCmdNumber = 1;
 
     // Creation d'une nouvelle commande qui s'execute en background
-    BgCmd* bgCmd = (BgCmd*)malloc( sizeof( BgCmd ) );
+    BgCmd* bgCmd = (BgCmd*)memAlloc( MEM_JOBS, sizeof( BgCmd ) );
     bgCmd->pid = cmd->pid;
     bgCmd->number = 0;
+    strcpy( bgCmd->path, cmd->path );
+    bgCmd->startTime = cmd->startTime;
+    recordBgCmdStarted();
     bgCmd->cmdLine[0] = '\0';
-    for( int i = 0; i < MAX_CMD_SIZE; ++i )
+    size_t length = 0;
+    for( int i = 0; i < cmd->argc && length < MAX_LINE_SIZE; ++i )
     {
-        if( cmd->argv[i] == NULL ) break;
-        strcat( bgCmd->cmdLine, cmd->argv[i] );
-        strcat( bgCmd->cmdLine, " " );
+        // La ligne de commande est tronquee si elle est trop longue
+        length += snprintf( bgCmd->cmdLine + length, MAX_LINE_SIZE - length, "%s ", cmd->argv[i] );
     }
+
+    // Un groupe (sans arguments) est affiche sous son nom
+    if( cmd->argc == 0 ) snprintf( bgCmd->cmdLine, MAX_LINE_SIZE, "%s", cmd->path );
+    bgCmd->finished = 0;
+    bgCmd->exitStatus = 0;
+    bgCmd->outputFd = outputFd;
+    bgCmd->output = NULL;
     bgCmd->next = NULL;
     bgCmd->previous = NULL;
 
+    // Buffer de capture des sorties (sans buffer, les sorties ne peuvent pas etre conservees)
+    if( outputFd != -1 )
+    {
+        bgCmd->output = createRingBuffer( getOption( OPTION_BG_CAPTURE_SIZE ) );
+        if( bgCmd->output == NULL )
+        {
+            fprintf( stderr, "ERREUR - Impossible d'allouer le buffer de capture de la commande\n" );
+            close( outputFd );
+            bgCmd->outputFd = -1;
+        }
+    }
+
     // Si premiere commande
     if( backgroundCommands == NULL )
     {
@@ -761,3 +2182,593 @@ static const BgCmd* addBgCmd( cmd_t* cmd )
 
     return( bgCmd );
 }
+
+
+static int execInShell( cmd_t* cmd, Function* function )
+{
+    // Une seule commande a la fois modifie les descripteurs du minishell
+    const int redirected = ( cmd->in != -1 || cmd->out != -1 || cmd->err != -1 || cmd->fddupCount > 0 );
+    if( redirected ) pthread_mutex_lock( &inShellLock );
+
+    // Les messages deja produits par le minishell sont ecrits avant la mise en place des redirections
+    fflush( stdout );
+    fflush( stderr );
+
+    // Les redirections de la builtin 'exec' s'appliquent durablement au minishell (pas de restauration)
+    const int persistent = ( function == NULL && strcmp( cmd->path, "exec" ) == 0 );
+
+    // Sauvegarde des descripteurs du minishell modifies par les redirections (hors des descripteurs 0 a 9,
+    // reserves aux commandes), et mise en place des redirections de la commande. Un descripteur non ouvert
+    // dans le minishell est sauvegarde sous la forme -1 (il sera referme).
+    int savedFds[MAX_CMD_FD];
+    int modified[MAX_CMD_FD] = {0};
+    const int cmdFds[3] = { cmd->in, cmd->out, cmd->err };
+    for( int i = 0; i < 3 + cmd->fddupCount; ++i )
+    {
+        // Descripteur cible et source de la redirection
+        const int target = ( i < 3 ? i : cmd->fddup[i - 3][0] );
+        const int source = ( i < 3 ? cmdFds[i] : cmd->fddup[i - 3][1] );
+        if( source == -1 ) continue;
+
+        // Sauvegarde (une seule fois) du descripteur cible
+        if( ! persistent && ! modified[target] ) savedFds[target] = fcntl( target, F_DUPFD_CLOEXEC, MAX_CMD_FD );
+        modified[target] = 1;
+
+        // Redirection
+        duplicateFd( target, source );
+
+        // Mise a jour des descripteurs ouverts durablement dans le minishell
+        if( persistent && target > STDERR_FILENO )
+        {
+            if( source == FD_CLOSED ) shellFds &= ~( 1 << target );
+            else shellFds |= ( 1 << target );
+        }
+    }
+
+    // Execution de la builtin, des commandes du groupe ou du corps de la fonction, et mise a jour du code de
+    // retour de la commande
+    if( cmd->group != GROUP_NONE )
+    {
+        cmd->status = execCmdList( cmd + 1 );
+    }
+    else if( function != NULL )
+    {
+        cmd->status = callFunction( cmd, function );
+    }
+    else
+    {
+        const int status = execBuiltin( cmd );
+        cmd->status = ( status == BUILTIN_NOT_FOUND ? CMD_NOT_FOUND : status );
+    }
+
+    // Restauration des descripteurs du minishell
+    fflush( stdout );
+    fflush( stderr );
+    for( int fd = 0; fd < MAX_CMD_FD && ! persistent; ++fd )
+    {
+        if( ! modified[fd] ) continue;
+        if( savedFds[fd] == -1 )
+        {
+            close( fd );
+            continue;
+        }
+        dup2( savedFds[fd], fd );
+        close( savedFds[fd] );
+    }
+    if( redirected ) pthread_mutex_unlock( &inShellLock );
+
+    return( CMD_OK );
+}
+
+
+static int execGroupProcess( const cmd_t* cmd )
+{
+    // Les pipes des autres commandes sont refermes (ceux des commandes du groupe sont conserves)
+    closeLinePipes( cmd );
+
+    // Le zygote reste reserve au minishell (sa socket ne peut pas etre partagee)
+    detachZygote();
+
+    // Execution des commandes du groupe
+    inGroupProcess = 1;
+    lastInProcess = 1;
+    return( execCmdList( (cmd_t*)cmd + 1 ) );
+}
+
+
+static int execFunctionProcess( const cmd_t* cmd, Function* function )
+{
+    // Comme pour un groupe, les pipes des autres commandes sont refermes, et le zygote reste reserve au minishell
+    closeLinePipes( cmd );
+    detachZygote();
+
+    // Execution du corps de la fonction
+    inGroupProcess = 1;
+    lastInProcess = 1;
+    return( callFunction( cmd, function ) );
+}
+
+
+static void closeLinePipes( const cmd_t* cmd )
+{
+    // Ligne en cours, puis lignes appelantes
+    const CallerLine current = { lineCmds, lineCmdCount, callerLines };
+    for( const CallerLine* line = &current; line != NULL; line = line->caller )
+    {
+        for( cmd_t* other = line->cmds; other < line->cmds + line->count; ++other )
+        {
+            // Les commandes d'un groupe sont rangees juste apres le groupe, dans le tableau de la ligne en cours
+            if( line == &current && other > cmd && other < cmd->groupEnd ) continue;
+            if( other->fdpipe[0] != -1 && ! isFdDuplicationTarget( cmd, other->fdpipe[0] ) ) close( other->fdpipe[0] );
+            if( other->fdpipe[1] != -1 && ! isFdDuplicationTarget( cmd, other->fdpipe[1] ) ) close( other->fdpipe[1] );
+        }
+    }
+}
+
+
+static int callFunction( const cmd_t* cmd, Function* function )
+{
+    // Contexte de l'appel : parametres positionnels et variables locales (la ligne re-executee par 'watch' n'a
+    // pas de parametres positionnels, les arguments de la commande etant ses options)
+    FuncFrame frame;
+    const int argc = ( function == cmd->watchBody ? 1 : cmd->argc );
+    if( beginFuncCall( &frame, function, argc, cmd->argv ) != FUNC_OK )
+    {
+        fprintf( stderr, "ERREUR - Trop d'appels de fonctions imbriques (%s)\n", function->name );
+        return( FUNC_TOO_DEEP );
+    }
+
+    // Instanciation du corps de la fonction
+    const int count = function->cmdCount;
+    cmd_t* body = (cmd_t*)memCalloc( MEM_COMMANDS, count, sizeof( cmd_t ) );
+    int status = FUNC_NO_MEMORY;
+    if( body != NULL )
+    {
+        for( int i = 0; i < count; ++i ) initCmd( body + i );
+        status = instantiateBody( function, body );
+    }
+    if( status != CMD_OK )
+    {
+        fprintf( stderr, "ERREUR - Impossible d'instancier la fonction %s [code = %d]\n", function->name, status );
+    }
+
+    // Execution du corps : ses commandes remplacent celles de la ligne le temps de l'appel
+    else
+    {
+        const CallerLine caller = { lineCmds, lineCmdCount, callerLines };
+        callerLines = &caller;
+        lineCmds = body;
+        lineCmdCount = count;
+        status = execCmdList( body );
+        lineCmds = caller.cmds;
+        lineCmdCount = caller.count;
+        callerLines = caller.caller;
+    }
+
+    // Fermeture des pipes des commandes qui n'ont pas ete executees, et destruction du corps
+    for( int i = 0; body != NULL && i < count; ++i )
+    {
+        closeCmdPipe( body + i );
+        initCmd( body + i );
+        memFree( body[i].argv );
+    }
+    memFree( body );
+    endFuncCall( &frame );
+
+    return( status );
+}
+
+
+static int instantiateBody( const Function* function, cmd_t* body )
+{
+    // Type et enchainements de chaque commande (les chainages vers les commandes modeles deviennent des chainages
+    // vers les commandes correspondantes du corps)
+    const cmd_t* models = function->cmds;
+    for( int i = 0; i < function->cmdCount; ++i )
+    {
+        const cmd_t* model = models + i;
+        cmd_t* cmd = body + i;
+        cmd->wait = model->wait;
+        snprintf( cmd->path, MAX_LINE_SIZE, "%s", model->path );
+        cmd->next = ( model->next != NULL ? body + ( model->next - models ) : NULL );
+        cmd->nextSuccess = ( model->nextSuccess != NULL ? body + ( model->nextSuccess - models ) : NULL );
+        cmd->nextFailure = ( model->nextFailure != NULL ? body + ( model->nextFailure - models ) : NULL );
+        cmd->nextCmdLink = model->nextCmdLink;
+        cmd->group = model->group;
+        cmd->groupEnd = ( model->groupEnd != NULL ? body + ( model->groupEnd - models ) : NULL );
+        cmd->source = model;
+    }
+
+    // Creation des pipes, dans l'ordre du corps (les sorties d'une commande de diffusion sont donc ajoutees dans
+    // l'ordre de ses pipelines)
+    for( int i = 0; i < function->cmdCount; ++i )
+    {
+        const cmd_t* model = models + i;
+        if( model->pipeSource == NULL ) continue;
+        cmd_t* writer = body + ( model->pipeSource - models );
+        const int status = createPipe( writer, body + i );
+        if( status != CMD_OK ) return( status );
+
+        // Sortie d'une commande de diffusion, dont le pipeline est chaine a la fin du pipeline precedent
+        if( model->pipeSource->fanoutCount > 0 )
+        {
+            writer->fanoutFds[writer->fanoutCount++] = writer->out;
+            writer->out = -1;
+        }
+        body[i].pipePrev = body + ( model->pipePrev - models );
+    }
+
+    return( CMD_OK );
+}
+
+
+static int execBodyCmd( cmd_t* cmd )
+{
+    // Traitement des arguments et des redirections
+    int status = bindCmd( cmd );
+
+    // Fichiers ouverts par les redirections
+    int fileCount = 0;
+    while( fileCount < MAX_CMD_SIZE && cmd->fdclose[fileCount] != -1 ) ++fileCount;
+
+    // Execution de la commande
+    if( status == CMD_OK )
+    {
+        status = execCmd( cmd );
+    }
+    else
+    {
+        cmd->executed = 1;
+        cmd->status = status;
+    }
+
+    // Fermeture des fichiers des redirections (les descripteurs ajoutes ensuite, comme l'entree d'un pipe de
+    // capture, sont deja refermes)
+    for( int i = 0; i < fileCount; ++i ) close( cmd->fdclose[i] );
+    cmd->fdclose[0] = -1;
+
+    return( status );
+}
+
+
+static int bindCmd( cmd_t* cmd )
+{
+    // Les arguments bruts ne sont traites qu'une fois
+    const cmd_t* model = cmd->source;
+    cmd->source = NULL;
+
+    // Pour chaque argument brut : redirection (operateur suivi du fichier), commande arithmetique, ou mot
+    for( int i = 0; i < model->argc; ++i )
+    {
+        int status = CMD_OK;
+        if( isSeparator( model->argv[i] ) == SEP_REDIRECT )
+        {
+            status = processWordRedirection( model->argv[i], cmd, model->argv[i + 1] );
+            ++i;
+        }
+        else if( cmd->argc == 0 && isArithCmd( model->argv[i] ) )
+        {
+            status = addArithCmd( cmd, model->argv[i] );
+        }
+        else
+        {
+            status = addCmdWord( cmd, model->argv[i] );
+        }
+        if( status != CMD_OK ) return( status );
+    }
+
+    // Le nom de la commande est son premier argument (un groupe conserve son nom)
+    if( cmd->group == GROUP_NONE ) snprintf( cmd->path, MAX_LINE_SIZE, "%s", cmd->argc > 0 ? cmd->argv[0] : "" );
+
+    return( CMD_OK );
+}
+
+
+static void closeCmdPipe( cmd_t* cmd )
+{
+    // Le pipe est marque comme referme, pour ne pas l'etre une deuxieme fois en fin de ligne de commande
+    for( int i = 0; i < 2; ++i )
+    {
+        if( cmd->fdpipe[i] != -1 ) close( cmd->fdpipe[i] );
+        cmd->fdpipe[i] = -1;
+    }
+}
+
+
+static cmd_t* nextCmd( cmd_t* current )
+{
+    // S'il existe une commande suivante inconditionnelle
+    if( current->next != NULL )
+    {
+        // On utilise cette commande
+        return current->next;
+    }
+
+    // Sinon, si la commande a echoue et s'il existe une commande suivante en cas d'erreur
+    else if( current->status != 0 && current->nextFailure != NULL )
+    {
+        // On utilise cette commande
+        return current->nextFailure;
+    }
+
+    // Sinon, si la commande a reussie et s'il existe une commande suivante en cas de succes
+    else if( current->status == 0 && current->nextSuccess != NULL )
+    {
+        // On utilise cette commande
+        return current->nextSuccess;
+    }
+
+    // Pas de commande suivante disponible
+    return( NULL );
+}
+
+
+static int openCaptureOutput( cmd_t* cmd, int* captureIn )
+{
+    // Rien a capturer si les sorties sont deja redirigees
+    if( cmd->out != -1 && cmd->err != -1 ) return( -1 );
+
+    // Installation (une seule fois) du callback de vidage des pipes de capture. Les appels systemes
+    // interrompus par le signal (saisie, attente d'une commande) sont automatiquement relances.
+    static int handlerInstalled = 0;
+    if( ! handlerInstalled )
+    {
+        struct sigaction action;
+        memset( &action, 0, sizeof( action ) );
+        action.sa_handler = onBgCmdOutput;
+        action.sa_flags = SA_RESTART;
+        sigemptyset( &action.sa_mask );
+        sigaction( SIGIO, &action, NULL );
+        handlerInstalled = 1;
+    }
+
+    // Creation du pipe de capture. Le minishell est prevenu par SIGIO de l'arrivee de donnees sur la sortie
+    // du pipe, qui est lue sans attente.
+    int pipeFD[2] = {-1, -1};
+    if( pipe2( pipeFD, O_CLOEXEC ) == -1 ) return( -1 );
+    pipeFD[PIPE_OUT] = moveShellFd( pipeFD[PIPE_OUT] );
+    if( pipeFD[PIPE_OUT] == -1 ||
+        fcntl( pipeFD[PIPE_OUT], F_SETOWN, getpid() ) == -1 ||
+        fcntl( pipeFD[PIPE_OUT], F_SETFL, O_NONBLOCK | O_ASYNC ) == -1 )
+    {
+        close( pipeFD[PIPE_OUT] );
+        close( pipeFD[PIPE_IN] );
+        return( -1 );
+    }
+
+    // Les sorties non redirigees de la commande sont associees a l'entree du pipe, qui doit aussi etre
+    // refermee par le processus d'execution de la commande apres sa mise en place
+    if( cmd->out == -1 ) cmd->out = pipeFD[PIPE_IN];
+    if( cmd->err == -1 ) cmd->err = pipeFD[PIPE_IN];
+    addFileDescriptor( cmd, pipeFD[PIPE_IN] );
+    *captureIn = pipeFD[PIPE_IN];
+
+    return( pipeFD[PIPE_OUT] );
+}
+
+
+static size_t getArgsSize( char* const argv[] )
+{
+    // Chaque argument occupe sa chaine (avec le '\0') et son pointeur
+    size_t size = sizeof( char* );
+    for( int i = 0; argv[i] != NULL; ++i ) size += strlen( argv[i] ) + 1 + sizeof( char* );
+
+    return( size );
+}
+
+
+static size_t getArgsLimit( void )
+{
+    // Limite du systeme (l'espace reserve est partage avec l'environnement)
+    long argMax = sysconf( _SC_ARG_MAX );
+    if( argMax <= 0 ) argMax = 128 * 1024;
+    const size_t envSize = getArgsSize( environ );
+
+    // Marge de securite (comme xargs)
+    const size_t margin = 4096;
+    return( (size_t)argMax > envSize + margin ? (size_t)argMax - envSize - margin : 0 );
+}
+
+
+static int execBatches( const cmd_t* cmd )
+{
+    // Ce processus n'execute pas de programme : les descripteurs herites du minishell qui seraient fermes par
+    // un exec (dont les pipes des autres commandes de la ligne) doivent etre refermes explicitement, pour ne pas
+    // retarder les fins de fichier. Les descripteurs ouverts par 'exec' ou par les redirections sont conserves.
+    for( int fd = STDERR_FILENO + 1; fd < MAX_CMD_FD; ++fd )
+    {
+        const int flags = fcntl( fd, F_GETFD );
+        if( flags != -1 && ( flags & FD_CLOEXEC ) ) close( fd );
+    }
+    closefrom( MAX_CMD_FD );
+
+    // Arguments repetes dans chaque invocation : avant et apres les arguments a repartir
+    const int batchEnd = cmd->batchStart + cmd->batchCount;
+    const int suffixCount = cmd->argc - batchEnd;
+    size_t fixedSize = sizeof( char* );
+    for( int i = 0; i < cmd->argc; ++i )
+    {
+        if( i < cmd->batchStart || i >= batchEnd ) fixedSize += strlen( cmd->argv[i] ) + 1 + sizeof( char* );
+    }
+
+    // Liste d'arguments des invocations (les arguments fixes du debut sont recopies une fois pour toutes)
+    const size_t limit = getArgsLimit();
+    char** argv = (char**)memAlloc( MEM_COMMANDS, ( cmd->argc + 1 ) * sizeof( char* ) );
+    if( argv == NULL ) return( CMD_EXEC_FAILED );
+    memcpy( argv, cmd->argv, cmd->batchStart * sizeof( char* ) );
+
+    // Tant qu'il reste des arguments a repartir ou des invocations en cours
+    int status = 0;
+    int running = 0;
+    int next = cmd->batchStart;
+    while( next < batchEnd || running > 0 )
+    {
+        // Lancement d'une nouvelle invocation si possible
+        if( next < batchEnd && running < getOption( OPTION_ARG_BATCH_JOBS ) && status != CMD_FORK_FAILED )
+        {
+            // On prend autant d'arguments que possible (au moins un)
+            int argc = cmd->batchStart;
+            size_t size = fixedSize;
+            while( next < batchEnd )
+            {
+                const size_t argSize = strlen( cmd->argv[next] ) + 1 + sizeof( char* );
+                if( argc > cmd->batchStart && size + argSize > limit ) break;
+                argv[argc++] = cmd->argv[next++];
+                size += argSize;
+            }
+
+            // Ajout des arguments fixes de la fin
+            memcpy( argv + argc, cmd->argv + batchEnd, ( suffixCount + 1 ) * sizeof( char* ) );
+
+            // Lancement de l'invocation
+            const pid_t pid = fork();
+            if( pid == 0 )
+            {
+                execvp( cmd->path, argv );
+                fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", cmd->path );
+                reportExecFailure();
+                _exit( CMD_EXEC_FAILED );
+            }
+            if( pid == -1 )
+            {
+                // Plus aucune invocation n'est lancee
+                if( status == 0 ) status = CMD_FORK_FAILED;
+                next = batchEnd;
+            }
+            else
+            {
+                ++running;
+            }
+            continue;
+        }
+
+        // Sinon, on attend la fin d'une invocation
+        int childStatus = 0;
+        if( wait( &childStatus ) == -1 ) break;
+        --running;
+        if( status == 0 && WEXITSTATUS( childStatus ) != 0 ) status = WEXITSTATUS( childStatus );
+    }
+
+    memFree( argv );
+    return( status );
+}
+
+
+static void onBgCmdOutput( int sigNum )
+{
+    if( sigNum == SIGIO ) __atomic_add_fetch( &bgOutputSignals, 1, __ATOMIC_RELEASE );
+}
+
+
+static int getPipeStage( const cmd_t* cmd )
+{
+    // On compte les commandes precedentes du pipeline
+    int stage = 0;
+    for( const cmd_t* prev = cmd->pipePrev; prev != NULL; prev = prev->pipePrev ) ++stage;
+
+    return( stage );
+}
+
+
+static void waitPipeline( const cmd_t* cmd )
+{
+    // Pour chaque commande precedente du pipeline
+    for( cmd_t* prev = cmd->pipePrev; prev != NULL; prev = prev->pipePrev )
+    {
+        // Etape executee dans un thread
+        if( prev->stage != NULL )
+        {
+            prev->status = joinStage( prev );
+            recordCommand( prev->path, prev->startTime, W_EXITCODE( prev->status, 0 ), NULL );
+            continue;
+        }
+
+        // Si la commande a bien ete lancee, on se synchronise avec sa terminaison
+        int status = 0;
+        struct rusage usage;
+        if( prev->pid > 0 && waitCmdProcess( prev, &status, &usage ) != -1 )
+        {
+            prev->status = WEXITSTATUS( status );
+            recordCommand( prev->path, prev->startTime, status, &usage );
+        }
+    }
+}
+
+
+static int execStage( cmd_t* cmd )
+{
+    // Lancement du thread de l'etape
+    recordCommandSpawn( cmd->path );
+    cmd->startTime = getMetricsTime();
+    const int64_t spawnStart = getReplayTime();
+    if( startStage( cmd ) != STAGE_OK )
+    {
+        recordCommandError( cmd->path, CMD_FORK_FAILED );
+        return( CMD_FORK_FAILED );
+    }
+    recordReplaySample( REPLAY_SPAWN, spawnStart );
+
+    // Le thread utilise ses propres copies des descripteurs : le pipe de la commande peut etre referme
+    closeCmdPipe( cmd );
+
+    // Si l'etape ecrit dans un pipe (ou un buffer), elle s'execute en parallele de l'etape suivante
+    if( cmd->nextCmdLink == LINK_PIPE ) return( CMD_OK );
+
+    // Sinon, c'est la derniere etape : on se synchronise avec sa fin, puis avec les etapes precedentes
+    cmd->status = joinStage( cmd );
+    recordCommand( cmd->path, cmd->startTime, W_EXITCODE( cmd->status, 0 ), NULL );
+    waitPipeline( cmd );
+
+    return( CMD_OK );
+}
+
+
+static pid_t waitCmdProcess( cmd_t* cmd, int* status, struct rusage* usage )
+{
+    // Attente de la fin du processus, en interrompant les processus du pipeline dont le delai expire
+    if( waitDeadline( cmd ) != DEADLINE_OK )
+    {
+        fprintf( stderr, "ERREUR - Impossible de surveiller le delai de la commande %s\n", cmd->path );
+    }
+
+    // Vidage des pipes de capture pendant l'attente
+    waitCmdCapturing( cmd );
+
+    // Processus cree par le zygote (ses ressources consommees ne sont pas connues), ou fils du minishell
+    pid_t pid = -1;
+    if( isZygoteChild( cmd->pid ) )
+    {
+        memset( usage, 0, sizeof( *usage ) );
+        pid = zygoteWait( cmd->pid, status );
+    }
+    else
+    {
+        pid = wait4( cmd->pid, status, 0, usage );
+    }
+
+    // Une commande interrompue a l'expiration de son delai a un code de retour dedie
+    if( pid != -1 && cmd->expired ) *status = W_EXITCODE( DEADLINE_EXIT_STATUS, 0 );
+
+    // Ressources consommees, conservees avec la commande
+    if( pid != -1 ) cmd->usage = *usage;
+
+    return( pid );
+}
+
+
+static void waitCmdCapturing( const cmd_t* cmd )
+{
+    // Une commande en background au moins doit avoir son pipe de capture ouvert
+    const BgCmd* bgCmd = backgroundCommands;
+    while( bgCmd != NULL && bgCmd->outputFd == -1 ) bgCmd = bgCmd->next;
+    if( bgCmd == NULL ) return;
+
+    // Descripteur signalant la fin du processus (cree par le minishell ou par le zygote)
+    const int pidFd = syscall( SYS_pidfd_open, cmd->pid, 0 );
+    if( pidFd == -1 ) return;
+
+    // Attente, avec vidage des pipes a chaque interruption par SIGIO
+    struct pollfd pfd = { pidFd, POLLIN, 0 };
+    while( poll( &pfd, 1, -1 ) == -1 && errno == EINTR ) pollBgCmdOutputs();
+    close( pidFd );
+}
@@ -16,9 +16,25 @@
 #ifndef _CMD_H_
 #define _CMD_H_
 
+#include <stdint.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include "parser.h"
+#include "ringbuf.h"
+
+// Nombre de descripteurs utilisables dans les redirections (0 a 9). Les descripteurs internes du minishell
+// sont places au-dela, afin de ne pas etre ecrases par une redirection.
+#define MAX_CMD_FD      10
+
+// Nombre max de duplications de descripteurs ("N>&M", "N>&-", "N>fichier" avec N > 2) d'une commande
+#define MAX_FD_DUPS     16
+
+// Source d'une duplication qui ferme le descripteur ("N>&-" ou "N<&-")
+#define FD_CLOSED       -2
+
+// Nombre max de pipelines alimentes par une meme commande de diffusion ('|+', voir fanout.h)
+#define MAX_FANOUT      16
 
 // Codes d'erreurs
 enum CmdError
@@ -30,7 +46,8 @@ enum CmdError
     CMD_FORK_FAILED,        // Echec de creation d'un nouveau processus
     CMD_WAIT_FAILED,        // Echec de synchro avec la terminaison du processus d'execution d'une commande
     CMD_EXEC_FAILED,        // Echec de l'execution (via exec) de la commande
-    CMD_NOT_FOUND           // Commande builtin non trouvee (ou non supportee)
+    CMD_NOT_FOUND,          // Commande builtin non trouvee (ou non supportee)
+    CMD_TOO_MANY_FANOUTS    // Trop de pipelines alimentes par une meme commande ('|+', voir MAX_FANOUT)
 };
 
 // Type d'enchainements possible entre 2 commandes.
@@ -64,6 +81,27 @@ typedef enum
     LINK_NONE = -1          // Pas de commande suivante
 } NextCmdLink;
 
+// Groupes de commandes.
+//
+// Un groupe est represente par une commande (sans arguments) qui s'enchaine avec les autres commandes comme une
+// commande ordinaire, et dont les redirections et le pipe eventuel s'appliquent a toutes les commandes du groupe.
+// Les commandes du groupe sont rangees dans le tableau des commandes juste apres la commande du groupe, et
+// s'enchainent entre elles comme les commandes d'une ligne de commande.
+//
+// - '{ ... ; }' (GROUP_CURRENT) :
+//   Les commandes s'executent dans le processus du minishell (elles peuvent donc modifier son etat), sauf si le
+//   groupe fait partie d'un pipeline ou est lance en background (un seul processus est alors cree pour le groupe)
+// - '( ... )' (GROUP_SUBSHELL) :
+//   Les commandes s'executent dans un seul processus cree pour le groupe. La derniere commande du groupe
+//   s'execute directement dans ce processus.
+//
+typedef enum
+{
+    GROUP_NONE = 0,         // Commande ordinaire
+    GROUP_CURRENT,          // Groupe execute dans le minishell ('{ ... ; }')
+    GROUP_SUBSHELL          // Groupe execute dans un sous-shell ('( ... )')
+} CmdGroup;
+
 /*
  *  Structure de donnees associee a une commande a executer.
  *
@@ -81,13 +119,61 @@ typedef enum
  *  err:            Descripteur associe a l'erreur standard du processus (ou -1 si par defaut)
  *  wait:           Flag sur l'execution synchrone du processus (si faux execution en background)
  *  path:           Nom de la commande
- *  argv:           Liste des arguments de la commande (incluant la commande elle-meme)
+ *  argv:           Liste des arguments de la commande (incluant la commande elle-meme), terminee par NULL.
+ *                  Cette liste est allouee dynamiquement, car l'expansion des motifs de noms de fichiers
+ *                  peut produire un grand nombre d'arguments.
+ *  argc:           Nombre d'arguments de la commande
+ *  argvCapacity:   Taille allouee de la liste des arguments (hors NULL final)
+ *  batchStart:     Index du premier argument produit par le mot de la ligne de commande qui a produit le plus
+ *                  d'arguments lors de l'expansion (seuls ces arguments sont repartis entre plusieurs invocations
+ *                  lorsque la liste est trop longue, voir l'option "argbatch")
+ *  batchCount:     Nombre d'arguments produits par ce mot
+ *  fddup:          Liste des duplications de descripteurs a effectuer dans le processus de la commande, apres
+ *                  la mise en place des entree/sortie/erreur : pour chaque duplication, le descripteur cible
+ *                  (fddup[i][0]) devient une copie du descripteur source (fddup[i][1]), ou est ferme si la
+ *                  source vaut FD_CLOSED. Les duplications sont effectuees dans l'ordre de la ligne de commande ;
+ *                  les redirections vers un fichier qui suivent une duplication sont rangees dans cette liste
+ *                  (et non dans in/out/err), pour etre appliquees a leur rang.
+ *  fddupCount:     Nombre de duplications de descripteurs
  *  fdclose:        Liste des descripteurs de fichiers a fermer a la fin de l'execution
  *  fdpipe:         Eventuel pipe a refermer apres le fork du process
  *  next:           Pointeur vers la commande suivante (execution inconditionnelle)
  *  next_success:   Pointeur vers la commande suivante en cas de succes
  *  next_failure:   Pointeur vers la commande suivante en cas d'erreur
+ *  pipePrev:       Pointeur vers la commande precedente dans le pipeline (ou NULL si debut de pipeline)
  *  nextCmdLink:    Type du separateur avec la prochaine commande
+ *  startTime:      Heure de lancement de la commande (voir metrics.h)
+ *  group:          Type de groupe (GROUP_NONE pour une commande ordinaire)
+ *  elided:         Vrai si la commande a ete supprimee par l'optimisation du plan d'execution (voir plan.h) :
+ *                  elle n'est pas executee, et son code de retour 'status' est connu a l'avance
+ *  groupEnd:       Pour un groupe, pointeur vers la commande qui suit la derniere commande du groupe dans le
+ *                  tableau des commandes (les commandes du groupe commencent juste apres le groupe)
+ *  stage:          Etape executee dans un thread du minishell plutot que par un processus (voir stage.h), ou NULL
+ *  timeout:        Delai d'execution de la commande, en nanosecondes (0 pour le delai par defaut, voir deadline.h)
+ *  timeoutSignal:  Signal envoye a l'expiration du delai
+ *  timeoutKillAfter: Delai avant l'envoi de SIGKILL apres le premier signal, en nanosecondes (-1 pour la valeur
+ *                  par defaut)
+ *  deadline:       Heure d'expiration du delai (horloge monotone, en nanosecondes), ou 0 si pas de delai
+ *  expired:        Nombre de signaux envoyes au processus apres l'expiration du delai (0 si pas expire)
+ *  fanoutFds:      Pour une commande de diffusion ('|+', voir fanout.h), entrees des pipes vers chacun des
+ *                  pipelines alimentes (la sortie 'out' n'est alors pas utilisee)
+ *  fanoutCount:    Nombre de pipelines alimentes (0 pour une commande ordinaire)
+ *  executed:       Vrai si l'execution de la commande a commence (dans un processus, un thread ou le minishell)
+ *  usage:          Ressources consommees par le processus de la commande, une fois celui-ci recupere (a zero pour
+ *                  une commande executee dans le minishell ou dans un thread, ou non attendue)
+ *  pipeSource:     Commande qui ecrit dans le pipe lu par la commande (la commande de diffusion pour le debut d'un
+ *                  pipeline alimente par '|+', sinon 'pipePrev'), ou NULL
+ *  funcDef:        Pour une definition de fonction ('nom() { ... ; }'), la fonction definie (enregistree lors de
+ *                  l'execution de la commande, voir func.h), sinon NULL
+ *  source:         Pour une commande du corps d'une fonction en cours d'appel, la commande modele dont les
+ *                  arguments bruts (variables, motifs, redirections) restent a traiter juste avant l'execution,
+ *                  sinon NULL
+ *  watchBody:      Pour la builtin 'watch', la ligne qui suit "--", analysee en commandes modeles comme le corps
+ *                  d'une fonction anonyme (voir watch.h), sinon NULL
+ *
+ *  Les commandes d'un pipeline s'executent en parallele : le shell n'attend pas les commandes qui ecrivent
+ *  dans un pipe, mais seulement la derniere commande du pipeline. Les commandes precedentes sont ensuite
+ *  attendues en remontant le chainage 'pipePrev'.
  */
 typedef struct cmd_t
 {
@@ -96,22 +182,63 @@ typedef struct cmd_t
     int in, out, err;
     int wait;
     char path[MAX_LINE_SIZE];
-    char* argv[MAX_CMD_SIZE];
+    char** argv;
+    int argc;
+    int argvCapacity;
+    int batchStart;
+    int batchCount;
+    int fddup[MAX_FD_DUPS][2];
+    int fddupCount;
     int fdclose[MAX_CMD_SIZE];
     int fdpipe[2];
     struct cmd_t* next;
     struct cmd_t* nextSuccess;
     struct cmd_t* nextFailure;
+    struct cmd_t* pipePrev;
     NextCmdLink nextCmdLink;
+    int64_t startTime;
+    CmdGroup group;
+    int elided;
+    struct cmd_t* groupEnd;
+    struct Stage* stage;
+    int64_t timeout;
+    int timeoutSignal;
+    int64_t timeoutKillAfter;
+    int64_t deadline;
+    int expired;
+    int fanoutFds[MAX_FANOUT];
+    int fanoutCount;
+    int executed;
+    struct rusage usage;
+    struct cmd_t* pipeSource;
+    struct Function* funcDef;
+    const struct cmd_t* source;
+    struct Function* watchBody;
 } cmd_t;
 
 /*
  * Structure de donnees associee a une commande qui s'execute an arriere plan. Ces commande sont gerees
  * dans une liste doublement chainee
  *
+ * Lorsque l'option "bgcapture" est active, les sorties standard et d'erreur de la commande (si elles ne
+ * sont pas redirigees) sont envoyees dans un pipe, que le minishell vide sans attente (apres reception de SIGIO,
+ * voir pollBgCmdOutputs()) dans un buffer circulaire de taille fixe. Une commande dont les sorties sont
+ * capturees reste dans la liste apres sa terminaison, jusqu'a ce que ses sorties soient consultees (builtin
+ * 'jobs -o').
+ *
+ * Pour un pipeline en background, seules les sorties de la derniere commande sont capturees : les sorties
+ * d'erreur des commandes precedentes restent celles du minishell. Pendant la saisie d'une ligne, le pipe n'est
+ * pas vide : une commande qui y ecrit plus que sa capacite attend la ligne suivante.
+ *
  * pid : PID du processus
  * number : numero attribuee a la commande lors de son lancement (et affiche a sa terminaison)
+ * path : nom de la commande
+ * startTime : heure de lancement de la commande (voir metrics.h)
  * cmdLine : ligne de commande correspondante
+ * finished : flag indiquant si la commande est terminee
+ * exitStatus : code de retour de la commande (si elle est terminee)
+ * outputFd : sortie du pipe de capture des sorties de la commande (ou -1 si pas de capture)
+ * output : buffer de capture des sorties de la commande (ou NULL si pas de capture)
  * next : pointeur sur la commande suivante
  * previous : pointeur sur la commande precedente
  */
@@ -119,7 +246,13 @@ typedef struct BgCmd
 {
     pid_t pid;
     int number;
+    char path[MAX_LINE_SIZE];
+    int64_t startTime;
     char cmdLine[MAX_LINE_SIZE];
+    int finished;
+    int exitStatus;
+    int outputFd;
+    RingBuffer* output;
     struct BgCmd* next;
     struct BgCmd* previous;
 } BgCmd;
@@ -135,7 +268,12 @@ typedef struct BgCmd
 int initCmd( cmd_t* p );
 
 /*
- *  Remplit le tableau de commandes en fonction du contenu de tokens.
+ *  Remplit le tableau de commandes en fonction du contenu de tokens. Les variables ($NOM, voir getVar()) des
+ *  arguments et des fichiers de redirection sont substituees (une valeur avec des espaces donne plusieurs
+ *  arguments), puis les arguments sont expanses (voir expand.h) avant d'etre ajoutes aux commandes. Les tokens
+ *  "(" et ")", ainsi que "{" et "}" a la place d'une commande, delimitent les groupes de commandes (voir
+ *  CmdGroup). "nom ( ) { ... ; }" definit une fonction (voir func.h), dont le corps est analyse sans traiter
+ *  ses arguments.
  *  Ex : {"ls", "-l", "|", "grep", "^a", NULL} =>
  *       {
  *          {
@@ -174,6 +312,70 @@ int parseCmd( char* tokens[], cmd_t* cmds, int* cmdCount );
  */
 int execCmd( cmd_t* cmd );
 
+/*
+ *  Execute une liste de commandes (ligne de commande, ou commandes d'un groupe) en suivant leurs
+ *  enchainements, a partir de la premiere commande de la liste.
+ *
+ *  first : pointeur sur la premiere commande a executer.
+ *
+ *  Retourne le code de retour de la derniere commande executee.
+ */
+int execCmdList( cmd_t* first );
+
+/*
+ *  Execute une fois la ligne re-executee par la builtin 'watch' (voir watch.h) : ses commandes modeles sont
+ *  instanciees et executees comme le corps d'une fonction, sans parametres positionnels.
+ *
+ *  cmd : la commande 'watch'.
+ *
+ *  Retourne le code de retour de la derniere commande executee.
+ */
+int execWatchBody( const cmd_t* cmd );
+
+/*
+ *  Configure l'execution des commandes par le thread courant lorsque le moteur du minishell est integre a une
+ *  autre application (voir libminishell.h) : 'exit' termine alors seulement la ligne de commande en cours, et non
+ *  le processus, et les programmes lances recoivent l'environnement fourni plutot que celui du processus.
+ *
+ *  embedded : vrai pour une execution integree, faux pour le fonctionnement du minishell
+ *  env : environnement des programmes lances (tableau "NOM=VALEUR" termine par NULL), ou NULL pour celui du
+ *        processus
+ */
+void setEmbeddedExec( int embedded, char** env );
+
+/*
+ *  Retourne vrai si le thread courant execute les commandes pour une application qui integre le moteur du
+ *  minishell (voir setEmbeddedExec()) : les messages de suivi des jobs ne sont alors pas affiches sur la sortie
+ *  standard de cette application.
+ */
+int isEmbeddedExec( void );
+
+/*
+ *  Redirige les sorties standard et d'erreur non redirigees des commandes lancees ensuite en background (et non
+ *  capturees, voir l'option "bgcapture") vers le descripteur specifie, plutot que vers celles du minishell.
+ *
+ *  fd : descripteur ouvert en ecriture (qui reste a la charge de l'appelant), ou -1 pour revenir aux sorties du
+ *       minishell
+ */
+void setBgCmdOutput( int fd );
+
+/*
+ *  Active ou desactive l'analyse a blanc des lignes de commande (builtin 'explain') : les fichiers de redirection
+ *  ne sont pas ouverts (ni crees, ni tronques), /dev/null les remplace, et leurs noms sont memorises pour
+ *  l'affichage du plan jusqu'a la prochaine analyse a blanc (voir getDryRunFile()).
+ *
+ *  dryRun : vrai pour analyser les lignes suivantes a blanc, faux pour revenir a l'analyse normale
+ */
+void setDryRunParse( int dryRun );
+
+/*
+ * Retourne le nom du fichier de redirection remplace par le descripteur specifie lors de la derniere analyse a
+ * blanc, ou NULL si le descripteur ne remplace aucun fichier
+ *
+ * fd : le descripteur
+ */
+const char* getDryRunFile( int fd );
+
 /*
  * Recherche et retourne la commande en background correspondant au PID specifie.
  *
@@ -185,6 +387,62 @@ int execCmd( cmd_t* cmd );
  */
 BgCmd* removeBgCmd( pid_t pid );
 
+/*
+ * Marque comme terminee la commande en background correspondant au PID specifie. Les dernieres sorties
+ * eventuellement capturees de la commande sont recuperees, et le pipe de capture est referme.
+ *
+ * La commande reste dans la liste globale des commandes en background : c'est a l'appelant de l'en retirer
+ * (via removeBgCmd()) si ses sorties ne sont pas capturees.
+ *
+ * pid : PID de la commande
+ * status : code de terminaison de la commande (au format de waitpid())
+ * usage : ressources consommees par la commande, ou NULL si inconnues
+ * retourne un pointeur sur la commande si trouvee, sinon NULL
+ */
+BgCmd* endBgCmd( pid_t pid, int status, const struct rusage* usage );
+
+/*
+ * Recherche la commande en background correspondant au numero specifie
+ *
+ * number : numero de la commande
+ * retourne un pointeur sur la commande si trouvee, sinon NULL
+ */
+BgCmd* findBgCmd( int number );
+
+/*
+ * Retourne la premiere commande de la liste globale des commandes en background (ou NULL si la liste est vide)
+ */
+const BgCmd* getBgCmds( void );
+
+/*
+ * Detruit une commande en background (et son eventuel buffer de capture)
+ *
+ * bgCmd : la commande a detruire (peut etre NULL)
+ */
+void freeBgCmd( BgCmd* bgCmd );
+
+/*
+ * Vide sans attente les pipes de capture des commandes en background dans leurs buffers circulaires
+ */
+void drainBgCmdOutputs( void );
+
+/*
+ * Vide les pipes de capture (voir drainBgCmdOutputs()) si le signal SIGIO a ete recu depuis le dernier vidage
+ * par le thread courant. Le callback de SIGIO se contente de compter le signal : cette fonction est appelee par
+ * la boucle du minishell avant chaque saisie, entre les commandes d'une ligne, et pendant les attentes
+ * (emplacement de job libre, delai d'une commande).
+ */
+void pollBgCmdOutputs( void );
+
+/*
+ * Deplace un descripteur interne du minishell au-dela des descripteurs utilisables dans les redirections
+ * (voir MAX_CMD_FD). Le nouveau descripteur est ferme automatiquement lors d'un exec.
+ *
+ * fd : descripteur a deplacer (referme en cas de deplacement)
+ * retourne le nouveau descripteur, ou -1 en cas d'erreur
+ */
+int moveShellFd( int fd );
+
 /*
  * Affiche le contenu d'une commande.
  *
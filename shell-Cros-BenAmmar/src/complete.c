@@ -0,0 +1,380 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : expand.h builtin.h memstat.h
+ *
+ *  Completion des mots de la ligne de commande (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "complete.h"
+#include "builtin.h"
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre max de repertoires de $PATH pris en compte (un bit par repertoire dans les noeuds du trie)
+#define MAX_PATH_DIRS   63
+
+// Bit des noeuds du trie associe aux builtins
+#define BUILTIN_BIT     ( (uint64_t)1 << MAX_PATH_DIRS )
+
+// Evenements surveilles sur les repertoires de $PATH
+#define WATCHED_EVENTS  ( IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_DELETE_SELF )
+
+// Noeud du trie des commandes. Les fils d'un noeud sont chaines entre eux, dans l'ordre des caracteres.
+// - c : caractere du noeud
+// - dirs : repertoires de $PATH qui contiennent la commande qui se termine sur ce noeud (un bit par
+//          repertoire, plus BUILTIN_BIT pour les builtins), ou 0 si aucune commande ne se termine ici
+// - child : premier fils
+// - sibling : frere suivant
+typedef struct TrieNode
+{
+    unsigned char c;
+    uint64_t dirs;
+    struct TrieNode* child;
+    struct TrieNode* sibling;
+} TrieNode;
+
+// Racine du trie des commandes
+static TrieNode commandTrie = { 0, 0, NULL, NULL };
+
+// Valeur de $PATH lors de la construction du trie (ou NULL si le trie n'est pas construit)
+static char* triePath = NULL;
+
+// Surveillance des repertoires de $PATH : descripteur inotify, et pour chaque repertoire, son chemin et
+// l'identifiant de sa surveillance
+static int inotifyFd = -1;
+static struct
+{
+    char* path;
+    int wd;
+} pathDirs[MAX_PATH_DIRS];
+static int pathDirCount = 0;
+
+/*
+ * Met a jour la presence d'une commande dans un repertoire de $PATH (ou parmi les builtins)
+ *
+ * name : nom de la commande
+ * bit : bit du repertoire
+ * present : si vrai, la commande est presente dans le repertoire, sinon elle en est retiree
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int updateTrie( const char* name, uint64_t bit, int present );
+
+/*
+ * Ajoute dans une liste, dans l'ordre, les commandes d'un sous-arbre du trie
+ *
+ * node : racine du sous-arbre
+ * name : buffer contenant le nom correspondant au noeud (taille NAME_MAX + 1)
+ * length : longueur du nom
+ * list : liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int collectCommands( const TrieNode* node, char* name, size_t length, WordList* list );
+
+/*
+ * Libere les noeuds d'un sous-arbre du trie
+ *
+ * node : premier noeud a liberer (ses freres et ses fils sont aussi liberes)
+ */
+static void freeTrieNodes( TrieNode* node );
+
+/*
+ * Construit le trie des commandes a partir des builtins et des repertoires de $PATH, et met en place la
+ * surveillance de ces repertoires
+ */
+static void buildCommandTrie( void );
+
+/*
+ * Met a jour le trie avant une completion : construction initiale ou apres une modification de $PATH, sinon
+ * prise en compte des evenements inotify en attente (sans attente)
+ */
+static void refreshCommandTrie( void );
+
+/*
+ * Met a jour le trie pour une entree d'un repertoire de $PATH (la commande est presente si c'est un fichier
+ * executable)
+ *
+ * iDir : index du repertoire
+ * name : nom de l'entree
+ * type : type de l'entree (DT_REG...), ou DT_UNKNOWN s'il n'est pas connu
+ */
+static void updateTrieEntry( int iDir, const char* name, unsigned char type );
+
+/*
+ * Recherche les chemins de fichiers qui completent un mot
+ *
+ * word : debut du chemin
+ * candidates : liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int getFileCompletions( const char* word, WordList* candidates );
+
+/*
+ * Comparaison de deux noms (pour qsort)
+ */
+static int compareNames( const void* a, const void* b );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int getCompletions( const char* word, int isCommand, WordList* candidates )
+{
+    // Chemins de fichiers
+    if( ! isCommand || strchr( word, '/' ) != NULL ) return( getFileCompletions( word, candidates ) );
+
+    // Commandes : trie a jour
+    refreshCommandTrie();
+
+    // Recherche du noeud correspondant au debut du mot
+    const TrieNode* node = &commandTrie;
+    for( const unsigned char* c = (const unsigned char*)word; *c != '\0' && node != NULL; ++c )
+    {
+        node = node->child;
+        while( node != NULL && node->c < *c ) node = node->sibling;
+        if( node != NULL && node->c != *c ) node = NULL;
+    }
+    if( node == NULL ) return( COMPLETE_OK );
+
+    // Toutes les commandes du sous-arbre completent le mot (elles sont deja triees)
+    char name[NAME_MAX + 1];
+    const size_t length = strlen( word );
+    if( length > NAME_MAX ) return( COMPLETE_OK );
+    strcpy( name, word );
+    return( collectCommands( node, name, length, candidates ) );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int updateTrie( const char* name, uint64_t bit, int present )
+{
+    // Descente dans le trie, en creant si besoin les noeuds manquants (a leur place parmi leurs freres)
+    TrieNode* node = &commandTrie;
+    for( const unsigned char* c = (const unsigned char*)name; *c != '\0'; ++c )
+    {
+        TrieNode** link = &node->child;
+        while( *link != NULL && (*link)->c < *c ) link = &(*link)->sibling;
+        if( *link == NULL || (*link)->c != *c )
+        {
+            // Inutile de creer des noeuds pour retirer une commande absente
+            if( ! present ) return( COMPLETE_OK );
+            TrieNode* newNode = (TrieNode*)calloc( 1, sizeof( TrieNode ) );
+            if( newNode == NULL ) return( COMPLETE_NO_MEMORY );
+            newNode->c = *c;
+            newNode->sibling = *link;
+            *link = newNode;
+        }
+        node = *link;
+    }
+
+    // Mise a jour du noeud de fin de la commande
+    if( present ) node->dirs |= bit;
+    else node->dirs &= ~bit;
+
+    return( COMPLETE_OK );
+}
+
+
+static int collectCommands( const TrieNode* node, char* name, size_t length, WordList* list )
+{
+    // Commande qui se termine sur ce noeud
+    if( node->dirs != 0 )
+    {
+        char* command = memStrdup( MEM_PARSER, name );
+        if( command == NULL || addWord( list, command ) != EXPAND_OK ) return( COMPLETE_NO_MEMORY );
+    }
+
+    // Commandes des fils (dans l'ordre des caracteres)
+    if( length >= NAME_MAX ) return( COMPLETE_OK );
+    for( const TrieNode* child = node->child; child != NULL; child = child->sibling )
+    {
+        name[length] = child->c;
+        name[length + 1] = '\0';
+        const int status = collectCommands( child, name, length + 1, list );
+        if( status != COMPLETE_OK ) return( status );
+    }
+    name[length] = '\0';
+
+    return( COMPLETE_OK );
+}
+
+
+static void freeTrieNodes( TrieNode* node )
+{
+    while( node != NULL )
+    {
+        TrieNode* sibling = node->sibling;
+        freeTrieNodes( node->child );
+        free( node );
+        node = sibling;
+    }
+}
+
+
+static void buildCommandTrie( void )
+{
+    // Destruction de l'eventuel trie precedent et de ses surveillances
+    freeTrieNodes( commandTrie.child );
+    commandTrie.child = NULL;
+    if( inotifyFd != -1 ) close( inotifyFd );
+    for( int i = 0; i < pathDirCount; ++i ) free( pathDirs[i].path );
+    pathDirCount = 0;
+    free( triePath );
+
+    // Builtins (et la commande 'exit', traitee directement par le minishell)
+    for( int i = 0; getBuiltinName( i ) != NULL; ++i ) updateTrie( getBuiltinName( i ), BUILTIN_BIT, 1 );
+    updateTrie( "exit", BUILTIN_BIT, 1 );
+
+    // Surveillance des repertoires de $PATH (mise en place avant leur lecture, pour ne manquer aucune
+    // modification)
+    const char* path = getenv( "PATH" );
+    triePath = strdup( path != NULL ? path : "" );
+    inotifyFd = moveShellFd( inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) );
+    char* copy = strdup( triePath );
+    char* savePtr = NULL;
+    for( char* dir = strtok_r( copy, ":", &savePtr ); dir != NULL && pathDirCount < MAX_PATH_DIRS;
+         dir = strtok_r( NULL, ":", &savePtr ) )
+    {
+        const int iDir = pathDirCount++;
+        pathDirs[iDir].path = strdup( dir );
+        pathDirs[iDir].wd = ( inotifyFd != -1 ? inotify_add_watch( inotifyFd, dir, WATCHED_EVENTS ) : -1 );
+
+        // Lecture du repertoire
+        DIR* stream = opendir( dir );
+        if( stream == NULL ) continue;
+        const struct dirent* entry = NULL;
+        while( ( entry = readdir( stream ) ) != NULL )
+        {
+            if( entry->d_type == DT_DIR ) continue;
+            updateTrieEntry( iDir, entry->d_name, entry->d_type );
+        }
+        closedir( stream );
+    }
+    free( copy );
+}
+
+
+static void refreshCommandTrie( void )
+{
+    // Construction initiale, ou apres une modification de $PATH
+    const char* path = getenv( "PATH" );
+    if( triePath == NULL || strcmp( triePath, path != NULL ? path : "" ) != 0 )
+    {
+        buildCommandTrie();
+        return;
+    }
+    if( inotifyFd == -1 ) return;
+
+    // Traitement des evenements en attente
+    char buff[16384] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+    ssize_t length = 0;
+    while( ( length = read( inotifyFd, buff, sizeof( buff ) ) ) > 0 )
+    {
+        for( char* p = buff; p < buff + length; )
+        {
+            const struct inotify_event* event = (const struct inotify_event*)p;
+            p += sizeof( struct inotify_event ) + event->len;
+
+            // Evenements perdus, ou repertoire supprime : le trie sera reconstruit a la prochaine completion
+            if( event->mask & ( IN_Q_OVERFLOW | IN_DELETE_SELF ) )
+            {
+                free( triePath );
+                triePath = NULL;
+                continue;
+            }
+
+            // Recherche du repertoire concerne, et mise a jour de l'entree
+            for( int iDir = 0; iDir < pathDirCount && event->len > 0; ++iDir )
+            {
+                if( pathDirs[iDir].wd == event->wd ) updateTrieEntry( iDir, event->name, DT_UNKNOWN );
+            }
+        }
+    }
+}
+
+
+static void updateTrieEntry( int iDir, const char* name, unsigned char type )
+{
+    // La commande est presente si l'entree est un fichier executable (les liens sont suivis). Le type de
+    // l'entree evite si possible un appel a stat().
+    char path[PATH_MAX];
+    struct stat st;
+    snprintf( path, sizeof( path ), "%s/%s", pathDirs[iDir].path, name );
+    const int isFile = ( type == DT_REG || ( stat( path, &st ) == 0 && ! S_ISDIR( st.st_mode ) ) );
+    const int present = ( isFile && access( path, X_OK ) == 0 );
+    updateTrie( name, (uint64_t)1 << iDir, present );
+}
+
+
+static int getFileCompletions( const char* word, WordList* candidates )
+{
+    // Separation du repertoire et du debut du nom
+    const char* slash = strrchr( word, '/' );
+    const size_t dirLength = ( slash != NULL ? (size_t)( slash - word ) + 1 : 0 );
+    const char* prefix = word + dirLength;
+    const size_t prefixLength = strlen( prefix );
+    char dir[PATH_MAX];
+    if( dirLength >= sizeof( dir ) ) return( COMPLETE_OK );
+    memcpy( dir, word, dirLength );
+    dir[dirLength] = '\0';
+
+    // Lecture du repertoire
+    DIR* stream = opendir( dirLength > 0 ? dir : "." );
+    if( stream == NULL ) return( COMPLETE_OK );
+    const int first = candidates->count;
+    const struct dirent* entry = NULL;
+    while( ( entry = readdir( stream ) ) != NULL )
+    {
+        // Les noms caches ne sont proposes que si le debut du nom commence par '.'
+        const char* name = entry->d_name;
+        if( strcmp( name, "." ) == 0 || strcmp( name, ".." ) == 0 ) continue;
+        if( name[0] == '.' && prefix[0] != '.' ) continue;
+        if( strncmp( name, prefix, prefixLength ) != 0 ) continue;
+
+        // Chemin complet (avec un '/' final pour un repertoire)
+        char path[PATH_MAX];
+        struct stat st;
+        snprintf( path, sizeof( path ), "%s%s", dir, name );
+        const int isDir = ( entry->d_type == DT_DIR ||
+                            ( ( entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN ) &&
+                              stat( path, &st ) == 0 && S_ISDIR( st.st_mode ) ) );
+        char* candidate = (char*)memAlloc( MEM_PARSER, strlen( path ) + 2 );
+        if( candidate == NULL ) break;
+        sprintf( candidate, "%s%s", path, isDir ? "/" : "" );
+        if( addWord( candidates, candidate ) != EXPAND_OK ) break;
+    }
+    closedir( stream );
+
+    // Tri des chemins
+    qsort( candidates->words + first, candidates->count - first, sizeof( char* ), compareNames );
+
+    return( COMPLETE_OK );
+}
+
+
+static int compareNames( const void* a, const void* b )
+{
+    return( strcoll( *(char* const*)a, *(char* const*)b ) );
+}
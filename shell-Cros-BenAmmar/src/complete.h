@@ -0,0 +1,44 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Completion des mots de la ligne de commande (touche Tab) :
+ *  - En position de commande : builtins et executables des repertoires de $PATH.
+ *  - Sinon (ou si le mot contient un '/') : chemins de fichiers.
+ *
+ *  Les noms des commandes sont ranges dans un arbre de prefixes (trie), construit une seule fois lors de la
+ *  premiere completion. Il est ensuite tenu a jour via des surveillances inotify sur les repertoires de $PATH :
+ *  les completions suivantes ne relisent jamais ces repertoires (sauf si $PATH est modifie).
+ */
+
+#ifndef _COMPLETE_H_
+#define _COMPLETE_H_
+
+#include "expand.h"
+
+
+// Codes d'erreur
+enum CompleteError
+{
+    COMPLETE_OK = 0,            // Pas d'erreur
+    COMPLETE_NO_MEMORY = 120    // Echec d'allocation memoire
+};
+
+
+/*
+ * Recherche les completions possibles d'un mot
+ *
+ * word : debut du mot a completer
+ * isCommand : si vrai, le mot est en position de commande
+ * candidates : en sortie, liste triee des mots complets possibles (les repertoires se terminent par '/')
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int getCompletions( const char* word, int isCommand, WordList* candidates );
+
+
+#endif // _COMPLETE_H_
@@ -0,0 +1,359 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h memstat.h options.h
+ *
+ *  Delais d'execution des commandes (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "deadline.h"
+#include "memstat.h"
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre de nanosecondes dans une seconde
+#define NS_PER_SECOND       1000000000LL
+
+// Message d'utilisation de la builtin 'timeout'
+static const char* TIMEOUT_USAGE = "ERREUR - Usage: timeout DUREE [-s SIGNAL] [-k DELAI] [--] CMD [ARGS...] "
+                                   "(DUREE et DELAI en secondes, ou suffixes ms, s, m, h, d)\n";
+
+// Noms des signaux acceptes par l'option -s (sans le prefixe "SIG")
+typedef struct
+{
+    const char* name;
+    int number;
+} SignalName;
+static const SignalName SIGNAL_NAMES[] =
+{
+    { "HUP", SIGHUP }, { "INT", SIGINT }, { "QUIT", SIGQUIT }, { "KILL", SIGKILL }, { "USR1", SIGUSR1 },
+    { "USR2", SIGUSR2 }, { "PIPE", SIGPIPE }, { "ALRM", SIGALRM }, { "TERM", SIGTERM }, { "CONT", SIGCONT },
+    { "STOP", SIGSTOP }
+};
+static const int SIGNAL_NAME_COUNT = sizeof( SIGNAL_NAMES ) / sizeof( SignalName );
+
+/*
+ * Decode une duree ("1.5", "500ms", "2m", ...)
+ *
+ * str : la duree (en secondes, ou suivie d'un suffixe ms, s, m, h ou d)
+ * duration : en sortie, la duree en nanosecondes
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseDuration( const char* str, int64_t* duration );
+
+/*
+ * Decode un signal, par son nom (avec ou sans le prefixe "SIG") ou son numero
+ *
+ * str : le signal
+ * signal : en sortie, le numero du signal
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseSignal( const char* str, int* signal );
+
+/*
+ * Retourne l'heure de la prochaine action sur le processus d'une commande : premier signal a l'expiration du
+ * delai, puis SIGKILL
+ *
+ * cmd : la commande
+ * retourne l'heure de la prochaine action (horloge monotone, en nanosecondes), ou 0 s'il n'y en a plus
+ */
+static int64_t getNextExpiration( const cmd_t* cmd );
+
+/*
+ * Envoie au processus d'une commande le signal correspondant a l'etape de son delai
+ *
+ * cmd : la commande
+ */
+static void expireDeadline( cmd_t* cmd );
+
+/*
+ * Arme un timerfd sur une heure de l'horloge monotone
+ *
+ * timerFd : le timerfd
+ * time : heure d'expiration, en nanosecondes (0 pour desarmer le timerfd)
+ * retourne 0 en cas de succes, -1 en cas d'erreur
+ */
+static int armTimer( int timerFd, int64_t time );
+
+/*
+ * Retourne l'heure courante de l'horloge monotone, en nanosecondes
+ */
+static int64_t getMonotonicTime( void );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int parseTimeout( cmd_t* cmd )
+{
+    // Decodage des options, avant ou apres la duree
+    int64_t duration = -1;
+    int iArg = 1;
+    while( cmd->argv[iArg] != NULL )
+    {
+        const char* arg = cmd->argv[iArg];
+
+        // Fin des options
+        if( strcmp( arg, "--" ) == 0 )
+        {
+            ++iArg;
+            break;
+        }
+
+        // Options avec une valeur
+        if( strcmp( arg, "-s" ) == 0 || strcmp( arg, "-k" ) == 0 )
+        {
+            const char* value = cmd->argv[iArg + 1];
+            int status = DEADLINE_BAD_ARGS;
+            if( value != NULL && arg[1] == 's' ) status = parseSignal( value, &cmd->timeoutSignal );
+            if( value != NULL && arg[1] == 'k' ) status = parseDuration( value, &cmd->timeoutKillAfter );
+            if( status != DEADLINE_OK )
+            {
+                fprintf( stderr, "%s", TIMEOUT_USAGE );
+                return( DEADLINE_BAD_ARGS );
+            }
+            iArg += 2;
+            continue;
+        }
+
+        // Sinon, la duree (une seule fois), puis la commande
+        if( duration != -1 ) break;
+        if( parseDuration( arg, &duration ) != DEADLINE_OK )
+        {
+            fprintf( stderr, "ERREUR - Duree incorrecte : %s\n", arg );
+            fprintf( stderr, "%s", TIMEOUT_USAGE );
+            return( DEADLINE_BAD_ARGS );
+        }
+        ++iArg;
+    }
+
+    // Il faut une duree, puis une commande
+    if( duration == -1 || cmd->argv[iArg] == NULL )
+    {
+        fprintf( stderr, "%s", TIMEOUT_USAGE );
+        return( DEADLINE_BAD_ARGS );
+    }
+
+    // Une duree nulle n'impose aucun delai (comme la commande timeout de coreutils)
+    cmd->timeout = duration;
+
+    // On retire les options de la liste des arguments (elles sont liberees, la commande restant dans le
+    // minishell) : la commande devient la commande a executer
+    for( int i = 0; i < iArg; ++i ) memFree( cmd->argv[i] );
+    int iDst = 0;
+    while( cmd->argv[iArg] != NULL ) cmd->argv[iDst++] = cmd->argv[iArg++];
+    cmd->argc = iDst;
+    while( iDst < iArg ) cmd->argv[iDst++] = NULL;
+    strcpy( cmd->path, cmd->argv[0] );
+
+    return( DEADLINE_OK );
+}
+
+
+void startDeadline( cmd_t* cmd )
+{
+    // Delai de la commande, sinon delai par defaut
+    int64_t timeout = cmd->timeout;
+    if( timeout == 0 ) timeout = getOption( OPTION_CMD_TIMEOUT ) * NS_PER_SECOND;
+    if( cmd->timeoutKillAfter < 0 ) cmd->timeoutKillAfter = getOption( OPTION_CMD_TIMEOUT_KILL ) * NS_PER_SECOND;
+
+    // Heure d'expiration
+    cmd->deadline = ( timeout > 0 ? getMonotonicTime() + timeout : 0 );
+    cmd->expired = 0;
+}
+
+
+int waitDeadline( cmd_t* cmd )
+{
+    // Pendant l'attente de la derniere commande d'un pipeline, les commandes precedentes (attendues ensuite)
+    // doivent aussi respecter leur delai
+    int hasDeadline = 0;
+    for( const cmd_t* current = cmd; current != NULL; current = current->pipePrev )
+    {
+        if( current->pid > 0 && current->deadline != 0 ) hasDeadline = 1;
+    }
+    if( ! hasDeadline ) return( DEADLINE_OK );
+
+    // Descripteur signalant la fin du processus, et timer de la prochaine expiration
+    const int pidFd = syscall( SYS_pidfd_open, cmd->pid, 0 );
+    if( pidFd == -1 ) return( DEADLINE_WAIT_FAILED );
+    const int timerFd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC );
+    if( timerFd == -1 )
+    {
+        close( pidFd );
+        return( DEADLINE_WAIT_FAILED );
+    }
+
+    // Jusqu'a la fin du processus
+    struct pollfd fds[2] = { { pidFd, POLLIN, 0 }, { timerFd, POLLIN, 0 } };
+    while( 1 )
+    {
+        // Interruption des processus dont le delai a expire, et prochaine expiration
+        const int64_t now = getMonotonicTime();
+        int64_t next = 0;
+        for( cmd_t* current = cmd; current != NULL; current = current->pipePrev )
+        {
+            // Apres une expiration, la suivante (SIGKILL) doit aussi etre programmee, ou envoyee si elle est deja
+            // passee
+            int64_t time = getNextExpiration( current );
+            while( time != 0 && time <= now )
+            {
+                expireDeadline( current );
+                time = getNextExpiration( current );
+            }
+            if( time != 0 && ( next == 0 || time < next ) ) next = time;
+        }
+        if( armTimer( timerFd, next ) == -1 ) break;
+
+        // Attente de la fin du processus ou de l'expiration du timer
+        if( poll( fds, 2, -1 ) == -1 )
+        {
+            // Interruption par un signal (SIGIO des sorties capturees, ...)
+            if( errno == EINTR )
+            {
+                pollBgCmdOutputs();
+                continue;
+            }
+            break;
+        }
+
+        // Processus termine
+        if( fds[0].revents != 0 ) break;
+
+        // Expiration du timer
+        uint64_t expirations = 0;
+        if( read( timerFd, &expirations, sizeof( expirations ) ) == -1 && errno != EAGAIN ) break;
+    }
+
+    close( timerFd );
+    close( pidFd );
+
+    return( DEADLINE_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int parseDuration( const char* str, int64_t* duration )
+{
+    // Nombre (eventuellement decimal)
+    char* end = NULL;
+    errno = 0;
+    const double value = strtod( str, &end );
+    if( end == str || errno != 0 || value < 0 ) return( DEADLINE_BAD_ARGS );
+
+    // Unite
+    double unit = 0;
+    if( strcmp( end, "" ) == 0 || strcmp( end, "s" ) == 0 ) unit = 1;
+    else if( strcmp( end, "ms" ) == 0 ) unit = 1e-3;
+    else if( strcmp( end, "m" ) == 0 ) unit = 60;
+    else if( strcmp( end, "h" ) == 0 ) unit = 3600;
+    else if( strcmp( end, "d" ) == 0 ) unit = 86400;
+    else return( DEADLINE_BAD_ARGS );
+
+    // Conversion en nanosecondes (limitee a une duree representable)
+    const double ns = value * unit * NS_PER_SECOND;
+    if( ns > 1e18 ) return( DEADLINE_BAD_ARGS );
+    *duration = (int64_t)ns;
+
+    return( DEADLINE_OK );
+}
+
+
+static int parseSignal( const char* str, int* signal )
+{
+    // Numero du signal
+    char* end = NULL;
+    const long number = strtol( str, &end, 10 );
+    if( end != str && *end == '\0' )
+    {
+        if( number <= 0 || number >= NSIG ) return( DEADLINE_BAD_ARGS );
+        *signal = (int)number;
+        return( DEADLINE_OK );
+    }
+
+    // Nom du signal, avec ou sans le prefixe "SIG"
+    const char* name = ( strncasecmp( str, "SIG", 3 ) == 0 ? str + 3 : str );
+    for( int i = 0; i < SIGNAL_NAME_COUNT; ++i )
+    {
+        if( strcasecmp( SIGNAL_NAMES[i].name, name ) == 0 )
+        {
+            *signal = SIGNAL_NAMES[i].number;
+            return( DEADLINE_OK );
+        }
+    }
+
+    return( DEADLINE_BAD_ARGS );
+}
+
+
+static int64_t getNextExpiration( const cmd_t* cmd )
+{
+    // Processus attendu par le minishell, avec un delai
+    if( cmd->pid <= 0 || cmd->deadline == 0 ) return( 0 );
+
+    // Premier signal a l'expiration, puis SIGKILL apres le second delai (sauf si le premier etait SIGKILL)
+    if( cmd->expired == 0 ) return( cmd->deadline );
+    if( cmd->expired == 1 && cmd->timeoutSignal != SIGKILL && cmd->timeoutKillAfter > 0 )
+    {
+        return( cmd->deadline + cmd->timeoutKillAfter );
+    }
+
+    return( 0 );
+}
+
+
+static void expireDeadline( cmd_t* cmd )
+{
+    if( cmd->expired == 0 )
+    {
+        kill( cmd->pid, cmd->timeoutSignal );
+
+        // Un processus arrete ne traiterait pas le signal avant d'etre relance
+        if( cmd->timeoutSignal != SIGKILL && cmd->timeoutSignal != SIGCONT ) kill( cmd->pid, SIGCONT );
+    }
+    else
+    {
+        kill( cmd->pid, SIGKILL );
+    }
+    ++cmd->expired;
+}
+
+
+static int armTimer( int timerFd, int64_t time )
+{
+    struct itimerspec spec;
+    memset( &spec, 0, sizeof( spec ) );
+    spec.it_value.tv_sec = time / NS_PER_SECOND;
+    spec.it_value.tv_nsec = time % NS_PER_SECOND;
+    return( timerfd_settime( timerFd, TFD_TIMER_ABSTIME, &spec, NULL ) );
+}
+
+
+static int64_t getMonotonicTime( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (int64_t)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec );
+}
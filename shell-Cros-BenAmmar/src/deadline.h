@@ -0,0 +1,70 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Delais d'execution des commandes : builtin 'timeout DUREE [-s SIGNAL] [-k DELAI] CMD [ARGS...]', et delai
+ *  par defaut de toutes les commandes au premier plan (option "cmd-timeout", en secondes, 0 pour aucun delai).
+ *
+ *  Le delai est surveille par le minishell lui-meme, pendant qu'il attend la fin de la commande (pas de
+ *  processus intermediaire) : un descripteur pidfd signale la fin du processus, et un timerfd l'expiration du
+ *  delai. A l'expiration, le signal choisi (SIGTERM par defaut) est envoye au processus, puis SIGKILL si le
+ *  processus n'est toujours pas termine apres le second delai (-k, par defaut l'option "cmd-timeout-kill", 0
+ *  pour ne pas insister). Une commande interrompue se termine avec le code de retour DEADLINE_EXIT_STATUS, que
+ *  les connecteurs '||' peuvent traiter comme tout autre echec.
+ *
+ *  Les delais ne s'appliquent qu'aux commandes executees par un processus et attendues par le minishell (les
+ *  commandes en background et les etapes executees dans des threads ne sont pas surveillees : une commande
+ *  avec un delai n'est jamais executee dans un thread).
+ */
+
+#ifndef _DEADLINE_H_
+#define _DEADLINE_H_
+
+#include "cmd.h"
+
+
+// Code de retour d'une commande interrompue a l'expiration de son delai (comme la commande timeout de coreutils)
+#define DEADLINE_EXIT_STATUS    124
+
+// Codes d'erreur
+enum DeadlineError
+{
+    DEADLINE_OK = 0,            // Pas d'erreur
+    DEADLINE_BAD_ARGS = 170,    // Erreur d'utilisation (arguments) de la builtin 'timeout'
+    DEADLINE_WAIT_FAILED        // Impossible de surveiller le processus (pidfd ou timerfd non disponible)
+};
+
+
+/*
+ * Decode les options de la builtin 'timeout', et les retire de la liste des arguments : la commande devient
+ * la commande a executer, avec son delai
+ *
+ * cmd : la commande 'timeout' (modifiee)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int parseTimeout( cmd_t* cmd );
+
+/*
+ * Arme le delai d'une commande au moment de son lancement (son propre delai, sinon le delai par defaut)
+ *
+ * cmd : la commande
+ */
+void startDeadline( cmd_t* cmd );
+
+/*
+ * Attend la fin du processus d'une commande en faisant respecter son delai, ainsi que celui des commandes
+ * precedentes du pipeline (rien n'est fait si aucune n'a de delai). Le processus n'est pas recupere (voir
+ * waitpid()) : il reste a l'attendre normalement. Le champ 'expired' des commandes interrompues est mis a jour.
+ *
+ * cmd : la commande
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int waitDeadline( cmd_t* cmd );
+
+
+#endif // _DEADLINE_H_
@@ -0,0 +1,390 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : complete.h expand.h
+ *
+ *  Saisie des lignes de commande (implementation)
+ */
+
+#include "editor.h"
+#include "complete.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Caracteres qui separent les mots pour la completion
+#define WORD_SEPARATORS " ;|&<>()"
+
+// Etat de la ligne en cours d'edition :
+// - prompt : prompt affiche devant la ligne
+// - buff : contenu de la ligne
+// - size : taille du buffer
+// - length : longueur de la ligne
+// - cursor : position du curseur dans la ligne
+typedef struct
+{
+    const char* prompt;
+    char* buff;
+    size_t size;
+    size_t length;
+    size_t cursor;
+} EditLine;
+
+/*
+ * Saisie d'une ligne en mode brut (l'entree standard est un terminal)
+ *
+ * line : la ligne a editer
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int editLine( EditLine* line );
+
+/*
+ * Reaffiche le prompt et la ligne, et replace le curseur
+ *
+ * line : la ligne
+ */
+static void refreshLine( const EditLine* line );
+
+/*
+ * Insere des caracteres a la position du curseur (dans la limite de la taille du buffer)
+ *
+ * line : la ligne
+ * text : caracteres a inserer
+ * length : nombre de caracteres
+ */
+static void insertText( EditLine* line, const char* text, size_t length );
+
+/*
+ * Supprime des caracteres de la ligne
+ *
+ * line : la ligne
+ * start : position du premier caractere a supprimer
+ * length : nombre de caracteres a supprimer
+ */
+static void deleteText( EditLine* line, size_t start, size_t length );
+
+/*
+ * Completion du mot qui precede le curseur
+ *
+ * line : la ligne
+ * showAll : si vrai et si plusieurs completions sont possibles sans debut commun a inserer, elles sont affichees
+ */
+static void completeLine( EditLine* line, int showAll );
+
+/*
+ * Teste si un mot est en position de commande (debut de ligne, ou apres un separateur de commandes)
+ *
+ * line : la ligne
+ * start : position du debut du mot
+ * retourne 1 si le mot est en position de commande, sinon 0
+ */
+static int isCommandPosition( const EditLine* line, size_t start );
+
+/*
+ * Affiche une liste de completions en colonnes, sous la ligne en cours
+ *
+ * candidates : completions a afficher
+ * skip : nombre de caracteres a ne pas afficher en debut de chaque completion (repertoire commun)
+ */
+static void showCandidates( const WordList* candidates, size_t skip );
+
+/*
+ * Ecrit une chaine de caracteres sur la sortie standard (sans passer par le buffer de stdout)
+ */
+static void writeString( const char* str );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int readLine( const char* prompt, char* line, size_t size )
+{
+    // Affichage du prompt
+    fputs( prompt, stdout );
+    fflush( stdout );
+
+    // Si l'entree standard est un terminal, saisie en mode brut
+    struct termios saved;
+    if( isatty( STDIN_FILENO ) && tcgetattr( STDIN_FILENO, &saved ) == 0 )
+    {
+        // Pas d'echo, lecture caractere par caractere (les signaux du terminal restent actifs)
+        struct termios raw = saved;
+        raw.c_lflag &= ~( ICANON | ECHO | IEXTEN );
+        raw.c_iflag &= ~( IXON | ICRNL );
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr( STDIN_FILENO, TCSADRAIN, &raw );
+
+        // Saisie de la ligne, puis restauration du mode du terminal pour les commandes
+        EditLine edit = { prompt, line, size, 0, 0 };
+        line[0] = '\0';
+        const int status = editLine( &edit );
+        tcsetattr( STDIN_FILENO, TCSADRAIN, &saved );
+        return( status );
+    }
+
+    // Sinon, simple lecture de la ligne
+    if( fgets( line, size, stdin ) == NULL ) return( EDITOR_EOF );
+
+    // Suppression du '\n' en fin de ligne
+    line[strcspn( line, "\n" )] = '\0';
+
+    return( EDITOR_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int editLine( EditLine* line )
+{
+    // Flag indiquant si la touche precedente etait Tab (un deuxieme Tab affiche les completions)
+    int lastWasTab = 0;
+
+    // Boucle de lecture des touches
+    while( 1 )
+    {
+        unsigned char c = 0;
+        const ssize_t n = read( STDIN_FILENO, &c, 1 );
+        if( n == -1 && errno == EINTR ) continue;
+        if( n <= 0 ) return( EDITOR_EOF );
+        const int isTab = ( c == '\t' );
+
+        // Fin de la ligne
+        if( c == '\r' || c == '\n' )
+        {
+            writeString( "\n" );
+            return( EDITOR_OK );
+        }
+
+        // Ctrl-D : fin de saisie sur une ligne vide, sinon suppression du caractere sous le curseur
+        else if( c == 4 )
+        {
+            if( line->length == 0 )
+            {
+                writeString( "\n" );
+                return( EDITOR_EOF );
+            }
+            if( line->cursor < line->length ) deleteText( line, line->cursor, 1 );
+        }
+
+        // Backspace
+        else if( c == 127 || c == 8 )
+        {
+            if( line->cursor > 0 ) deleteText( line, line->cursor - 1, 1 );
+        }
+
+        // Completion
+        else if( isTab )
+        {
+            completeLine( line, lastWasTab );
+        }
+
+        // Sequences d'echappement (fleches, Home, End, Suppr)
+        else if( c == 27 )
+        {
+            unsigned char seq[3] = {0};
+            if( read( STDIN_FILENO, seq, 1 ) != 1 || read( STDIN_FILENO, seq + 1, 1 ) != 1 ) continue;
+            if( seq[0] != '[' && seq[0] != 'O' ) continue;
+            if( seq[1] == 'C' && line->cursor < line->length ) ++line->cursor;
+            else if( seq[1] == 'D' && line->cursor > 0 ) --line->cursor;
+            else if( seq[1] == 'H' ) line->cursor = 0;
+            else if( seq[1] == 'F' ) line->cursor = line->length;
+            else if( seq[1] >= '0' && seq[1] <= '9' )
+            {
+                // Sequences de la forme "ESC [ n ~"
+                if( read( STDIN_FILENO, seq + 2, 1 ) != 1 || seq[2] != '~' ) continue;
+                if( seq[1] == '3' && line->cursor < line->length ) deleteText( line, line->cursor, 1 );
+                else if( seq[1] == '1' || seq[1] == '7' ) line->cursor = 0;
+                else if( seq[1] == '4' || seq[1] == '8' ) line->cursor = line->length;
+            }
+        }
+
+        // Raccourcis Ctrl-A, Ctrl-E, Ctrl-U, Ctrl-K, Ctrl-L
+        else if( c == 1 ) line->cursor = 0;
+        else if( c == 5 ) line->cursor = line->length;
+        else if( c == 21 ) deleteText( line, 0, line->cursor );
+        else if( c == 11 ) deleteText( line, line->cursor, line->length - line->cursor );
+        else if( c == 12 ) writeString( "\x1b[H\x1b[2J" );
+
+        // Caractere imprimable
+        else if( c >= 32 )
+        {
+            insertText( line, (const char*)&c, 1 );
+        }
+
+        // Reaffichage de la ligne
+        lastWasTab = isTab;
+        refreshLine( line );
+    }
+}
+
+
+static void refreshLine( const EditLine* line )
+{
+    // Retour en debut de ligne, prompt, contenu de la ligne et effacement de la fin de la ligne du terminal
+    char move[32];
+    writeString( "\r" );
+    writeString( line->prompt );
+    writeString( line->buff );
+    writeString( "\x1b[K" );
+
+    // Placement du curseur
+    if( line->cursor < line->length )
+    {
+        snprintf( move, sizeof( move ), "\x1b[%zuD", line->length - line->cursor );
+        writeString( move );
+    }
+}
+
+
+static void insertText( EditLine* line, const char* text, size_t length )
+{
+    // Place disponible (avec le '\0' final)
+    if( line->length + length >= line->size ) length = line->size - line->length - 1;
+
+    // Decalage de la fin de la ligne, puis insertion
+    memmove( line->buff + line->cursor + length, line->buff + line->cursor, line->length - line->cursor + 1 );
+    memcpy( line->buff + line->cursor, text, length );
+    line->length += length;
+    line->cursor += length;
+}
+
+
+static void deleteText( EditLine* line, size_t start, size_t length )
+{
+    // Decalage de la fin de la ligne
+    memmove( line->buff + start, line->buff + start + length, line->length - start - length + 1 );
+    line->length -= length;
+
+    // Mise a jour du curseur
+    if( line->cursor > start + length ) line->cursor -= length;
+    else if( line->cursor > start ) line->cursor = start;
+}
+
+
+static void completeLine( EditLine* line, int showAll )
+{
+    // Debut du mot qui precede le curseur
+    size_t start = line->cursor;
+    while( start > 0 && strchr( WORD_SEPARATORS, line->buff[start - 1] ) == NULL ) --start;
+    const size_t wordLength = line->cursor - start;
+    char* word = strndup( line->buff + start, wordLength );
+    if( word == NULL ) return;
+
+    // Longueur du repertoire du mot (non affiche dans la liste des completions)
+    const char* slash = strrchr( word, '/' );
+    const size_t dirLength = ( slash != NULL ? (size_t)( slash - word ) + 1 : 0 );
+
+    // Recherche des completions
+    WordList candidates;
+    initWordList( &candidates );
+    getCompletions( word, isCommandPosition( line, start ), &candidates );
+    free( word );
+
+    // Aucune completion : signal sonore
+    if( candidates.count == 0 )
+    {
+        writeString( "\a" );
+        freeWordList( &candidates );
+        return;
+    }
+
+    // Debut commun a toutes les completions
+    size_t common = strlen( candidates.words[0] );
+    for( int i = 1; i < candidates.count; ++i )
+    {
+        size_t j = 0;
+        while( j < common && candidates.words[i][j] == candidates.words[0][j] ) ++j;
+        common = j;
+    }
+
+    // Insertion de la partie manquante (suivie d'un espace si la completion est unique et n'est pas un
+    // repertoire)
+    if( common > wordLength )
+    {
+        insertText( line, candidates.words[0] + wordLength, common - wordLength );
+    }
+    if( candidates.count == 1 && candidates.words[0][common - 1] != '/' )
+    {
+        insertText( line, " ", 1 );
+    }
+
+    // Plusieurs completions sans debut commun supplementaire : affichage de la liste (au deuxieme Tab)
+    else if( candidates.count > 1 && common == wordLength )
+    {
+        if( showAll ) showCandidates( &candidates, dirLength );
+        else writeString( "\a" );
+    }
+
+    freeWordList( &candidates );
+}
+
+
+static int isCommandPosition( const EditLine* line, size_t start )
+{
+    // Recherche du caractere significatif qui precede le mot
+    size_t pos = start;
+    while( pos > 0 && line->buff[pos - 1] == ' ' ) --pos;
+
+    // Debut de ligne, ou separateur de commandes
+    return( pos == 0 || strchr( ";|&(", line->buff[pos - 1] ) != NULL );
+}
+
+
+static void showCandidates( const WordList* candidates, size_t skip )
+{
+    // Largeur du terminal et des colonnes
+    struct winsize ws;
+    const int width = ( ioctl( STDOUT_FILENO, TIOCGWINSZ, &ws ) == 0 && ws.ws_col > 0 ? ws.ws_col : 80 );
+    int columnWidth = 0;
+    for( int i = 0; i < candidates->count; ++i )
+    {
+        const int length = (int)strlen( candidates->words[i] + skip );
+        if( length > columnWidth ) columnWidth = length;
+    }
+    columnWidth += 2;
+    const int columns = ( width / columnWidth > 0 ? width / columnWidth : 1 );
+
+    // Affichage ligne par ligne, sous la ligne en cours
+    writeString( "\n" );
+    for( int i = 0; i < candidates->count; ++i )
+    {
+        writeString( candidates->words[i] + skip );
+        if( ( i + 1 ) % columns == 0 || i + 1 == candidates->count )
+        {
+            writeString( "\n" );
+            continue;
+        }
+
+        // Completion de la colonne par des espaces
+        for( int j = (int)strlen( candidates->words[i] + skip ); j < columnWidth; ++j ) writeString( " " );
+    }
+}
+
+
+static void writeString( const char* str )
+{
+    // Ecriture complete de la chaine
+    size_t length = strlen( str );
+    while( length > 0 )
+    {
+        const ssize_t written = write( STDOUT_FILENO, str, length );
+        if( written == -1 && errno == EINTR ) continue;
+        if( written <= 0 ) return;
+        str += written;
+        length -= written;
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Saisie des lignes de commande. Si l'entree standard est un terminal, la ligne est saisie en mode brut et
+ *  peut etre editee :
+ *  - Fleches gauche/droite, Home/End (ou Ctrl-A/Ctrl-E) : deplacement du curseur
+ *  - Backspace, Suppr : effacement d'un caractere
+ *  - Ctrl-U / Ctrl-K : effacement du debut / de la fin de la ligne
+ *  - Ctrl-L : effacement de l'ecran
+ *  - Ctrl-D : fin de saisie (sur une ligne vide)
+ *  - Tab : completion du mot sous le curseur (voir complete.h). Si plusieurs completions sont possibles, leur
+ *    debut commun est insere ; un deuxieme Tab affiche la liste des completions.
+ *  Sinon (fichier, pipe), la ligne est simplement lue.
+ */
+
+#ifndef _EDITOR_H_
+#define _EDITOR_H_
+
+#include <stddef.h>
+
+
+// Codes d'erreur
+enum EditorError
+{
+    EDITOR_OK = 0,              // Pas d'erreur
+    EDITOR_EOF = 110            // Fin de l'entree standard (ou erreur de lecture)
+};
+
+
+/*
+ * Affiche le prompt et saisit une ligne de commande
+ *
+ * prompt : prompt a afficher
+ * line : en sortie, la ligne saisie (sans '\n' final)
+ * size : taille du buffer de la ligne
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int readLine( const char* prompt, char* line, size_t size );
+
+
+#endif // _EDITOR_H_
@@ -0,0 +1,829 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : memstat.h
+ *
+ *  Expansion des mots de la ligne de commande (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "expand.h"
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre max de composants (separes par '/') d'un motif
+#define MAX_GLOB_COMPONENTS 64
+
+// Taille du buffer de lecture des entrees d'un repertoire (plusieurs centaines d'entrees par appel systeme)
+#define DIR_BUFFER_SIZE     65536
+
+// Types d'elements d'un motif compile
+enum MatchType
+{
+    MATCH_CHAR = 0,         // Caractere litteral
+    MATCH_ANY,              // Un caractere quelconque ("?")
+    MATCH_STAR,             // Une suite quelconque de caracteres ("*")
+    MATCH_CLASS             // Un caractere parmi un ensemble ("[...]")
+};
+
+// Element d'un motif compile :
+// - type : type de l'element (MatchType)
+// - c : caractere (MATCH_CHAR)
+// - set : ensemble des caracteres acceptes, un bit par caractere (MATCH_CLASS)
+typedef struct
+{
+    unsigned char type;
+    unsigned char c;
+    uint32_t set[8];
+} MatchItem;
+
+// Motif compile d'un composant de chemin :
+// - items : elements du motif
+// - count : nombre d'elements
+// - prefix : prefixe litteral du motif (pour un rejet rapide des noms)
+// - prefixLength : longueur du prefixe
+// - matchDot : flag indiquant si le motif peut correspondre a un nom cache (debut par '.')
+typedef struct
+{
+    MatchItem* items;
+    int count;
+    char prefix[NAME_MAX + 1];
+    size_t prefixLength;
+    int matchDot;
+} Matcher;
+
+// Contenu d'un repertoire (cache) :
+// - path : chemin du repertoire
+// - names : noms des entrees (a la suite, termines par '\0')
+// - namesSize : nombre d'octets utilises dans 'names'
+// - offsets : position du nom de chaque entree dans 'names'
+// - types : type de chaque entree (DT_DIR, DT_REG...)
+// - count : nombre d'entrees
+// - next : repertoire suivant dans le cache
+typedef struct DirListing
+{
+    char* path;
+    char* names;
+    size_t namesSize;
+    size_t* offsets;
+    unsigned char* types;
+    int count;
+    struct DirListing* next;
+} DirListing;
+
+// Entree renvoyee par l'appel systeme getdents64
+struct linux_dirent64
+{
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Cache des repertoires lus depuis le dernier appel a clearExpandCache() (propre a chaque thread qui analyse des
+// lignes de commande)
+static _Thread_local DirListing* dirCache = NULL;
+
+/*
+ * Recherche le premier groupe d'accolades valide d'un mot (liste d'alternatives separees par des virgules,
+ * ou intervalle). Les groupes precedes de '$' ne sont pas des groupes d'accolades.
+ *
+ * word : le mot
+ * open : en sortie, position de l'accolade ouvrante
+ * close : en sortie, position de l'accolade fermante correspondante
+ * retourne 1 si un groupe valide a ete trouve, sinon 0
+ */
+static int findBraceGroup( const char* word, const char** open, const char** close );
+
+/*
+ * Decode un intervalle d'accolades ("DEBUT..FIN" ou "DEBUT..FIN..PAS"), numerique ou alphabetique. Les bornes et
+ * le pas doivent tenir dans un long, et le nombre d'elements dans une liste de mots (sinon, le contenu n'est pas
+ * un intervalle).
+ *
+ * spec : contenu des accolades
+ * length : longueur du contenu
+ * first : en sortie, premier element de l'intervalle (caractere pour un intervalle alphabetique)
+ * step : en sortie, ecart entre deux elements successifs (negatif pour un intervalle decroissant)
+ * count : en sortie, nombre d'elements de l'intervalle
+ * width : en sortie, largeur minimale des nombres (bornes ecrites avec des zeros en tete), ou -1 pour un
+ *         intervalle alphabetique
+ * retourne 1 si le contenu est un intervalle, sinon 0
+ */
+static int parseBraceRange( const char* spec, size_t length, long* first, long* step, unsigned long* count,
+                            int* width );
+
+/*
+ * Expansion des accolades d'un mot : pour chaque mot genere (prefixe + alternative + suffixe), les groupes
+ * suivants sont expanses recursivement, puis les motifs de noms de fichiers
+ *
+ * word : le mot
+ * list : liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int expandBraces( const char* word, WordList* list );
+
+/*
+ * Genere un mot "prefixe + alternative + suffixe" et poursuit son expansion
+ *
+ * prefix : debut du mot (jusqu'a l'accolade ouvrante)
+ * prefixLength : longueur du prefixe
+ * alt : alternative
+ * altLength : longueur de l'alternative
+ * suffix : fin du mot (apres l'accolade fermante)
+ * list : liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int expandBraceAlternative( const char* prefix, size_t prefixLength, const char* alt, size_t altLength,
+                                   const char* suffix, WordList* list );
+
+/*
+ * Expansion des motifs de noms de fichiers d'un mot (le mot est conserve s'il ne correspond a aucun chemin)
+ *
+ * word : le mot
+ * list : liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int expandFileNames( const char* word, WordList* list );
+
+/*
+ * Compile le motif d'un composant de chemin
+ *
+ * pattern : motif a compiler
+ * matcher : en sortie, motif compile (a liberer via memFree( matcher->items ))
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int compileMatcher( const char* pattern, Matcher* matcher );
+
+/*
+ * Teste si un nom correspond a un motif compile
+ *
+ * matcher : motif compile
+ * name : nom a tester
+ * retourne 1 si le nom correspond, sinon 0
+ */
+static int matchName( const Matcher* matcher, const char* name );
+
+/*
+ * Retourne le contenu d'un repertoire, lu si besoin (sinon recupere dans le cache)
+ *
+ * path : chemin du repertoire
+ * retourne le contenu du repertoire, ou NULL si le repertoire ne peut pas etre lu
+ */
+static const DirListing* getDirListing( const char* path );
+
+/*
+ * Lit le contenu d'un repertoire via getdents64
+ *
+ * path : chemin du repertoire
+ * retourne le contenu du repertoire (a liberer via freeDirListing()), ou NULL en cas d'erreur
+ */
+static DirListing* readDirListing( const char* path );
+
+/*
+ * Libere le contenu d'un repertoire
+ *
+ * listing : contenu a liberer
+ */
+static void freeDirListing( DirListing* listing );
+
+/*
+ * Recherche recursive des chemins correspondant aux composants restants d'un motif
+ *
+ * path : chemin en cours de construction (buffer de taille PATH_MAX)
+ * pathLength : longueur du chemin en cours
+ * components : composants restants du motif
+ * matchers : motifs compiles des composants (pour les composants qui sont des motifs)
+ * count : nombre de composants restants
+ * list : liste des chemins trouves
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int globComponents( char* path, size_t pathLength, char** components, const Matcher* matchers, int count,
+                           WordList* list );
+
+/*
+ * Ajoute dans la liste les chemins correspondant a un motif, tries comme le fait bash
+ *
+ * pattern : le motif
+ * list : liste mise a jour
+ * retourne le nombre de chemins ajoutes
+ */
+static int expandGlob( const char* pattern, WordList* list );
+
+/*
+ * Comparaison de deux chemins (pour qsort)
+ */
+static int comparePaths( const void* a, const void* b );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+void initWordList( WordList* list )
+{
+    list->words = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+
+int addWord( WordList* list, char* word )
+{
+    // Agrandissement du tableau si besoin (avec la place du NULL final)
+    if( list->count == list->capacity )
+    {
+        const int capacity = ( list->capacity == 0 ? 16 : list->capacity * 2 );
+        char** words = (char**)memRealloc( MEM_PARSER, list->words, ( capacity + 1 ) * sizeof( char* ) );
+        if( words == NULL )
+        {
+            memFree( word );
+            return( EXPAND_NO_MEMORY );
+        }
+        list->words = words;
+        list->capacity = capacity;
+    }
+
+    // Ajout du mot
+    list->words[list->count++] = word;
+    list->words[list->count] = NULL;
+
+    return( EXPAND_OK );
+}
+
+
+void freeWordList( WordList* list )
+{
+    for( int i = 0; i < list->count; ++i ) memFree( list->words[i] );
+    memFree( list->words );
+    initWordList( list );
+}
+
+
+int hasGlobChars( const char* word )
+{
+    return( strpbrk( word, "*?[" ) != NULL );
+}
+
+
+int expandWord( const char* word, WordList* list )
+{
+    // Les accolades sont expansees en premier, puis les motifs de noms de fichiers de chaque mot obtenu
+    return( expandBraces( word, list ) );
+}
+
+
+void clearExpandCache( void )
+{
+    while( dirCache != NULL )
+    {
+        DirListing* next = dirCache->next;
+        freeDirListing( dirCache );
+        dirCache = next;
+    }
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int findBraceGroup( const char* word, const char** open, const char** close )
+{
+    // Pour chaque accolade ouvrante (qui ne fait pas partie d'une variable "${...}")
+    for( const char* p = strchr( word, '{' ); p != NULL; p = strchr( p + 1, '{' ) )
+    {
+        if( p > word && p[-1] == '$' ) continue;
+
+        // Recherche de l'accolade fermante correspondante, et d'une virgule de premier niveau
+        int depth = 0;
+        int hasComma = 0;
+        const char* end = p;
+        for( ; *end != '\0'; ++end )
+        {
+            if( *end == '{' ) ++depth;
+            else if( *end == '}' && --depth == 0 ) break;
+            else if( *end == ',' && depth == 1 ) hasComma = 1;
+        }
+        if( *end == '\0' ) return( 0 );
+
+        // Le groupe est valide s'il contient une liste ou un intervalle
+        long first, step;
+        unsigned long count;
+        int width;
+        if( hasComma || parseBraceRange( p + 1, end - p - 1, &first, &step, &count, &width ) )
+        {
+            *open = p;
+            *close = end;
+            return( 1 );
+        }
+    }
+
+    return( 0 );
+}
+
+
+static int parseBraceRange( const char* spec, size_t length, long* first, long* step, unsigned long* count,
+                            int* width )
+{
+    // Copie du contenu, decoupe en bornes et pas
+    char buff[64];
+    if( length >= sizeof( buff ) ) return( 0 );
+    memcpy( buff, spec, length );
+    buff[length] = '\0';
+    char* from = buff;
+    char* to = strstr( from, ".." );
+    if( to == NULL ) return( 0 );
+    *to = '\0';
+    to += 2;
+    char* by = strstr( to, ".." );
+    if( by != NULL )
+    {
+        *by = '\0';
+        by += 2;
+    }
+
+    // Pas (valeur absolue, le sens est donne par les bornes)
+    long absStep = 1;
+    if( by != NULL )
+    {
+        char* end = NULL;
+        errno = 0;
+        absStep = strtol( by, &end, 10 );
+        if( *by == '\0' || *end != '\0' || errno == ERANGE || absStep == LONG_MIN ) return( 0 );
+        absStep = labs( absStep );
+        if( absStep == 0 ) absStep = 1;
+    }
+
+    // Bornes : alphabetiques, ou numeriques (hors de l'intervalle d'un long, le contenu n'est pas un intervalle)
+    long last = 0;
+    *width = -1;
+    if( strlen( from ) == 1 && strlen( to ) == 1 && isalpha( (unsigned char)from[0] ) &&
+        isalpha( (unsigned char)to[0] ) )
+    {
+        *first = from[0];
+        last = to[0];
+    }
+    else
+    {
+        char* endFrom = NULL;
+        char* endTo = NULL;
+        errno = 0;
+        *first = strtol( from, &endFrom, 10 );
+        last = strtol( to, &endTo, 10 );
+        if( *from == '\0' || *to == '\0' || *endFrom != '\0' || *endTo != '\0' || errno == ERANGE ) return( 0 );
+
+        // Largeur des nombres : les bornes ecrites avec des zeros en tete imposent leur largeur
+        *width = 0;
+        const char* digitsFrom = from + ( *from == '-' );
+        const char* digitsTo = to + ( *to == '-' );
+        if( ( digitsFrom[0] == '0' && digitsFrom[1] != '\0' ) || ( digitsTo[0] == '0' && digitsTo[1] != '\0' ) )
+        {
+            *width = (int)( strlen( from ) > strlen( to ) ? strlen( from ) : strlen( to ) );
+        }
+    }
+
+    // Nombre d'elements, calcule en non signe (l'ecart entre les bornes peut depasser LONG_MAX), et limite a la
+    // taille d'une liste de mots
+    const unsigned long span = ( *first <= last ? (unsigned long)last - (unsigned long)*first :
+                                                  (unsigned long)*first - (unsigned long)last );
+    *count = span / (unsigned long)absStep + 1;
+    if( span / (unsigned long)absStep >= INT_MAX ) return( 0 );
+    *step = ( *first <= last ? absStep : -absStep );
+
+    return( 1 );
+}
+
+
+static int expandBraces( const char* word, WordList* list )
+{
+    // Sans groupe d'accolades, on passe aux motifs de noms de fichiers
+    const char* open = NULL;
+    const char* close = NULL;
+    if( ! findBraceGroup( word, &open, &close ) ) return( expandFileNames( word, list ) );
+    const size_t prefixLength = open - word;
+    const char* content = open + 1;
+    const size_t contentLength = close - content;
+
+    // Intervalle : les elements sont generes un par un. Chaque element est compris entre les bornes, mais son
+    // ecart au premier peut depasser LONG_MAX : il est calcule en non signe.
+    long first, step;
+    unsigned long count;
+    int width;
+    if( parseBraceRange( content, contentLength, &first, &step, &count, &width ) )
+    {
+        for( unsigned long i = 0; i < count; ++i )
+        {
+            const unsigned long offset = i * (unsigned long)step;
+            const long value = (long)( (unsigned long)first + offset );
+            char alt[32];
+            int altLength = 0;
+            if( width < 0 ) altLength = snprintf( alt, sizeof( alt ), "%c", (char)value );
+            else if( value < 0 ) altLength = snprintf( alt, sizeof( alt ), "-%0*lu", width > 0 ? width - 1 : 0,
+                                                       0UL - (unsigned long)value );
+            else altLength = snprintf( alt, sizeof( alt ), "%0*ld", width, value );
+
+            const int status = expandBraceAlternative( word, prefixLength, alt, altLength, close + 1, list );
+            if( status != EXPAND_OK ) return( status );
+        }
+        return( EXPAND_OK );
+    }
+
+    // Liste : chaque alternative de premier niveau est traitee dans l'ordre
+    const char* alt = content;
+    int depth = 0;
+    for( const char* p = content; p <= close; ++p )
+    {
+        if( *p == '{' ) ++depth;
+        else if( *p == '}' && depth > 0 ) --depth;
+        else if( ( *p == ',' && depth == 0 ) || p == close )
+        {
+            const int status = expandBraceAlternative( word, prefixLength, alt, p - alt, close + 1, list );
+            if( status != EXPAND_OK ) return( status );
+            alt = p + 1;
+        }
+    }
+
+    return( EXPAND_OK );
+}
+
+
+static int expandBraceAlternative( const char* prefix, size_t prefixLength, const char* alt, size_t altLength,
+                                   const char* suffix, WordList* list )
+{
+    // Un mot vide du seul fait des accolades ne produit pas d'argument (comme "{,x}" dans bash)
+    const size_t suffixLength = strlen( suffix );
+    if( prefixLength + altLength + suffixLength == 0 ) return( EXPAND_OK );
+
+    // Construction du mot genere
+    char* word = (char*)memAlloc( MEM_PARSER, prefixLength + altLength + suffixLength + 1 );
+    if( word == NULL ) return( EXPAND_NO_MEMORY );
+    memcpy( word, prefix, prefixLength );
+    memcpy( word + prefixLength, alt, altLength );
+    memcpy( word + prefixLength + altLength, suffix, suffixLength + 1 );
+
+    // Expansion des groupes suivants (ou imbriques dans l'alternative)
+    const int status = expandBraces( word, list );
+    memFree( word );
+
+    return( status );
+}
+
+
+static int expandFileNames( const char* word, WordList* list )
+{
+    // Motif de noms de fichiers : s'il correspond a des chemins, ils remplacent le mot
+    if( hasGlobChars( word ) && expandGlob( word, list ) > 0 ) return( EXPAND_OK );
+
+    // Sinon, le mot est conserve tel quel
+    char* copy = memStrdup( MEM_PARSER, word );
+    if( copy == NULL ) return( EXPAND_NO_MEMORY );
+    return( addWord( list, copy ) );
+}
+
+
+static int compileMatcher( const char* pattern, Matcher* matcher )
+{
+    // Un element au plus par caractere du motif
+    matcher->items = (MatchItem*)memAlloc( MEM_PARSER, ( strlen( pattern ) + 1 ) * sizeof( MatchItem ) );
+    if( matcher->items == NULL ) return( EXPAND_NO_MEMORY );
+    matcher->count = 0;
+    matcher->prefixLength = 0;
+
+    // Les noms caches ne correspondent que si le motif commence explicitement par '.'
+    matcher->matchDot = ( pattern[0] == '.' );
+
+    // Pour chaque caractere du motif
+    int literalPrefix = 1;
+    const char* p = pattern;
+    while( *p != '\0' )
+    {
+        MatchItem* item = matcher->items + matcher->count++;
+        memset( item, 0, sizeof( MatchItem ) );
+
+        // Suite quelconque de caracteres (plusieurs '*' consecutifs equivalent a un seul)
+        if( *p == '*' )
+        {
+            item->type = MATCH_STAR;
+            while( *p == '*' ) ++p;
+        }
+
+        // Caractere quelconque
+        else if( *p == '?' )
+        {
+            item->type = MATCH_ANY;
+            ++p;
+        }
+
+        // Ensemble de caracteres, s'il est bien termine par ']' (un ']' en premiere position est litteral)
+        else if( *p == '[' && strchr( p + ( p[1] == '!' || p[1] == '^' ? 3 : 2 ), ']' ) != NULL )
+        {
+            item->type = MATCH_CLASS;
+            const int negate = ( p[1] == '!' || p[1] == '^' );
+            const unsigned char* c = (const unsigned char*)p + 1 + negate;
+            int first = 1;
+            while( first || *c != ']' )
+            {
+                // Intervalle de caracteres ("a-z"), ou caractere isole
+                unsigned int low = *c;
+                unsigned int high = *c;
+                if( c[1] == '-' && c[2] != ']' && c[2] != '\0' )
+                {
+                    high = c[2];
+                    c += 2;
+                }
+                for( unsigned int x = low; x <= high; ++x ) item->set[x / 32] |= ( 1u << ( x % 32 ) );
+                ++c;
+                first = 0;
+            }
+            if( negate ) for( int i = 0; i < 8; ++i ) item->set[i] = ~item->set[i];
+
+            // Le separateur de chemin n'est jamais accepte
+            item->set['/' / 32] &= ~( 1u << ( '/' % 32 ) );
+            p = (const char*)c + 1;
+        }
+
+        // Caractere litteral
+        else
+        {
+            item->type = MATCH_CHAR;
+            item->c = (unsigned char)*p++;
+        }
+
+        // Mise a jour du prefixe litteral (limite a NAME_MAX caracteres : les suivants sont compares element par
+        // element, comme le reste du motif)
+        if( item->type != MATCH_CHAR || matcher->prefixLength == NAME_MAX ) literalPrefix = 0;
+        if( literalPrefix ) matcher->prefix[matcher->prefixLength++] = item->c;
+    }
+    matcher->prefix[matcher->prefixLength] = '\0';
+
+    return( EXPAND_OK );
+}
+
+
+static int matchName( const Matcher* matcher, const char* name )
+{
+    // Rejets rapides : nom cache et prefixe litteral
+    if( name[0] == '.' && ! matcher->matchDot ) return( 0 );
+    if( strncmp( name, matcher->prefix, matcher->prefixLength ) != 0 ) return( 0 );
+
+    // Comparaison element par element. En cas d'echec apres un '*', on reprend juste apres ce '*' en lui
+    // faisant absorber un caractere de plus (seul le dernier '*' rencontre doit etre remis en cause).
+    const MatchItem* items = matcher->items;
+    const unsigned char* s = (const unsigned char*)name + matcher->prefixLength;
+    int i = (int)matcher->prefixLength;
+    int starItem = -1;
+    const unsigned char* starPos = NULL;
+    while( *s != '\0' )
+    {
+        if( i < matcher->count )
+        {
+            const MatchItem* item = items + i;
+            if( item->type == MATCH_STAR )
+            {
+                starItem = ++i;
+                starPos = s;
+                continue;
+            }
+            if( ( item->type == MATCH_CHAR && item->c == *s ) || item->type == MATCH_ANY ||
+                ( item->type == MATCH_CLASS && ( item->set[*s / 32] & ( 1u << ( *s % 32 ) ) ) ) )
+            {
+                ++i;
+                ++s;
+                continue;
+            }
+        }
+        if( starItem == -1 ) return( 0 );
+        i = starItem;
+        s = ++starPos;
+    }
+
+    // Le nom est epuise : seuls des '*' peuvent rester dans le motif
+    while( i < matcher->count && items[i].type == MATCH_STAR ) ++i;
+    return( i == matcher->count );
+}
+
+
+static const DirListing* getDirListing( const char* path )
+{
+    // Recherche dans le cache
+    for( const DirListing* listing = dirCache; listing != NULL; listing = listing->next )
+    {
+        if( strcmp( listing->path, path ) == 0 ) return( listing );
+    }
+
+    // Lecture du repertoire, et ajout dans le cache
+    DirListing* listing = readDirListing( path );
+    if( listing == NULL ) return( NULL );
+    listing->next = dirCache;
+    dirCache = listing;
+
+    return( listing );
+}
+
+
+static DirListing* readDirListing( const char* path )
+{
+    // Ouverture du repertoire
+    const int fd = openat( AT_FDCWD, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if( fd == -1 ) return( NULL );
+
+    // Contenu vide, et buffer de lecture des entrees (propre a l'appel : plusieurs threads peuvent lire des
+    // repertoires en meme temps)
+    DirListing* listing = (DirListing*)memCalloc( MEM_PARSER, 1, sizeof( DirListing ) );
+    char* buff = (char*)memAlloc( MEM_PARSER, DIR_BUFFER_SIZE );
+    if( listing == NULL || buff == NULL || ( listing->path = memStrdup( MEM_PARSER, path ) ) == NULL )
+    {
+        memFree( listing );
+        memFree( buff );
+        close( fd );
+        return( NULL );
+    }
+    size_t namesCapacity = 0;
+    int capacity = 0;
+
+    // Lecture des entrees par blocs (plusieurs centaines d'entrees par appel systeme)
+    long length = 0;
+    while( ( length = syscall( SYS_getdents64, fd, buff, DIR_BUFFER_SIZE ) ) > 0 )
+    {
+        for( long pos = 0; pos < length; )
+        {
+            const struct linux_dirent64* entry = (const struct linux_dirent64*)( buff + pos );
+            pos += entry->d_reclen;
+
+            // Les entrees "." et ".." ne sont jamais retenues
+            const char* name = entry->d_name;
+            if( name[0] == '.' && ( name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' ) ) ) continue;
+
+            // Agrandissement des tableaux si besoin
+            const size_t nameSize = strlen( name ) + 1;
+            if( listing->namesSize + nameSize > namesCapacity )
+            {
+                namesCapacity = ( namesCapacity + nameSize ) * 2;
+                char* names = (char*)memRealloc( MEM_PARSER, listing->names, namesCapacity );
+                if( names == NULL ) break;
+                listing->names = names;
+            }
+            if( listing->count == capacity )
+            {
+                capacity = ( capacity == 0 ? 256 : capacity * 2 );
+                size_t* offsets = (size_t*)memRealloc( MEM_PARSER, listing->offsets, capacity * sizeof( size_t ) );
+                if( offsets != NULL ) listing->offsets = offsets;
+                unsigned char* types = (unsigned char*)memRealloc( MEM_PARSER, listing->types, capacity );
+                if( types != NULL ) listing->types = types;
+                if( offsets == NULL || types == NULL ) break;
+            }
+
+            // Ajout de l'entree
+            memcpy( listing->names + listing->namesSize, name, nameSize );
+            listing->offsets[listing->count] = listing->namesSize;
+            listing->types[listing->count] = entry->d_type;
+            listing->namesSize += nameSize;
+            ++listing->count;
+        }
+    }
+
+    memFree( buff );
+    close( fd );
+    return( listing );
+}
+
+
+static void freeDirListing( DirListing* listing )
+{
+    memFree( listing->path );
+    memFree( listing->names );
+    memFree( listing->offsets );
+    memFree( listing->types );
+    memFree( listing );
+}
+
+
+static int globComponents( char* path, size_t pathLength, char** components, const Matcher* matchers, int count,
+                           WordList* list )
+{
+    // Tous les composants ont ete traites : le chemin construit correspond au motif
+    if( count == 0 )
+    {
+        char* match = memStrdup( MEM_PARSER, path );
+        if( match == NULL ) return( EXPAND_NO_MEMORY );
+        return( addWord( list, match ) );
+    }
+
+    // Composant litteral : il est simplement ajoute au chemin (son existence est verifiee par la lecture du
+    // repertoire suivant, ou directement s'il s'agit du dernier composant)
+    const char* component = components[0];
+    if( matchers[0].items == NULL )
+    {
+        const size_t length = strlen( component );
+        if( pathLength + length + 2 > PATH_MAX ) return( EXPAND_OK );
+        memcpy( path + pathLength, component, length );
+        size_t newLength = pathLength + length;
+        if( count > 1 ) path[newLength++] = '/';
+        path[newLength] = '\0';
+        struct stat st;
+        if( count == 1 && lstat( path, &st ) == -1 ) return( EXPAND_OK );
+        return( globComponents( path, newLength, components + 1, matchers + 1, count - 1, list ) );
+    }
+
+    // Composant motif : lecture (ou recuperation dans le cache) du repertoire courant du chemin
+    const DirListing* listing = getDirListing( pathLength == 0 ? "." : path );
+    if( listing == NULL ) return( EXPAND_OK );
+
+    // Pour chaque entree du repertoire qui correspond au motif
+    for( int i = 0; i < listing->count; ++i )
+    {
+        const char* name = listing->names + listing->offsets[i];
+        if( ! matchName( matchers, name ) ) continue;
+
+        // Construction du chemin de l'entree
+        const size_t length = strlen( name );
+        if( pathLength + length + 2 > PATH_MAX ) continue;
+        memcpy( path + pathLength, name, length + 1 );
+
+        // S'il reste des composants, l'entree doit etre un repertoire (le type n'est pas toujours fourni
+        // par le systeme de fichiers, et un lien doit etre suivi)
+        size_t newLength = pathLength + length;
+        if( count > 1 )
+        {
+            const unsigned char type = listing->types[i];
+            struct stat st;
+            if( type != DT_DIR && ( ( type != DT_LNK && type != DT_UNKNOWN ) || stat( path, &st ) == -1 ||
+                                    ! S_ISDIR( st.st_mode ) ) ) continue;
+            path[newLength++] = '/';
+            path[newLength] = '\0';
+        }
+
+        // Traitement des composants suivants
+        const int status = globComponents( path, newLength, components + 1, matchers + 1, count - 1, list );
+        if( status != EXPAND_OK ) return( status );
+    }
+    path[pathLength] = '\0';
+
+    return( EXPAND_OK );
+}
+
+
+static int expandGlob( const char* pattern, WordList* list )
+{
+    // Copie du motif, decoupee en composants
+    char copy[PATH_MAX];
+    if( strlen( pattern ) >= PATH_MAX ) return( 0 );
+    strcpy( copy, pattern );
+    char* components[MAX_GLOB_COMPONENTS];
+    int count = 0;
+    char* p = copy + ( copy[0] == '/' ? 1 : 0 );
+    while( p != NULL )
+    {
+        if( count == MAX_GLOB_COMPONENTS ) return( 0 );
+        components[count++] = p;
+        p = strchr( p, '/' );
+        if( p != NULL ) *p++ = '\0';
+    }
+
+    // Compilation des composants qui sont des motifs
+    Matcher matchers[MAX_GLOB_COMPONENTS];
+    int status = EXPAND_OK;
+    for( int i = 0; i < count; ++i )
+    {
+        matchers[i].items = NULL;
+        if( status == EXPAND_OK && hasGlobChars( components[i] ) ) status = compileMatcher( components[i], matchers + i );
+    }
+
+    // Recherche des chemins (a partir de la racine pour un motif absolu)
+    const int first = list->count;
+    char path[PATH_MAX] = {'\0'};
+    size_t pathLength = 0;
+    if( pattern[0] == '/' ) path[pathLength++] = '/';
+    if( status == EXPAND_OK ) globComponents( path, pathLength, components, matchers, count, list );
+    for( int i = 0; i < count; ++i ) memFree( matchers[i].items );
+
+    // Tri des chemins trouves
+    qsort( list->words + first, list->count - first, sizeof( char* ), comparePaths );
+
+    return( list->count - first );
+}
+
+
+static int comparePaths( const void* a, const void* b )
+{
+    return( strcoll( *(char* const*)a, *(char* const*)b ) );
+}
@@ -0,0 +1,97 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Expansion des mots de la ligne de commande en listes d'arguments :
+ *  - Accolades : listes ("a{b,c}d" donne "abd acd") et intervalles numeriques ou alphabetiques ("{1..10}",
+ *    "{01..10..2}", "{a..e}"), eventuellement imbriquees. Les mots sont generes un par un, au fur et a mesure
+ *    du parcours des accolades (sans construire la liste des alternatives de chaque groupe), mais tous sont
+ *    ajoutes a la liste d'arguments : un intervalle de N elements produit N mots en memoire. Un mot vide
+ *    uniquement du fait des accolades ("{,x}") n'est pas conserve.
+ *  - Motifs de noms de fichiers ("*", "?" et "[...]"), remplaces par la liste triee des chemins correspondants
+ *    (le mot est conserve tel quel si aucun chemin ne correspond).
+ *
+ *  Les repertoires sont lus en une fois (via getdents64) et conserves dans un cache jusqu'a l'appel de
+ *  clearExpandCache() : plusieurs motifs d'une meme ligne de commande portant sur un meme repertoire ne le
+ *  lisent donc qu'une seule fois.
+ */
+
+#ifndef _EXPAND_H_
+#define _EXPAND_H_
+
+
+// Codes d'erreur
+enum ExpandError
+{
+    EXPAND_OK = 0,              // Pas d'erreur
+    EXPAND_NO_MEMORY = 100      // Echec d'allocation memoire
+};
+
+/*
+ * Liste dynamique de mots
+ *
+ * words : tableau des mots (alloues via memAlloc()), termine par NULL
+ * count : nombre de mots
+ * capacity : taille allouee du tableau (hors NULL final)
+ */
+typedef struct
+{
+    char** words;
+    int count;
+    int capacity;
+} WordList;
+
+
+/*
+ * Initialise une liste de mots vide
+ *
+ * list : la liste a initialiser
+ */
+void initWordList( WordList* list );
+
+/*
+ * Ajoute un mot en fin de liste. La liste devient proprietaire du mot.
+ *
+ * list : la liste
+ * word : le mot a ajouter (alloue via memAlloc() ou memStrdup(), voir memstat.h)
+ * retourne 0 en cas de succes, sinon un code d'erreur (le mot est alors libere)
+ */
+int addWord( WordList* list, char* word );
+
+/*
+ * Libere les mots d'une liste, et la liste elle-meme
+ *
+ * list : la liste a liberer
+ */
+void freeWordList( WordList* list );
+
+/*
+ * Teste si un mot contient des caracteres de motif de noms de fichiers ("*", "?" ou "[")
+ *
+ * word : le mot a tester
+ * retourne 1 si le mot est un motif, sinon 0
+ */
+int hasGlobChars( const char* word );
+
+/*
+ * Expanse un mot de la ligne de commande, et ajoute le ou les mots obtenus en fin de liste
+ *
+ * word : le mot a expanser
+ * list : la liste mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int expandWord( const char* word, WordList* list );
+
+/*
+ * Vide le cache des repertoires lus. A appeler apres le traitement de chaque ligne de commande, pour que les
+ * lignes suivantes voient les modifications des repertoires.
+ */
+void clearExpandCache( void );
+
+
+#endif // _EXPAND_H_
@@ -0,0 +1,273 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h
+ *
+ *  Diffusion de la sortie d'une commande vers plusieurs pipelines (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "fanout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre max d'octets par transfert (tee ou splice)
+#define FANOUT_CHUNK        ( 1024 * 1024 )
+
+// Etape de la diffusion vers une sortie : les donnees de la file d'entree sont dupliquees dans la sortie, puis
+// deplacees dans la file de l'etape suivante
+//
+// in : file d'entree (le pipe du producteur pour la premiere etape, sinon un pipe interne)
+// out : sortie (pipe vers un pipeline), ou -1 si elle est fermee
+// next : entree de la file de l'etape suivante, ou -1 pour la derniere etape (les donnees sont alors deplacees
+//        directement dans la sortie)
+// pending : nombre d'octets en tete de la file d'entree deja dupliques dans la sortie, mais pas encore deplaces
+//           dans la file suivante
+// done : vrai si toutes les donnees ont ete traitees
+typedef struct
+{
+    int in;
+    int out;
+    int next;
+    size_t pending;
+    int done;
+} FanoutStep;
+
+/*
+ * Referme, dans le processus de diffusion, tous les descripteurs herites du minishell autres que l'entree
+ * standard, les sorties standard/erreur et les sorties de la diffusion (en particulier les autres extremites
+ * des pipes, qui empecheraient de detecter la fin d'un pipeline)
+ *
+ * cmd : la commande de diffusion
+ */
+static void closeOtherFds( const cmd_t* cmd );
+
+/*
+ * Fait avancer une etape de la diffusion, sans attente
+ *
+ * step : l'etape
+ * wait : en sortie, si l'etape est bloquee, descripteur et evenement a attendre
+ * retourne 1 si l'etape a avance, 0 si elle est bloquee, ou -1 en cas d'erreur
+ */
+static int runStep( FanoutStep* step, struct pollfd* wait );
+
+/*
+ * Termine une etape : sa sortie et la file suivante sont refermees (fin des donnees pour le pipeline et pour
+ * l'etape suivante)
+ *
+ * step : l'etape
+ */
+static void endStep( FanoutStep* step );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int runFanout( const cmd_t* cmd )
+{
+    // Un pipeline termine est detecte par l'echec des ecritures (EPIPE), et non par le signal SIGPIPE
+    signal( SIGPIPE, SIG_IGN );
+    closeOtherFds( cmd );
+
+    // Etapes, reliees par des files internes (toutes les lectures sont non bloquantes)
+    FanoutStep steps[MAX_FANOUT];
+    const int count = cmd->fanoutCount;
+    fcntl( STDIN_FILENO, F_SETFL, fcntl( STDIN_FILENO, F_GETFL ) | O_NONBLOCK );
+    for( int i = 0; i < count; ++i )
+    {
+        steps[i].out = cmd->fanoutFds[i];
+        steps[i].next = -1;
+        steps[i].pending = 0;
+        steps[i].done = 0;
+        if( i == 0 ) steps[i].in = STDIN_FILENO;
+
+        // File entre l'etape et la suivante
+        if( i + 1 < count )
+        {
+            int queue[2] = { -1, -1 };
+            if( pipe2( queue, O_NONBLOCK | O_CLOEXEC ) == -1 )
+            {
+                perror( "ERREUR - Creation d'une file de diffusion" );
+                return( FANOUT_PIPE_FAILED );
+            }
+            steps[i].next = queue[1];
+            steps[i + 1].in = queue[0];
+        }
+    }
+
+    // Diffusion, jusqu'a la fin des donnees ou la fin de tous les pipelines
+    while( 1 )
+    {
+        // S'il ne reste aucune sortie ouverte, la diffusion est terminee (le producteur est alors interrompu par
+        // la fermeture de son pipe)
+        int openCount = 0;
+        for( int i = 0; i < count; ++i ) openCount += ( steps[i].out != -1 );
+        if( openCount == 0 ) break;
+
+        // Avancement de chaque etape
+        struct pollfd waits[MAX_FANOUT];
+        int waitCount = 0;
+        int progress = 0;
+        for( int i = 0; i < count; ++i )
+        {
+            if( steps[i].done ) continue;
+            const int status = runStep( steps + i, waits + waitCount );
+            if( status == -1 )
+            {
+                perror( "ERREUR - Diffusion" );
+                return( FANOUT_IO_FAILED );
+            }
+            if( status == 1 ) progress = 1;
+            else if( waits[waitCount].fd != -1 ) ++waitCount;
+        }
+
+        // Si toutes les etapes sont bloquees, attente de donnees ou de place dans un pipe
+        if( ! progress && poll( waits, waitCount, -1 ) == -1 && errno != EINTR )
+        {
+            perror( "ERREUR - Diffusion" );
+            return( FANOUT_IO_FAILED );
+        }
+    }
+
+    return( FANOUT_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void closeOtherFds( const cmd_t* cmd )
+{
+    // Descripteurs a conserver, dans l'ordre croissant
+    int keep[MAX_FANOUT + 1];
+    int keepCount = 0;
+    keep[keepCount++] = STDERR_FILENO;
+    for( int i = 0; i < cmd->fanoutCount; ++i )
+    {
+        int j = keepCount++;
+        while( j > 0 && keep[j - 1] > cmd->fanoutFds[i] )
+        {
+            keep[j] = keep[j - 1];
+            --j;
+        }
+        keep[j] = cmd->fanoutFds[i];
+    }
+
+    // Fermeture des intervalles entre les descripteurs conserves
+    for( int i = 0; i < keepCount; ++i )
+    {
+        const unsigned int first = keep[i] + 1;
+        const unsigned int last = ( i + 1 < keepCount ? (unsigned int)keep[i + 1] - 1 : ~0U );
+        if( first <= last ) syscall( SYS_close_range, first, last, 0 );
+    }
+}
+
+
+static int runStep( FanoutStep* step, struct pollfd* wait )
+{
+    wait->fd = -1;
+    wait->events = 0;
+    wait->revents = 0;
+
+    // Donnees deja dupliquees dans la sortie : elles doivent etre deplacees dans la file suivante avant toute
+    // nouvelle duplication (tee() lit toujours la tete de la file)
+    if( step->pending > 0 )
+    {
+        const ssize_t moved = splice( step->in, NULL, step->next, NULL, step->pending,
+                                      SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+        if( moved > 0 )
+        {
+            step->pending -= moved;
+            return( 1 );
+        }
+        if( moved == -1 && errno != EAGAIN ) return( -1 );
+        wait->fd = step->next;
+        wait->events = POLLOUT;
+        return( 0 );
+    }
+
+    // Nouvelles donnees : duplication dans la sortie (deplacement pour la derniere etape), ou seulement
+    // deplacement dans la file suivante si le pipeline est termine
+    ssize_t size = 0;
+    int target = -1;
+    if( step->out != -1 && step->next != -1 )
+    {
+        target = step->out;
+        size = tee( step->in, step->out, FANOUT_CHUNK, SPLICE_F_NONBLOCK );
+        if( size > 0 ) step->pending = size;
+    }
+    else if( step->out != -1 )
+    {
+        target = step->out;
+        size = splice( step->in, NULL, step->out, NULL, FANOUT_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+    }
+    else if( step->next != -1 )
+    {
+        target = step->next;
+        size = splice( step->in, NULL, step->next, NULL, FANOUT_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK );
+    }
+    else
+    {
+        // Derniere etape, pipeline termine : les donnees sont jetees
+        char buffer[4096];
+        size = read( step->in, buffer, sizeof( buffer ) );
+    }
+    if( size > 0 ) return( 1 );
+
+    // Fin des donnees
+    if( size == 0 )
+    {
+        endStep( step );
+        return( 1 );
+    }
+
+    // Pipeline termine : sa sortie est refermee, les donnees continuent vers les etapes suivantes
+    if( errno == EPIPE && target == step->out )
+    {
+        close( step->out );
+        step->out = -1;
+        return( 1 );
+    }
+    if( errno != EAGAIN ) return( -1 );
+
+    // File d'entree vide, ou destination pleine
+    int available = 0;
+    if( target != -1 && ioctl( step->in, FIONREAD, &available ) == 0 && available > 0 )
+    {
+        wait->fd = target;
+        wait->events = POLLOUT;
+    }
+    else
+    {
+        wait->fd = step->in;
+        wait->events = POLLIN;
+    }
+    return( 0 );
+}
+
+
+static void endStep( FanoutStep* step )
+{
+    if( step->out != -1 ) close( step->out );
+    if( step->next != -1 ) close( step->next );
+    step->out = -1;
+    step->next = -1;
+    step->done = 1;
+}
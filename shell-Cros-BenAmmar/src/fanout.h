@@ -0,0 +1,51 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Diffusion de la sortie d'une commande vers plusieurs pipelines ('|+'), sans recopie des donnees.
+ *
+ *  Dans "PRODUCTEUR |+ A | B |+ C |+ D", la sortie du producteur est envoyee a la fois aux pipelines "A | B",
+ *  "C" et "D", qui s'executent en parallele. Lors du parsing, une commande de diffusion ("|+") est inseree
+ *  entre le producteur et les pipelines : son entree est le pipe du producteur, et elle a une sortie (un pipe
+ *  cree comme ceux des autres commandes) par pipeline.
+ *
+ *  La commande de diffusion s'execute dans un processus fils du minishell, qui duplique les donnees du pipe
+ *  d'entree dans les pipes de sortie avec tee(2), et les deplace avec splice(2) : les pages du pipe sont
+ *  partagees, sans passer par la memoire du processus. Pour que chaque pipeline recoive chaque octet une et une
+ *  seule fois, meme lorsque les ecritures sont partielles, les donnees transitent par une file de pipes
+ *  internes : la file i contient les donnees deja envoyees aux pipelines 0 a i-1, mais pas encore aux suivants.
+ *  Toutes les files etant des pipes de taille fixe, le pipeline le plus lent freine le producteur (sans
+ *  accumulation en memoire). Un pipeline qui se termine avant la fin des donnees est ignore par la suite.
+ */
+
+#ifndef _FANOUT_H_
+#define _FANOUT_H_
+
+#include "cmd.h"
+
+
+// Codes d'erreur
+enum FanoutError
+{
+    FANOUT_OK = 0,              // Pas d'erreur
+    FANOUT_PIPE_FAILED = 190,   // Echec de creation d'une file interne
+    FANOUT_IO_FAILED            // Echec d'un transfert de donnees (tee, splice)
+};
+
+
+/*
+ * Diffuse l'entree standard vers les sorties d'une commande de diffusion, jusqu'a la fin des donnees (a
+ * executer dans le processus fils de la commande, apres la mise en place de son entree standard)
+ *
+ * cmd : la commande de diffusion (voir fanoutFds dans cmd.h)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int runFanout( const cmd_t* cmd );
+
+
+#endif // _FANOUT_H_
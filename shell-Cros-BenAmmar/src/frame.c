@@ -0,0 +1,170 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances :
+ *
+ *  Echange de trames sur une socket Unix (implementation)
+ */
+
+#include "frame.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Ecrit la totalite d'un buffer sur une socket
+ *
+ * sock : socket d'emission
+ * data : donnees a ecrire
+ * length : nombre d'octets a ecrire
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int writeFull( int sock, const void* data, size_t length );
+
+/*
+ * Lit exactement le nombre d'octets demande sur une socket
+ *
+ * sock : socket de reception
+ * data : buffer de reception
+ * length : nombre d'octets a lire
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int readFull( int sock, void* data, size_t length );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int sendFrame( int sock, uint32_t type, const void* data, size_t length, const int* fds, int fdCount )
+{
+    // Entete de la trame
+    FrameHeader header = { type, (uint32_t)length };
+    struct iovec iov = { &header, sizeof( header ) };
+
+    // Message transportant l'entete et les eventuels descripteurs joints
+    char control[CMSG_SPACE( MAX_FRAME_FDS * sizeof( int ) )];
+    memset( control, 0, sizeof( control ) );
+    struct msghdr msg;
+    memset( &msg, 0, sizeof( msg ) );
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if( fdCount > 0 )
+    {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE( fdCount * sizeof( int ) );
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN( fdCount * sizeof( int ) );
+        memcpy( CMSG_DATA( cmsg ), fds, fdCount * sizeof( int ) );
+    }
+
+    // Emission de l'entete (les descripteurs sont transmis avec le premier octet)
+    ssize_t sent = -1;
+    do sent = sendmsg( sock, &msg, MSG_NOSIGNAL ); while( sent == -1 && errno == EINTR );
+    if( sent == -1 ) return( FRAME_IO_FAILED );
+
+    // Emission de la fin eventuelle de l'entete, puis des donnees
+    if( writeFull( sock, (char*)&header + sent, sizeof( header ) - sent ) != FRAME_OK ) return( FRAME_IO_FAILED );
+    return( writeFull( sock, data, length ) );
+}
+
+
+int recvFrame( int sock, FrameHeader* header, void* data, size_t maxLength, int* fds, int* fdCount )
+{
+    // Aucun descripteur recu pour l'instant
+    *fdCount = 0;
+
+    // Message de reception de l'entete et des eventuels descripteurs joints
+    struct iovec iov = { header, sizeof( *header ) };
+    char control[CMSG_SPACE( MAX_FRAME_FDS * sizeof( int ) )];
+    struct msghdr msg;
+    memset( &msg, 0, sizeof( msg ) );
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof( control );
+
+    // Reception du debut de l'entete
+    ssize_t received = -1;
+    do received = recvmsg( sock, &msg, MSG_CMSG_CLOEXEC ); while( received == -1 && errno == EINTR );
+    if( received == 0 ) return( FRAME_CLOSED );
+    if( received == -1 ) return( FRAME_IO_FAILED );
+
+    // Recuperation des descripteurs joints
+    for( struct cmsghdr* cmsg = CMSG_FIRSTHDR( &msg ); cmsg != NULL; cmsg = CMSG_NXTHDR( &msg, cmsg ) )
+    {
+        if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS )
+        {
+            *fdCount = ( cmsg->cmsg_len - CMSG_LEN( 0 ) ) / sizeof( int );
+            memcpy( fds, CMSG_DATA( cmsg ), *fdCount * sizeof( int ) );
+        }
+    }
+
+    // Reception de la fin eventuelle de l'entete
+    const int status = readFull( sock, (char*)header + received, sizeof( *header ) - received );
+    if( status != FRAME_OK ) return( status );
+
+    // Si les donnees ne tiennent pas dans le buffer, on les ignore
+    if( header->length > maxLength )
+    {
+        char trash[4096];
+        for( size_t left = header->length; left > 0; )
+        {
+            const size_t chunk = ( left < sizeof( trash ) ? left : sizeof( trash ) );
+            if( readFull( sock, trash, chunk ) != FRAME_OK ) return( FRAME_IO_FAILED );
+            left -= chunk;
+        }
+        return( FRAME_TOO_LONG );
+    }
+
+    // Reception des donnees
+    return( readFull( sock, data, header->length ) );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int writeFull( int sock, const void* data, size_t length )
+{
+    // Tant qu'il reste des octets a ecrire
+    const char* p = (const char*)data;
+    while( length > 0 )
+    {
+        const ssize_t written = send( sock, p, length, MSG_NOSIGNAL );
+        if( written == -1 && errno == EINTR ) continue;
+        if( written <= 0 ) return( FRAME_IO_FAILED );
+        p += written;
+        length -= written;
+    }
+
+    return( FRAME_OK );
+}
+
+
+static int readFull( int sock, void* data, size_t length )
+{
+    // Tant qu'il reste des octets a lire
+    char* p = (char*)data;
+    while( length > 0 )
+    {
+        const ssize_t received = recv( sock, p, length, 0 );
+        if( received == -1 && errno == EINTR ) continue;
+        if( received == 0 ) return( FRAME_CLOSED );
+        if( received == -1 ) return( FRAME_IO_FAILED );
+        p += received;
+        length -= received;
+    }
+
+    return( FRAME_OK );
+}
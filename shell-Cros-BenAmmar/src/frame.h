@@ -0,0 +1,74 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Echange de trames sur une socket Unix : chaque trame est composee d'un entete (type et longueur) suivi
+ *  des donnees, et peut transporter des descripteurs de fichiers (SCM_RIGHTS) joints a l'entete.
+ */
+
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Nombre max de descripteurs de fichiers joints a une trame
+#define MAX_FRAME_FDS   4
+
+// Codes d'erreur
+enum FrameError
+{
+    FRAME_OK = 0,               // Pas d'erreur
+    FRAME_CLOSED = 70,          // Connexion fermee par l'autre extremite
+    FRAME_IO_FAILED,            // Erreur d'emission ou de reception
+    FRAME_TOO_LONG              // Donnees de la trame trop longues pour le buffer de reception
+};
+
+/*
+ * Entete d'une trame
+ *
+ * type : type de la trame (defini par le protocole qui utilise les trames)
+ * length : nombre d'octets de donnees qui suivent l'entete
+ */
+typedef struct
+{
+    uint32_t type;
+    uint32_t length;
+} FrameHeader;
+
+
+/*
+ * Envoie une trame, avec d'eventuels descripteurs de fichiers joints
+ *
+ * sock : socket d'emission
+ * type : type de la trame
+ * data : donnees de la trame
+ * length : nombre d'octets de donnees
+ * fds : descripteurs de fichiers a joindre (ou NULL)
+ * fdCount : nombre de descripteurs de fichiers a joindre
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int sendFrame( int sock, uint32_t type, const void* data, size_t length, const int* fds, int fdCount );
+
+/*
+ * Recoit une trame, avec d'eventuels descripteurs de fichiers joints. Si les donnees de la trame sont trop
+ * longues pour le buffer, elles sont ignorees et la fonction retourne FRAME_TOO_LONG (la connexion reste
+ * utilisable pour les trames suivantes).
+ *
+ * sock : socket de reception
+ * header : en sortie, entete de la trame recue
+ * data : buffer de reception des donnees
+ * maxLength : taille du buffer de reception
+ * fds : en sortie, descripteurs de fichiers recus (au plus MAX_FRAME_FDS)
+ * fdCount : en sortie, nombre de descripteurs de fichiers recus
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int recvFrame( int sock, FrameHeader* header, void* data, size_t maxLength, int* fds, int* fdCount );
+
+
+#endif // _FRAME_H_
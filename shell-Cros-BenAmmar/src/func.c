@@ -0,0 +1,353 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h memstat.h
+ *
+ *  Fonctions du minishell (implementation)
+ */
+
+#include "func.h"
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre d'entrees de la table de hachage des fonctions
+#define FUNC_TABLE_SIZE     64
+
+// Table des fonctions definies (propre a chaque thread, comme l'etat d'execution des lignes de commande)
+static _Thread_local Function* functionTable[FUNC_TABLE_SIZE];
+
+// Contexte de l'appel de fonction en cours (NULL en dehors d'une fonction), et nombre d'appels imbriques
+static _Thread_local FuncFrame* currentFrame = NULL;
+static _Thread_local int callDepth = 0;
+
+// Valeur calculee d'un parametre ($#, $@...), retournee par getVar()
+static _Thread_local char paramValue[MAX_LINE_SIZE];
+
+/*
+ * Retourne l'entree de la table de hachage d'un nom de fonction (hachage FNV-1a)
+ *
+ * name : nom de la fonction
+ */
+static unsigned int hashName( const char* name );
+
+/*
+ * Convertit un pointeur vers une commande des commandes d'origine en pointeur vers la commande correspondante
+ * des commandes deplacees
+ *
+ * cmd : le pointeur a convertir (peut etre NULL)
+ * from : commandes d'origine
+ * to : commandes deplacees
+ * retourne le pointeur converti
+ */
+static cmd_t* relocateCmd( cmd_t* cmd, const cmd_t* from, cmd_t* to );
+
+/*
+ * Recherche une variable locale dans les appels en cours, du plus recent au plus ancien
+ *
+ * name : nom de la variable
+ * retourne la variable si elle existe, sinon NULL
+ */
+static FuncVar* findLocalVar( const char* name );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int createFunction( const char* name, cmd_t* cmds, int cmdCount, Function** function )
+{
+    *function = NULL;
+
+    // Allocation de la fonction et de ses commandes
+    Function* newFunction = (Function*)memCalloc( MEM_VARIABLES, 1, sizeof( Function ) );
+    if( newFunction == NULL ) return( FUNC_NO_MEMORY );
+    newFunction->name = memStrdup( MEM_VARIABLES, name );
+    newFunction->cmds = (cmd_t*)memAlloc( MEM_VARIABLES, cmdCount * sizeof( cmd_t ) );
+    if( newFunction->name == NULL || newFunction->cmds == NULL )
+    {
+        memFree( newFunction->name );
+        memFree( newFunction->cmds );
+        memFree( newFunction );
+        return( FUNC_NO_MEMORY );
+    }
+    newFunction->cmdCount = cmdCount;
+    newFunction->refCount = 1;
+
+    // Deplacement des commandes : les chainages sont convertis, et les arguments changent de proprietaire
+    memcpy( newFunction->cmds, cmds, cmdCount * sizeof( cmd_t ) );
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        cmd_t* cmd = newFunction->cmds + i;
+        cmd->next = relocateCmd( cmd->next, cmds, newFunction->cmds );
+        cmd->nextSuccess = relocateCmd( cmd->nextSuccess, cmds, newFunction->cmds );
+        cmd->nextFailure = relocateCmd( cmd->nextFailure, cmds, newFunction->cmds );
+        cmd->pipePrev = relocateCmd( cmd->pipePrev, cmds, newFunction->cmds );
+        cmd->pipeSource = relocateCmd( cmd->pipeSource, cmds, newFunction->cmds );
+        cmd->groupEnd = relocateCmd( cmd->groupEnd, cmds, newFunction->cmds );
+
+        // La commande d'origine est reinitialisee, sans ses arguments
+        cmds[i].argv = NULL;
+        cmds[i].argc = 0;
+        cmds[i].argvCapacity = 0;
+        initCmd( cmds + i );
+    }
+
+    *function = newFunction;
+    return( FUNC_OK );
+}
+
+
+void defineFunction( Function* function )
+{
+    // Retrait de l'eventuelle fonction de meme nom
+    Function** pFunction = functionTable + hashName( function->name );
+    while( *pFunction != NULL && strcmp( ( *pFunction )->name, function->name ) != 0 )
+    {
+        pFunction = &( *pFunction )->next;
+    }
+    if( *pFunction != NULL )
+    {
+        Function* previous = *pFunction;
+        *pFunction = previous->next;
+        releaseFunction( previous );
+    }
+
+    // Ajout en tete de l'entree
+    pFunction = functionTable + hashName( function->name );
+    function->next = *pFunction;
+    *pFunction = function;
+}
+
+
+Function* findFunction( const char* name )
+{
+    // Parcours de l'entree correspondant au nom
+    for( Function* function = functionTable[hashName( name )]; function != NULL; function = function->next )
+    {
+        if( strcmp( function->name, name ) == 0 ) return( function );
+    }
+
+    return( NULL );
+}
+
+
+void releaseFunction( Function* function )
+{
+    if( function == NULL || --function->refCount > 0 ) return;
+
+    // Destruction des commandes modeles (et de leurs arguments)
+    for( int i = 0; i < function->cmdCount; ++i )
+    {
+        initCmd( function->cmds + i );
+        memFree( function->cmds[i].argv );
+    }
+    memFree( function->cmds );
+    memFree( function->name );
+    memFree( function );
+}
+
+
+int isValidName( const char* name )
+{
+    // Le nom ne doit pas etre vide ni commencer par un chiffre
+    if( name[0] == '\0' || isdigit( (unsigned char)name[0] ) ) return( 0 );
+
+    // Lettres, chiffres et '_'
+    for( const char* c = name; *c != '\0'; ++c )
+    {
+        if( ! isalnum( (unsigned char)*c ) && *c != '_' ) return( 0 );
+    }
+
+    return( 1 );
+}
+
+
+int beginFuncCall( FuncFrame* frame, Function* function, int argc, char** argv )
+{
+    // Recursion limitee
+    if( callDepth == MAX_FUNC_DEPTH ) return( FUNC_TOO_DEEP );
+
+    // Le contexte de l'appel devient le contexte courant
+    frame->function = function;
+    frame->argc = argc;
+    frame->argv = argv;
+    frame->locals = NULL;
+    frame->caller = currentFrame;
+    currentFrame = frame;
+    ++callDepth;
+
+    // La fonction est conservee pendant l'appel, meme si elle est redefinie
+    ++function->refCount;
+
+    return( FUNC_OK );
+}
+
+
+void endFuncCall( FuncFrame* frame )
+{
+    // Destruction des variables locales
+    while( frame->locals != NULL )
+    {
+        FuncVar* var = frame->locals;
+        frame->locals = var->next;
+        memFree( var->name );
+        memFree( var->value );
+        memFree( var );
+    }
+
+    // Retour au contexte de l'appelant
+    currentFrame = frame->caller;
+    --callDepth;
+    releaseFunction( frame->function );
+}
+
+
+int setLocalVar( const char* name, const char* value )
+{
+    // Il faut etre dans une fonction
+    if( currentFrame == NULL ) return( FUNC_NOT_IN_CALL );
+    if( ! isValidName( name ) ) return( FUNC_BAD_NAME );
+
+    // Copie de la valeur
+    char* newValue = memStrdup( MEM_VARIABLES, value );
+    if( newValue == NULL ) return( FUNC_NO_MEMORY );
+
+    // Variable deja declaree dans l'appel : seule sa valeur change
+    for( FuncVar* var = currentFrame->locals; var != NULL; var = var->next )
+    {
+        if( strcmp( var->name, name ) == 0 )
+        {
+            memFree( var->value );
+            var->value = newValue;
+            return( FUNC_OK );
+        }
+    }
+
+    // Sinon, nouvelle variable de l'appel
+    FuncVar* var = (FuncVar*)memAlloc( MEM_VARIABLES, sizeof( FuncVar ) );
+    char* newName = memStrdup( MEM_VARIABLES, name );
+    if( var == NULL || newName == NULL )
+    {
+        memFree( var );
+        memFree( newName );
+        memFree( newValue );
+        return( FUNC_NO_MEMORY );
+    }
+    var->name = newName;
+    var->value = newValue;
+    var->next = currentFrame->locals;
+    currentFrame->locals = var;
+
+    return( FUNC_OK );
+}
+
+
+int setVar( const char* name, const char* value )
+{
+    if( ! isValidName( name ) ) return( FUNC_BAD_NAME );
+
+    // Variable locale d'un appel en cours
+    FuncVar* var = findLocalVar( name );
+    if( var != NULL )
+    {
+        char* newValue = memStrdup( MEM_VARIABLES, value );
+        if( newValue == NULL ) return( FUNC_NO_MEMORY );
+        memFree( var->value );
+        var->value = newValue;
+        return( FUNC_OK );
+    }
+
+    // Sinon, variable d'environnement
+    return( setenv( name, value, 1 ) == 0 ? FUNC_OK : FUNC_NO_MEMORY );
+}
+
+
+const char* getVar( const char* name )
+{
+    // Parametres de l'appel de fonction courant
+    if( currentFrame != NULL )
+    {
+        // Nombre de parametres
+        if( strcmp( name, "#" ) == 0 )
+        {
+            snprintf( paramValue, MAX_LINE_SIZE, "%d", currentFrame->argc - 1 );
+            return( paramValue );
+        }
+
+        // Liste des parametres, separes par des espaces
+        if( strcmp( name, "@" ) == 0 || strcmp( name, "*" ) == 0 )
+        {
+            size_t length = 0;
+            paramValue[0] = '\0';
+            for( int i = 1; i < currentFrame->argc && length < MAX_LINE_SIZE; ++i )
+            {
+                length += snprintf( paramValue + length, MAX_LINE_SIZE - length, i > 1 ? " %s" : "%s",
+                                    currentFrame->argv[i] );
+            }
+            return( paramValue );
+        }
+
+        // Parametre positionnel ($0 est le nom de la fonction)
+        if( isdigit( (unsigned char)name[0] ) )
+        {
+            char* end = NULL;
+            const long index = strtol( name, &end, 10 );
+            if( *end != '\0' ) return( NULL );
+            return( index < currentFrame->argc ? currentFrame->argv[index] : NULL );
+        }
+
+        // Variable locale d'un appel en cours
+        const FuncVar* var = findLocalVar( name );
+        if( var != NULL ) return( var->value );
+    }
+
+    // Variable d'environnement
+    return( getenv( name ) );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static unsigned int hashName( const char* name )
+{
+    uint32_t hash = 2166136261u;
+    for( const char* c = name; *c != '\0'; ++c )
+    {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+
+    return( hash % FUNC_TABLE_SIZE );
+}
+
+
+static cmd_t* relocateCmd( cmd_t* cmd, const cmd_t* from, cmd_t* to )
+{
+    return( cmd != NULL ? to + ( cmd - from ) : NULL );
+}
+
+
+static FuncVar* findLocalVar( const char* name )
+{
+    // Portee dynamique : les variables de l'appelant sont visibles dans les fonctions qu'il appelle
+    for( FuncFrame* frame = currentFrame; frame != NULL; frame = frame->caller )
+    {
+        for( FuncVar* var = frame->locals; var != NULL; var = var->next )
+        {
+            if( strcmp( var->name, name ) == 0 ) return( var );
+        }
+    }
+
+    return( NULL );
+}
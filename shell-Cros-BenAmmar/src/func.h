@@ -0,0 +1,191 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Fonctions du minishell ('nom() { ... ; }'), et variables des appels de fonctions.
+ *
+ *  Le corps d'une fonction est analyse une seule fois, lors de sa definition, en un tableau de commandes
+ *  "modeles" (comme celui d'une ligne de commande, voir parseCmd()) dont les tokens sont conserves bruts :
+ *  variables, expansion des motifs et redirections ne sont traites qu'a l'execution de chaque commande, avec les
+ *  parametres de l'appel. Les fonctions sont rangees dans une table de hachage, consultee avant les builtins et
+ *  les programmes du PATH.
+ *
+ *  Chaque appel empile un contexte avec ses parametres positionnels ($1 a $N, $# pour leur nombre, $@ et $*
+ *  pour leur liste, $0 pour le nom de la fonction) et ses variables locales (builtin 'local'). Une variable est
+ *  recherchee dans les variables locales des appels en cours, du plus recent au plus ancien, puis dans
+ *  l'environnement du processus.
+ *
+ *  Les fonctions et les appels en cours sont propres a chaque thread (voir libminishell.h).
+ */
+
+#ifndef _FUNC_H_
+#define _FUNC_H_
+
+#include "cmd.h"
+
+
+// Nombre max d'appels de fonctions imbriques (recursion)
+#define MAX_FUNC_DEPTH      200
+
+// Codes d'erreur
+enum FuncError
+{
+    FUNC_OK = 0,                // Pas d'erreur
+    FUNC_BAD_NAME = 210,        // Nom de fonction ou de variable incorrect
+    FUNC_NO_MEMORY,             // Allocation impossible
+    FUNC_TOO_DEEP,              // Trop d'appels de fonctions imbriques (voir MAX_FUNC_DEPTH)
+    FUNC_NOT_IN_CALL            // Variable locale declaree en dehors d'une fonction
+};
+
+/*
+ * Structure de donnees associee a une fonction
+ *
+ * name : nom de la fonction
+ * cmds : commandes modeles du corps de la fonction (les commandes d'un groupe sont rangees juste apres celui-ci,
+ *        comme dans une ligne de commande). Les arguments bruts de chaque commande comprennent ses redirections
+ *        (operateur suivi du fichier), dans l'ordre du corps.
+ * cmdCount : nombre de commandes du corps
+ * refCount : nombre de references a la fonction (table des fonctions, appels en cours)
+ * next : fonction suivante de la meme entree de la table de hachage
+ */
+typedef struct Function
+{
+    char* name;
+    cmd_t* cmds;
+    int cmdCount;
+    int refCount;
+    struct Function* next;
+} Function;
+
+/*
+ * Variable locale d'un appel de fonction
+ *
+ * name : nom de la variable
+ * value : valeur de la variable
+ * next : variable suivante de l'appel
+ */
+typedef struct FuncVar
+{
+    char* name;
+    char* value;
+    struct FuncVar* next;
+} FuncVar;
+
+/*
+ * Contexte d'un appel de fonction
+ *
+ * function : la fonction appelee
+ * argc : nombre d'arguments de l'appel (y compris le nom de la fonction)
+ * argv : arguments de l'appel (argv[0] est le nom de la fonction)
+ * locals : variables locales de l'appel
+ * caller : contexte de l'appel appelant, ou NULL
+ */
+typedef struct FuncFrame
+{
+    Function* function;
+    int argc;
+    char** argv;
+    FuncVar* locals;
+    struct FuncFrame* caller;
+} FuncFrame;
+
+
+/*
+ * Cree une fonction a partir des commandes modeles de son corps, qui sont deplacees dans la fonction (les
+ * commandes d'origine sont reinitialisees et peuvent etre reutilisees)
+ *
+ * name : nom de la fonction
+ * cmds : commandes modeles du corps
+ * cmdCount : nombre de commandes du corps
+ * function : en sortie, la fonction creee (a enregistrer avec defineFunction(), ou a detruire avec
+ *            releaseFunction())
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int createFunction( const char* name, cmd_t* cmds, int cmdCount, Function** function );
+
+/*
+ * Enregistre une fonction dans la table des fonctions, a la place de l'eventuelle fonction de meme nom (qui
+ * reste utilisable par ses appels en cours)
+ *
+ * function : la fonction (la table en devient proprietaire)
+ */
+void defineFunction( Function* function );
+
+/*
+ * Recherche une fonction par son nom
+ *
+ * name : nom de la fonction
+ * retourne la fonction si elle existe, sinon NULL
+ */
+Function* findFunction( const char* name );
+
+/*
+ * Libere une reference a une fonction, et la detruit s'il n'en reste plus
+ *
+ * function : la fonction (peut etre NULL)
+ */
+void releaseFunction( Function* function );
+
+/*
+ * Teste si un nom peut etre celui d'une fonction ou d'une variable (lettres, chiffres et '_', sans commencer
+ * par un chiffre)
+ *
+ * name : le nom a tester
+ * retourne 1 si le nom est valide, sinon 0
+ */
+int isValidName( const char* name );
+
+/*
+ * Debute un appel de fonction : son contexte devient le contexte courant, et la fonction est conservee jusqu'a
+ * la fin de l'appel
+ *
+ * frame : contexte de l'appel (a conserver jusqu'a endFuncCall())
+ * function : la fonction appelee
+ * argc : nombre d'arguments de l'appel (y compris le nom de la fonction)
+ * argv : arguments de l'appel (non recopies)
+ * retourne 0 en cas de succes, sinon un code d'erreur (l'appel n'a alors pas debute)
+ */
+int beginFuncCall( FuncFrame* frame, Function* function, int argc, char** argv );
+
+/*
+ * Termine l'appel de fonction courant : ses variables locales sont detruites, et le contexte de l'appelant
+ * redevient le contexte courant
+ *
+ * frame : contexte de l'appel
+ */
+void endFuncCall( FuncFrame* frame );
+
+/*
+ * Declare (ou modifie) une variable locale de l'appel de fonction courant
+ *
+ * name : nom de la variable
+ * value : valeur de la variable
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int setLocalVar( const char* name, const char* value );
+
+/*
+ * Modifie une variable : variable locale d'un appel en cours si elle existe, sinon variable d'environnement
+ *
+ * name : nom de la variable
+ * value : nouvelle valeur de la variable
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int setVar( const char* name, const char* value );
+
+/*
+ * Retourne la valeur d'une variable : parametre de l'appel de fonction courant, variable locale d'un appel en
+ * cours, ou sinon variable d'environnement (voir substEnv())
+ *
+ * name : nom de la variable
+ * retourne la valeur de la variable (valable jusqu'au prochain appel), ou NULL si elle n'existe pas
+ */
+const char* getVar( const char* name );
+
+
+#endif // _FUNC_H_
@@ -0,0 +1,200 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h memstat.h options.h zygote.h
+ *
+ *  Ordonnancement des commandes en background (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "jobs.h"
+#include "memstat.h"
+#include "options.h"
+#include "zygote.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Intervalle de verification de la charge pendant que les lancements sont retenus, en millisecondes
+#define LOAD_POLL_INTERVAL  250
+
+/*
+ * Retourne le nombre max de commandes en background en cours d'execution (option "bgjobs", ou nombre de coeurs
+ * disponibles)
+ */
+static int getJobSlots( void );
+
+/*
+ * Teste si la machine est trop chargee pour lancer une nouvelle commande (voir les options "bgjobs-maxload" et
+ * "bgjobs-maxpressure")
+ *
+ * retourne 1 si les lancements doivent etre retenus, sinon 0
+ */
+static int isOverloaded( void );
+
+/*
+ * Recupere une commande en background terminee, et affiche sa fin
+ *
+ * pid : PID du processus de la commande
+ */
+static void reapJob( pid_t pid );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int isJobStart( const cmd_t* cmd )
+{
+    // Premiere etape d'un pipeline (ou commande isolee)
+    if( cmd->pipePrev != NULL ) return( 0 );
+
+    // Le pipeline ne doit pas etre attendu par le minishell
+    const cmd_t* last = cmd;
+    while( last->nextCmdLink == LINK_PIPE && last->nextSuccess != NULL ) last = last->nextSuccess;
+    return( ! last->wait );
+}
+
+
+int waitJobSlot( void )
+{
+    const int slots = getJobSlots();
+    while( 1 )
+    {
+        // Commandes en background en cours d'execution
+        int running = 0;
+        for( const BgCmd* bgCmd = getBgCmds(); bgCmd != NULL; bgCmd = bgCmd->next ) running += ! bgCmd->finished;
+
+        // Lancement immediat s'il reste un emplacement et que la machine n'est pas trop chargee
+        if( running == 0 || ( running < slots && ! isOverloaded() ) ) return( JOBS_OK );
+
+        // Descripteurs signalant la fin des processus des commandes en cours (la liste des commandes peut etre
+        // modifiee par leur recuperation : les PID sont conserves)
+        struct pollfd* fds = (struct pollfd*)memAlloc( MEM_JOBS, running * sizeof( struct pollfd ) );
+        pid_t* pids = (pid_t*)memAlloc( MEM_JOBS, running * sizeof( pid_t ) );
+        int count = 0;
+        for( const BgCmd* bgCmd = getBgCmds(); fds != NULL && pids != NULL && bgCmd != NULL; bgCmd = bgCmd->next )
+        {
+            if( bgCmd->finished ) continue;
+            const int pidFd = syscall( SYS_pidfd_open, bgCmd->pid, 0 );
+            if( pidFd == -1 ) continue;
+            fds[count].fd = pidFd;
+            fds[count].events = POLLIN;
+            fds[count].revents = 0;
+            pids[count++] = bgCmd->pid;
+        }
+
+        // Sans descripteur, impossible d'attendre : la commande est lancee
+        if( count == 0 )
+        {
+            memFree( fds );
+            memFree( pids );
+            return( JOBS_WAIT_FAILED );
+        }
+
+        // Attente de la fin d'une commande (ou, si seule la charge retient le lancement, de sa prochaine mesure)
+        const int timeout = ( running < slots ? LOAD_POLL_INTERVAL : -1 );
+        if( poll( fds, count, timeout ) == -1 && errno != EINTR )
+        {
+            for( int i = 0; i < count; ++i ) close( fds[i].fd );
+            memFree( fds );
+            memFree( pids );
+            return( JOBS_WAIT_FAILED );
+        }
+
+        // Sorties capturees arrivees pendant l'attente, puis recuperation des commandes terminees
+        pollBgCmdOutputs();
+        for( int i = 0; i < count; ++i )
+        {
+            if( fds[i].revents != 0 ) reapJob( pids[i] );
+            close( fds[i].fd );
+        }
+        memFree( fds );
+        memFree( pids );
+    }
+}
+
+
+void reportBgCmdEnd( BgCmd* bgCmd )
+{
+    // Affichage de l'information de terminaison (sauf sur la sortie d'une application qui integre le moteur)
+    if( ! isEmbeddedExec() ) printf( "[%d]   Fini (status = %d)           %s\n", bgCmd->number, bgCmd->exitStatus, bgCmd->cmdLine );
+
+    // Si ses sorties sont capturees, la commande est conservee jusqu'a leur consultation (jobs -o), sinon elle
+    // est retiree de la liste et liberee
+    if( bgCmd->output == NULL ) freeBgCmd( removeBgCmd( bgCmd->pid ) );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int getJobSlots( void )
+{
+    // Valeur de l'option
+    const long slots = getOption( OPTION_BG_JOBS );
+    if( slots > 0 ) return( (int)slots );
+
+    // Par defaut, nombre de coeurs sur lesquels le minishell peut s'executer
+    cpu_set_t cpus;
+    if( sched_getaffinity( 0, sizeof( cpus ), &cpus ) == 0 ) return( CPU_COUNT( &cpus ) );
+    const long online = sysconf( _SC_NPROCESSORS_ONLN );
+    return( online > 0 ? (int)online : 1 );
+}
+
+
+static int isOverloaded( void )
+{
+    // Charge moyenne sur une minute
+    const long maxLoad = getOption( OPTION_BG_JOBS_MAX_LOAD );
+    if( maxLoad > 0 )
+    {
+        FILE* file = fopen( "/proc/loadavg", "r" );
+        double load = 0;
+        const int found = ( file != NULL && fscanf( file, "%lf", &load ) == 1 );
+        if( file != NULL ) fclose( file );
+        if( found && load > maxLoad ) return( 1 );
+    }
+
+    // Pression sur le CPU (pourcentage du temps ou des taches ont attendu le CPU, sur 10 secondes)
+    const long maxPressure = getOption( OPTION_BG_JOBS_MAX_PRESSURE );
+    if( maxPressure > 0 )
+    {
+        FILE* file = fopen( "/proc/pressure/cpu", "r" );
+        double pressure = 0;
+        const int found = ( file != NULL && fscanf( file, "some avg10=%lf", &pressure ) == 1 );
+        if( file != NULL ) fclose( file );
+        if( found && pressure > maxPressure ) return( 1 );
+    }
+
+    return( 0 );
+}
+
+
+static void reapJob( pid_t pid )
+{
+    // Synchronisation avec la fin du processus (cree par le minishell ou par le zygote)
+    int status = 0;
+    struct rusage usage;
+    memset( &usage, 0, sizeof( usage ) );
+    const pid_t result = ( isZygoteChild( pid ) ? zygoteWait( pid, &status ) : wait4( pid, &status, 0, &usage ) );
+    if( result <= 0 ) return;
+
+    // Fin de la commande en background correspondante
+    BgCmd* bgCmd = endBgCmd( pid, status, &usage );
+    if( bgCmd != NULL ) reportBgCmdEnd( bgCmd );
+}
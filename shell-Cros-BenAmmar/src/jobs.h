@@ -0,0 +1,66 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Ordonnancement des commandes en background ('&'), pour qu'un script qui en lance des milliers ne les cree
+ *  pas toutes en meme temps.
+ *
+ *  Le nombre de commandes en background en cours d'execution est limite (option "bgjobs", par defaut le
+ *  nombre de coeurs disponibles). Au-dela, le lancement d'une nouvelle commande attend dans le minishell que
+ *  les commandes precedentes se terminent : elles sont alors recuperees (et leur fin affichee), et la commande
+ *  est lancee des qu'un emplacement se libere. Un pipeline en background occupe un seul emplacement.
+ *
+ *  Les lancements peuvent aussi etre retenus tant que la machine est chargee : charge moyenne sur une minute
+ *  (/proc/loadavg) superieure a l'option "bgjobs-maxload", ou pression sur le CPU (/proc/pressure/cpu, "some
+ *  avg10", en %) superieure a l'option "bgjobs-maxpressure" (0 pour ne pas surveiller). Pour ne jamais bloquer
+ *  indefiniment, la charge n'est prise en compte que si au moins une commande en background est en cours.
+ */
+
+#ifndef _JOBS_H_
+#define _JOBS_H_
+
+#include "cmd.h"
+
+
+// Codes d'erreur
+enum JobsError
+{
+    JOBS_OK = 0,                // Pas d'erreur
+    JOBS_WAIT_FAILED = 180      // Impossible d'attendre la fin des commandes en background
+};
+
+
+/*
+ * Teste si une commande lance un nouveau job en background (commande en background, ou premiere etape d'un
+ * pipeline en background)
+ *
+ * cmd : la commande
+ * retourne 1 si la commande lance un job en background, sinon 0
+ */
+int isJobStart( const cmd_t* cmd );
+
+/*
+ * Attend qu'un emplacement se libere pour lancer un nouveau job en background (voir les options "bgjobs",
+ * "bgjobs-maxload" et "bgjobs-maxpressure"). Les commandes en background terminees pendant l'attente sont
+ * recuperees, et leur fin est affichee.
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int waitJobSlot( void );
+
+/*
+ * Affiche la fin d'une commande en background (sauf dans une execution integree, voir isEmbeddedExec()), puis
+ * la detruit si ses sorties ne sont pas capturees (sinon elle est conservee jusqu'a leur consultation, via
+ * 'jobs -o')
+ *
+ * bgCmd : la commande terminee (voir endBgCmd())
+ */
+void reportBgCmdEnd( BgCmd* bgCmd );
+
+
+#endif // _JOBS_H_
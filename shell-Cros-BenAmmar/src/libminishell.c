@@ -0,0 +1,185 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : shell.h parser.h cmd.h ringbuf.h memstat.h
+ *
+ *  Bibliotheque libminishell (implementation)
+ */
+
+#include "libminishell.h"
+#include "shell.h"
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Etats d'un plan
+enum PlanState
+{
+    PLAN_PARSED = 0,        // Ligne analysee, en attente d'execution
+    PLAN_DONE               // Ligne executee (ses fichiers et pipes sont refermes)
+};
+
+// Plan d'execution d'une ligne de commande : moteur d'execution dedie a la ligne, et etat du plan
+struct MinishellPlan
+{
+    Shell shell;
+    int state;
+};
+
+/*
+ * Applique l'entree/sortie/erreur d'execution aux commandes de premier niveau d'un plan (les commandes des groupes
+ * heritent de celles de leur groupe)
+ *
+ * shell : le moteur d'execution du plan
+ * io : entree/sortie/erreur d'execution
+ */
+static void applyIo( Shell* shell, const MinishellIo* io );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int minishellParse( const char* cmdLine, MinishellPlan** plan )
+{
+    // Pas de plan en cas d'erreur
+    *plan = NULL;
+    if( strlen( cmdLine ) >= MAX_LINE_SIZE ) return( MINISHELL_LINE_TOO_LONG );
+
+    // Moteur d'execution dedie a la ligne (trop volumineux pour la pile d'un thread)
+    MinishellPlan* newPlan = (MinishellPlan*)memAlloc( MEM_COMMANDS, sizeof( MinishellPlan ) );
+    if( newPlan == NULL ) return( MINISHELL_NO_MEMORY );
+    initShell( &newPlan->shell );
+    newPlan->state = PLAN_PARSED;
+
+    // Mise en forme et analyse d'une copie de la ligne
+    char line[MAX_LINE_SIZE];
+    strcpy( line, cmdLine );
+    int status = formatCmdLine( line );
+    if( status == 0 ) status = parseCmdLine( &newPlan->shell, line );
+    if( status != 0 )
+    {
+        freeShell( &newPlan->shell );
+        memFree( newPlan );
+        return( status );
+    }
+
+    *plan = newPlan;
+    return( MINISHELL_OK );
+}
+
+
+int minishellRun( MinishellPlan* plan, const MinishellIo* io, int* status )
+{
+    // Un plan ne s'execute qu'une fois (ses pipes sont consommes)
+    *status = 0;
+    if( plan->state != PLAN_PARSED ) return( MINISHELL_ALREADY_RUN );
+    plan->state = PLAN_DONE;
+
+    // Ligne vide
+    Shell* shell = &plan->shell;
+    if( shell->cmdCount == 0 )
+    {
+        releaseCmdLine( shell );
+        return( MINISHELL_OK );
+    }
+
+    // Execution integree, avec l'entree/sortie/erreur et l'environnement fournis
+    if( io != NULL ) applyIo( shell, io );
+    setEmbeddedExec( 1, io != NULL ? io->env : NULL );
+    *status = execCmdLine( shell );
+    setEmbeddedExec( 0, NULL );
+
+    return( MINISHELL_OK );
+}
+
+
+int minishellGetCmdCount( const MinishellPlan* plan )
+{
+    return( plan->shell.cmdCount );
+}
+
+
+int minishellGetResult( const MinishellPlan* plan, int index, MinishellResult* result )
+{
+    if( index < 0 || index >= plan->shell.cmdCount ) return( MINISHELL_BAD_INDEX );
+
+    // Le code de retour d'une commande supprimee par l'optimisation du plan est connu d'avance
+    const cmd_t* cmd = plan->shell.cmds + index;
+    result->path = cmd->path;
+    result->pid = cmd->pid;
+    result->status = ( cmd->executed || cmd->elided ? cmd->status : -1 );
+    result->background = ! cmd->wait;
+    result->usage = cmd->usage;
+
+    return( MINISHELL_OK );
+}
+
+
+void minishellFreePlan( MinishellPlan* plan )
+{
+    if( plan == NULL ) return;
+
+    // Un plan non execute a encore des fichiers et pipes ouverts
+    if( plan->state == PLAN_PARSED ) releaseCmdLine( &plan->shell );
+    freeShell( &plan->shell );
+    memFree( plan );
+}
+
+
+int minishellWaitJobs( int block )
+{
+    // Pour chaque commande en background du thread (la commande peut etre retiree de la liste)
+    int running = 0;
+    const BgCmd* bgCmd = getBgCmds();
+    while( bgCmd != NULL )
+    {
+        const BgCmd* next = bgCmd->next;
+        const pid_t pid = bgCmd->pid;
+
+        // Commande encore en cours d'execution
+        int status = 0;
+        struct rusage usage;
+        const pid_t result = ( bgCmd->finished ? pid : wait4( pid, &status, block ? 0 : WNOHANG, &usage ) );
+        if( result == 0 )
+        {
+            ++running;
+            bgCmd = next;
+            continue;
+        }
+
+        // Commande terminee (ou deja recuperee ailleurs) : elle est retiree de la liste et detruite
+        if( result == pid && ! bgCmd->finished ) endBgCmd( pid, status, &usage );
+        freeBgCmd( removeBgCmd( pid ) );
+        bgCmd = next;
+    }
+
+    return( running );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void applyIo( Shell* shell, const MinishellIo* io )
+{
+    // Commandes de premier niveau : les commandes d'un groupe sont rangees juste apres celui-ci
+    cmd_t* const end = shell->cmds + shell->cmdCount;
+    for( cmd_t* cmd = shell->cmds; cmd < end; cmd = ( cmd->group != GROUP_NONE ? cmd->groupEnd : cmd + 1 ) )
+    {
+        // Seuls les descripteurs ni rediriges ni relies a un pipe sont remplaces (une commande de diffusion
+        // n'utilise pas sa sortie standard)
+        if( cmd->in == -1 ) cmd->in = io->in;
+        if( cmd->out == -1 && cmd->fanoutCount == 0 ) cmd->out = io->out;
+        if( cmd->err == -1 ) cmd->err = io->err;
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Interface de la bibliotheque libminishell (libminishell.a, libminishell.so), qui permet a une application
+ *  d'analyser et d'executer des lignes de commande avec le moteur du minishell, sans lancer de shell dans un
+ *  processus intermediaire (comme le ferait system()).
+ *
+ *  Une ligne de commande est d'abord analysee en un plan (minishellParse()), qui peut etre examine ou abandonne,
+ *  puis executee une seule fois (minishellRun()) avec les descripteurs d'entree/sortie/erreur et l'environnement
+ *  fournis par l'application. Les resultats de chaque commande (code de retour, PID, ressources consommees)
+ *  restent ensuite consultables dans le plan, jusqu'a sa destruction.
+ *
+ *  Les fonctions peuvent etre appelees depuis plusieurs threads, chacun avec ses propres plans : l'etat
+ *  d'execution (commandes en background et fonctions 'nom() { ... ; }' en particulier) est propre a chaque
+ *  thread. Restent en revanche
+ *  partages par tout le processus :
+ *  - Le repertoire courant et les variables d'environnement modifies par les builtins 'cd', 'export' et 'unset'
+ *    (les variables '$NOM' sont substituees lors de l'analyse, a partir de l'environnement du processus)
+ *  - Les options ('set -o', voir options.h)
+ *  - Les descripteurs standards du processus, modifies pendant l'execution d'une builtin ou d'un groupe '{ ... ; }'
+ *    dans le processus avec des redirections : ces executions sont serialisees entre les threads
+ *  Les commandes sont attendues avec waitpid() : l'application ne doit pas ignorer SIGCHLD (SIG_IGN), ni
+ *  recuperer elle-meme les processus qu'elle n'a pas crees. Dans une ligne executee par la bibliotheque, 'exit'
+ *  termine la ligne de commande, et non le processus.
+ */
+
+#ifndef _LIBMINISHELL_H_
+#define _LIBMINISHELL_H_
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+
+// Codes d'erreur (en plus des codes d'erreur de parsing, voir parser.h et cmd.h)
+enum MinishellError
+{
+    MINISHELL_OK = 0,                   // Pas d'erreur
+    MINISHELL_NO_MEMORY = 200,          // Allocation du plan impossible
+    MINISHELL_LINE_TOO_LONG,            // Ligne de commande trop longue (voir MAX_LINE_SIZE)
+    MINISHELL_ALREADY_RUN,              // Le plan a deja ete execute (ou abandonne)
+    MINISHELL_BAD_INDEX                 // Index de commande en dehors du plan
+};
+
+// Plan d'execution d'une ligne de commande (structure opaque)
+typedef struct MinishellPlan MinishellPlan;
+
+// Entree/sortie/erreur et environnement d'execution d'un plan
+//
+// in, out, err : descripteurs utilises par les commandes dont l'entree/sortie/erreur n'est ni redirigee ni un
+//                pipe (-1 pour ceux du processus). Ils ne sont pas refermes par la bibliotheque.
+// env : environnement des programmes lances (tableau "NOM=VALEUR" termine par NULL), ou NULL pour celui du
+//       processus
+typedef struct
+{
+    int in;
+    int out;
+    int err;
+    char** env;
+} MinishellIo;
+
+// Resultat de l'execution d'une commande du plan
+//
+// path : nom de la commande (pointe dans le plan)
+// pid : PID du processus de la commande, ou -1 si aucun processus n'a ete cree (builtin executee dans le
+//       processus, etape executee dans un thread, commande non executee)
+// status : code de retour de la commande, ou -1 si elle n'a pas ete executee (enchainement conditionnel, 'exit')
+// background : vrai si la commande a ete lancee en background (elle n'est pas attendue, voir
+//              minishellWaitJobs())
+// usage : ressources consommees par le processus de la commande (a zero s'il n'a pas ete attendu)
+typedef struct
+{
+    const char* path;
+    pid_t pid;
+    int status;
+    int background;
+    struct rusage usage;
+} MinishellResult;
+
+
+/*
+ * Analyse une ligne de commande (mise en forme, substitution des variables, decoupage, parsing, optimisation).
+ * Les fichiers des redirections et les pipes sont ouverts des l'analyse.
+ *
+ * cmdLine : la ligne de commande (non modifiee)
+ * plan : en sortie, le plan d'execution (a detruire avec minishellFreePlan()), ou NULL en cas d'erreur
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int minishellParse( const char* cmdLine, MinishellPlan** plan );
+
+/*
+ * Execute un plan, et attend la fin des commandes au premier plan. Un plan ne peut etre execute qu'une fois.
+ *
+ * plan : le plan a executer
+ * io : entree/sortie/erreur et environnement d'execution, ou NULL pour ceux du processus
+ * status : en sortie, code de retour de la derniere commande executee
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int minishellRun( MinishellPlan* plan, const MinishellIo* io, int* status );
+
+/*
+ * Retourne le nombre de commandes d'un plan (y compris les commandes des groupes, et les commandes inserees
+ * lors de l'analyse)
+ *
+ * plan : le plan
+ */
+int minishellGetCmdCount( const MinishellPlan* plan );
+
+/*
+ * Recupere le resultat d'une commande d'un plan execute
+ *
+ * plan : le plan
+ * index : index de la commande (de 0 a minishellGetCmdCount() - 1, dans l'ordre de la ligne de commande)
+ * result : en sortie, le resultat de la commande
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int minishellGetResult( const MinishellPlan* plan, int index, MinishellResult* result );
+
+/*
+ * Detruit un plan (s'il n'a pas ete execute, ses fichiers et pipes sont refermes)
+ *
+ * plan : le plan a detruire (peut etre NULL)
+ */
+void minishellFreePlan( MinishellPlan* plan );
+
+/*
+ * Recupere les commandes en background terminees, lancees par les plans executes dans le thread courant
+ *
+ * block : si vrai, attend la fin de toutes les commandes en background du thread
+ * retourne le nombre de commandes en background encore en cours d'execution
+ */
+int minishellWaitJobs( int block );
+
+
+#endif // _LIBMINISHELL_H_
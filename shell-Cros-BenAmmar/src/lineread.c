@@ -0,0 +1,292 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Lecture de lignes sur un descripteur (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "lineread.h"
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre de pipes du minishell memorises (les plus recents)
+#define SHELL_PIPE_COUNT    64
+
+// Entree dont les donnees sont dans le tampon de lecture anticipee
+enum ReadAheadKind
+{
+    READ_NONE = 0,          // Tampon vide
+    READ_FILE,              // Fichier ordinaire
+    READ_PIPE               // Pipe du minishell
+};
+
+// Tampon de lecture anticipee :
+// - kind : type de l'entree lue
+// - dev, ino : identification de l'entree
+// - size, mtime : taille et date de modification du fichier lu (un fichier modifie est relu)
+// - offset : position dans le fichier du debut du tampon
+// - start, end : donnees non consommees du tampon
+// - data : le tampon
+typedef struct
+{
+    int kind;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    off_t offset;
+    size_t start;
+    size_t end;
+    char data[LINEREAD_BUFFER_SIZE];
+} ReadAhead;
+
+// Tampon de lecture anticipee du thread
+static _Thread_local ReadAhead readAhead;
+
+// Pipes crees par le minishell (inodes, en tampon circulaire)
+static _Thread_local ino_t shellPipes[SHELL_PIPE_COUNT];
+static _Thread_local int shellPipeCount = 0;
+
+/*
+ * Prepare le tampon de lecture anticipee pour une lecture sur une entree
+ *
+ * fd : le descripteur de l'entree
+ * st : etat de l'entree (fstat)
+ * retourne 1 si le tampon peut etre utilise, ou 0 si la lecture doit se faire octet par octet
+ */
+static int prepareReadAhead( int fd, const struct stat* st );
+
+/*
+ * Lit une ligne via le tampon de lecture anticipee
+ *
+ * fd : le descripteur
+ * delim : le delimiteur de fin de ligne
+ * line, size, length : voir readInputLine()
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int readBufferedLine( int fd, char delim, char* line, size_t size, size_t* length );
+
+/*
+ * Remplit le tampon de lecture anticipee avec les donnees qui suivent celles du tampon
+ *
+ * fd : le descripteur
+ * retourne 0 en cas de succes, sinon un code d'erreur (LINEREAD_EOF en fin de fichier)
+ */
+static int fillReadAhead( int fd );
+
+/*
+ * Lit une ligne octet par octet
+ *
+ * fd : le descripteur
+ * delim : le delimiteur de fin de ligne
+ * line, size, length : voir readInputLine()
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int readUnbufferedLine( int fd, char delim, char* line, size_t size, size_t* length );
+
+/*
+ * Ajoute des caracteres en fin de ligne (dans la limite de sa taille)
+ *
+ * line, size, length : la ligne (voir readInputLine())
+ * chars : les caracteres
+ * count : nombre de caracteres
+ */
+static void appendChars( char* line, size_t size, size_t* length, const char* chars, size_t count );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int readInputLine( int fd, char delim, char* line, size_t size, size_t* length )
+{
+    *length = 0;
+    line[0] = '\0';
+
+    // Type de l'entree
+    struct stat st;
+    if( fstat( fd, &st ) == -1 ) return( LINEREAD_IO_ERROR );
+
+    // Lecture par blocs si l'entree le permet
+    if( prepareReadAhead( fd, &st ) ) return( readBufferedLine( fd, delim, line, size, length ) );
+
+    return( readUnbufferedLine( fd, delim, line, size, length ) );
+}
+
+
+void addShellPipe( int fd )
+{
+    struct stat st;
+    if( fstat( fd, &st ) == -1 ) return;
+    shellPipes[shellPipeCount++ % SHELL_PIPE_COUNT] = st.st_ino;
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int prepareReadAhead( int fd, const struct stat* st )
+{
+    // Entree deja dans le tampon
+    const int sameInput = ( readAhead.kind != READ_NONE && readAhead.dev == st->st_dev &&
+                            readAhead.ino == st->st_ino );
+
+    // Fichier ordinaire
+    if( S_ISREG( st->st_mode ) )
+    {
+        // Les donnees d'un pipe encore dans le tampon ne sont pas perdues : le fichier est lu octet par octet
+        if( readAhead.kind == READ_PIPE && readAhead.start < readAhead.end ) return( 0 );
+
+        // Position courante du descripteur
+        const off_t position = lseek( fd, 0, SEEK_CUR );
+        if( position == -1 ) return( 0 );
+
+        // Le tampon est conserve si le fichier n'a pas change, et si la position est dans le tampon
+        if( sameInput && readAhead.kind == READ_FILE && readAhead.size == st->st_size &&
+            readAhead.mtime.tv_sec == st->st_mtim.tv_sec && readAhead.mtime.tv_nsec == st->st_mtim.tv_nsec &&
+            position >= readAhead.offset && position <= readAhead.offset + (off_t)readAhead.end )
+        {
+            readAhead.start = position - readAhead.offset;
+            return( 1 );
+        }
+
+        // Sinon, le tampon est vide, positionne sur la position courante
+        readAhead.kind = READ_FILE;
+        readAhead.dev = st->st_dev;
+        readAhead.ino = st->st_ino;
+        readAhead.size = st->st_size;
+        readAhead.mtime = st->st_mtim;
+        readAhead.offset = position;
+        readAhead.start = 0;
+        readAhead.end = 0;
+        return( 1 );
+    }
+
+    // Pipe cree par le minishell
+    if( S_ISFIFO( st->st_mode ) )
+    {
+        // Recherche du pipe parmi ceux du minishell
+        int shellPipe = 0;
+        for( int i = 0; i < SHELL_PIPE_COUNT && i < shellPipeCount && ! shellPipe; ++i )
+        {
+            shellPipe = ( shellPipes[i] == st->st_ino );
+        }
+        if( ! shellPipe ) return( 0 );
+
+        // Les donnees deja lues du pipe restent utilisables
+        if( sameInput && readAhead.kind == READ_PIPE ) return( 1 );
+
+        // Les donnees d'un autre pipe encore dans le tampon ne sont pas perdues
+        if( readAhead.kind == READ_PIPE && readAhead.start < readAhead.end ) return( 0 );
+
+        // Tampon vide, associe au pipe
+        readAhead.kind = READ_PIPE;
+        readAhead.dev = st->st_dev;
+        readAhead.ino = st->st_ino;
+        readAhead.offset = 0;
+        readAhead.start = 0;
+        readAhead.end = 0;
+        return( 1 );
+    }
+
+    // Autres entrees
+    return( 0 );
+}
+
+
+static int readBufferedLine( int fd, char delim, char* line, size_t size, size_t* length )
+{
+    // Tant que le delimiteur n'est pas trouve
+    int status = LINEREAD_OK;
+    for( ;; )
+    {
+        // Tampon consomme : lecture du bloc suivant
+        if( readAhead.start == readAhead.end )
+        {
+            status = fillReadAhead( fd );
+            if( status != LINEREAD_OK ) break;
+        }
+
+        // Recherche du delimiteur dans les donnees du tampon, et ajout des caracteres qui le precedent
+        const char* begin = readAhead.data + readAhead.start;
+        const size_t available = readAhead.end - readAhead.start;
+        const char* found = memchr( begin, delim, available );
+        const size_t count = ( found != NULL ? (size_t)( found - begin ) : available );
+        appendChars( line, size, length, begin, count );
+        readAhead.start += count + ( found != NULL );
+        if( found != NULL ) break;
+    }
+
+    // Le descripteur d'un fichier est repositionne juste apres la ligne
+    if( readAhead.kind == READ_FILE &&
+        lseek( fd, readAhead.offset + readAhead.start, SEEK_SET ) == -1 && status == LINEREAD_OK )
+    {
+        status = LINEREAD_IO_ERROR;
+    }
+
+    return( status );
+}
+
+
+static int fillReadAhead( int fd )
+{
+    // Lecture du bloc (a la suite du bloc precedent, pour un fichier)
+    ssize_t count = 0;
+    do
+    {
+        if( readAhead.kind == READ_FILE )
+        {
+            readAhead.offset += readAhead.end;
+            readAhead.end = 0;
+            count = pread( fd, readAhead.data, LINEREAD_BUFFER_SIZE, readAhead.offset );
+        }
+        else
+        {
+            count = read( fd, readAhead.data, LINEREAD_BUFFER_SIZE );
+        }
+    }
+    while( count == -1 && errno == EINTR );
+
+    // Donnees du tampon
+    readAhead.start = 0;
+    readAhead.end = ( count > 0 ? count : 0 );
+    if( count == -1 ) return( LINEREAD_IO_ERROR );
+
+    return( count == 0 ? LINEREAD_EOF : LINEREAD_OK );
+}
+
+
+static int readUnbufferedLine( int fd, char delim, char* line, size_t size, size_t* length )
+{
+    // Caractere par caractere, jusqu'au delimiteur
+    for( ;; )
+    {
+        char c = '\0';
+        const ssize_t count = read( fd, &c, 1 );
+        if( count == -1 && errno == EINTR ) continue;
+        if( count == -1 ) return( LINEREAD_IO_ERROR );
+        if( count == 0 ) return( LINEREAD_EOF );
+        if( c == delim ) return( LINEREAD_OK );
+        appendChars( line, size, length, &c, 1 );
+    }
+}
+
+
+static void appendChars( char* line, size_t size, size_t* length, const char* chars, size_t count )
+{
+    // Recopie dans la limite de la taille de la ligne
+    if( *length + count >= size ) count = size - 1 - *length;
+    memcpy( line + *length, chars, count );
+    *length += count;
+    line[*length] = '\0';
+}
@@ -0,0 +1,64 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Lecture de lignes sur un descripteur (builtin 'read').
+ *
+ *  Lire une ligne octet par octet (un appel a read() par caractere) est la seule facon de ne pas consommer les
+ *  donnees qui la suivent, mais coute un appel systeme par caractere. Les lignes sont donc lues par blocs, dans un
+ *  tampon de lecture anticipee partage par les lectures successives (un tampon par thread), quand l'entree le
+ *  permet :
+ *  - Fichier ordinaire : le bloc est lu a la position courante du descripteur (pread), puis le descripteur est
+ *    repositionne juste apres la ligne, de sorte que les autres lecteurs du fichier reprennent au bon endroit. Le
+ *    bloc est conserve tant que le fichier (meme inode, taille et date de modification) est relu a une position
+ *    qu'il contient : les lignes suivantes ne coutent qu'un repositionnement.
+ *  - Pipe cree par le minishell (voir addShellPipe()) : les donnees lues d'avance restent dans le tampon pour les
+ *    lectures suivantes du meme pipe (une commande externe qui lirait ensuite ce pipe ne les recevrait pas).
+ *  - Autres entrees (terminal, pipe herite d'un autre processus...) : lecture octet par octet.
+ */
+
+#ifndef _LINEREAD_H_
+#define _LINEREAD_H_
+
+#include <stddef.h>
+
+
+// Taille du tampon de lecture anticipee
+#define LINEREAD_BUFFER_SIZE    16384
+
+// Codes d'erreur
+enum LineReadError
+{
+    LINEREAD_OK = 0,            // Pas d'erreur (ligne terminee par le delimiteur)
+    LINEREAD_EOF = 230,         // Fin de fichier atteinte avant le delimiteur (la ligne peut etre non vide)
+    LINEREAD_IO_ERROR           // Erreur de lecture (voir errno)
+};
+
+
+/*
+ * Lit une ligne sur un descripteur, jusqu'au delimiteur (qui est consomme, mais n'est pas recopie)
+ *
+ * fd : le descripteur
+ * delim : le delimiteur de fin de ligne
+ * line : en sortie, la ligne (tronquee a 'size' - 1 caracteres, le reste de la ligne etant ignore)
+ * size : taille de 'line'
+ * length : en sortie, longueur de la ligne
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int readInputLine( int fd, char delim, char* line, size_t size, size_t* length );
+
+/*
+ * Memorise un pipe cree par le minishell : ses lectures pourront utiliser le tampon de lecture anticipee
+ * (les derniers pipes crees par le thread sont memorises)
+ *
+ * fd : un descripteur du pipe
+ */
+void addShellPipe( int fd );
+
+
+#endif // _LINEREAD_H_
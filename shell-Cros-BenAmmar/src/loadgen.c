@@ -0,0 +1,221 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : frame.h server.h
+ *
+ *  Generateur de charge pour le mode serveur du minishell : plusieurs connexions paralleles envoient chacune
+ *  la meme ligne de commande un certain nombre de fois, puis le debit (lignes/s) et les percentiles de
+ *  latence sont affiches.
+ *
+ *  Usage : minishell-loadgen -s SOCKET [-n LIGNES] [-c CONNEXIONS] [-m fds|stream] LIGNE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "frame.h"
+#include "server.h"
+
+
+// Codes d'erreur
+enum LoadgenError
+{
+    LOADGEN_OK = 0,             // Pas d'erreur
+    LOADGEN_BAD_ARGS = 1,       // Erreur d'utilisation (arguments)
+    LOADGEN_CONNECT_FAILED,     // Impossible de se connecter au serveur
+    LOADGEN_IO_FAILED           // Erreur d'echange avec le serveur
+};
+
+
+/*
+ * Retourne l'heure courante (horloge monotone) en nano-secondes
+ */
+static long long nowNs( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec * 1000000000LL + ts.tv_nsec );
+}
+
+
+/*
+ * Comparaison de deux latences (pour qsort)
+ */
+static int compareLatencies( const void* a, const void* b )
+{
+    const long long la = *(const long long*)a;
+    const long long lb = *(const long long*)b;
+    return( la < lb ? -1 : ( la > lb ? 1 : 0 ) );
+}
+
+
+/*
+ * Envoie une ligne de commande et attend son resultat.
+ *
+ * sock : socket connectee au serveur
+ * cmdLine : ligne de commande a envoyer
+ * streamMode : si vrai, les sorties sont renvoyees par le serveur (et ignorees), sinon /dev/null est transmis
+ * devNull : descripteur ouvert sur /dev/null
+ * result : en sortie, resultat de la ligne
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int sendLine( int sock, const char* cmdLine, int streamMode, int devNull, FrameResult* result )
+{
+    // Envoi de la ligne (avec les descripteurs a utiliser en mode "descripteurs")
+    const int fds[3] = { devNull, devNull, devNull };
+    if( sendFrame( sock, FRAME_LINE, cmdLine, strlen( cmdLine ), fds, streamMode ? 0 : 3 ) != FRAME_OK )
+    {
+        return( LOADGEN_IO_FAILED );
+    }
+
+    // Reception des trames jusqu'au resultat
+    while( 1 )
+    {
+        FrameHeader header;
+        char data[16384];
+        int recvFds[MAX_FRAME_FDS];
+        int recvFdCount = 0;
+        if( recvFrame( sock, &header, data, sizeof( data ), recvFds, &recvFdCount ) != FRAME_OK )
+        {
+            return( LOADGEN_IO_FAILED );
+        }
+
+        // Resultat : fin de la ligne
+        if( header.type == FRAME_RESULT && header.length == sizeof( FrameResult ) )
+        {
+            memcpy( result, data, sizeof( FrameResult ) );
+            return( LOADGEN_OK );
+        }
+    }
+}
+
+
+/*
+ * Processus d'une connexion : envoie 'count' fois la ligne de commande, et enregistre les latences.
+ *
+ * socketPath : chemin de la socket du serveur
+ * cmdLine : ligne de commande a envoyer
+ * count : nombre de lignes a envoyer
+ * streamMode : mode de transmission des sorties
+ * latencies : tableau (partage) des latences de la connexion
+ * failures : en sortie, nombre de lignes en erreur (partage)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int runConnection( const char* socketPath, const char* cmdLine, int count, int streamMode,
+                          long long* latencies, int* failures )
+{
+    // Connexion au serveur
+    struct sockaddr_un addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    strncpy( addr.sun_path, socketPath, sizeof( addr.sun_path ) - 1 );
+    const int sock = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if( sock == -1 || connect( sock, (struct sockaddr*)&addr, sizeof( addr ) ) == -1 )
+    {
+        perror( "ERREUR - Connexion au serveur" );
+        return( LOADGEN_CONNECT_FAILED );
+    }
+    const int devNull = open( "/dev/null", O_RDWR );
+
+    // Envoi des lignes
+    for( int i = 0; i < count; ++i )
+    {
+        FrameResult result;
+        const long long start = nowNs();
+        if( sendLine( sock, cmdLine, streamMode, devNull, &result ) != LOADGEN_OK ) return( LOADGEN_IO_FAILED );
+        latencies[i] = nowNs() - start;
+        if( result.error != 0 || result.status != 0 ) ++( *failures );
+    }
+
+    close( devNull );
+    close( sock );
+    return( LOADGEN_OK );
+}
+
+
+/*
+ * Fonction principale du programme
+ */
+int main( int argc, char* argv[] )
+{
+    // Options
+    const char* socketPath = NULL;
+    const char* cmdLine = NULL;
+    int count = 1000;
+    int connections = 1;
+    int streamMode = 0;
+    for( int iArg = 1; iArg < argc; ++iArg )
+    {
+        if( strcmp( argv[iArg], "-s" ) == 0 && iArg + 1 < argc ) socketPath = argv[++iArg];
+        else if( strcmp( argv[iArg], "-n" ) == 0 && iArg + 1 < argc ) count = atoi( argv[++iArg] );
+        else if( strcmp( argv[iArg], "-c" ) == 0 && iArg + 1 < argc ) connections = atoi( argv[++iArg] );
+        else if( strcmp( argv[iArg], "-m" ) == 0 && iArg + 1 < argc ) streamMode = ( strcmp( argv[++iArg], "stream" ) == 0 );
+        else if( cmdLine == NULL ) cmdLine = argv[iArg];
+        else socketPath = NULL;
+    }
+    if( socketPath == NULL || cmdLine == NULL || count <= 0 || connections <= 0 )
+    {
+        fprintf( stderr, "Usage: %s -s SOCKET [-n LIGNES] [-c CONNEXIONS] [-m fds|stream] LIGNE\n", argv[0] );
+        return( LOADGEN_BAD_ARGS );
+    }
+
+    // Tableaux partages entre les processus des connexions
+    const int total = count * connections;
+    long long* latencies = mmap( NULL, total * sizeof( long long ), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    int* failures = mmap( NULL, connections * sizeof( int ), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+    if( latencies == MAP_FAILED || failures == MAP_FAILED )
+    {
+        perror( "ERREUR - mmap" );
+        return( LOADGEN_IO_FAILED );
+    }
+
+    // Lancement des connexions paralleles
+    const long long start = nowNs();
+    for( int i = 0; i < connections; ++i )
+    {
+        if( fork() == 0 )
+        {
+            _exit( runConnection( socketPath, cmdLine, count, streamMode, latencies + i * count, failures + i ) );
+        }
+    }
+
+    // Attente de la fin des connexions
+    int status = LOADGEN_OK;
+    for( int i = 0; i < connections; ++i )
+    {
+        int childStatus = 0;
+        wait( &childStatus );
+        if( WEXITSTATUS( childStatus ) != LOADGEN_OK ) status = WEXITSTATUS( childStatus );
+    }
+    const double elapsed = ( nowNs() - start ) / 1e9;
+    if( status != LOADGEN_OK ) return( status );
+
+    // Statistiques
+    int failureCount = 0;
+    for( int i = 0; i < connections; ++i ) failureCount += failures[i];
+    qsort( latencies, total, sizeof( long long ), compareLatencies );
+    printf( "Lignes       : %d (%d connexions, %d en erreur)\n", total, connections, failureCount );
+    printf( "Duree        : %.3f s\n", elapsed );
+    printf( "Debit        : %.1f lignes/s\n", total / elapsed );
+    printf( "Latence (us) : p50 = %.1f, p90 = %.1f, p99 = %.1f, max = %.1f\n",
+            latencies[total / 2] / 1e3, latencies[total * 9 / 10] / 1e3,
+            latencies[total * 99 / 100] / 1e3, latencies[total - 1] / 1e3 );
+
+    return( LOADGEN_OK );
+}
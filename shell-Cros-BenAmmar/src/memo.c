@@ -0,0 +1,900 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h builtin.h metrics.h options.h
+ *
+ *  Memoisation de la sortie des commandes deterministes (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "memo.h"
+#include "builtin.h"
+#include "metrics.h"
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre max de fichiers --dep et de variables --env
+#define MEMO_MAX_DEPS       64
+
+// Taille des blocs lus et ecrits
+#define MEMO_BUFFER_SIZE    65536
+
+// Taille d'un hachage en hexadecimal (avec le '\0' final)
+#define HASH_HEX_SIZE       33
+
+// Message d'utilisation de la builtin 'memo'
+static const char* MEMO_USAGE = "ERREUR - Usage: memo [--dep FICHIER]... [--env NOM]... [--] CMD [ARGS...], "
+                                "memo --stats, memo --clear\n";
+
+// Hachage de 128 bits, calcule sur deux voies independantes (FNV-1a et une variante a multiplicateur different)
+typedef struct
+{
+    uint64_t a;
+    uint64_t b;
+} Hash;
+
+// Compteurs du fichier des statistiques
+enum MemoCounter
+{
+    COUNTER_HITS = 0,       // Sorties restituees depuis le cache
+    COUNTER_MISSES,         // Commandes executees puis memorisees
+    COUNTER_BYPASSES,       // Commandes executees sans memoisation (entree non identifiable, cache inaccessible)
+    COUNTER_EVICTIONS,      // Cles supprimees pour respecter la taille du cache
+    COUNTER_SERVED,         // Octets restitues depuis le cache
+    COUNTER_COUNT
+};
+
+// Noms des compteurs dans le fichier des statistiques
+static const char* COUNTER_NAMES[COUNTER_COUNT] = { "hits", "misses", "bypasses", "evictions", "served" };
+
+// Cle du cache (eviction) :
+// - name : nom de la cle
+// - object : objet reference
+// - used : date de derniere utilisation
+typedef struct
+{
+    char name[HASH_HEX_SIZE];
+    char object[HASH_HEX_SIZE];
+    struct timespec used;
+} KeyEntry;
+
+// Objet du cache (eviction) :
+// - name : nom de l'objet
+// - size : taille de l'objet
+// - refs : nombre de cles qui referencent l'objet
+typedef struct
+{
+    char name[HASH_HEX_SIZE];
+    off_t size;
+    int refs;
+} ObjectEntry;
+
+/*
+ * Initialise un hachage
+ *
+ * hash : le hachage
+ */
+static void initHash( Hash* hash );
+
+/*
+ * Ajoute des octets a un hachage
+ *
+ * hash : le hachage
+ * data : les octets
+ * size : nombre d'octets
+ */
+static void updateHash( Hash* hash, const void* data, size_t size );
+
+/*
+ * Ecrit un hachage en hexadecimal
+ *
+ * hash : le hachage
+ * hex : en sortie, le hachage en hexadecimal (HASH_HEX_SIZE caracteres)
+ */
+static void formatHash( const Hash* hash, char* hex );
+
+/*
+ * Ajoute un fichier d'entree a la cle : taille, date de modification et contenu (a partir d'une position)
+ *
+ * key : la cle
+ * fd : descripteur du fichier
+ * offset : position de debut du contenu
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addFileToKey( Hash* key, int fd, off_t offset );
+
+/*
+ * Calcule la cle d'une commande
+ *
+ * cmd : la commande (sans les options de 'memo')
+ * deps : fichiers listes par --dep
+ * depCount : nombre de fichiers
+ * envs : variables listees par --env
+ * envCount : nombre de variables
+ * hex : en sortie, la cle en hexadecimal
+ * retourne 1 si la commande peut etre memorisee, sinon 0 (entree standard non identifiable)
+ */
+static int computeKey( const cmd_t* cmd, char** deps, int depCount, char** envs, int envCount, char* hex );
+
+/*
+ * Retourne le repertoire du cache, en le creant si besoin
+ *
+ * dir : en sortie, le repertoire (PATH_MAX caracteres)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int getStoreDir( char* dir );
+
+/*
+ * Restitue la sortie memorisee d'une commande sur la sortie standard
+ *
+ * dir : repertoire du cache
+ * key : cle de la commande
+ * status : en sortie, code de retour memorise
+ * retourne 0 si la sortie a ete restituee, sinon un code d'erreur (cle inconnue)
+ */
+static int replayEntry( const char* dir, const char* key, int* status );
+
+/*
+ * Execute une commande, recopie sa sortie standard vers la sortie standard et dans le cache, puis memorise
+ * la cle de la commande
+ *
+ * cmd : la commande
+ * dir : repertoire du cache, ou NULL pour une execution sans memoisation
+ * key : cle de la commande
+ * retourne le code de retour de la commande, ou un code d'erreur
+ */
+static int runAndStore( cmd_t* cmd, const char* dir, const char* key );
+
+/*
+ * Memorise la sortie d'une commande : l'objet temporaire est renomme d'apres son contenu, puis la cle de la
+ * commande est ecrite
+ *
+ * dir : repertoire du cache
+ * key : cle de la commande
+ * tmpPath : objet temporaire qui contient la sortie
+ * content : hachage de la sortie
+ * size : taille de la sortie
+ * status : code de retour de la commande
+ */
+static void storeEntry( const char* dir, const char* key, const char* tmpPath, const Hash* content, long long size,
+                        int status );
+
+/*
+ * Supprime les cles les moins recemment utilisees, et les objets qui ne sont plus references, tant que la taille
+ * des objets du cache depasse l'option "memo-size"
+ *
+ * dir : repertoire du cache
+ * retourne le nombre de cles supprimees
+ */
+static int evictEntries( const char* dir );
+
+/*
+ * Ajoute des valeurs aux compteurs du fichier des statistiques (verrouille pendant la mise a jour)
+ *
+ * dir : repertoire du cache
+ * deltas : valeur a ajouter a chaque compteur (MemoCounter)
+ * counters : en sortie (si non NULL), valeur des compteurs apres la mise a jour
+ */
+static void updateStats( const char* dir, const long* deltas, long* counters );
+
+/*
+ * Affiche les statistiques du cache ('memo --stats')
+ *
+ * dir : repertoire du cache
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int printStats( const char* dir );
+
+/*
+ * Vide le cache ('memo --clear')
+ *
+ * dir : repertoire du cache
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int clearStore( const char* dir );
+
+/*
+ * Supprime les fichiers d'un sous-repertoire du cache
+ *
+ * dir : repertoire du cache
+ * subDir : le sous-repertoire
+ */
+static void removeFiles( const char* dir, const char* subDir );
+
+/*
+ * Ecrit un bloc de donnees en entier
+ *
+ * fd : le descripteur
+ * data : les donnees
+ * size : taille des donnees
+ * retourne 0 en cas de succes, sinon -1
+ */
+static int writeAll( int fd, const char* data, size_t size );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int runMemo( cmd_t* cmd )
+{
+    // Commandes d'administration du cache
+    char dir[PATH_MAX];
+    const char* action = cmd->argv[1];
+    if( action != NULL && ( strcmp( action, "--stats" ) == 0 || strcmp( action, "--clear" ) == 0 ) )
+    {
+        if( cmd->argv[2] != NULL )
+        {
+            fprintf( stderr, "%s", MEMO_USAGE );
+            return( MEMO_BAD_ARGS );
+        }
+        if( getStoreDir( dir ) != MEMO_OK ) return( MEMO_STORE_ERROR );
+        return( strcmp( action, "--stats" ) == 0 ? printStats( dir ) : clearStore( dir ) );
+    }
+
+    // Decodage des options
+    char* deps[MEMO_MAX_DEPS];
+    char* envs[MEMO_MAX_DEPS];
+    int depCount = 0;
+    int envCount = 0;
+    int iArg = 1;
+    while( cmd->argv[iArg] != NULL && strncmp( cmd->argv[iArg], "--", 2 ) == 0 )
+    {
+        // Fin des options
+        const char* option = cmd->argv[iArg++];
+        if( strcmp( option, "--" ) == 0 ) break;
+
+        // Option et valeur associee
+        char* value = cmd->argv[iArg++];
+        if( value != NULL && strcmp( option, "--dep" ) == 0 && depCount < MEMO_MAX_DEPS ) deps[depCount++] = value;
+        else if( value != NULL && strcmp( option, "--env" ) == 0 && envCount < MEMO_MAX_DEPS ) envs[envCount++] = value;
+        else
+        {
+            fprintf( stderr, "%s", MEMO_USAGE );
+            return( MEMO_BAD_ARGS );
+        }
+    }
+
+    // Il doit rester une commande a executer
+    if( cmd->argv[iArg] == NULL )
+    {
+        fprintf( stderr, "%s", MEMO_USAGE );
+        return( MEMO_BAD_ARGS );
+    }
+
+    // On retire 'memo' et ses options de la liste des arguments (le processus se termine avec la commande : les
+    // arguments retires ne sont pas liberes, et les valeurs des options restent valides)
+    int iDst = 0;
+    while( cmd->argv[iArg] != NULL ) cmd->argv[iDst++] = cmd->argv[iArg++];
+    cmd->argc = iDst;
+    while( iDst < iArg ) cmd->argv[iDst++] = NULL;
+    strcpy( cmd->path, cmd->argv[0] );
+
+    // Cle de la commande, et restitution de sa sortie si elle est connue
+    long deltas[COUNTER_COUNT] = { 0 };
+    char key[HASH_HEX_SIZE];
+    const int cacheable = computeKey( cmd, deps, depCount, envs, envCount, key );
+    const int storeStatus = ( cacheable ? getStoreDir( dir ) : MEMO_STORE_ERROR );
+    int status = 0;
+    if( storeStatus == MEMO_OK && replayEntry( dir, key, &status ) == MEMO_OK ) return( status );
+
+    // Sinon, execution de la commande (memorisee si possible)
+    status = runAndStore( cmd, storeStatus == MEMO_OK ? dir : NULL, key );
+    if( storeStatus == MEMO_OK ) return( status );
+
+    // Execution sans memoisation : seul le compteur du cache est mis a jour (s'il est accessible)
+    if( getStoreDir( dir ) == MEMO_OK )
+    {
+        deltas[COUNTER_BYPASSES] = 1;
+        updateStats( dir, deltas, NULL );
+    }
+    return( status );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void initHash( Hash* hash )
+{
+    hash->a = 14695981039346656037ULL;
+    hash->b = 0x9e3779b97f4a7c15ULL;
+}
+
+
+static void updateHash( Hash* hash, const void* data, size_t size )
+{
+    // Les deux voies utilisent des multiplicateurs premiers differents
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t a = hash->a;
+    uint64_t b = hash->b;
+    for( size_t i = 0; i < size; ++i )
+    {
+        a = ( a ^ bytes[i] ) * 1099511628211ULL;
+        b = ( b ^ bytes[i] ) * 0x100000000000053ULL;
+    }
+    hash->a = a;
+    hash->b = b;
+}
+
+
+static void formatHash( const Hash* hash, char* hex )
+{
+    // Melange final de chaque voie (les derniers octets influencent ainsi tous les bits)
+    uint64_t lanes[2] = { hash->a, hash->b ^ ( hash->a >> 29 ) };
+    for( int i = 0; i < 2; ++i )
+    {
+        uint64_t x = lanes[i];
+        x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+        x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebULL;
+        lanes[i] = x ^ ( x >> 31 );
+    }
+    snprintf( hex, HASH_HEX_SIZE, "%016llx%016llx", (unsigned long long)lanes[0], (unsigned long long)lanes[1] );
+}
+
+
+static int addFileToKey( Hash* key, int fd, off_t offset )
+{
+    // Taille et date de modification
+    struct stat st;
+    if( fstat( fd, &st ) == -1 ) return( MEMO_STORE_ERROR );
+    updateHash( key, &st.st_size, sizeof( st.st_size ) );
+    updateHash( key, &st.st_mtim, sizeof( st.st_mtim ) );
+    updateHash( key, &offset, sizeof( offset ) );
+
+    // Contenu (lu sans deplacer la position du descripteur)
+    Hash content;
+    initHash( &content );
+    char buffer[MEMO_BUFFER_SIZE];
+    ssize_t count = 0;
+    while( ( count = pread( fd, buffer, sizeof( buffer ), offset ) ) != 0 )
+    {
+        if( count == -1 && errno == EINTR ) continue;
+        if( count == -1 ) return( MEMO_STORE_ERROR );
+        updateHash( &content, buffer, count );
+        offset += count;
+    }
+    updateHash( key, &content, sizeof( content ) );
+
+    return( MEMO_OK );
+}
+
+
+static int computeKey( const cmd_t* cmd, char** deps, int depCount, char** envs, int envCount, char* hex )
+{
+    Hash key;
+    initHash( &key );
+
+    // Arguments de la commande (chacun avec son '\0', pour separer les arguments)
+    for( int i = 0; i < cmd->argc; ++i ) updateHash( &key, cmd->argv[i], strlen( cmd->argv[i] ) + 1 );
+
+    // Repertoire courant (les chemins relatifs en dependent)
+    char cwd[PATH_MAX];
+    if( getcwd( cwd, sizeof( cwd ) ) != NULL ) updateHash( &key, cwd, strlen( cwd ) + 1 );
+
+    // Variables d'environnement choisies (une variable inexistante differe d'une variable vide)
+    for( int i = 0; i < envCount; ++i )
+    {
+        const char* value = getenv( envs[i] );
+        updateHash( &key, envs[i], strlen( envs[i] ) + 1 );
+        updateHash( &key, value != NULL ? "=" : "!", 1 );
+        if( value != NULL ) updateHash( &key, value, strlen( value ) + 1 );
+    }
+
+    // Fichiers listes par --dep (un fichier inexistant est note comme tel)
+    for( int i = 0; i < depCount; ++i )
+    {
+        updateHash( &key, deps[i], strlen( deps[i] ) + 1 );
+        const int fd = open( deps[i], O_RDONLY | O_CLOEXEC );
+        const int status = ( fd != -1 ? addFileToKey( &key, fd, 0 ) : MEMO_STORE_ERROR );
+        if( fd != -1 ) close( fd );
+        if( status != MEMO_OK ) updateHash( &key, "!", 1 );
+    }
+
+    // Entree standard redirigee : un fichier ordinaire fait partie de la cle (a partir de la position courante) ;
+    // le contenu d'un pipe ou d'une socket n'est pas connu a l'avance. L'entree heritee du minishell (terminal,
+    // script) n'est pas prise en compte.
+    struct stat st;
+    int cacheable = 1;
+    if( cmd->in == -1 )
+    {
+        cacheable = 1;
+    }
+    else if( fstat( STDIN_FILENO, &st ) == 0 && S_ISREG( st.st_mode ) )
+    {
+        const off_t offset = lseek( STDIN_FILENO, 0, SEEK_CUR );
+        updateHash( &key, "<", 1 );
+        cacheable = ( offset != -1 && addFileToKey( &key, STDIN_FILENO, offset ) == MEMO_OK );
+    }
+    else if( fstat( STDIN_FILENO, &st ) == 0 && ( S_ISFIFO( st.st_mode ) || S_ISSOCK( st.st_mode ) ) )
+    {
+        cacheable = 0;
+    }
+
+    formatHash( &key, hex );
+    return( cacheable );
+}
+
+
+static int getStoreDir( char* dir )
+{
+    // Repertoire choisi, sinon repertoire de cache de l'utilisateur
+    const char* path = getenv( "MINISHELL_MEMO_DIR" );
+    const char* cacheHome = getenv( "XDG_CACHE_HOME" );
+    const char* home = getenv( "HOME" );
+    if( path != NULL && path[0] != '\0' ) snprintf( dir, PATH_MAX, "%s", path );
+    else if( cacheHome != NULL && cacheHome[0] != '\0' ) snprintf( dir, PATH_MAX, "%s/minishell/memo", cacheHome );
+    else if( home != NULL ) snprintf( dir, PATH_MAX, "%s/.cache/minishell/memo", home );
+    else return( MEMO_STORE_ERROR );
+
+    // Creation des repertoires manquants (chaque composant du chemin, puis les sous-repertoires)
+    char path2[PATH_MAX + 16];
+    snprintf( path2, sizeof( path2 ), "%s", dir );
+    for( char* slash = strchr( path2 + 1, '/' ); slash != NULL; slash = strchr( slash + 1, '/' ) )
+    {
+        *slash = '\0';
+        mkdir( path2, 0755 );
+        *slash = '/';
+    }
+    mkdir( dir, 0755 );
+    static const char* SUB_DIRS[] = { "objects", "keys" };
+    for( int i = 0; i < 2; ++i )
+    {
+        snprintf( path2, sizeof( path2 ), "%s/%s", dir, SUB_DIRS[i] );
+        if( mkdir( path2, 0755 ) == -1 && errno != EEXIST )
+        {
+            fprintf( stderr, "ERREUR - Cache memo inaccessible : %s (%s)\n", path2, strerror( errno ) );
+            return( MEMO_STORE_ERROR );
+        }
+    }
+
+    return( MEMO_OK );
+}
+
+
+static int replayEntry( const char* dir, const char* key, int* status )
+{
+    // Cle de la commande : code de retour, objet et taille de la sortie
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/keys/%s", dir, key );
+    FILE* keyFile = fopen( path, "r" );
+    if( keyFile == NULL ) return( MEMO_STORE_ERROR );
+    char object[HASH_HEX_SIZE];
+    long long size = 0;
+    const int fields = fscanf( keyFile, "%d %32s %lld", status, object, &size );
+    fclose( keyFile );
+    if( fields != 3 ) return( MEMO_STORE_ERROR );
+
+    // L'objet doit etre complet (il a pu etre supprime par l'eviction d'un autre minishell)
+    char objectPath[PATH_MAX + 64];
+    snprintf( objectPath, sizeof( objectPath ), "%s/objects/%s", dir, object );
+    const int fd = open( objectPath, O_RDONLY | O_CLOEXEC );
+    struct stat st;
+    if( fd == -1 ) return( MEMO_STORE_ERROR );
+    if( fstat( fd, &st ) == -1 || st.st_size != size )
+    {
+        close( fd );
+        return( MEMO_STORE_ERROR );
+    }
+
+    // La cle devient la plus recemment utilisee
+    utimensat( AT_FDCWD, path, NULL, 0 );
+
+    // Recopie de la sortie
+    char buffer[MEMO_BUFFER_SIZE];
+    ssize_t count = 0;
+    while( ( count = read( fd, buffer, sizeof( buffer ) ) ) != 0 )
+    {
+        if( count == -1 && errno == EINTR ) continue;
+        if( count == -1 || writeAll( STDOUT_FILENO, buffer, count ) == -1 ) break;
+    }
+    close( fd );
+
+    // Statistiques
+    long deltas[COUNTER_COUNT] = { 0 };
+    deltas[COUNTER_HITS] = 1;
+    deltas[COUNTER_SERVED] = size;
+    updateStats( dir, deltas, NULL );
+
+    return( MEMO_OK );
+}
+
+
+static int runAndStore( cmd_t* cmd, const char* dir, const char* key )
+{
+    // Pipe qui recoit la sortie standard de la commande
+    int pipeFD[2];
+    if( pipe( pipeFD ) == -1 ) return( MEMO_EXEC_FAILED );
+
+    // Processus d'execution de la commande
+    fflush( stdout );
+    const pid_t pid = fork();
+    if( pid == -1 )
+    {
+        close( pipeFD[0] );
+        close( pipeFD[1] );
+        return( MEMO_EXEC_FAILED );
+    }
+    if( pid == 0 )
+    {
+        close( pipeFD[0] );
+        dup2( pipeFD[1], STDOUT_FILENO );
+        close( pipeFD[1] );
+
+        // Execution de la commande (builtin ou binaire)
+        if( isBuiltin( cmd->path ) )
+        {
+            const int status = execBuiltin( cmd );
+            fflush( stdout );
+            _exit( status );
+        }
+        execvp( cmd->path, cmd->argv );
+        fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", cmd->path );
+        reportExecFailure();
+        _exit( CMD_EXEC_FAILED );
+    }
+    close( pipeFD[1] );
+
+    // Objet temporaire qui recoit la sortie (renomme d'apres son contenu une fois complet)
+    char tmpPath[PATH_MAX + 64];
+    int tmpFd = -1;
+    if( dir != NULL )
+    {
+        snprintf( tmpPath, sizeof( tmpPath ), "%s/objects/tmp.XXXXXX", dir );
+        tmpFd = mkstemp( tmpPath );
+    }
+
+    // Recopie de la sortie vers la sortie standard et dans l'objet, au fil de l'eau
+    const long maxSize = getOption( OPTION_MEMO_SIZE );
+    Hash content;
+    initHash( &content );
+    long long size = 0;
+    int outputOpen = 1;
+    char buffer[MEMO_BUFFER_SIZE];
+    ssize_t count = 0;
+    while( ( count = read( pipeFD[0], buffer, sizeof( buffer ) ) ) != 0 )
+    {
+        if( count == -1 && errno == EINTR ) continue;
+        if( count == -1 ) break;
+
+        // Sortie standard (si le lecteur s'arrete, la commande continue d'etre memorisee)
+        if( outputOpen && writeAll( STDOUT_FILENO, buffer, count ) == -1 ) outputOpen = 0;
+
+        // Objet : abandonne si la sortie est plus grande que le cache lui-meme
+        size += count;
+        updateHash( &content, buffer, count );
+        if( tmpFd != -1 && ( size > maxSize || writeAll( tmpFd, buffer, count ) == -1 ) )
+        {
+            close( tmpFd );
+            unlink( tmpPath );
+            tmpFd = -1;
+        }
+    }
+    close( pipeFD[0] );
+
+    // Attente de la fin de la commande
+    int childStatus = 0;
+    while( waitpid( pid, &childStatus, 0 ) == -1 && errno == EINTR );
+    const int status = ( WIFEXITED( childStatus ) ? WEXITSTATUS( childStatus ) : 128 + WTERMSIG( childStatus ) );
+    if( dir == NULL ) return( status );
+
+    // Memorisation de la sortie complete (une commande tuee par un signal n'est pas memorisee)
+    if( tmpFd != -1 )
+    {
+        close( tmpFd );
+        if( WIFEXITED( childStatus ) ) storeEntry( dir, key, tmpPath, &content, size, status );
+        else unlink( tmpPath );
+    }
+
+    // Statistiques, et eviction des cles les moins recemment utilisees
+    long deltas[COUNTER_COUNT] = { 0 };
+    deltas[COUNTER_MISSES] = 1;
+    deltas[COUNTER_EVICTIONS] = evictEntries( dir );
+    updateStats( dir, deltas, NULL );
+
+    return( status );
+}
+
+
+static void storeEntry( const char* dir, const char* key, const char* tmpPath, const Hash* content, long long size,
+                        int status )
+{
+    // L'objet prend le nom de son contenu (un objet identique existant est simplement remplace)
+    char object[HASH_HEX_SIZE];
+    formatHash( content, object );
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/objects/%s", dir, object );
+    if( rename( tmpPath, path ) == -1 )
+    {
+        unlink( tmpPath );
+        return;
+    }
+
+    // Cle de la commande, ecrite sous un nom temporaire puis renommee
+    char keyTmpPath[PATH_MAX + 64];
+    snprintf( keyTmpPath, sizeof( keyTmpPath ), "%s/keys/tmp.XXXXXX", dir );
+    const int fd = mkstemp( keyTmpPath );
+    if( fd == -1 ) return;
+    char entry[128];
+    const int length = snprintf( entry, sizeof( entry ), "%d %s %lld\n", status, object, size );
+    snprintf( path, sizeof( path ), "%s/keys/%s", dir, key );
+    const int written = ( writeAll( fd, entry, length ) == 0 );
+    close( fd );
+    if( ! written || rename( keyTmpPath, path ) == -1 ) unlink( keyTmpPath );
+}
+
+
+static int evictEntries( const char* dir )
+{
+    // Objets du cache, et taille totale
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/objects", dir );
+    DIR* stream = opendir( path );
+    if( stream == NULL ) return( 0 );
+    ObjectEntry* objects = NULL;
+    int objectCount = 0;
+    int objectCapacity = 0;
+    long long total = 0;
+    struct dirent* entry = NULL;
+    while( ( entry = readdir( stream ) ) != NULL )
+    {
+        // Seuls les objets complets sont comptes (pas les fichiers temporaires)
+        struct stat st;
+        if( strlen( entry->d_name ) != HASH_HEX_SIZE - 1 ) continue;
+        if( fstatat( dirfd( stream ), entry->d_name, &st, 0 ) == -1 ) continue;
+        if( objectCount == objectCapacity )
+        {
+            objectCapacity = ( objectCapacity == 0 ? 64 : objectCapacity * 2 );
+            ObjectEntry* newObjects = (ObjectEntry*)realloc( objects, objectCapacity * sizeof( ObjectEntry ) );
+            if( newObjects == NULL ) break;
+            objects = newObjects;
+        }
+        ObjectEntry* object = objects + objectCount++;
+        strcpy( object->name, entry->d_name );
+        object->size = st.st_size;
+        object->refs = 0;
+        total += st.st_size;
+    }
+    closedir( stream );
+
+    // Rien a supprimer si le cache respecte sa taille
+    const long maxSize = getOption( OPTION_MEMO_SIZE );
+    if( total <= maxSize )
+    {
+        free( objects );
+        return( 0 );
+    }
+
+    // Cles du cache, et objets qu'elles referencent
+    snprintf( path, sizeof( path ), "%s/keys", dir );
+    stream = opendir( path );
+    KeyEntry* keys = NULL;
+    int keyCount = 0;
+    int keyCapacity = 0;
+    while( stream != NULL && ( entry = readdir( stream ) ) != NULL )
+    {
+        struct stat st;
+        if( strlen( entry->d_name ) != HASH_HEX_SIZE - 1 ) continue;
+        if( fstatat( dirfd( stream ), entry->d_name, &st, 0 ) == -1 ) continue;
+        if( keyCount == keyCapacity )
+        {
+            keyCapacity = ( keyCapacity == 0 ? 64 : keyCapacity * 2 );
+            KeyEntry* newKeys = (KeyEntry*)realloc( keys, keyCapacity * sizeof( KeyEntry ) );
+            if( newKeys == NULL ) break;
+            keys = newKeys;
+        }
+        KeyEntry* key = keys + keyCount;
+        strcpy( key->name, entry->d_name );
+        key->used = st.st_mtim;
+        key->object[0] = '\0';
+        char keyPath[PATH_MAX + 128];
+        snprintf( keyPath, sizeof( keyPath ), "%s/%s", path, entry->d_name );
+        FILE* keyFile = fopen( keyPath, "r" );
+        if( keyFile == NULL ) continue;
+        int status = 0;
+        if( fscanf( keyFile, "%d %32s", &status, key->object ) == 2 ) ++keyCount;
+        fclose( keyFile );
+    }
+    if( stream != NULL ) closedir( stream );
+
+    // Nombre de references de chaque objet
+    for( int i = 0; i < keyCount; ++i )
+    {
+        for( int j = 0; j < objectCount; ++j )
+        {
+            if( strcmp( objects[j].name, keys[i].object ) == 0 ) ++objects[j].refs;
+        }
+    }
+
+    // Les objets qui ne sont plus references sont supprimes en premier
+    for( int j = 0; j < objectCount && total > maxSize; ++j )
+    {
+        if( objects[j].refs > 0 ) continue;
+        snprintf( path, sizeof( path ), "%s/objects/%s", dir, objects[j].name );
+        if( unlink( path ) == 0 ) total -= objects[j].size;
+        objects[j].refs = -1;
+    }
+
+    // Puis les cles les moins recemment utilisees (recherche de la plus ancienne a chaque suppression), avec
+    // leur objet s'il n'est plus reference
+    int evicted = 0;
+    while( total > maxSize && evicted < keyCount )
+    {
+        int oldest = -1;
+        for( int i = 0; i < keyCount; ++i )
+        {
+            if( keys[i].name[0] == '\0' ) continue;
+            if( oldest == -1 || keys[i].used.tv_sec < keys[oldest].used.tv_sec ||
+                ( keys[i].used.tv_sec == keys[oldest].used.tv_sec &&
+                  keys[i].used.tv_nsec < keys[oldest].used.tv_nsec ) )
+            {
+                oldest = i;
+            }
+        }
+        if( oldest == -1 ) break;
+        snprintf( path, sizeof( path ), "%s/keys/%s", dir, keys[oldest].name );
+        unlink( path );
+        keys[oldest].name[0] = '\0';
+        ++evicted;
+        for( int j = 0; j < objectCount; ++j )
+        {
+            if( strcmp( objects[j].name, keys[oldest].object ) != 0 || --objects[j].refs > 0 ) continue;
+            snprintf( path, sizeof( path ), "%s/objects/%s", dir, objects[j].name );
+            if( unlink( path ) == 0 ) total -= objects[j].size;
+        }
+    }
+
+    free( keys );
+    free( objects );
+    return( evicted );
+}
+
+
+static void updateStats( const char* dir, const long* deltas, long* counters )
+{
+    long values[COUNTER_COUNT] = { 0 };
+
+    // Fichier des statistiques, verrouille le temps de la mise a jour
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/stats", dir );
+    const int fd = open( path, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+    if( fd == -1 ) return;
+    flock( fd, LOCK_EX );
+
+    // Lecture des compteurs ("NOM VALEUR" par ligne)
+    char buffer[1024];
+    const ssize_t count = pread( fd, buffer, sizeof( buffer ) - 1, 0 );
+    buffer[count > 0 ? count : 0] = '\0';
+    char* savePtr = NULL;
+    for( char* line = strtok_r( buffer, "\n", &savePtr ); line != NULL; line = strtok_r( NULL, "\n", &savePtr ) )
+    {
+        char name[32];
+        long value = 0;
+        if( sscanf( line, "%31s %ld", name, &value ) != 2 ) continue;
+        for( int i = 0; i < COUNTER_COUNT; ++i )
+        {
+            if( strcmp( name, COUNTER_NAMES[i] ) == 0 ) values[i] = value;
+        }
+    }
+
+    // Mise a jour et reecriture
+    int length = 0;
+    for( int i = 0; i < COUNTER_COUNT; ++i )
+    {
+        if( deltas != NULL ) values[i] += deltas[i];
+        length += snprintf( buffer + length, sizeof( buffer ) - length, "%s %ld\n", COUNTER_NAMES[i], values[i] );
+    }
+    if( deltas != NULL && ftruncate( fd, 0 ) == 0 && pwrite( fd, buffer, length, 0 ) != length )
+    {
+        fprintf( stderr, "ERREUR - Ecriture impossible : %s\n", path );
+    }
+    close( fd );
+
+    if( counters != NULL ) memcpy( counters, values, sizeof( values ) );
+}
+
+
+static int printStats( const char* dir )
+{
+    // Compteurs (lus sans modification)
+    long counters[COUNTER_COUNT];
+    updateStats( dir, NULL, counters );
+
+    // Nombre de cles, et taille des objets
+    const char* SUB_DIRS[] = { "keys", "objects" };
+    long long counts[2] = { 0, 0 };
+    long long total = 0;
+    for( int i = 0; i < 2; ++i )
+    {
+        char path[PATH_MAX + 64];
+        snprintf( path, sizeof( path ), "%s/%s", dir, SUB_DIRS[i] );
+        DIR* stream = opendir( path );
+        struct dirent* entry = NULL;
+        while( stream != NULL && ( entry = readdir( stream ) ) != NULL )
+        {
+            struct stat st;
+            if( strlen( entry->d_name ) != HASH_HEX_SIZE - 1 ) continue;
+            if( fstatat( dirfd( stream ), entry->d_name, &st, 0 ) == -1 ) continue;
+            ++counts[i];
+            if( i == 1 ) total += st.st_size;
+        }
+        if( stream != NULL ) closedir( stream );
+    }
+
+    // Affichage
+    const long lookups = counters[COUNTER_HITS] + counters[COUNTER_MISSES];
+    printf( "cache       %s\n", dir );
+    printf( "entrees     %lld (%lld objets, %lld octets sur %ld)\n", counts[0], counts[1], total,
+            getOption( OPTION_MEMO_SIZE ) );
+    printf( "succes      %ld (%ld %%)\n", counters[COUNTER_HITS],
+            lookups > 0 ? counters[COUNTER_HITS] * 100 / lookups : 0 );
+    printf( "echecs      %ld\n", counters[COUNTER_MISSES] );
+    printf( "ignorees    %ld\n", counters[COUNTER_BYPASSES] );
+    printf( "evictions   %ld\n", counters[COUNTER_EVICTIONS] );
+    printf( "restitues   %ld octets\n", counters[COUNTER_SERVED] );
+    fflush( stdout );
+
+    return( MEMO_OK );
+}
+
+
+static int clearStore( const char* dir )
+{
+    // Suppression des cles, puis des objets, puis des statistiques
+    removeFiles( dir, "keys" );
+    removeFiles( dir, "objects" );
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/stats", dir );
+    unlink( path );
+
+    return( MEMO_OK );
+}
+
+
+static void removeFiles( const char* dir, const char* subDir )
+{
+    char path[PATH_MAX + 64];
+    snprintf( path, sizeof( path ), "%s/%s", dir, subDir );
+    DIR* stream = opendir( path );
+    if( stream == NULL ) return;
+    struct dirent* entry = NULL;
+    while( ( entry = readdir( stream ) ) != NULL )
+    {
+        if( entry->d_name[0] != '.' ) unlinkat( dirfd( stream ), entry->d_name, 0 );
+    }
+    closedir( stream );
+}
+
+
+static int writeAll( int fd, const char* data, size_t size )
+{
+    // Les ecritures partielles (pipe, signal) sont completees
+    while( size > 0 )
+    {
+        const ssize_t count = write( fd, data, size );
+        if( count == -1 && errno == EINTR ) continue;
+        if( count == -1 ) return( -1 );
+        data += count;
+        size -= count;
+    }
+
+    return( 0 );
+}
@@ -0,0 +1,64 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Memoisation de la sortie des commandes deterministes : builtin
+ *  'memo [--dep FICHIER]... [--env NOM]... [--] CMD [ARGS...]', ainsi que 'memo --stats' et 'memo --clear'.
+ *
+ *  La commande est identifiee par une cle calculee a partir de ses arguments, du repertoire courant, des
+ *  variables d'environnement choisies (--env), et de la taille, la date de modification et le contenu des
+ *  fichiers d'entree : fichiers listes par --dep, et fichier ordinaire redirige sur l'entree standard ("<") ;
+ *  l'entree standard heritee du minishell (terminal, script) ne fait pas partie de la cle.
+ *  Si la cle est connue, la sortie standard et le code de retour memorises sont restitues sans executer la
+ *  commande ; sinon, la commande est executee et sa sortie standard est recopiee au fil de l'eau vers la
+ *  sortie de 'memo' et dans le cache.
+ *
+ *  Le cache est un repertoire (variable MINISHELL_MEMO_DIR, sinon $XDG_CACHE_HOME/minishell/memo ou
+ *  $HOME/.cache/minishell/memo) adresse par contenu :
+ *  - objects/HASH : une sortie, nommee d'apres le hachage de son contenu (deux commandes qui produisent la meme
+ *    sortie partagent le meme objet)
+ *  - keys/CLE : code de retour, objet et taille de la sortie de la commande identifiee par la cle ; la date de
+ *    modification du fichier est celle de sa derniere utilisation
+ *  - stats : compteurs de succes et d'echecs, partages par tous les minishells qui utilisent le cache
+ *  Les fichiers sont ecrits sous un nom temporaire puis renommes : plusieurs minishells peuvent utiliser le
+ *  meme cache simultanement. Quand la taille des objets depasse l'option "memo-size" (en octets), les cles les
+ *  moins recemment utilisees sont supprimees, avec les objets qui ne sont plus references (LRU).
+ *
+ *  Seules la sortie standard et les terminaisons normales (exit) sont memorisees : la sortie d'erreur n'est pas
+ *  conservee, et une commande tuee par un signal n'est pas memorisee. Une commande dont l'entree standard est
+ *  redirigee depuis un pipe ou une socket (contenu inconnu a l'avance) est executee sans memoisation. Les
+ *  hachages (128 bits, non cryptographiques) identifient des contenus, pas des versions signees.
+ */
+
+#ifndef _MEMO_H_
+#define _MEMO_H_
+
+#include "cmd.h"
+
+
+// Codes d'erreur
+enum MemoError
+{
+    MEMO_OK = 0,                // Pas d'erreur
+    MEMO_BAD_ARGS = 260,        // Erreur d'utilisation (arguments) de la builtin 'memo'
+    MEMO_STORE_ERROR,           // Cache inaccessible
+    MEMO_EXEC_FAILED            // Impossible d'executer la commande (pipe ou fork)
+};
+
+
+/*
+ * Execute la builtin 'memo' (dans le processus d'execution de la commande) : restitue la sortie memorisee de la
+ * commande, ou execute la commande et memorise sa sortie
+ *
+ * cmd : la commande 'memo' (ses options sont retirees de la liste des arguments)
+ * retourne le code de retour de la commande, ou un code d'erreur
+ */
+int runMemo( cmd_t* cmd );
+
+
+#endif // _MEMO_H_
@@ -0,0 +1,222 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Comptabilite des allocations memoire du minishell (implementation)
+ */
+
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// En-tete d'un bloc (aligne comme un bloc de malloc(), le bloc utilisateur le suit directement) :
+// - size : taille demandee du bloc
+// - subsystem : sous-systeme auquel le bloc est impute
+typedef union
+{
+    struct
+    {
+        size_t size;
+        int subsystem;
+    } info;
+    max_align_t align;
+} MemHeader;
+
+// Compteurs d'un sous-systeme (voir MemStats)
+typedef struct
+{
+    atomic_size_t bytes;
+    atomic_size_t peakBytes;
+    atomic_size_t blocks;
+    atomic_size_t allocs;
+} MemCounters;
+
+// Compteurs de chaque sous-systeme
+static MemCounters counters[MEM_SUBSYSTEM_COUNT];
+
+// Noms des sous-systemes
+static const char* SUBSYSTEM_NAMES[MEM_SUBSYSTEM_COUNT] = { "parseur", "commandes", "jobs", "variables" };
+
+/*
+ * Impute l'allocation d'un bloc a un sous-systeme
+ *
+ * subsystem : le sous-systeme
+ * size : taille du bloc
+ */
+static void addBlock( int subsystem, size_t size );
+
+/*
+ * Retire la liberation d'un bloc des compteurs de son sous-systeme
+ *
+ * subsystem : le sous-systeme
+ * size : taille du bloc
+ */
+static void removeBlock( int subsystem, size_t size );
+
+/*
+ * Met a jour le pic d'octets alloues d'un sous-systeme
+ *
+ * subsystem : le sous-systeme
+ * bytes : octets actuellement alloues
+ */
+static void updatePeak( int subsystem, size_t bytes );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+void* memAlloc( int subsystem, size_t size )
+{
+    // Le bloc est alloue avec son en-tete
+    MemHeader* header = (MemHeader*)malloc( sizeof( MemHeader ) + size );
+    if( header == NULL ) return( NULL );
+    header->info.size = size;
+    header->info.subsystem = subsystem;
+
+    addBlock( subsystem, size );
+    return( header + 1 );
+}
+
+
+void* memCalloc( int subsystem, size_t count, size_t size )
+{
+    // Taille totale (sans depassement de capacite)
+    if( size != 0 && count > ( (size_t)-1 - sizeof( MemHeader ) ) / size ) return( NULL );
+
+    void* ptr = memAlloc( subsystem, count * size );
+    if( ptr != NULL ) memset( ptr, 0, count * size );
+    return( ptr );
+}
+
+
+void* memRealloc( int subsystem, void* ptr, size_t size )
+{
+    if( ptr == NULL ) return( memAlloc( subsystem, size ) );
+
+    // Redimensionnement du bloc avec son en-tete (le bloc reste impute a son sous-systeme)
+    MemHeader* header = (MemHeader*)ptr - 1;
+    const size_t oldSize = header->info.size;
+    header = (MemHeader*)realloc( header, sizeof( MemHeader ) + size );
+    if( header == NULL ) return( NULL );
+    header->info.size = size;
+
+    // Seule la difference de taille change les octets alloues
+    MemCounters* stats = counters + header->info.subsystem;
+    if( size >= oldSize )
+    {
+        const size_t bytes = atomic_fetch_add( &stats->bytes, size - oldSize ) + size - oldSize;
+        updatePeak( header->info.subsystem, bytes );
+    }
+    else
+    {
+        atomic_fetch_sub( &stats->bytes, oldSize - size );
+    }
+
+    return( header + 1 );
+}
+
+
+char* memStrdup( int subsystem, const char* str )
+{
+    const size_t size = strlen( str ) + 1;
+    char* copy = (char*)memAlloc( subsystem, size );
+    if( copy != NULL ) memcpy( copy, str, size );
+    return( copy );
+}
+
+
+void memFree( void* ptr )
+{
+    if( ptr == NULL ) return;
+
+    // Le sous-systeme et la taille du bloc sont dans son en-tete
+    MemHeader* header = (MemHeader*)ptr - 1;
+    removeBlock( header->info.subsystem, header->info.size );
+    free( header );
+}
+
+
+void getMemStats( int subsystem, MemStats* stats )
+{
+    MemCounters* source = counters + subsystem;
+    stats->bytes = atomic_load( &source->bytes );
+    stats->peakBytes = atomic_load( &source->peakBytes );
+    stats->blocks = atomic_load( &source->blocks );
+    stats->allocs = atomic_load( &source->allocs );
+}
+
+
+const char* getMemSubsystemName( int subsystem )
+{
+    return( subsystem >= 0 && subsystem < MEM_SUBSYSTEM_COUNT ? SUBSYSTEM_NAMES[subsystem] : "?" );
+}
+
+
+void resetMemPeaks( void )
+{
+    for( int i = 0; i < MEM_SUBSYSTEM_COUNT; ++i )
+    {
+        atomic_store( &counters[i].peakBytes, atomic_load( &counters[i].bytes ) );
+    }
+}
+
+
+int readProcessMemory( long* rss, long* peakRss )
+{
+    *rss = 0;
+    *peakRss = 0;
+
+    // Fichier d'etat du processus
+    FILE* file = fopen( "/proc/self/status", "r" );
+    if( file == NULL ) return( MEMSTAT_IO_ERROR );
+
+    // Recherche des champs (en kio)
+    char line[256];
+    int found = 0;
+    while( fgets( line, sizeof( line ), file ) != NULL )
+    {
+        if( sscanf( line, "VmRSS: %ld", rss ) == 1 ) ++found;
+        else if( sscanf( line, "VmHWM: %ld", peakRss ) == 1 ) ++found;
+    }
+    fclose( file );
+
+    return( found == 2 ? MEMSTAT_OK : MEMSTAT_IO_ERROR );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void addBlock( int subsystem, size_t size )
+{
+    MemCounters* stats = counters + subsystem;
+    atomic_fetch_add( &stats->blocks, 1 );
+    atomic_fetch_add( &stats->allocs, 1 );
+    updatePeak( subsystem, atomic_fetch_add( &stats->bytes, size ) + size );
+}
+
+
+static void removeBlock( int subsystem, size_t size )
+{
+    MemCounters* stats = counters + subsystem;
+    atomic_fetch_sub( &stats->blocks, 1 );
+    atomic_fetch_sub( &stats->bytes, size );
+}
+
+
+static void updatePeak( int subsystem, size_t bytes )
+{
+    // Le pic n'est modifie que s'il est depasse (un autre thread peut le modifier entre-temps)
+    atomic_size_t* peak = &counters[subsystem].peakBytes;
+    size_t current = atomic_load( peak );
+    while( bytes > current && ! atomic_compare_exchange_weak( peak, &current, bytes ) );
+}
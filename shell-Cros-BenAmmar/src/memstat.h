@@ -0,0 +1,141 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Comptabilite des allocations memoire du minishell (builtin 'memstat').
+ *
+ *  Les allocations du minishell passent par des fonctions d'enrobage de malloc(), calloc(), realloc(), strdup()
+ *  et free(), qui tiennent a jour des compteurs par sous-systeme :
+ *  - parseur : mots de la ligne de commande (strcut()), arguments produits par l'expansion des mots et caches
+ *    de l'expansion (voir expand.h et param.h)
+ *  - commandes : listes d'arguments des commandes, corps des fonctions appelees, plans de libminishell
+ *  - jobs : commandes en background et leur attente
+ *  - variables : variables locales et definitions des fonctions
+ *  Pour chaque sous-systeme : octets alloues (courant et pic), nombre de blocs alloues et nombre total
+ *  d'allocations. Un bloc est precede d'un en-tete qui memorise sa taille et son sous-systeme : il doit etre
+ *  libere par memFree() (et un bloc alloue par malloc() ne doit jamais l'etre par memFree()), mais peut changer
+ *  de proprietaire (un argument produit par le parseur est libere avec sa commande). Les compteurs sont
+ *  atomiques (partages par les threads de libminishell et des etapes de pipeline).
+ *
+ *  Les autres allocations (editeur de ligne, tampons des etapes et des sorties capturees...) ne sont pas
+ *  comptabilisees ; la memoire du processus est donnee par son RSS (/proc/self/status).
+ */
+
+#ifndef _MEMSTAT_H_
+#define _MEMSTAT_H_
+
+#include <stddef.h>
+
+
+// Sous-systemes dont les allocations sont comptabilisees
+enum MemSubsystem
+{
+    MEM_PARSER = 0,             // Parseur
+    MEM_COMMANDS,               // Commandes
+    MEM_JOBS,                   // Commandes en background
+    MEM_VARIABLES,              // Variables et fonctions
+    MEM_SUBSYSTEM_COUNT
+};
+
+// Codes d'erreur
+enum MemstatError
+{
+    MEMSTAT_OK = 0,             // Pas d'erreur
+    MEMSTAT_IO_ERROR = 250      // Lecture de /proc/self/status impossible
+};
+
+// Compteurs d'un sous-systeme :
+// - bytes : octets actuellement alloues
+// - peakBytes : maximum atteint par 'bytes'
+// - blocks : nombre de blocs actuellement alloues
+// - allocs : nombre total d'allocations
+typedef struct
+{
+    size_t bytes;
+    size_t peakBytes;
+    size_t blocks;
+    size_t allocs;
+} MemStats;
+
+
+/*
+ * Alloue un bloc (comme malloc())
+ *
+ * subsystem : sous-systeme auquel le bloc est impute (MemSubsystem)
+ * size : taille du bloc
+ * retourne le bloc, ou NULL en cas d'echec
+ */
+void* memAlloc( int subsystem, size_t size );
+
+/*
+ * Alloue un bloc initialise a zero (comme calloc())
+ *
+ * subsystem : sous-systeme auquel le bloc est impute (MemSubsystem)
+ * count : nombre d'elements
+ * size : taille d'un element
+ * retourne le bloc, ou NULL en cas d'echec
+ */
+void* memCalloc( int subsystem, size_t count, size_t size );
+
+/*
+ * Redimensionne un bloc (comme realloc()) : il reste impute a son sous-systeme
+ *
+ * subsystem : sous-systeme auquel le bloc est impute s'il est alloue (ptr NULL)
+ * ptr : le bloc (alloue par ces fonctions), ou NULL
+ * size : nouvelle taille du bloc
+ * retourne le bloc redimensionne, ou NULL en cas d'echec (le bloc d'origine est alors conserve)
+ */
+void* memRealloc( int subsystem, void* ptr, size_t size );
+
+/*
+ * Duplique une chaine de caracteres (comme strdup())
+ *
+ * subsystem : sous-systeme auquel la copie est imputee (MemSubsystem)
+ * str : la chaine
+ * retourne la copie, ou NULL en cas d'echec
+ */
+char* memStrdup( int subsystem, const char* str );
+
+/*
+ * Libere un bloc alloue par ces fonctions (comme free())
+ *
+ * ptr : le bloc, ou NULL
+ */
+void memFree( void* ptr );
+
+/*
+ * Lit les compteurs d'un sous-systeme
+ *
+ * subsystem : le sous-systeme (MemSubsystem)
+ * stats : en sortie, les compteurs
+ */
+void getMemStats( int subsystem, MemStats* stats );
+
+/*
+ * Retourne le nom d'un sous-systeme (pour l'affichage)
+ *
+ * subsystem : le sous-systeme (MemSubsystem)
+ */
+const char* getMemSubsystemName( int subsystem );
+
+/*
+ * Ramene le pic de chaque sous-systeme a sa valeur courante (pour mesurer le pic d'une operation)
+ */
+void resetMemPeaks( void );
+
+/*
+ * Lit la memoire residente du processus (champs VmRSS et VmHWM de /proc/self/status)
+ *
+ * rss : en sortie, memoire residente (en kio)
+ * peakRss : en sortie, pic de memoire residente (en kio)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int readProcessMemory( long* rss, long* peakRss );
+
+
+#endif // _MEMSTAT_H_
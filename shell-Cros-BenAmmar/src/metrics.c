@@ -0,0 +1,550 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h options.h parser.h ringbuf.h
+ *
+ *  Metriques d'execution du minishell (implementation)
+ */
+
+#include "metrics.h"
+#include "cmd.h"
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre max de noms de commandes distincts suivis (les commandes suivantes sont regroupees sous le nom
+// OTHER_COMMANDS)
+#define MAX_METRICS_COMMANDS    128
+
+// Taille max d'un nom de commande (les noms plus longs sont tronques)
+#define MAX_METRICS_NAME        64
+
+// Nom sous lequel sont regroupees les commandes qui ne tiennent plus dans la table
+#define OTHER_COMMANDS          "_other"
+
+// Nombre de codes d'erreur CmdError
+#define CMD_ERROR_COUNT         ( CMD_NOT_FOUND - CMD_BAD_SEP + 1 )
+
+// Nombre de nanosecondes par seconde
+#define NS_PER_SECOND           1000000000LL
+
+// Bornes superieures des intervalles des histogrammes (en nanosecondes), l'intervalle +Inf etant implicite :
+// - duree d'execution des commandes : de 1 ms a 1 min
+// - duree de parsing des lignes : de 10 us a 50 ms
+static const int64_t WALL_BUCKETS[] =
+{
+    1000000LL, 5000000LL, 10000000LL, 50000000LL, 100000000LL, 500000000LL,
+    1000000000LL, 5000000000LL, 10000000000LL, 60000000000LL
+};
+#define WALL_BUCKET_COUNT       ( sizeof( WALL_BUCKETS ) / sizeof( WALL_BUCKETS[0] ) )
+static const int64_t PARSE_BUCKETS[] =
+{
+    10000LL, 50000LL, 100000LL, 500000LL, 1000000LL, 5000000LL, 10000000LL, 50000000LL
+};
+#define PARSE_BUCKET_COUNT      ( sizeof( PARSE_BUCKETS ) / sizeof( PARSE_BUCKETS[0] ) )
+
+// Metriques ecrites pour chaque commande
+enum CommandMetric
+{
+    METRIC_SPAWNS = 0,          // Lancements
+    METRIC_ERRORS,              // Erreurs de lancement, par code CmdError
+    METRIC_EXIT_FAILURES,       // Terminaisons en echec
+    METRIC_CPU,                 // Temps CPU
+    METRIC_WALL,                // Histogramme des durees d'execution
+    METRIC_LAST                 // Marque la derniere metrique
+};
+
+// Lignes HELP/TYPE des metriques de chaque commande, dans l'ordre de l'enum CommandMetric
+static const char* COMMAND_METRIC_HEADERS[METRIC_LAST] =
+{
+    "# HELP minishell_command_spawns_total Lancements de la commande.\n"
+    "# TYPE minishell_command_spawns_total counter\n",
+    "# HELP minishell_command_errors_total Erreurs de lancement de la commande, par code CmdError.\n"
+    "# TYPE minishell_command_errors_total counter\n",
+    "# HELP minishell_command_exit_failures_total Terminaisons en echec (code non nul ou signal).\n"
+    "# TYPE minishell_command_exit_failures_total counter\n",
+    "# HELP minishell_command_cpu_seconds_total Temps CPU (utilisateur et systeme) de la commande.\n"
+    "# TYPE minishell_command_cpu_seconds_total counter\n",
+    "# HELP minishell_command_wall_seconds Duree d'execution de la commande.\n"
+    "# TYPE minishell_command_wall_seconds histogram\n"
+};
+
+// Metriques d'une commande :
+// - name : nom de la commande (chaine vide si l'entree de la table est libre)
+// - spawns : nombre de lancements
+// - exitFailures : nombre de terminaisons avec un code de retour non nul (ou par un signal)
+// - errors : nombre d'erreurs, par code CmdError
+// - wallBuckets : histogramme des durees d'execution (nombre de commandes par intervalle, non cumule)
+// - wallSum : somme des durees d'execution (nanosecondes)
+// - cpuSum : somme des temps CPU consommes (micro-secondes)
+typedef struct
+{
+    char name[MAX_METRICS_NAME];
+    uint64_t spawns;
+    uint64_t exitFailures;
+    uint64_t errors[CMD_ERROR_COUNT];
+    uint64_t wallBuckets[WALL_BUCKET_COUNT + 1];
+    int64_t wallSum;
+    int64_t cpuSum;
+} CommandMetrics;
+
+// Metriques globales :
+// - path : chemin du fichier des metriques (NULL si l'enregistrement n'est pas actif)
+// - commands : table (a adressage ouvert) des metriques par nom de commande
+// - commandCount : nombre d'entrees utilisees de la table
+// - other : metriques des commandes qui ne tiennent plus dans la table
+// - forkFailures, execFailures : nombre d'echecs de creation de processus et d'exec (hors echecs signales par les
+//   processus des commandes)
+// - bgStarted, bgReaped : nombre de commandes en background lancees et terminees
+// - parseBuckets, parseSum : histogramme des durees de parsing des lignes
+// - lastWrite : heure de la derniere ecriture du fichier (nanosecondes)
+// Echecs d'exec signales par les processus des commandes (page partagee, voir reportExecFailure()) :
+// - failures : nombre total d'echecs
+// - pending : echecs pas encore attribues a une commande terminee (voir recordCommand())
+typedef struct
+{
+    uint64_t failures;
+    uint64_t pending;
+} ExecReports;
+
+static struct
+{
+    char* path;
+    CommandMetrics commands[MAX_METRICS_COMMANDS];
+    int commandCount;
+    CommandMetrics other;
+    uint64_t forkFailures;
+    uint64_t execFailures;
+    uint64_t bgStarted;
+    uint64_t bgReaped;
+    uint64_t parseBuckets[PARSE_BUCKET_COUNT + 1];
+    int64_t parseSum;
+    int64_t lastWrite;
+    ExecReports* execReports;
+} metrics;
+
+/*
+ * Retourne l'heure courante de l'horloge monotone (nanosecondes)
+ */
+static int64_t getMonotonicTime( void );
+
+/*
+ * Attribue a la commande qui vient de se terminer l'un des echecs d'exec signales et pas encore attribues
+ *
+ * retourne 1 si un echec a ete attribue, sinon 0 (la commande a elle-meme choisi son code de retour)
+ */
+static int takeExecFailure( void );
+
+/*
+ * Ecrit le fichier des metriques
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int writeMetricsFile( void );
+
+/*
+ * Recherche (ou cree) les metriques d'une commande
+ *
+ * name : nom de la commande
+ * retourne les metriques de la commande
+ */
+static CommandMetrics* getCommandMetrics( const char* name );
+
+/*
+ * Ajoute une duree a un histogramme
+ *
+ * buckets : intervalles de l'histogramme (non cumules)
+ * bounds : bornes superieures des intervalles
+ * count : nombre de bornes
+ * duration : duree (nanosecondes)
+ */
+static void addToHistogram( uint64_t buckets[], const int64_t bounds[], size_t count, int64_t duration );
+
+/*
+ * Ecrit un histogramme au format Prometheus
+ *
+ * file : fichier de sortie
+ * name : nom de la metrique
+ * label : labels communs a toutes les lignes (de la forme 'nom="valeur",'), ou chaine vide
+ * buckets, bounds, count : l'histogramme
+ * sum : somme des durees (nanosecondes)
+ */
+static void writeHistogram( FILE* file, const char* name, const char* label, const uint64_t buckets[],
+                            const int64_t bounds[], size_t count, int64_t sum );
+
+/*
+ * Ecrit les metriques d'une commande
+ *
+ * file : fichier de sortie
+ * metric : metrique a ecrire (CommandMetric)
+ * cmd : metriques de la commande
+ */
+static void writeCommandMetrics( FILE* file, int metric, const CommandMetrics* cmd );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int initMetrics( const char* path )
+{
+    // Memorisation du chemin du fichier (l'enregistrement est actif)
+    free( metrics.path );
+    metrics.path = strdup( path );
+    if( metrics.path == NULL ) return( METRICS_WRITE_FAILED );
+    strcpy( metrics.other.name, OTHER_COMMANDS );
+    metrics.lastWrite = getMonotonicTime();
+
+    // Page partagee avec les processus crees ensuite, pour le signalement des echecs d'exec (sans elle, ces
+    // echecs ne sont pas comptes)
+    if( metrics.execReports == NULL )
+    {
+        void* page = mmap( NULL, sizeof( ExecReports ), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0 );
+        if( page != MAP_FAILED ) metrics.execReports = (ExecReports*)page;
+    }
+
+    return( METRICS_OK );
+}
+
+
+int64_t getMetricsTime( void )
+{
+    return( metrics.path != NULL ? getMonotonicTime() : 0 );
+}
+
+
+void recordCommand( const char* name, int64_t startTime, int status, const struct rusage* usage )
+{
+    // Enregistrement inactif
+    if( metrics.path == NULL ) return;
+
+    // Duree d'execution
+    CommandMetrics* cmd = getCommandMetrics( name );
+    const int64_t duration = getMonotonicTime() - startTime;
+    addToHistogram( cmd->wallBuckets, WALL_BUCKETS, WALL_BUCKET_COUNT, duration );
+    cmd->wallSum += duration;
+
+    // Temps CPU
+    if( usage != NULL )
+    {
+        cmd->cpuSum += (int64_t)( usage->ru_utime.tv_sec + usage->ru_stime.tv_sec ) * 1000000 +
+                       usage->ru_utime.tv_usec + usage->ru_stime.tv_usec;
+    }
+
+    // Code de retour. Un echec d'exec se termine avec le code CMD_EXEC_FAILED, mais n'est compte que s'il a ete
+    // signale par le processus de la commande (un programme peut aussi choisir ce code)
+    if( ! WIFEXITED( status ) || WEXITSTATUS( status ) != 0 ) ++cmd->exitFailures;
+    if( WIFEXITED( status ) && WEXITSTATUS( status ) == CMD_EXEC_FAILED && takeExecFailure() )
+    {
+        ++cmd->errors[CMD_EXEC_FAILED - CMD_BAD_SEP];
+    }
+}
+
+
+void recordCommandSpawn( const char* name )
+{
+    if( metrics.path != NULL ) ++getCommandMetrics( name )->spawns;
+}
+
+
+void recordCommandError( const char* name, int error )
+{
+    // Enregistrement inactif, ou code d'erreur inconnu
+    if( metrics.path == NULL || error < CMD_BAD_SEP || error > CMD_NOT_FOUND ) return;
+
+    // Erreur de la commande, et compteur global correspondant
+    ++getCommandMetrics( name )->errors[error - CMD_BAD_SEP];
+    if( error == CMD_FORK_FAILED ) ++metrics.forkFailures;
+    if( error == CMD_EXEC_FAILED ) ++metrics.execFailures;
+}
+
+
+void reportExecFailure( void )
+{
+    // Page partagee absente (enregistrement inactif)
+    if( metrics.execReports == NULL ) return;
+
+    // Compteurs mis a jour atomiquement (plusieurs processus peuvent echouer en meme temps)
+    __atomic_add_fetch( &metrics.execReports->failures, 1, __ATOMIC_RELAXED );
+    __atomic_add_fetch( &metrics.execReports->pending, 1, __ATOMIC_RELEASE );
+}
+
+
+void recordBgCmdStarted( void )
+{
+    ++metrics.bgStarted;
+}
+
+
+void recordBgCmdReaped( void )
+{
+    ++metrics.bgReaped;
+}
+
+
+void recordParse( int64_t startTime )
+{
+    // Enregistrement inactif
+    if( metrics.path == NULL ) return;
+
+    // Duree de parsing
+    const int64_t duration = getMonotonicTime() - startTime;
+    addToHistogram( metrics.parseBuckets, PARSE_BUCKETS, PARSE_BUCKET_COUNT, duration );
+    metrics.parseSum += duration;
+}
+
+
+int writeMetricsIfDue( void )
+{
+    // Enregistrement inactif
+    if( metrics.path == NULL ) return( METRICS_OK );
+
+    // Ecriture si l'intervalle est ecoule
+    if( getMonotonicTime() - metrics.lastWrite < getOption( OPTION_METRICS_INTERVAL ) * NS_PER_SECOND )
+    {
+        return( METRICS_OK );
+    }
+    return( writeMetrics() );
+}
+
+
+int writeMetrics( void )
+{
+    // Enregistrement inactif
+    if( metrics.path == NULL ) return( METRICS_OK );
+    metrics.lastWrite = getMonotonicTime();
+
+    // Les commandes en background terminees pendant l'ecriture ne sont enregistrees qu'apres (callback de
+    // SIGCHLD)
+    sigset_t mask, oldMask;
+    sigemptyset( &mask );
+    sigaddset( &mask, SIGCHLD );
+    sigprocmask( SIG_BLOCK, &mask, &oldMask );
+    const int status = writeMetricsFile();
+    sigprocmask( SIG_SETMASK, &oldMask, NULL );
+
+    return( status );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int writeMetricsFile( void )
+{
+    // Ecriture dans un fichier temporaire (le fichier final est remplace en une seule operation)
+    char tmpPath[MAX_LINE_SIZE];
+    snprintf( tmpPath, sizeof( tmpPath ), "%s.tmp", metrics.path );
+    FILE* file = fopen( tmpPath, "w" );
+    if( file == NULL ) return( METRICS_WRITE_FAILED );
+
+    // Metriques par commande, regroupees metrique par metrique sous leurs lignes HELP/TYPE
+    for( int metric = 0; metric < METRIC_LAST; ++metric )
+    {
+        fputs( COMMAND_METRIC_HEADERS[metric], file );
+        for( int i = 0; i < MAX_METRICS_COMMANDS; ++i )
+        {
+            if( metrics.commands[i].name[0] != '\0' ) writeCommandMetrics( file, metric, metrics.commands + i );
+        }
+        writeCommandMetrics( file, metric, &metrics.other );
+    }
+
+    // Compteurs globaux
+    fprintf( file, "# HELP minishell_fork_failures_total Echecs de creation du processus d'une commande.\n"
+                   "# TYPE minishell_fork_failures_total counter\n"
+                   "minishell_fork_failures_total %llu\n",
+                   (unsigned long long)metrics.forkFailures );
+    fprintf( file, "# HELP minishell_exec_failures_total Echecs d'exec d'une commande.\n"
+                   "# TYPE minishell_exec_failures_total counter\n"
+                   "minishell_exec_failures_total %llu\n",
+                   (unsigned long long)( metrics.execFailures + ( metrics.execReports != NULL ?
+                       __atomic_load_n( &metrics.execReports->failures, __ATOMIC_RELAXED ) : 0 ) ) );
+    fprintf( file, "# HELP minishell_background_jobs_started_total Commandes lancees en background.\n"
+                   "# TYPE minishell_background_jobs_started_total counter\n"
+                   "minishell_background_jobs_started_total %llu\n",
+                   (unsigned long long)metrics.bgStarted );
+    fprintf( file, "# HELP minishell_background_jobs_reaped_total Commandes en background terminees.\n"
+                   "# TYPE minishell_background_jobs_reaped_total counter\n"
+                   "minishell_background_jobs_reaped_total %llu\n",
+                   (unsigned long long)metrics.bgReaped );
+
+    // Durees de parsing
+    fprintf( file, "# HELP minishell_parse_seconds Duree de decoupage et de parsing des lignes de commande.\n"
+                   "# TYPE minishell_parse_seconds histogram\n" );
+    writeHistogram( file, "minishell_parse_seconds", "", metrics.parseBuckets, PARSE_BUCKETS,
+                    PARSE_BUCKET_COUNT, metrics.parseSum );
+
+    // Fermeture, puis remplacement du fichier final
+    const int writeError = ferror( file );
+    if( fclose( file ) != 0 || writeError || rename( tmpPath, metrics.path ) == -1 )
+    {
+        unlink( tmpPath );
+        return( METRICS_WRITE_FAILED );
+    }
+
+    return( METRICS_OK );
+}
+
+
+static int64_t getMonotonicTime( void )
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return( (int64_t)now.tv_sec * NS_PER_SECOND + now.tv_nsec );
+}
+
+
+static int takeExecFailure( void )
+{
+    // Decrementation du nombre d'echecs non attribues, s'il n'est pas nul
+    if( metrics.execReports == NULL ) return( 0 );
+    uint64_t pending = __atomic_load_n( &metrics.execReports->pending, __ATOMIC_ACQUIRE );
+    while( pending > 0 )
+    {
+        if( __atomic_compare_exchange_n( &metrics.execReports->pending, &pending, pending - 1, 0, __ATOMIC_ACQ_REL,
+                                         __ATOMIC_ACQUIRE ) )
+        {
+            return( 1 );
+        }
+    }
+
+    return( 0 );
+}
+
+
+static CommandMetrics* getCommandMetrics( const char* name )
+{
+    // Hachage du nom (FNV-1a), limite a la longueur conservee
+    uint32_t hash = 2166136261u;
+    size_t length = 0;
+    for( ; name[length] != '\0' && length < MAX_METRICS_NAME - 1; ++length )
+    {
+        hash = ( hash ^ (unsigned char)name[length] ) * 16777619u;
+    }
+
+    // Recherche de la commande, ou de la premiere entree libre (sondage lineaire)
+    for( int i = 0; i < MAX_METRICS_COMMANDS; ++i )
+    {
+        CommandMetrics* cmd = metrics.commands + ( hash + i ) % MAX_METRICS_COMMANDS;
+        if( cmd->name[0] == '\0' )
+        {
+            // Table pleine (une entree reste libre pour arreter les recherches) : commandes regroupees
+            if( metrics.commandCount == MAX_METRICS_COMMANDS - 1 ) return( &metrics.other );
+
+            // Nouvelle commande
+            memcpy( cmd->name, name, length );
+            cmd->name[length] = '\0';
+            ++metrics.commandCount;
+            return( cmd );
+        }
+        if( strncmp( cmd->name, name, length ) == 0 && cmd->name[length] == '\0' ) return( cmd );
+    }
+
+    return( &metrics.other );
+}
+
+
+static void addToHistogram( uint64_t buckets[], const int64_t bounds[], size_t count, int64_t duration )
+{
+    // Recherche du premier intervalle dont la borne superieure depasse la duree
+    size_t i = 0;
+    while( i < count && duration > bounds[i] ) ++i;
+    ++buckets[i];
+}
+
+
+static void writeHistogram( FILE* file, const char* name, const char* label, const uint64_t buckets[],
+                            const int64_t bounds[], size_t count, int64_t sum )
+{
+    // Intervalles (cumules), en secondes
+    uint64_t total = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        total += buckets[i];
+        fprintf( file, "%s_bucket{%sle=\"%g\"} %llu\n", name, label, (double)bounds[i] / NS_PER_SECOND,
+                 (unsigned long long)total );
+    }
+    total += buckets[count];
+    fprintf( file, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, label, (unsigned long long)total );
+
+    // Somme et nombre de valeurs (sans virgule finale dans les labels)
+    char plainLabel[MAX_LINE_SIZE];
+    snprintf( plainLabel, sizeof( plainLabel ), "%s", label );
+    const size_t length = strlen( plainLabel );
+    if( length > 0 ) plainLabel[length - 1] = '\0';
+    const char* open = ( length > 0 ? "{" : "" );
+    const char* close = ( length > 0 ? "}" : "" );
+    fprintf( file, "%s_sum%s%s%s %.9f\n", name, open, plainLabel, close, (double)sum / NS_PER_SECOND );
+    fprintf( file, "%s_count%s%s%s %llu\n", name, open, plainLabel, close, (unsigned long long)total );
+}
+
+
+static void writeCommandMetrics( FILE* file, int metric, const CommandMetrics* cmd )
+{
+    // Une commande sans aucune valeur n'est pas ecrite (regroupement OTHER_COMMANDS inutilise)
+    uint64_t values = cmd->spawns + cmd->exitFailures;
+    for( int i = 0; i < CMD_ERROR_COUNT; ++i ) values += cmd->errors[i];
+    for( size_t i = 0; i <= WALL_BUCKET_COUNT; ++i ) values += cmd->wallBuckets[i];
+    if( values == 0 ) return;
+
+    // Label de la commande (les caracteres '\\', '"' et '\n' du nom doivent etre echappes)
+    char label[4 * MAX_METRICS_NAME];
+    size_t length = snprintf( label, sizeof( label ), "command=\"" );
+    for( const char* c = cmd->name; *c != '\0'; ++c )
+    {
+        if( *c == '\\' || *c == '"' || *c == '\n' ) label[length++] = '\\';
+        label[length++] = ( *c == '\n' ? 'n' : *c );
+    }
+    strcpy( label + length, "\"," );
+
+    // Suivant la metrique
+    switch( metric )
+    {
+        // Lancements
+        case METRIC_SPAWNS:
+            fprintf( file, "minishell_command_spawns_total{%.*s} %llu\n", (int)length + 1, label,
+                     (unsigned long long)cmd->spawns );
+            break;
+
+        // Erreurs, par code (seuls les codes rencontres sont ecrits)
+        case METRIC_ERRORS:
+            for( int i = 0; i < CMD_ERROR_COUNT; ++i )
+            {
+                if( cmd->errors[i] == 0 ) continue;
+                fprintf( file, "minishell_command_errors_total{%scode=\"%d\"} %llu\n", label, CMD_BAD_SEP + i,
+                         (unsigned long long)cmd->errors[i] );
+            }
+            break;
+
+        // Terminaisons en echec
+        case METRIC_EXIT_FAILURES:
+            fprintf( file, "minishell_command_exit_failures_total{%.*s} %llu\n", (int)length + 1, label,
+                     (unsigned long long)cmd->exitFailures );
+            break;
+
+        // Temps CPU
+        case METRIC_CPU:
+            fprintf( file, "minishell_command_cpu_seconds_total{%.*s} %.6f\n", (int)length + 1, label,
+                     (double)cmd->cpuSum / 1000000 );
+            break;
+
+        // Durees d'execution
+        default:
+            writeHistogram( file, "minishell_command_wall_seconds", label, cmd->wallBuckets, WALL_BUCKETS,
+                            WALL_BUCKET_COUNT, cmd->wallSum );
+            break;
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Metriques d'execution du minishell, exportees au format texte de Prometheus (fichier lu par le
+ *  "textfile collector" de node_exporter).
+ *
+ *  Les compteurs sont tenus en memoire, par nom de commande :
+ *  - nombre de lancements, erreurs par code CmdError, codes de retour non nuls
+ *  - histogramme des durees d'execution (temps ecoule), et temps CPU consomme
+ *  Ainsi que des compteurs globaux : echecs de fork et d'exec, commandes en background lancees et terminees,
+ *  et histogramme des durees de parsing des lignes de commande.
+ *
+ *  L'enregistrement est desactive tant que initMetrics() n'a pas ete appelee (option --metrics du minishell) :
+ *  il ne coute alors qu'un test. Active, il se limite a une lecture de l'horloge et a la mise a jour de
+ *  quelques compteurs (aucune allocation, aucune ecriture). Le fichier est reecrit periodiquement (option
+ *  "metrics-interval", en secondes) entre deux lignes de commande, et a la sortie du minishell. Il est ecrit
+ *  dans un fichier temporaire puis renomme, afin de ne jamais etre lu partiellement.
+ *
+ *  Le temps CPU n'est pas connu pour les commandes lancees par le zygote (qui se synchronise avec leur
+ *  terminaison), ni pour les builtins executees dans le processus du minishell.
+ *
+ *  Les echecs d'exec sont signales explicitement par le processus de la commande (reportExecFailure()), dans
+ *  une page partagee avec le minishell (et le zygote) : un programme qui se termine avec le code CMD_EXEC_FAILED
+ *  n'est pas compte comme un echec d'exec.
+ */
+
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdint.h>
+#include <sys/resource.h>
+
+
+// Codes d'erreur
+enum MetricsError
+{
+    METRICS_OK = 0,             // Pas d'erreur
+    METRICS_WRITE_FAILED = 130  // Echec d'ecriture du fichier des metriques
+};
+
+
+/*
+ * Active l'enregistrement des metriques
+ *
+ * path : chemin du fichier des metriques (typiquement "<repertoire du textfile collector>/minishell.prom")
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int initMetrics( const char* path );
+
+/*
+ * Retourne l'heure courante (horloge monotone, en nanosecondes) pour mesurer une duree, ou 0 si
+ * l'enregistrement des metriques n'est pas actif
+ */
+int64_t getMetricsTime( void );
+
+/*
+ * Enregistre la terminaison d'une commande
+ *
+ * name : nom de la commande
+ * startTime : heure de lancement de la commande (voir getMetricsTime())
+ * status : code de terminaison du processus de la commande (au format de waitpid())
+ * usage : ressources consommees par le processus de la commande, ou NULL si inconnues
+ */
+void recordCommand( const char* name, int64_t startTime, int status, const struct rusage* usage );
+
+/*
+ * Enregistre le lancement d'une commande
+ *
+ * name : nom de la commande
+ */
+void recordCommandSpawn( const char* name );
+
+/*
+ * Enregistre une erreur de lancement d'une commande
+ *
+ * name : nom de la commande
+ * error : code d'erreur (CmdError)
+ */
+void recordCommandError( const char* name, int error );
+
+/*
+ * Signale l'echec de l'exec d'une commande, depuis le processus cree pour elle (juste avant qu'il se termine avec
+ * le code CMD_EXEC_FAILED). Utilisable entre fork() et exec (pas d'allocation, pas de verrou).
+ */
+void reportExecFailure( void );
+
+/*
+ * Enregistre le lancement d'une commande en background
+ */
+void recordBgCmdStarted( void );
+
+/*
+ * Enregistre la terminaison d'une commande en background
+ */
+void recordBgCmdReaped( void );
+
+/*
+ * Enregistre la duree de parsing d'une ligne de commande
+ *
+ * startTime : heure de debut du parsing (voir getMetricsTime())
+ */
+void recordParse( int64_t startTime );
+
+/*
+ * Reecrit le fichier des metriques si l'intervalle d'ecriture (option "metrics-interval") est ecoule depuis
+ * la derniere ecriture
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int writeMetricsIfDue( void );
+
+/*
+ * Reecrit le fichier des metriques (si l'enregistrement est actif)
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int writeMetrics( void );
+
+
+#endif // _METRICS_H_
@@ -0,0 +1,104 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances :
+ *
+ *  Options du minishell (implementation)
+ */
+
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Structure de donnees associee a une option :
+// - name : nom de l'option
+// - value : valeur courante (initialisee avec la valeur par defaut)
+// - min : valeur minimale acceptee
+typedef struct
+{
+    const char* name;
+    long value;
+    long min;
+} Option;
+
+// Liste des options, dans l'ordre de l'enum ShellOption
+static Option ALL_OPTIONS[OPTION_LAST] =
+{
+    { "bgcapture", 0, 0 },
+    { "bgcapture-size", 65536, 1 },
+    { "argbatch", 0, 0 },
+    { "argbatch-jobs", 1, 1 },
+    { "metrics-interval", 15, 1 },
+    { "optimize", 1, 0 },
+    { "threadstages", 1, 0 },
+    { "stubexec", 0, 0 },
+    { "cmd-timeout", 0, 0 },
+    { "cmd-timeout-kill", 5, 0 },
+    { "bgjobs", 0, 0 },
+    { "bgjobs-maxload", 0, 0 },
+    { "bgjobs-maxpressure", 0, 0 },
+    { "memo-size", 67108864, 1 }
+};
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+long getOption( int option )
+{
+    return( ALL_OPTIONS[option].value );
+}
+
+
+int setOption( const char* spec, int enable )
+{
+    // Separation du nom et de l'eventuelle valeur
+    const char* value = strchr( spec, '=' );
+    const size_t nameLength = ( value != NULL ? (size_t)( value - spec ) : strlen( spec ) );
+
+    // Recherche de l'option
+    for( int i = 0; i < OPTION_LAST; ++i )
+    {
+        Option* option = ALL_OPTIONS + i;
+        if( strlen( option->name ) != nameLength || strncmp( option->name, spec, nameLength ) != 0 ) continue;
+
+        // Desactivation de l'option
+        if( ! enable )
+        {
+            if( value != NULL || option->min > 0 ) return( OPTION_BAD_VALUE );
+            option->value = 0;
+            return( OPTION_OK );
+        }
+
+        // Activation de l'option, ou modification de sa valeur
+        long newValue = 1;
+        if( value != NULL )
+        {
+            char* end = NULL;
+            newValue = strtol( value + 1, &end, 10 );
+            if( value[1] == '\0' || *end != '\0' ) return( OPTION_BAD_VALUE );
+        }
+        if( newValue < option->min ) return( OPTION_BAD_VALUE );
+        option->value = newValue;
+        return( OPTION_OK );
+    }
+
+    // Option non trouvee
+    return( OPTION_UNKNOWN );
+}
+
+
+void printOptions( void )
+{
+    for( int i = 0; i < OPTION_LAST; ++i ) printf( "%s=%ld\n", ALL_OPTIONS[i].name, ALL_OPTIONS[i].value );
+}
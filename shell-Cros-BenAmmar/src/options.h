@@ -0,0 +1,69 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Options du minishell, modifiables au lancement (-o NOM[=VALEUR]) ou via la builtin 'set'.
+ */
+
+#ifndef _OPTIONS_H_
+#define _OPTIONS_H_
+
+
+// Code d'erreur
+enum OptionError
+{
+    OPTION_OK = 0,              // Pas d'erreur
+    OPTION_UNKNOWN = 90,        // Option inconnue
+    OPTION_BAD_VALUE            // Valeur incorrecte
+};
+
+// Options disponibles
+enum ShellOption
+{
+    OPTION_BG_CAPTURE = 0,      // Capture des sorties des commandes en background ("bgcapture")
+    OPTION_BG_CAPTURE_SIZE,     // Taille du buffer de capture de chaque commande, en octets ("bgcapture-size")
+    OPTION_ARG_BATCH,           // Decoupage des listes d'arguments trop longues pour exec ("argbatch")
+    OPTION_ARG_BATCH_JOBS,      // Nombre max d'invocations simultanees d'une commande decoupee ("argbatch-jobs")
+    OPTION_METRICS_INTERVAL,    // Intervalle d'ecriture du fichier des metriques, en secondes ("metrics-interval")
+    OPTION_OPTIMIZE,            // Optimisation du plan d'execution des lignes de commande ("optimize")
+    OPTION_THREAD_STAGES,       // Etapes simples des pipelines executees dans des threads ("threadstages")
+    OPTION_STUB_EXEC,           // Commandes externes remplacees par un processus qui se termine aussitot ("stubexec")
+    OPTION_CMD_TIMEOUT,         // Delai par defaut des commandes au premier plan, en secondes ("cmd-timeout")
+    OPTION_CMD_TIMEOUT_KILL,    // Delai avant SIGKILL apres expiration du delai, en secondes ("cmd-timeout-kill")
+    OPTION_BG_JOBS,             // Nombre max de commandes en background en cours (0 : nombre de coeurs) ("bgjobs")
+    OPTION_BG_JOBS_MAX_LOAD,    // Charge moyenne max pour lancer une commande en background ("bgjobs-maxload")
+    OPTION_BG_JOBS_MAX_PRESSURE,// Pression CPU max (%) pour lancer une commande en background ("bgjobs-maxpressure")
+    OPTION_MEMO_SIZE,           // Taille max du cache de la builtin 'memo', en octets ("memo-size")
+    OPTION_LAST                 // Marque la derniere option disponible
+};
+
+
+/*
+ * Retourne la valeur d'une option
+ *
+ * option : l'option (ShellOption)
+ * retourne la valeur de l'option
+ */
+long getOption( int option );
+
+/*
+ * Modifie une option a partir d'une specification de la forme "NOM" (valeur 1) ou "NOM=VALEUR"
+ *
+ * spec : specification de l'option
+ * enable : si faux, l'option est desactivee (valeur 0) et la specification ne doit pas contenir de valeur
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int setOption( const char* spec, int enable );
+
+/*
+ * Affiche toutes les options et leurs valeurs (au format accepte par 'set -o')
+ */
+void printOptions( void );
+
+
+#endif // _OPTIONS_H_
@@ -0,0 +1,735 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : parser.h arith.h func.h cmd.h ringbuf.h memstat.h
+ *
+ *  Expansion des parametres d'un mot de la ligne de commande (implementation)
+ */
+
+#include "param.h"
+#include "parser.h"
+#include "arith.h"
+#include "func.h"
+#include "memstat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Nombre d'entrees du cache des motifs compiles
+#define PATTERN_CACHE_SIZE  32
+
+// Types d'elements d'un motif compile
+enum PatternItemType
+{
+    PATTERN_CHAR = 0,       // Caractere litteral
+    PATTERN_ANY,            // Caractere quelconque ('?')
+    PATTERN_STAR,           // Suite quelconque de caracteres ('*')
+    PATTERN_CLASS           // Ensemble de caracteres ('[...]')
+};
+
+// Element d'un motif compile :
+// - type : type de l'element
+// - c : caractere (PATTERN_CHAR)
+// - set : ensemble des caracteres acceptes, un bit par caractere (PATTERN_CLASS)
+typedef struct
+{
+    int type;
+    unsigned char c;
+    uint32_t set[8];
+} PatternItem;
+
+// Motif compile (entree du cache) :
+// - text : texte du motif (NULL pour une entree libre)
+// - items : elements du motif
+// - count : nombre d'elements
+// - literal : vrai si le motif ne contient que des caracteres litteraux (compare directement)
+typedef struct
+{
+    char* text;
+    PatternItem* items;
+    int count;
+    int literal;
+} Pattern;
+
+// Cache des motifs compiles (propre a chaque thread, comme l'analyse des lignes de commande)
+static _Thread_local Pattern patternCache[PATTERN_CACHE_SIZE];
+
+// Operations d'une expansion "${...}"
+enum ParamOpType
+{
+    OP_VALUE = 0,           // "${NOM}"
+    OP_DEFAULT,             // "${NOM:-MOT}"
+    OP_ASSIGN,              // "${NOM:=MOT}"
+    OP_ALTERNATE,           // "${NOM:+MOT}"
+    OP_ERROR,               // "${NOM:?MOT}"
+    OP_REMOVE_PREFIX,       // "${NOM#MOTIF}"
+    OP_REMOVE_SUFFIX,       // "${NOM%MOTIF}"
+    OP_REPLACE,             // "${NOM/MOTIF/TEXTE}"
+    OP_SUBSTRING            // "${NOM:POSITION:LONGUEUR}"
+};
+
+// Chaine en cours de construction (au plus MAX_LINE_SIZE - 1 caracteres, le reste est ignore) :
+// - str : la chaine
+// - length : longueur de la chaine
+typedef struct
+{
+    char str[MAX_LINE_SIZE];
+    size_t length;
+} Output;
+
+/*
+ * Expanse un texte, et ajoute le resultat a une chaine
+ *
+ * text : le texte
+ * output : la chaine mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int expandText( const char* text, Output* output );
+
+/*
+ * Evalue une expansion "${...}", et ajoute sa valeur a une chaine
+ *
+ * expr : contenu de l'expansion (sans "${" ni "}")
+ * output : la chaine mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int expandBraced( const char* expr, Output* output );
+
+/*
+ * Lit le nom d'une variable : nom de variable, parametre positionnel (chiffres), ou parametre special ('#', '@',
+ * '*')
+ *
+ * str : position du nom
+ * name : en sortie, le nom (au plus MAX_LINE_SIZE caracteres)
+ * retourne la position qui suit le nom (egale a 'str' si le nom est vide)
+ */
+static const char* readName( const char* str, char* name );
+
+/*
+ * Ajoute une sous-chaine de la valeur d'une variable a une chaine ("${NOM:POSITION:LONGUEUR}")
+ *
+ * value : la valeur
+ * spec : position et longueur eventuelle (expressions arithmetiques separees par ':')
+ * output : la chaine mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int appendSubstring( const char* value, const char* spec, Output* output );
+
+/*
+ * Ajoute la valeur d'une variable privee de son prefixe ou suffixe correspondant a un motif
+ *
+ * value : la valeur
+ * pattern : le motif compile
+ * suffix : vrai pour supprimer un suffixe, faux pour un prefixe
+ * longest : vrai pour supprimer la plus longue correspondance, faux pour la plus courte
+ * output : la chaine mise a jour
+ */
+static void appendRemoved( const char* value, const Pattern* pattern, int suffix, int longest, Output* output );
+
+/*
+ * Ajoute la valeur d'une variable dont les correspondances d'un motif sont remplacees
+ *
+ * value : la valeur
+ * spec : specification du remplacement ("MOTIF/TEXTE", "/MOTIF/TEXTE", "#MOTIF/TEXTE" ou "%MOTIF/TEXTE")
+ * output : la chaine mise a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int appendReplaced( const char* value, const char* spec, Output* output );
+
+/*
+ * Retourne le motif compile correspondant a un texte, compile si besoin (sinon recupere dans le cache)
+ *
+ * text : le texte du motif
+ * retourne le motif compile (valable jusqu'au prochain appel), ou NULL en cas d'echec d'allocation
+ */
+static const Pattern* getPattern( const char* text );
+
+/*
+ * Compile un motif
+ *
+ * text : le texte du motif
+ * pattern : en sortie, le motif compile (ses elements sont alloues via memAlloc())
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int compilePattern( const char* text, Pattern* pattern );
+
+/*
+ * Teste si une chaine (de longueur donnee) correspond entierement a un motif compile
+ *
+ * pattern : le motif compile
+ * str : la chaine (pas forcement terminee par '\0')
+ * length : longueur de la chaine
+ * retourne 1 si la chaine correspond, sinon 0
+ */
+static int matchPattern( const Pattern* pattern, const char* str, size_t length );
+
+/*
+ * Ajoute des caracteres a une chaine (dans la limite de sa taille)
+ *
+ * output : la chaine mise a jour
+ * chars : les caracteres
+ * count : nombre de caracteres
+ */
+static void appendChars( Output* output, const char* chars, size_t count );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int expandParams( char* str )
+{
+    // Expansion dans une chaine intermediaire (la chaine initiale va accueillir le resultat)
+    Output output;
+    output.length = 0;
+    output.str[0] = '\0';
+    const int status = expandText( str, &output );
+    if( status != PARAM_OK ) return( status );
+
+    memcpy( str, output.str, output.length + 1 );
+    return( PARAM_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int expandText( const char* text, Output* output )
+{
+    // Tant qu'il reste une expansion
+    const char* dollar = NULL;
+    while( ( dollar = strchr( text, '$' ) ) != NULL )
+    {
+        // On recopie les caracteres jusqu'a l'expansion
+        appendChars( output, text, dollar - text );
+
+        // Expansion "${...}"
+        if( dollar[1] == '{' )
+        {
+            const int length = getParamLength( dollar );
+            if( length == 0 ) return( PARAM_BAD_SYNTAX );
+            char expr[MAX_LINE_SIZE];
+            snprintf( expr, MAX_LINE_SIZE, "%.*s", length - 3, dollar + 2 );
+            const int status = expandBraced( expr, output );
+            if( status != PARAM_OK ) return( status );
+            text = dollar + length;
+            continue;
+        }
+
+        // Expansion arithmetique "$((...))"
+        const int arithLength = ( dollar[1] == '(' && dollar[2] == '(' ? getArithLength( dollar + 1 ) : 0 );
+        if( arithLength > 0 )
+        {
+            char expr[MAX_LINE_SIZE];
+            snprintf( expr, MAX_LINE_SIZE, "%.*s", arithLength - 4, dollar + 3 );
+            int64_t value = 0;
+            const int status = evalArith( expr, &value );
+            if( status != ARITH_OK ) return( status );
+            char number[32];
+            appendChars( output, number, snprintf( number, sizeof( number ), "%" PRId64, value ) );
+            text = dollar + 1 + arithLength;
+            continue;
+        }
+
+        // Variable "$NOM" : le nom s'etend jusqu'au prochain espace (voir substEnv()), ou jusqu'a l'expansion
+        // "${...}" ou "$((...))" suivante
+        size_t length = 1;
+        while( dollar[length] != '\0' && dollar[length] != ' ' &&
+               ! ( dollar[length] == '$' && ( dollar[length + 1] == '{' || dollar[length + 1] == '(' ) ) )
+        {
+            ++length;
+        }
+        char var[MAX_LINE_SIZE];
+        snprintf( var, MAX_LINE_SIZE, "%.*s", (int)length, dollar );
+        const int status = substEnv( var, getVar );
+        if( status != PARSER_OK ) return( status );
+        appendChars( output, var, strlen( var ) );
+        text = dollar + length;
+    }
+
+    // On recopie la fin du texte
+    appendChars( output, text, strlen( text ) );
+
+    return( PARAM_OK );
+}
+
+
+static int expandBraced( const char* expr, Output* output )
+{
+    // Longueur de la valeur : "${#NOM}" (mais "${#}" est le nombre de parametres)
+    char name[MAX_LINE_SIZE];
+    const int lengthOp = ( expr[0] == '#' && expr[1] != '\0' );
+    const char* rest = readName( expr + lengthOp, name );
+    if( rest == expr + lengthOp ) return( PARAM_BAD_SYNTAX );
+
+    // Valeur de la variable (recopiee : les expansions des mots peuvent modifier la valeur retournee par getVar())
+    const char* var = getVar( name );
+    const int isSet = ( var != NULL );
+    char value[MAX_LINE_SIZE];
+    snprintf( value, MAX_LINE_SIZE, "%s", isSet ? var : "" );
+
+    // Longueur
+    if( lengthOp )
+    {
+        if( *rest != '\0' ) return( PARAM_BAD_SYNTAX );
+        char number[32];
+        appendChars( output, number, snprintf( number, sizeof( number ), "%zu", strlen( value ) ) );
+        return( PARAM_OK );
+    }
+
+    // Operation : avec ':', une valeur vide est traitee comme une variable inexistante
+    int op = OP_VALUE;
+    int longest = 0;
+    const int colon = ( *rest == ':' );
+    const char* word = rest + colon;
+    switch( *word )
+    {
+        case '\0':
+            if( colon ) return( PARAM_BAD_SYNTAX );
+            break;
+
+        case '-': op = OP_DEFAULT; ++word; break;
+        case '=': op = OP_ASSIGN; ++word; break;
+        case '+': op = OP_ALTERNATE; ++word; break;
+        case '?': op = OP_ERROR; ++word; break;
+
+        // Suppression d'un prefixe ou d'un suffixe ('##' et '%%' pour la plus longue correspondance)
+        case '#':
+        case '%':
+            if( colon ) op = OP_SUBSTRING;
+            else
+            {
+                op = ( *word == '#' ? OP_REMOVE_PREFIX : OP_REMOVE_SUFFIX );
+                longest = ( word[1] == word[0] );
+                word += 1 + longest;
+            }
+            break;
+
+        case '/':
+            if( colon ) op = OP_SUBSTRING;
+            else
+            {
+                op = OP_REPLACE;
+                ++word;
+            }
+            break;
+
+        default:
+            if( ! colon ) return( PARAM_BAD_SYNTAX );
+            op = OP_SUBSTRING;
+            break;
+    }
+
+    // Variable consideree comme absente par les operations de valeur par defaut/alternative
+    const int missing = ( ! isSet || ( colon && value[0] == '\0' ) );
+
+    switch( op )
+    {
+        case OP_VALUE:
+            appendChars( output, value, strlen( value ) );
+            return( PARAM_OK );
+
+        case OP_DEFAULT:
+            if( missing ) return( expandText( word, output ) );
+            appendChars( output, value, strlen( value ) );
+            return( PARAM_OK );
+
+        case OP_ALTERNATE:
+            return( missing ? PARAM_OK : expandText( word, output ) );
+
+        case OP_ASSIGN:
+        case OP_ERROR:
+        {
+            // Variable presente : sa valeur
+            if( ! missing )
+            {
+                appendChars( output, value, strlen( value ) );
+                return( PARAM_OK );
+            }
+
+            // Sinon, le mot est expanse
+            Output expanded;
+            expanded.length = 0;
+            expanded.str[0] = '\0';
+            const int status = expandText( word, &expanded );
+            if( status != PARAM_OK ) return( status );
+
+            // Erreur, avec le message donne par le mot
+            if( op == OP_ERROR )
+            {
+                fprintf( stderr, "ERREUR - %s : %s\n", name,
+                         expanded.length > 0 ? expanded.str : "variable vide ou inexistante" );
+                return( PARAM_UNSET );
+            }
+
+            // Affectation (seules les variables nommees peuvent l'etre)
+            if( setVar( name, expanded.str ) != FUNC_OK ) return( PARAM_BAD_SYNTAX );
+            appendChars( output, expanded.str, expanded.length );
+            return( PARAM_OK );
+        }
+
+        case OP_SUBSTRING:
+            return( appendSubstring( value, word, output ) );
+
+        case OP_REPLACE:
+            return( appendReplaced( value, word, output ) );
+
+        default:
+        {
+            // Motif expanse, puis compile (ou recupere dans le cache)
+            Output text;
+            text.length = 0;
+            text.str[0] = '\0';
+            const int status = expandText( word, &text );
+            if( status != PARAM_OK ) return( status );
+            const Pattern* pattern = getPattern( text.str );
+            if( pattern == NULL ) return( PARAM_NO_MEMORY );
+
+            appendRemoved( value, pattern, op == OP_REMOVE_SUFFIX, longest, output );
+            return( PARAM_OK );
+        }
+    }
+}
+
+
+static const char* readName( const char* str, char* name )
+{
+    // Nom de variable, ou parametre positionnel
+    size_t length = 0;
+    if( isalpha( (unsigned char)*str ) || *str == '_' )
+    {
+        while( isalnum( (unsigned char)str[length] ) || str[length] == '_' ) ++length;
+    }
+    else if( isdigit( (unsigned char)*str ) )
+    {
+        while( isdigit( (unsigned char)str[length] ) ) ++length;
+    }
+
+    // Parametre special
+    else if( *str == '#' || *str == '@' || *str == '*' )
+    {
+        length = 1;
+    }
+
+    memcpy( name, str, length );
+    name[length] = '\0';
+    return( str + length );
+}
+
+
+static int appendSubstring( const char* value, const char* spec, Output* output )
+{
+    // Position et longueur : expressions arithmetiques separees par le premier ':' hors parentheses
+    char position[MAX_LINE_SIZE];
+    snprintf( position, MAX_LINE_SIZE, "%s", spec );
+    char* lengthSpec = NULL;
+    int depth = 0;
+    for( char* c = position; *c != '\0' && lengthSpec == NULL; ++c )
+    {
+        if( *c == '(' ) ++depth;
+        else if( *c == ')' ) --depth;
+        else if( *c == ':' && depth == 0 )
+        {
+            *c = '\0';
+            lengthSpec = c + 1;
+        }
+    }
+
+    // Evaluation des expressions (apres expansion de leurs parametres)
+    int64_t offset = 0;
+    int64_t count = 0;
+    const char* specs[2] = { position, lengthSpec };
+    int64_t* values[2] = { &offset, &count };
+    for( int i = 0; i < 2 && specs[i] != NULL; ++i )
+    {
+        Output expanded;
+        expanded.length = 0;
+        expanded.str[0] = '\0';
+        int status = expandText( specs[i], &expanded );
+        if( status == PARAM_OK ) status = evalArith( expanded.str, values[i] );
+        if( status != PARAM_OK ) return( status );
+    }
+
+    // Une position negative part de la fin de la valeur
+    const int64_t length = strlen( value );
+    if( offset < 0 ) offset += length;
+    if( offset < 0 || offset > length ) return( PARAM_OK );
+
+    // Sans longueur, jusqu'a la fin ; une longueur negative donne la fin par rapport a la fin de la valeur
+    int64_t end = length;
+    if( lengthSpec != NULL && count < 0 ) end = length + count;
+    else if( lengthSpec != NULL && count < length - offset ) end = offset + count;
+    if( end < offset ) return( lengthSpec != NULL && count < 0 ? PARAM_BAD_SYNTAX : PARAM_OK );
+
+    appendChars( output, value + offset, end - offset );
+    return( PARAM_OK );
+}
+
+
+static void appendRemoved( const char* value, const Pattern* pattern, int suffix, int longest, Output* output )
+{
+    const size_t length = strlen( value );
+
+    // Motif litteral : une seule comparaison
+    if( pattern->literal )
+    {
+        const size_t patternLength = pattern->count;
+        if( patternLength <= length && ! suffix && memcmp( value, pattern->text, patternLength ) == 0 )
+        {
+            value += patternLength;
+        }
+        else if( patternLength <= length && suffix &&
+                 memcmp( value + length - patternLength, pattern->text, patternLength ) == 0 )
+        {
+            appendChars( output, value, length - patternLength );
+            return;
+        }
+        appendChars( output, value, strlen( value ) );
+        return;
+    }
+
+    // Longueur du prefixe (ou du suffixe) supprime : la plus courte ou la plus longue qui correspond
+    for( size_t i = 0; i <= length; ++i )
+    {
+        const size_t removed = ( longest ? length - i : i );
+        const int match = ( suffix ? matchPattern( pattern, value + length - removed, removed )
+                                   : matchPattern( pattern, value, removed ) );
+        if( match )
+        {
+            if( suffix ) appendChars( output, value, length - removed );
+            else appendChars( output, value + removed, length - removed );
+            return;
+        }
+    }
+
+    // Aucune correspondance : la valeur est conservee
+    appendChars( output, value, length );
+}
+
+
+static int appendReplaced( const char* value, const char* spec, Output* output )
+{
+    // Type de remplacement : toutes les correspondances, en debut ou en fin de valeur, ou la premiere
+    const int all = ( *spec == '/' );
+    const int atStart = ( *spec == '#' );
+    const int atEnd = ( *spec == '%' );
+    if( all || atStart || atEnd ) ++spec;
+
+    // Motif et texte de remplacement (separes par le premier '/'), expanses
+    char patternSpec[MAX_LINE_SIZE];
+    snprintf( patternSpec, MAX_LINE_SIZE, "%s", spec );
+    char* slash = strchr( patternSpec, '/' );
+    if( slash != NULL ) *slash = '\0';
+    Output text;
+    text.length = 0;
+    text.str[0] = '\0';
+    Output replacement;
+    replacement.length = 0;
+    replacement.str[0] = '\0';
+    int status = expandText( patternSpec, &text );
+    if( status == PARAM_OK && slash != NULL ) status = expandText( slash + 1, &replacement );
+    if( status != PARAM_OK ) return( status );
+
+    // Un motif vide ne correspond qu'en debut ou en fin de valeur
+    const size_t length = strlen( value );
+    if( text.length == 0 && ! atStart && ! atEnd )
+    {
+        appendChars( output, value, length );
+        return( PARAM_OK );
+    }
+    const Pattern* pattern = getPattern( text.str );
+    if( pattern == NULL ) return( PARAM_NO_MEMORY );
+
+    // Pour chaque position de la valeur
+    size_t i = 0;
+    int replaced = 0;
+    while( i <= length )
+    {
+        // Plus longue correspondance a cette position (qui doit atteindre la fin de la valeur pour "/%")
+        long matched = -1;
+        if( ! ( atStart && i > 0 ) && ! ( replaced && ! all ) )
+        {
+            for( long n = length - i; n >= 0 && matched == -1; --n )
+            {
+                if( atEnd && i + n != length ) continue;
+                if( n == 0 && ! atStart && ! atEnd ) break;
+                if( matchPattern( pattern, value + i, n ) ) matched = n;
+            }
+        }
+
+        // Remplacement de la correspondance
+        if( matched >= 0 )
+        {
+            appendChars( output, replacement.str, replacement.length );
+            i += matched;
+            replaced = 1;
+            if( matched > 0 ) continue;
+        }
+
+        // Sinon, le caractere est conserve
+        if( i < length ) appendChars( output, value + i, 1 );
+        ++i;
+    }
+
+    return( PARAM_OK );
+}
+
+
+static const Pattern* getPattern( const char* text )
+{
+    // Entree du cache du motif (hachage FNV-1a)
+    uint32_t hash = 2166136261u;
+    for( const char* c = text; *c != '\0'; ++c )
+    {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+    Pattern* entry = patternCache + hash % PATTERN_CACHE_SIZE;
+
+    // Motif deja compile
+    if( entry->text != NULL && strcmp( entry->text, text ) == 0 ) return( entry );
+
+    // Sinon, il remplace le motif de l'entree
+    memFree( entry->text );
+    memFree( entry->items );
+    entry->text = NULL;
+    entry->items = NULL;
+    if( compilePattern( text, entry ) != PARAM_OK ) return( NULL );
+
+    return( entry );
+}
+
+
+static int compilePattern( const char* text, Pattern* pattern )
+{
+    // Un element au plus par caractere du motif
+    pattern->text = memStrdup( MEM_PARSER, text );
+    pattern->items = (PatternItem*)memAlloc( MEM_PARSER, ( strlen( text ) + 1 ) * sizeof( PatternItem ) );
+    if( pattern->text == NULL || pattern->items == NULL )
+    {
+        memFree( pattern->text );
+        memFree( pattern->items );
+        pattern->text = NULL;
+        pattern->items = NULL;
+        return( PARAM_NO_MEMORY );
+    }
+    pattern->count = 0;
+    pattern->literal = 1;
+
+    // Pour chaque caractere du motif
+    const char* p = text;
+    while( *p != '\0' )
+    {
+        PatternItem* item = pattern->items + pattern->count++;
+        memset( item, 0, sizeof( PatternItem ) );
+
+        // Suite quelconque de caracteres (plusieurs '*' consecutifs equivalent a un seul)
+        if( *p == '*' )
+        {
+            item->type = PATTERN_STAR;
+            while( *p == '*' ) ++p;
+        }
+
+        // Caractere quelconque
+        else if( *p == '?' )
+        {
+            item->type = PATTERN_ANY;
+            ++p;
+        }
+
+        // Ensemble de caracteres, s'il est bien termine par ']' (un ']' en premiere position est litteral)
+        else if( *p == '[' && strchr( p + ( p[1] == '!' || p[1] == '^' ? 3 : 2 ), ']' ) != NULL )
+        {
+            item->type = PATTERN_CLASS;
+            const int negate = ( p[1] == '!' || p[1] == '^' );
+            const unsigned char* c = (const unsigned char*)p + 1 + negate;
+            int first = 1;
+            while( first || *c != ']' )
+            {
+                // Intervalle de caracteres ("a-z"), ou caractere isole
+                unsigned int low = *c;
+                unsigned int high = *c;
+                if( c[1] == '-' && c[2] != ']' && c[2] != '\0' )
+                {
+                    high = c[2];
+                    c += 2;
+                }
+                for( unsigned int x = low; x <= high; ++x ) item->set[x / 32] |= ( 1u << ( x % 32 ) );
+                ++c;
+                first = 0;
+            }
+            if( negate ) for( int i = 0; i < 8; ++i ) item->set[i] = ~item->set[i];
+            p = (const char*)c + 1;
+        }
+
+        // Caractere litteral
+        else
+        {
+            item->type = PATTERN_CHAR;
+            item->c = (unsigned char)*p++;
+        }
+
+        if( item->type != PATTERN_CHAR ) pattern->literal = 0;
+    }
+
+    return( PARAM_OK );
+}
+
+
+static int matchPattern( const Pattern* pattern, const char* str, size_t length )
+{
+    // Comparaison element par element. En cas d'echec apres un '*', on reprend juste apres ce '*' en lui
+    // faisant absorber un caractere de plus (seul le dernier '*' rencontre doit etre remis en cause).
+    const PatternItem* items = pattern->items;
+    const unsigned char* s = (const unsigned char*)str;
+    const unsigned char* end = s + length;
+    int i = 0;
+    int starItem = -1;
+    const unsigned char* starPos = NULL;
+    while( s < end )
+    {
+        if( i < pattern->count )
+        {
+            const PatternItem* item = items + i;
+            if( item->type == PATTERN_STAR )
+            {
+                starItem = ++i;
+                starPos = s;
+                continue;
+            }
+            if( ( item->type == PATTERN_CHAR && item->c == *s ) || item->type == PATTERN_ANY ||
+                ( item->type == PATTERN_CLASS && ( item->set[*s / 32] & ( 1u << ( *s % 32 ) ) ) ) )
+            {
+                ++i;
+                ++s;
+                continue;
+            }
+        }
+        if( starItem == -1 ) return( 0 );
+        i = starItem;
+        s = ++starPos;
+    }
+
+    // La chaine est epuisee : seuls des '*' peuvent rester dans le motif
+    while( i < pattern->count && items[i].type == PATTERN_STAR ) ++i;
+    return( i == pattern->count );
+}
+
+
+static void appendChars( Output* output, const char* chars, size_t count )
+{
+    // Recopie dans la limite de la taille de la chaine
+    if( output->length + count >= MAX_LINE_SIZE ) count = MAX_LINE_SIZE - 1 - output->length;
+    memcpy( output->str + output->length, chars, count );
+    output->length += count;
+    output->str[output->length] = '\0';
+}
@@ -0,0 +1,58 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Expansion des parametres d'un mot de la ligne de commande, evaluee dans le minishell (sans lancer 'sed',
+ *  'cut' ou 'basename') :
+ *  - "$NOM" : valeur de la variable (le nom s'etend jusqu'au prochain espace, voir substEnv())
+ *  - "$((EXPR))" : valeur d'une expression arithmetique (voir arith.h)
+ *  - "${NOM}" : valeur de la variable (le nom est delimite par les accolades)
+ *  - "${#NOM}" : longueur de la valeur
+ *  - "${NOM:-MOT}", "${NOM-MOT}" : MOT si la variable est vide ou inexistante (inexistante seulement sans ':')
+ *  - "${NOM:=MOT}", "${NOM=MOT}" : idem, et MOT est affecte a la variable
+ *  - "${NOM:+MOT}", "${NOM+MOT}" : MOT si la variable est non vide (existe seulement sans ':'), sinon rien
+ *  - "${NOM:?MOT}", "${NOM?MOT}" : erreur (avec le message MOT) si la variable est vide ou inexistante
+ *  - "${NOM#MOTIF}", "${NOM##MOTIF}" : suppression du plus court (plus long) prefixe correspondant au motif
+ *  - "${NOM%MOTIF}", "${NOM%%MOTIF}" : suppression du plus court (plus long) suffixe correspondant au motif
+ *  - "${NOM:POSITION}", "${NOM:POSITION:LONGUEUR}" : sous-chaine (expressions arithmetiques ; une position
+ *    negative, ecrite "(-N)", part de la fin, et une longueur negative donne la fin par rapport a la fin)
+ *  - "${NOM/MOTIF/TEXTE}" : remplacement de la premiere (plus longue) correspondance du motif ; "//" remplace
+ *    toutes les correspondances, "/#" et "/%" une correspondance en debut ou en fin de valeur
+ *  NOM est un nom de variable, un parametre positionnel ou special d'une fonction ('1', '#', '@'...). Les MOT,
+ *  MOTIF et TEXTE sont eux-memes expanses. Les motifs utilisent "*", "?" et "[...]" (voir expand.h) ; chaque
+ *  motif est compile une seule fois, puis conserve dans un cache (propre a chaque thread) ou le retrouvent les
+ *  expansions suivantes du meme motif (corps de fonctions en particulier). La mise en forme de la ligne de
+ *  commande ne decoupe pas les "${...}" (voir showSeparators()) ; elles ne doivent pas contenir d'espace.
+ *
+ *  Les valeurs obtenues ne sont pas elles-memes expansees.
+ */
+
+#ifndef _PARAM_H_
+#define _PARAM_H_
+
+
+// Codes d'erreur
+enum ParamError
+{
+    PARAM_OK = 0,               // Pas d'erreur
+    PARAM_BAD_SYNTAX = 240,     // Expansion "${...}" incorrecte
+    PARAM_UNSET,                // Variable vide ou inexistante ("${NOM:?MOT}")
+    PARAM_NO_MEMORY             // Allocation impossible
+};
+
+
+/*
+ * Remplace chaque expansion ("$NOM", "$((...))", "${...}") d'un mot par sa valeur, de gauche a droite
+ *
+ * str : le mot (au plus MAX_LINE_SIZE caracteres, le resultat est tronque si besoin)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int expandParams( char* str );
+
+
+#endif // _PARAM_H_
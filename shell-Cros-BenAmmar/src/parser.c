@@ -7,18 +7,76 @@
  *  Groupe de projet :  Groupe 1
  *  Date :              30/10/2023
  *
- *  Dependances : 
+ *  Dependances : memstat.h scan.h
  *
  *  Parsing de la ligne de commande entree par l'utilisateur (implementation)
  */
 
 #include "parser.h"
+#include "memstat.h"
+#include "scan.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Recherche un operateur de redirection ("<&", "<", ">>", ">&" ou ">") au debut d'une chaine
+ *
+ * str : la chaine de caracteres
+ * op : en sortie, l'operateur trouve (chaine vide si pas d'operateur)
+ * retourne la longueur de l'operateur, ou 0 si la chaine ne commence pas par un operateur de redirection
+ */
+static int getRedirection( const char* str, char* op );
+
+/*
+ * Teste si une position d'une chaine est le debut d'une expansion arithmetique "$((...))" (la position du
+ * premier "(") ou d'une commande arithmetique "((...))" en debut de mot
+ *
+ * str : la chaine de caracteres
+ * index : la position a tester
+ * retourne 1 si une expression arithmetique debute a cette position, sinon 0
+ */
+static int isArithStart( const char* str, size_t index );
+
+/*
+ * Teste si une parenthese d'une chaine est un separateur : "(" n'ouvre un sous-shell qu'a la place d'une commande
+ * (ou fait partie du "()" d'une definition de fonction), et ")" ne ferme qu'un sous-shell ouvert. Ailleurs, une
+ * parenthese est un caractere ordinaire, tout comme la parenthese fermante qui lui correspond.
+ *
+ * str : la chaine de caracteres
+ * index : la position de la parenthese
+ * depth : en entree/sortie, nombre de sous-shells ouverts
+ * literalDepth : en entree/sortie, nombre de parentheses ordinaires ouvertes
+ * retourne 1 si la parenthese est un separateur, sinon 0
+ */
+static int isParenSeparator( const char* str, size_t index, int* depth, int* literalDepth );
+
+/*
+ * Teste si une position d'une chaine est a la place d'une commande : en debut de ligne, ou apres un separateur de
+ * commandes (";", "|", "&", "(" d'un sous-shell) ou un debut de groupe "{", aux espaces pres
+ *
+ * str : la chaine de caracteres
+ * index : la position a tester
+ * retourne 1 si une commande peut debuter a cette position, sinon 0
+ */
+static int isCmdStart( const char* str, size_t index );
+
+/*
+ * Passes clean(), showSeparators() et substEnv() sans classification des caracteres : la ligne est parcourue
+ * caractere par caractere (voir getScanMode()). Memes parametres et resultats que les fonctions publiques.
+ */
+static void cleanBytes( char* str );
+static void showSeparatorsBytes( char* str );
+static int substEnvBytes( char* str, VarLookup lookup );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
 void trim( char* str )
 {
     // Index du debut et de fin de la chaine resultante
@@ -39,42 +97,38 @@ void trim( char* str )
 
 void clean( char* str )
 {
+    // Sans instructions vectorielles, la classification couterait plus qu'elle ne fait gagner
+    if( getScanMode() == SCAN_SCALAR )
+    {
+        cleanBytes( str );
+        return;
+    }
+
     // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
     char buff[MAX_LINE_SIZE];
     strcpy( buff, str );
 
-    // Index des caracteres courants dans chaque chaine (buffer et resultat)
-    int iBuff = 0;
-    int iStr = 0;
+    // Classification des caracteres du buffer
+    const size_t length = strlen( buff );
+    ScanMask mask;
+    scanLine( buff, length, &mask );
 
-    // Flag qui dit si un separateur espace/tabulation est en cours de traitement
-    int sepInProgress = 0;
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    size_t iBuff = 0;
+    size_t iStr = 0;
 
-    // Pour chaque caractere du buffer
-    while( buff[iBuff] != '\0' )
+    // Tant qu'on est pas a la fin du buffer
+    while( iBuff < length )
     {
-        // Si le caractere est un espace ou une tabulation
-        if( buff[iBuff] == ' ' || buff[iBuff] == '\t' )
-        {
-            // Si pas de separateur en cours de traitement
-            if( ! sepInProgress )
-            {
-                // On recopie un espace (unique)
-                str[iStr++] = ' ';
-
-                // On leve le flag, de sorte a ignorer d'eventuels espaces/tabulations qui suivraient
-                sepInProgress = 1;
-            }
-        }
-        else
-        {
-            // Caractere normal : on le recopie, et on descend le flag
-            str[iStr++] = buff[iBuff];
-            sepInProgress = 0;
-        }
-
-        // Passage au caractere suivant
-        ++iBuff;
+        // On recopie les caracteres jusqu'au prochain espace ou tabulation
+        const size_t iBlank = nextScanBit( mask.blanks, iBuff, length );
+        memcpy( str + iStr, buff + iBuff, iBlank - iBuff );
+        iStr += iBlank - iBuff;
+        if( iBlank == length ) break;
+
+        // On recopie un espace (unique), et on ignore les espaces/tabulations qui suivent
+        str[iStr++] = ' ';
+        iBuff = nextScanGap( mask.blanks, iBlank, length );
     }
 
     // Caractere de terminaison
@@ -84,24 +138,82 @@ void clean( char* str )
 
 void showSeparators( char* str )
 {
+    // Sans instructions vectorielles, la classification couterait plus qu'elle ne fait gagner
+    if( getScanMode() == SCAN_SCALAR )
+    {
+        showSeparatorsBytes( str );
+        return;
+    }
+
     // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
     char buff[MAX_LINE_SIZE];
     strcpy( buff, str );
 
+    // Classification des caracteres du buffer
+    const size_t length = strlen( buff );
+    ScanMask mask;
+    scanLine( buff, length, &mask );
+
     // Index des caracteres courants dans chaque chaine (buffer et resultat)
-    int iBuff = 0;
-    int iStr = 0;
+    size_t iBuff = 0;
+    size_t iStr = 0;
+
+    // Sous-shells et parentheses ordinaires ouverts
+    int depth = 0;
+    int literalDepth = 0;
 
     // Tant qu'on est pas a la fin du buffer
-    while( buff[iBuff] != '\0' )
+    while( iBuff < length )
     {
-        // Separateur eventuel a mettre en evidence (pas plus de 3 caracteres)
+        // Prochain debut de separateur, et premiere expansion "${...}" qui le precede
+        const size_t iSep = nextScanBit( mask.separators, iBuff, length );
+        size_t iDollar = nextScanBit( mask.dollars, iBuff, length );
+        while( iDollar < iSep && buff[iDollar + 1] != '{' ) iDollar = nextScanBit( mask.dollars, iDollar + 1, length );
+        const int paramLength = ( iDollar < iSep ? getParamLength( buff + iDollar ) : 0 );
+
+        // Expansion "${...}" : recopiee telle quelle, jusqu'a son accolade fermante (ses caracteres ne sont pas
+        // des separateurs)
+        if( paramLength > 0 )
+        {
+            memcpy( str + iStr, buff + iBuff, iDollar + paramLength - iBuff );
+            iStr += iDollar + paramLength - iBuff;
+            iBuff = iDollar + paramLength;
+            continue;
+        }
+
+        // On recopie les caracteres jusqu'au prochain debut de separateur
+        memcpy( str + iStr, buff + iBuff, iSep - iBuff );
+        iStr += iSep - iBuff;
+        iBuff = iSep;
+        if( iBuff == length ) break;
+
+        // Expression arithmetique : recopiee sans ses espaces
+        const int arithLength = ( isArithStart( buff, iBuff ) ? getArithLength( buff + iBuff ) : 0 );
+        if( arithLength > 0 )
+        {
+            for( size_t iEnd = iBuff + arithLength; iBuff < iEnd; ++iBuff )
+            {
+                if( buff[iBuff] != ' ' ) str[iStr++] = buff[iBuff];
+            }
+            continue;
+        }
+
+        // Parenthese ordinaire : recopiee telle quelle
+        if( ( buff[iBuff] == '(' || buff[iBuff] == ')' ) && ! isParenSeparator( buff, iBuff, &depth, &literalDepth ) )
+        {
+            str[iStr++] = buff[iBuff++];
+            continue;
+        }
+
+        // Separateur a mettre en evidence (pas plus de 3 caracteres)
         char sep[4] = {'\0'};
 
-        // Suivant le caractere courant, s'il correspond au premier caractere d'un separateur, alors on
-        // verifie tous les separateurs potentiels qui commence par ce caractere, du plus long au plus
-        // court afin d'eviter de detruire un separateur compose de plusieurs caracteres. Si un separateur
-        // est detecte, il est copie dans la variable 'sep'
+        // Vrai si le separateur commence par un numero de descripteur (deja recopie)
+        int fdPrefix = 0;
+
+        // Suivant le caractere courant, on verifie tous les separateurs potentiels qui commence par ce
+        // caractere, du plus long au plus court afin d'eviter de detruire un separateur compose de plusieurs
+        // caracteres. Le separateur detecte est copie dans la variable 'sep'
         switch( buff[iBuff] )
         {
             // On traite uniquement ";"
@@ -109,10 +221,18 @@ void showSeparators( char* str )
                 strcpy( sep, ";" );
                 break;
 
-            // On traite "||" ou "|"
+            // On traite "(" ou ")"
+            case '(':
+            case ')':
+                sep[0] = buff[iBuff];
+                break;
+
+            // On traite "||" ou "|+" ou "|"
             case '|':
                 if( strncmp( buff + iBuff, "||", 2 ) == 0 )
                     strcpy( sep, "||" );
+                else if( strncmp( buff + iBuff, "|+", 2 ) == 0 )
+                    strcpy( sep, "|+" );
                 else
                     strcpy( sep, "|" );
                 break;
@@ -129,61 +249,26 @@ void showSeparators( char* str )
                     strcpy( sep, "&" );
                 break;
 
-            // On traite uniquement "<"
+            // On traite "<&", "<", ">>", ">&" ou ">", eventuellement precedes d'un numero de descripteur N (un
+            // chiffre en debut de mot) : "N<&", "N<", "N>>", "N>&" ou "N>"
             case '<':
-                strcpy( sep, "<" );
-                break;
-
-            // On traite ">>" ou ">"
             case '>':
-                if( strncmp( buff + iBuff, ">>", 2 ) == 0 )
-                    strcpy( sep, ">>" );
-                else
-                    strcpy( sep, ">" );
-                break;
-
-            // On traite "1>>" ou "1>"
-            case '1':
-                if( strncmp( buff + iBuff, "1>>", 3 ) == 0 )
-                    strcpy( sep, "1>>" );
-                else if( strncmp( buff + iBuff, "1>", 2 ) == 0 )
-                    strcpy( sep, "1>" );
-                else
-                    // Pas de separateur. Caractere suivant...
-                    str[iStr++] = buff[iBuff++];
+                getRedirection( buff + iBuff, sep );
+                fdPrefix = ( iBuff > 0 && isdigit( (unsigned char)buff[iBuff - 1] ) &&
+                             ( iBuff == 1 || buff[iBuff - 2] == ' ' ) );
                 break;
-
-            // On traite "2>>" ou "2>"
-            case '2':
-                if( strncmp( buff + iBuff, "2>>", 3 ) == 0 )
-                    strcpy( sep, "2>>" );
-                else if( strncmp( buff + iBuff, "2>", 2 ) == 0 )
-                    strcpy( sep, "2>" );
-                else
-                    // Pas de separateur. Caractere suivant...
-                    str[iStr++] = buff[iBuff++];
-                break;
-
-            // Pas de separateur a la position courante. On copie le caractere et on passe au suivant
-            default:
-                str[iStr++] = buff[iBuff++];
-                continue;
         }
 
-        // Si on a un separateur a traiter
-        if( strlen( sep ) != 0 )
-        {
-            // Si le caractere precedent n'est pas un espace, on le rajoute au resultat
-            if( iBuff > 0 && buff[iBuff - 1] != ' ' ) str[iStr++] = ' ';
+        // Si le caractere precedent n'est pas un espace (ni un numero de descripteur), on le rajoute au resultat
+        if( iBuff > 0 && buff[iBuff - 1] != ' ' && ! fdPrefix ) str[iStr++] = ' ';
 
-            // On recopie le separateur
-            memcpy( str + iStr, sep, strlen( sep ) );
-            iStr += strlen( sep ) ;
-            iBuff += strlen( sep ) ;
+        // On recopie le separateur
+        memcpy( str + iStr, sep, strlen( sep ) );
+        iStr += strlen( sep ) ;
+        iBuff += strlen( sep ) ;
 
-            // S'il n'y a pas d'espace apres le separateur, on le rajoute au resultat
-            if( buff[iBuff] != ' ' ) str[iStr++] = ' ';
-        }
+        // S'il n'y a pas d'espace apres le separateur, on le rajoute au resultat
+        if( buff[iBuff] != ' ' ) str[iStr++] = ' ';
     }
 
     // Caractere de terminaison
@@ -191,94 +276,433 @@ void showSeparators( char* str )
 }
 
 
-int substEnv( char* str )
+int substEnv( char* str, VarLookup lookup )
 {
+    // Sans instructions vectorielles, la classification couterait plus qu'elle ne fait gagner
+    if( getScanMode() == SCAN_SCALAR ) return( substEnvBytes( str, lookup ) );
+
     // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
     char buff[MAX_LINE_SIZE];
     strcpy( buff, str );
 
+    // Classification des caracteres du buffer
+    const size_t length = strlen( buff );
+    ScanMask mask;
+    scanLine( buff, length, &mask );
 
     // Index des caracteres courants dans chaque chaine (buffer et resultat)
-    int iBuff = 0;
-    int iStr = 0;
+    size_t iBuff = 0;
+    size_t iStr = 0;
 
     // Tant qu'on est pas a la fin du buffer
-    while( buff[iBuff] != '\0' )
+    while( iBuff < length )
     {
-        // Si on est sur le debut d'une variable d'environnement
-        if( buff[iBuff] == '$' )
+        // On recopie les caracteres jusqu'au prochain debut de variable d'environnement (le resultat est tronque
+        // s'il depasse la taille max d'une chaine)
+        const size_t iDollar = nextScanBit( mask.dollars, iBuff, length );
+        size_t copyLength = iDollar - iBuff;
+        if( iStr + copyLength >= MAX_LINE_SIZE ) copyLength = MAX_LINE_SIZE - 1 - iStr;
+        memcpy( str + iStr, buff + iBuff, copyLength );
+        iStr += copyLength;
+        iBuff = iDollar;
+        if( iBuff == length ) break;
+
+        // Index du debut du nom de la variable (apres le $)
+        const size_t iBegin = ++iBuff;
+
+        // Recherche de l'index de la fin du nom de la variable (premier espace ou fin de chaine)
+        const size_t iEnd = nextScanBit( mask.spaces, iBegin, length );
+
+        // Si le nom de la variable est vide (longueur nulle), on retourne une erreur
+        const size_t nameLength = iEnd - iBegin;
+        if( nameLength == 0 ) return( PARSER_BAD_NAME );
+
+        // Copie du nom de la variable
+        char varName[MAX_LINE_SIZE];
+        memcpy( varName, buff + iBegin, nameLength );
+        varName[nameLength] = '\0';
+
+        // Recherche de la valeur de la variable
+        const char* varValue = ( lookup != NULL ? lookup( varName ) : getenv( varName ) );
+
+        // Si la variable existe, on substitue sa valeur dans la chaine resultat (sinon, elle est ignoree)
+        if( varValue != NULL )
         {
-            // Index du debut du nom de la variable (apres le $)
-            int iBegin = ++iBuff;
-
-            // Recherche de l'index de la fin du nom de la variable (premier espace ou fin de chaine)
-            int iEnd = iBegin;
-            while( buff[iEnd] != ' ' && buff[iEnd] != '\0' ) ++iEnd;
+            size_t valueLength = strlen( varValue );
+            if( iStr + valueLength >= MAX_LINE_SIZE ) valueLength = MAX_LINE_SIZE - 1 - iStr;
+            memcpy( str + iStr, varValue, valueLength );
+            iStr += valueLength;
+        }
 
-            // Si le nom de la variable est vide (longueur nulle), on retourne une erreur
-            const int nameLength = iEnd - iBegin;
-            if( nameLength == 0 ) return( PARSER_BAD_NAME );
+        // On met a jour l'index du buffer
+        iBuff += nameLength;
+    }
 
-            // Copie du nom de la variable
-            char varName[MAX_LINE_SIZE];
-            memcpy( varName, buff + iBegin, nameLength );
-            varName[nameLength] = '\0';
+    // Caractere de terminaison
+    str[iStr] = '\0';
 
-            // Recherche de la valeur de la variable
-            char* varValue = getenv( varName );
+    return( PARSER_OK );
+}
 
-            // Si la variable n'existe pas
-            if( varValue == NULL )
-            {
-                // On ignore la variable, et on met a jour l'index du buffer
-                iBuff += nameLength;
-            }
-            else
-            {
-                // La variable existe, on substitue sa valeur dans la chaine resultat
-                const int valueLength= strlen( varValue );
-                memcpy( str + iStr, varValue, valueLength );
 
-                // On met a jour les index
-                iBuff += nameLength;
-                iStr += valueLength;
-            }
-        }
-        else
-        {
-            // Sinon, on recopie simplement le caractere
-            str[iStr++] = buff[iBuff++];
-        }
+int getArithLength( const char* str )
+{
+    // Recherche du premier "))" en dehors des parentheses de l'expression
+    int depth = 0;
+    for( int i = 2; str[i] != '\0'; ++i )
+    {
+        if( str[i] == '(' ) ++depth;
+        else if( str[i] == ')' && depth > 0 ) --depth;
+        else if( str[i] == ')' ) return( str[i + 1] == ')' ? i + 2 : 0 );
     }
 
-    // Caractere de terminaison
-    str[iStr] = '\0';
+    // Expression non terminee
+    return( 0 );
+}
 
-    return( PARSER_OK );
+
+int getParamLength( const char* str )
+{
+    // Recherche de l'accolade fermante, en dehors des expansions "${...}" imbriquees
+    int depth = 0;
+    for( int i = 2; str[i] != '\0'; ++i )
+    {
+        if( str[i] == '{' ) ++depth;
+        else if( str[i] == '}' && depth > 0 ) --depth;
+        else if( str[i] == '}' ) return( i + 1 );
+    }
+
+    // Expansion non terminee
+    return( 0 );
 }
 
 
 void strcut( char* str, char sepChar, char** tokens )
 {
-    // Separateur passe a strtok()
+    // Separateur passe a strtok_r() (reentrante : la position courante est conservee par l'appelant)
     char sep[2] = { sepChar, '\0' };
+    char* savePtr = NULL;
 
     // Index du prochain mot a rajouter dans le tableau 'tokens'
     int iLast = 0;
 
     // Recherche du premier mot de la chaine
-    char* word = strtok( str, sep );
+    char* word = strtok_r( str, sep, &savePtr );
 
     // Tant qu'un mot a ete trouve
     while( word != NULL )
     {
         // On rajoute le mot dans la liste
         const int wordLength = strlen( word );
-        tokens[iLast] = (char*)malloc( ( wordLength + 1 ) * sizeof( char ) );
+        tokens[iLast] = (char*)memAlloc( MEM_PARSER, ( wordLength + 1 ) * sizeof( char ) );
         strcpy( tokens[iLast], word );
 
         // On passe au mot suivant
         ++iLast;
-        word = strtok( NULL, sep );
+        word = strtok_r( NULL, sep, &savePtr );
     }
 }
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int getRedirection( const char* str, char* op )
+{
+    // Operateurs de redirection, les plus longs en premier
+    static const char* OPERATORS[] = { "<&", "<", ">>", ">&", ">", NULL };
+
+    // Recherche de l'operateur
+    for( const char** pOp = OPERATORS; *pOp != NULL; ++pOp )
+    {
+        if( strncmp( str, *pOp, strlen( *pOp ) ) == 0 )
+        {
+            strcpy( op, *pOp );
+            return( strlen( *pOp ) );
+        }
+    }
+
+    // Pas d'operateur
+    op[0] = '\0';
+    return( 0 );
+}
+
+
+static int isArithStart( const char* str, size_t index )
+{
+    // Deux parentheses ouvrantes
+    if( str[index] != '(' || str[index + 1] != '(' ) return( 0 );
+
+    // Precedees d'un "$", ou en debut de mot (apres un espace ou un separateur)
+    return( index == 0 || str[index - 1] == '$' || strchr( " ;&|", str[index - 1] ) != NULL );
+}
+
+
+static int isParenSeparator( const char* str, size_t index, int* depth, int* literalDepth )
+{
+    // Parenthese ouvrante : debut de sous-shell, "()" d'une definition de fonction, ou caractere ordinaire
+    if( str[index] == '(' )
+    {
+        size_t iNext = index + 1;
+        while( str[iNext] == ' ' ) ++iNext;
+        if( isCmdStart( str, index ) || str[iNext] == ')' )
+        {
+            ++*depth;
+            return( 1 );
+        }
+        ++*literalDepth;
+        return( 0 );
+    }
+
+    // Parenthese fermante : d'abord celle d'une parenthese ordinaire, puis celle d'un sous-shell
+    if( *literalDepth > 0 )
+    {
+        --*literalDepth;
+        return( 0 );
+    }
+    if( *depth > 0 )
+    {
+        --*depth;
+        return( 1 );
+    }
+    return( 0 );
+}
+
+
+static int isCmdStart( const char* str, size_t index )
+{
+    // Caractere precedent, sans les espaces
+    while( index > 0 && ( str[index - 1] == ' ' || str[index - 1] == '\t' ) ) --index;
+    if( index == 0 ) return( 1 );
+    const char previous = str[index - 1];
+
+    // Separateur de commandes ("&" ne doit pas terminer une redirection "<&" ou ">&")
+    if( previous == ';' || previous == '|' ) return( 1 );
+    if( previous == '&' ) return( index < 2 || ( str[index - 2] != '<' && str[index - 2] != '>' ) );
+
+    // Debut de sous-shell, ou debut de groupe "{" (un mot a lui seul), lui-meme a la place d'une commande
+    if( previous == '(' ) return( isCmdStart( str, index - 1 ) );
+    if( previous == '{' && ( index < 2 || strchr( " \t;|&(", str[index - 2] ) != NULL ) )
+    {
+        return( isCmdStart( str, index - 1 ) );
+    }
+
+    return( 0 );
+}
+
+
+static void cleanBytes( char* str )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Flag qui dit si un separateur espace/tabulation est en cours de traitement
+    int sepInProgress = 0;
+
+    // Pour chaque caractere du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Si le caractere est un espace ou une tabulation
+        if( buff[iBuff] == ' ' || buff[iBuff] == '\t' )
+        {
+            // Si pas de separateur en cours de traitement, on recopie un espace (unique), et on leve le flag, de
+            // sorte a ignorer d'eventuels espaces/tabulations qui suivraient
+            if( ! sepInProgress ) str[iStr++] = ' ';
+            sepInProgress = 1;
+        }
+        else
+        {
+            // Caractere normal : on le recopie, et on descend le flag
+            str[iStr++] = buff[iBuff];
+            sepInProgress = 0;
+        }
+
+        // Passage au caractere suivant
+        ++iBuff;
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+}
+
+
+static void showSeparatorsBytes( char* str )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Sous-shells et parentheses ordinaires ouverts
+    int depth = 0;
+    int literalDepth = 0;
+
+    // Vrai si une expansion "${...}" non terminee a ete rencontree depuis le dernier separateur : les suivantes
+    // ne sont pas recherchees avant le prochain separateur (comme dans showSeparators())
+    int paramFailed = 0;
+
+    // Tant qu'on est pas a la fin du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Suivant le caractere courant
+        switch( buff[iBuff] )
+        {
+            // Debut de separateur
+            case ';': case '|': case '&': case '<': case '>': case '(': case ')':
+                paramFailed = 0;
+                break;
+
+            // Expansion "${...}" : recopiee telle quelle, jusqu'a son accolade fermante (ses caracteres ne sont
+            // pas des separateurs)
+            case '$':
+                if( buff[iBuff + 1] == '{' && ! paramFailed )
+                {
+                    const int paramLength = getParamLength( buff + iBuff );
+                    if( paramLength > 0 )
+                    {
+                        memcpy( str + iStr, buff + iBuff, paramLength );
+                        iStr += paramLength;
+                        iBuff += paramLength;
+                        continue;
+                    }
+                    paramFailed = 1;
+                }
+                str[iStr++] = buff[iBuff++];
+                continue;
+
+            // Pas de separateur a la position courante : on copie le caractere et on passe au suivant
+            default:
+                str[iStr++] = buff[iBuff++];
+                continue;
+        }
+
+        // Expression arithmetique : recopiee sans ses espaces
+        const int arithLength = ( isArithStart( buff, iBuff ) ? getArithLength( buff + iBuff ) : 0 );
+        if( arithLength > 0 )
+        {
+            for( const int iEnd = iBuff + arithLength; iBuff < iEnd; ++iBuff )
+            {
+                if( buff[iBuff] != ' ' ) str[iStr++] = buff[iBuff];
+            }
+            continue;
+        }
+
+        // Parenthese ordinaire : recopiee telle quelle
+        if( ( buff[iBuff] == '(' || buff[iBuff] == ')' ) && ! isParenSeparator( buff, iBuff, &depth, &literalDepth ) )
+        {
+            str[iStr++] = buff[iBuff++];
+            continue;
+        }
+
+        // Separateur a mettre en evidence (pas plus de 3 caracteres), du plus long au plus court (voir
+        // showSeparators())
+        char sep[4] = {'\0'};
+        int fdPrefix = 0;
+        switch( buff[iBuff] )
+        {
+            case ';':
+            case '(':
+            case ')':
+                sep[0] = buff[iBuff];
+                break;
+
+            case '|':
+                if( strncmp( buff + iBuff, "||", 2 ) == 0 ) strcpy( sep, "||" );
+                else if( strncmp( buff + iBuff, "|+", 2 ) == 0 ) strcpy( sep, "|+" );
+                else strcpy( sep, "|" );
+                break;
+
+            case '&':
+                if( strncmp( buff + iBuff, "&>>", 3 ) == 0 ) strcpy( sep, "&>>" );
+                else if( strncmp( buff + iBuff, "&>", 2 ) == 0 ) strcpy( sep, "&>" );
+                else if( strncmp( buff + iBuff, "&&", 2 ) == 0 ) strcpy( sep, "&&" );
+                else strcpy( sep, "&" );
+                break;
+
+            // Redirection, eventuellement precedee d'un numero de descripteur en debut de mot (deja recopie)
+            default:
+                getRedirection( buff + iBuff, sep );
+                fdPrefix = ( iBuff > 0 && isdigit( (unsigned char)buff[iBuff - 1] ) &&
+                             ( iBuff == 1 || buff[iBuff - 2] == ' ' ) );
+                break;
+        }
+
+        // Si le caractere precedent n'est pas un espace (ni un numero de descripteur), on le rajoute au resultat
+        if( iBuff > 0 && buff[iBuff - 1] != ' ' && ! fdPrefix ) str[iStr++] = ' ';
+
+        // On recopie le separateur
+        const int sepLength = strlen( sep );
+        memcpy( str + iStr, sep, sepLength );
+        iStr += sepLength;
+        iBuff += sepLength;
+
+        // S'il n'y a pas d'espace apres le separateur, on le rajoute au resultat
+        if( buff[iBuff] != ' ' ) str[iStr++] = ' ';
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+}
+
+
+static int substEnvBytes( char* str, VarLookup lookup )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Tant qu'on est pas a la fin du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Caractere ordinaire : on le recopie (le resultat est tronque s'il depasse la taille max d'une chaine)
+        if( buff[iBuff] != '$' )
+        {
+            if( iStr < MAX_LINE_SIZE - 1 ) str[iStr++] = buff[iBuff];
+            ++iBuff;
+            continue;
+        }
+
+        // Index du debut du nom de la variable (apres le $), et de sa fin (premier espace ou fin de chaine)
+        const int iBegin = ++iBuff;
+        int iEnd = iBegin;
+        while( buff[iEnd] != ' ' && buff[iEnd] != '\0' ) ++iEnd;
+
+        // Si le nom de la variable est vide (longueur nulle), on retourne une erreur
+        const int nameLength = iEnd - iBegin;
+        if( nameLength == 0 ) return( PARSER_BAD_NAME );
+
+        // Copie du nom de la variable, et recherche de sa valeur
+        char varName[MAX_LINE_SIZE];
+        memcpy( varName, buff + iBegin, nameLength );
+        varName[nameLength] = '\0';
+        const char* varValue = ( lookup != NULL ? lookup( varName ) : getenv( varName ) );
+
+        // Si la variable existe, on substitue sa valeur dans la chaine resultat (sinon, elle est ignoree)
+        if( varValue != NULL )
+        {
+            int valueLength = strlen( varValue );
+            if( iStr + valueLength >= MAX_LINE_SIZE ) valueLength = MAX_LINE_SIZE - 1 - iStr;
+            memcpy( str + iStr, varValue, valueLength );
+            iStr += valueLength;
+        }
+
+        // On met a jour l'index du buffer
+        iBuff += nameLength;
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+
+    return( PARSER_OK );
+}
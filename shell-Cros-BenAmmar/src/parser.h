@@ -21,6 +21,9 @@
 // Nombre max de mots dans une ligne de commande
 #define MAX_CMD_SIZE    256
 
+// Fonction de recherche de la valeur d'une variable (voir substEnv())
+typedef const char* (*VarLookup)( const char* name );
+
 // Code d'erreur
 enum ParserError
 {
@@ -52,14 +55,18 @@ void clean(char* str);
  * - "||"   : OU logique
  * - "<"    : redirection de STDIN
  * - ">"    : redirection de STDOUT
- * - "1>"   : redirection de STDOUT
  * - ">>"   : redirection de STDOUT (mode concatenation)
- * - "1>>"  : redirection de STDOUT (mode concatenation)
- * - "2>"   : redirection de STDERR
- * - "2>>"  : redirection de STDERR (mode concatenation)
+ * - "<&"   : duplication d'un descripteur sur STDIN
+ * - ">&"   : duplication d'un descripteur sur STDOUT
+ * - "N<", "N>", "N>>", "N<&", "N>&" : memes redirections, pour le descripteur N (un chiffre en debut de mot)
  * - "&>"   : redirection de STDOUT et STDERR
  * - "&>>"  : redirection de STDOUT et STDERR (mode concatenation)
  * - "&"    : execution en background
+ * - "(", ")" : debut et fin d'un sous-shell ("(" seulement a la place d'une commande ou dans le "()" d'une
+ *   definition de fonction, ")" seulement pour fermer un sous-shell ; ailleurs, ce sont des caracteres ordinaires)
+ * Une expansion arithmetique "$((...))" ou une commande arithmetique "((...))" (en debut de mot) n'est pas
+ * decoupee : ses operateurs ne sont pas mis en evidence, et ses espaces sont supprimes (elle forme un seul mot).
+ * De meme, une expansion de parametre "${...}" est recopiee telle quelle (voir param.h).
  *
  * str : chaine de caracteres a traiter
  */
@@ -70,9 +77,28 @@ void showSeparators( char* str );
  * substitue la variable par sa valeur si cette variable existe (dans le cas contraire on ne met rien)
  *
  * str : chaine de caracteres a traiter
+ * lookup : fonction de recherche de la valeur d'une variable (NULL si elle n'existe pas), ou NULL pour les
+ *          variables d'environnement du processus
  * retourne 0 en cas de succes, sinon un code d'erreur
  */
-int substEnv(char* str );
+int substEnv( char* str, VarLookup lookup );
+
+/*
+ * Recherche la fin d'une expression arithmetique "((...))" : les parentheses de l'expression doivent etre
+ * equilibrees
+ *
+ * str : chaine commencant par "(("
+ * retourne la longueur de "((...))", ou 0 si l'expression n'est pas terminee
+ */
+int getArithLength( const char* str );
+
+/*
+ * Recherche la fin d'une expansion de parametre "${...}" : les accolades de l'expansion doivent etre equilibrees
+ *
+ * str : chaine commencant par "${"
+ * retourne la longueur de "${...}", ou 0 si l'expansion n'est pas terminee
+ */
+int getParamLength( const char* str );
 
 /*
  * Decoupe la chaine de caracteres specifiee en mots.
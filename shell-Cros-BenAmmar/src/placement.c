@@ -0,0 +1,335 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances :
+ *
+ *  Placement des processus d'execution des commandes (implementation)
+ */
+
+#include "placement.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Constantes de ioprio_set() (non exportees par la glibc)
+#define IOPRIO_WHO_PROCESS      1
+#define IOPRIO_CLASS_SHIFT      13
+#define IOPRIO_CLASS_RT         1
+#define IOPRIO_CLASS_BE         2
+#define IOPRIO_CLASS_IDLE       3
+
+// Structure de donnees associant un nom de ressource a la constante RLIMIT_xxx correspondante
+typedef struct
+{
+    const char* name;
+    int resource;
+} RlimitName;
+
+// Liste des ressources dont la limite peut etre modifiee
+static const RlimitName ALL_RLIMITS[] =
+{
+    { "as", RLIMIT_AS },
+    { "core", RLIMIT_CORE },
+    { "cpu", RLIMIT_CPU },
+    { "data", RLIMIT_DATA },
+    { "fsize", RLIMIT_FSIZE },
+    { "memlock", RLIMIT_MEMLOCK },
+    { "nofile", RLIMIT_NOFILE },
+    { "nproc", RLIMIT_NPROC },
+    { "rss", RLIMIT_RSS },
+    { "stack", RLIMIT_STACK }
+};
+static const int RLIMIT_COUNT = sizeof( ALL_RLIMITS ) / sizeof( RlimitName );
+
+// Coeurs utilises pour la repartition des pipelines (un CPU logique par coeur physique)
+static int spreadCpus[CPU_SETSIZE];
+
+// Nombre de coeurs utilises pour la repartition des pipelines (0 si repartition inactive)
+static int spreadCpuCount = 0;
+
+/*
+ * Decode un entier positif ou nul en base 10
+ *
+ * str : chaine de caracteres a decoder
+ * end : en sortie, pointeur sur le premier caractere qui suit l'entier
+ * value : en sortie, valeur de l'entier
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseNumber( const char* str, const char** end, long* value );
+
+/*
+ * Decode une valeur de limite de ressources (entier ou "unlimited")
+ *
+ * str : chaine de caracteres a decoder
+ * value : en sortie, valeur de la limite
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int parseRlimitValue( const char* str, rlim_t* value );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+void initPlacement( Placement* placement )
+{
+    // Aucune modification du processus
+    placement->hasCpus = 0;
+    CPU_ZERO( &placement->cpus );
+    placement->hasNice = 0;
+    placement->nice = 0;
+    placement->ioprio = -1;
+    placement->rlimitCount = 0;
+}
+
+
+int parseCpuList( const char* str, cpu_set_t* cpus )
+{
+    // Ensemble vide au depart
+    CPU_ZERO( cpus );
+
+    // Pour chaque element de la liste (un CPU ou un intervalle de CPUs)
+    const char* p = str;
+    while( *p != '\0' && *p != '\n' )
+    {
+        // Premier CPU de l'element
+        long first = 0;
+        if( parseNumber( p, &p, &first ) != PLACEMENT_OK ) return( PLACEMENT_BAD_SPEC );
+
+        // Eventuel dernier CPU de l'intervalle
+        long last = first;
+        if( *p == '-' )
+        {
+            if( parseNumber( p + 1, &p, &last ) != PLACEMENT_OK ) return( PLACEMENT_BAD_SPEC );
+        }
+
+        // Verification de l'intervalle
+        if( last < first || last >= CPU_SETSIZE ) return( PLACEMENT_BAD_SPEC );
+
+        // Ajout des CPUs de l'intervalle
+        for( long cpu = first; cpu <= last; ++cpu ) CPU_SET( cpu, cpus );
+
+        // Element suivant
+        if( *p == ',' ) ++p;
+        else if( *p != '\0' && *p != '\n' ) return( PLACEMENT_BAD_SPEC );
+    }
+
+    // La liste ne doit pas etre vide
+    return( CPU_COUNT( cpus ) > 0 ? PLACEMENT_OK : PLACEMENT_BAD_SPEC );
+}
+
+
+int parseIoPriority( const char* str, Placement* placement )
+{
+    // Extraction de la classe et du niveau eventuel
+    char className[32] = {'\0'};
+    const char* level = strchr( str, ':' );
+    const size_t classLength = ( level != NULL ? (size_t)( level - str ) : strlen( str ) );
+    if( classLength == 0 || classLength >= sizeof( className ) ) return( PLACEMENT_BAD_SPEC );
+    memcpy( className, str, classLength );
+
+    // Niveau de priorite dans la classe (4 par defaut, comme pour ionice)
+    long value = 4;
+    if( level != NULL )
+    {
+        const char* end = NULL;
+        if( parseNumber( level + 1, &end, &value ) != PLACEMENT_OK || *end != '\0' || value > 7 )
+        {
+            return( PLACEMENT_BAD_SPEC );
+        }
+    }
+
+    // Suivant la classe
+    int ioClass = 0;
+    if( strcmp( className, "realtime" ) == 0 ) ioClass = IOPRIO_CLASS_RT;
+    else if( strcmp( className, "best-effort" ) == 0 ) ioClass = IOPRIO_CLASS_BE;
+    else if( strcmp( className, "idle" ) == 0 ) ioClass = IOPRIO_CLASS_IDLE;
+    else return( PLACEMENT_BAD_SPEC );
+
+    // La classe idle n'a pas de niveau
+    if( ioClass == IOPRIO_CLASS_IDLE ) value = 0;
+
+    // Mise a jour du placement
+    placement->ioprio = ( ioClass << IOPRIO_CLASS_SHIFT ) | (int)value;
+
+    return( PLACEMENT_OK );
+}
+
+
+int parseRlimit( const char* str, Placement* placement )
+{
+    // On verifie qu'il reste de la place pour une limite
+    if( placement->rlimitCount >= MAX_RLIMITS ) return( PLACEMENT_BAD_SPEC );
+
+    // Extraction du nom de la ressource
+    const char* value = strchr( str, '=' );
+    if( value == NULL ) return( PLACEMENT_BAD_SPEC );
+    const size_t nameLength = value - str;
+
+    // Recherche de la ressource
+    int resource = -1;
+    for( int i = 0; i < RLIMIT_COUNT; ++i )
+    {
+        if( strlen( ALL_RLIMITS[i].name ) == nameLength && strncmp( ALL_RLIMITS[i].name, str, nameLength ) == 0 )
+        {
+            resource = ALL_RLIMITS[i].resource;
+        }
+    }
+    if( resource == -1 ) return( PLACEMENT_BAD_SPEC );
+
+    // Extraction des limites "soft" et "hard" (par defaut, la meme valeur)
+    char soft[32] = {'\0'};
+    const char* hard = strchr( value + 1, ':' );
+    const size_t softLength = ( hard != NULL ? (size_t)( hard - value - 1 ) : strlen( value + 1 ) );
+    if( softLength == 0 || softLength >= sizeof( soft ) ) return( PLACEMENT_BAD_SPEC );
+    memcpy( soft, value + 1, softLength );
+
+    // Decodage des valeurs
+    struct rlimit* limit = placement->rlimits + placement->rlimitCount;
+    if( parseRlimitValue( soft, &limit->rlim_cur ) != PLACEMENT_OK ) return( PLACEMENT_BAD_SPEC );
+    limit->rlim_max = limit->rlim_cur;
+    if( hard != NULL && parseRlimitValue( hard + 1, &limit->rlim_max ) != PLACEMENT_OK ) return( PLACEMENT_BAD_SPEC );
+
+    // Une limite supplementaire
+    placement->rlimitResources[placement->rlimitCount++] = resource;
+
+    return( PLACEMENT_OK );
+}
+
+
+int applyPlacement( const Placement* placement )
+{
+    // Affinite CPU
+    if( placement->hasCpus && sched_setaffinity( 0, sizeof( cpu_set_t ), &placement->cpus ) == -1 )
+    {
+        perror( "ERREUR - sched_setaffinity" );
+        return( PLACEMENT_FAILED );
+    }
+
+    // Priorite d'ordonnancement
+    if( placement->hasNice && setpriority( PRIO_PROCESS, 0, placement->nice ) == -1 )
+    {
+        perror( "ERREUR - setpriority" );
+        return( PLACEMENT_FAILED );
+    }
+
+    // Priorite d'entrees/sorties
+    if( placement->ioprio != -1 && syscall( SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, placement->ioprio ) == -1 )
+    {
+        perror( "ERREUR - ioprio_set" );
+        return( PLACEMENT_FAILED );
+    }
+
+    // Limites de ressources
+    for( int i = 0; i < placement->rlimitCount; ++i )
+    {
+        if( setrlimit( placement->rlimitResources[i], placement->rlimits + i ) == -1 )
+        {
+            perror( "ERREUR - setrlimit" );
+            return( PLACEMENT_FAILED );
+        }
+    }
+
+    return( PLACEMENT_OK );
+}
+
+
+int enablePipeSpread( void )
+{
+    // CPUs sur lesquels le minishell a le droit de s'executer
+    cpu_set_t allowed;
+    if( sched_getaffinity( 0, sizeof( cpu_set_t ), &allowed ) == -1 ) return( PLACEMENT_FAILED );
+
+    // Pour chaque CPU autorise
+    spreadCpuCount = 0;
+    for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+    {
+        if( ! CPU_ISSET( cpu, &allowed ) ) continue;
+
+        // Lecture des CPUs logiques partageant le meme coeur physique
+        char path[128];
+        snprintf( path, sizeof( path ), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu );
+        FILE* file = fopen( path, "r" );
+        char siblingList[256] = {'\0'};
+        cpu_set_t siblings;
+        int keep = 1;
+        if( file != NULL )
+        {
+            // On ne garde le CPU que s'il est le premier CPU autorise de son coeur physique
+            if( fgets( siblingList, sizeof( siblingList ), file ) != NULL &&
+                parseCpuList( siblingList, &siblings ) == PLACEMENT_OK )
+            {
+                for( int other = 0; other < cpu; ++other )
+                {
+                    if( CPU_ISSET( other, &siblings ) && CPU_ISSET( other, &allowed ) ) keep = 0;
+                }
+            }
+            fclose( file );
+        }
+
+        // Ajout du CPU dans la liste des coeurs utilisables
+        if( keep ) spreadCpus[spreadCpuCount++] = cpu;
+    }
+
+    return( spreadCpuCount > 0 ? PLACEMENT_OK : PLACEMENT_FAILED );
+}
+
+
+int pinPipeStage( int stage )
+{
+    // Si la repartition des pipelines n'est pas active, rien a faire
+    if( spreadCpuCount == 0 ) return( PLACEMENT_OK );
+
+    // Chaque etape consecutive est placee sur le coeur suivant
+    cpu_set_t cpus;
+    CPU_ZERO( &cpus );
+    CPU_SET( spreadCpus[stage % spreadCpuCount], &cpus );
+    if( sched_setaffinity( 0, sizeof( cpu_set_t ), &cpus ) == -1 ) return( PLACEMENT_FAILED );
+
+    return( PLACEMENT_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int parseNumber( const char* str, const char** end, long* value )
+{
+    // Le nombre doit commencer par un chiffre
+    if( *str < '0' || *str > '9' ) return( PLACEMENT_BAD_SPEC );
+
+    // Conversion
+    char* endPtr = NULL;
+    *value = strtol( str, &endPtr, 10 );
+    *end = endPtr;
+
+    return( PLACEMENT_OK );
+}
+
+
+static int parseRlimitValue( const char* str, rlim_t* value )
+{
+    // Valeur illimitee
+    if( strcmp( str, "unlimited" ) == 0 )
+    {
+        *value = RLIM_INFINITY;
+        return( PLACEMENT_OK );
+    }
+
+    // Valeur numerique
+    const char* end = NULL;
+    long number = 0;
+    if( parseNumber( str, &end, &number ) != PLACEMENT_OK || *end != '\0' ) return( PLACEMENT_BAD_SPEC );
+    *value = (rlim_t)number;
+
+    return( PLACEMENT_OK );
+}
@@ -0,0 +1,127 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Placement des processus d'execution des commandes :
+ *  - Affinite CPU, priorite (nice), priorite d'entrees/sorties et limites de ressources
+ *  - Repartition des etapes d'un pipeline sur des coeurs distincts
+ */
+
+#ifndef _PLACEMENT_H_
+#define _PLACEMENT_H_
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <sys/resource.h>
+
+// Nombre max de limites de ressources pouvant etre specifiees pour une commande
+#define MAX_RLIMITS     16
+
+// Code d'erreur
+enum PlacementError
+{
+    PLACEMENT_OK = 0,               // Pas d'erreur
+    PLACEMENT_BAD_SPEC = 40,        // Specification incorrecte (liste de CPUs, classe d'E/S, limite...)
+    PLACEMENT_FAILED                // Echec de l'appel systeme de placement
+};
+
+/*
+ * Structure de donnees decrivant le placement a appliquer au processus d'execution d'une commande.
+ *
+ * hasCpus : flag indiquant si l'affinite CPU doit etre modifiee
+ * cpus : ensemble des CPUs autorises
+ * hasNice : flag indiquant si la priorite (nice) doit etre modifiee
+ * nice : valeur de nice a appliquer
+ * ioprio : priorite d'entrees/sorties (au format de ioprio_set), ou -1 si pas de modification
+ * rlimitCount : nombre de limites de ressources a appliquer
+ * rlimitResources : ressources concernees par les limites (RLIMIT_xxx)
+ * rlimits : valeurs des limites de ressources
+ */
+typedef struct
+{
+    int hasCpus;
+    cpu_set_t cpus;
+    int hasNice;
+    int nice;
+    int ioprio;
+    int rlimitCount;
+    int rlimitResources[MAX_RLIMITS];
+    struct rlimit rlimits[MAX_RLIMITS];
+} Placement;
+
+
+/*
+ * Initialise un placement vide (aucune modification du processus)
+ *
+ * placement : le placement a initialiser
+ */
+void initPlacement( Placement* placement );
+
+/*
+ * Decode une liste de CPUs de la forme "0-3,8,10-11" (format utilise par taskset et par /sys)
+ *
+ * str : chaine de caracteres a decoder
+ * cpus : en sortie, ensemble des CPUs de la liste
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int parseCpuList( const char* str, cpu_set_t* cpus );
+
+/*
+ * Decode une classe de priorite d'entrees/sorties de la forme "CLASSE[:NIVEAU]", avec CLASSE parmi
+ * "realtime", "best-effort" et "idle", et NIVEAU entre 0 (le plus prioritaire) et 7.
+ *
+ * str : chaine de caracteres a decoder
+ * placement : placement mis a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int parseIoPriority( const char* str, Placement* placement );
+
+/*
+ * Decode une limite de ressources de la forme "RESSOURCE=SOFT[:HARD]", avec RESSOURCE parmi "as", "core",
+ * "cpu", "data", "fsize", "memlock", "nofile", "nproc", "rss" et "stack". Les valeurs peuvent etre
+ * "unlimited".
+ *
+ * str : chaine de caracteres a decoder
+ * placement : placement mis a jour
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int parseRlimit( const char* str, Placement* placement );
+
+/*
+ * Applique un placement au processus courant. Cette fonction est destinee a etre appelee dans le processus
+ * fils d'execution d'une commande, entre le fork() et l'exec.
+ *
+ * placement : le placement a appliquer
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int applyPlacement( const Placement* placement );
+
+/*
+ * Active la repartition des etapes des pipelines sur des coeurs physiques distincts. La liste des coeurs
+ * utilisables est calculee une seule fois, a partir de l'affinite courante du minishell et de la topologie
+ * decrite dans /sys (un seul CPU logique est retenu par coeur physique, pour que deux etapes consecutives
+ * ne partagent pas le meme cache L1).
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int enablePipeSpread( void );
+
+/*
+ * Epingle le processus courant sur le coeur associe a une etape de pipeline, si la repartition des
+ * pipelines est active (sinon ne fait rien).
+ *
+ * stage : index de l'etape dans le pipeline (0 pour la premiere commande)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int pinPipeStage( int stage );
+
+
+#endif // _PLACEMENT_H_
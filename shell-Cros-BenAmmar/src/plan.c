@@ -0,0 +1,452 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h builtin.h func.h stage.h
+ *
+ *  Plan d'execution d'une ligne de commande (implementation)
+ */
+
+#include "plan.h"
+#include "builtin.h"
+#include "func.h"
+#include "stage.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Remplace "cat FICHIER | CMD" par "CMD < FICHIER" : la commande cat est supprimee, et le fichier est ouvert
+ * comme entree standard de la commande suivante du pipeline
+ *
+ * cmd : la commande a tester (la premiere d'un pipeline)
+ * retourne 1 si la reecriture a ete effectuee, sinon 0
+ */
+static int elideCat( cmd_t* cmd );
+
+/*
+ * Supprime les redirections inutiles d'une commande : celles dont le descripteur cible est ecrase par une
+ * duplication ulterieure sans avoir ete utilise entre-temps, et les duplications d'un descripteur standard sur
+ * lui-meme
+ *
+ * cmd : la commande
+ * retourne le nombre de redirections supprimees
+ */
+static int dropDeadRedirections( cmd_t* cmd );
+
+/*
+ * Teste si un descripteur est ecrase par une duplication de la commande, sans etre utilise avant
+ *
+ * cmd : la commande
+ * fd : le descripteur
+ * position : index de la duplication a partir de laquelle chercher (non comprise), ou -1 pour l'entree/sortie/
+ *            erreur standards (mises en place avant les duplications)
+ * retourne 1 si le descripteur est ecrase, sinon 0
+ */
+static int isOverwritten( const cmd_t* cmd, int fd, int position );
+
+/*
+ * Referme les fichiers de redirection d'une commande qui ne sont plus utilises (redirection ecrasee par une
+ * redirection ulterieure du meme descripteur, comme dans "CMD > a > b"), et les retire de ses fichiers a refermer
+ *
+ * cmd : la commande
+ * retourne le nombre de fichiers refermes
+ */
+static int dropUnusedFiles( cmd_t* cmd );
+
+/*
+ * Teste si un descripteur est utilise par une commande (entree/sortie/erreur standards, ou duplication)
+ *
+ * cmd : la commande
+ * fd : le descripteur
+ * retourne 1 si le descripteur est utilise, sinon 0
+ */
+static int isFdUsed( const cmd_t* cmd, int fd );
+
+/*
+ * Supprime "true" suivi de "&&" et "false" suivi de "||", dont le code de retour est connu a l'avance
+ *
+ * cmd : la commande a tester
+ * retourne 1 si la commande a ete supprimee, sinon 0
+ */
+static int foldConstant( cmd_t* cmd );
+
+/*
+ * Teste si une commande fait partie d'un pipeline
+ *
+ * cmd : la commande
+ * retourne 1 si la commande fait partie d'un pipeline, sinon 0
+ */
+static int isInPipeline( const cmd_t* cmd );
+
+/*
+ * Affiche un descripteur d'une commande, en precisant s'il s'agit d'un pipe de la ligne de commande
+ *
+ * name : nom du descripteur ("in", "out", "err")
+ * fd : le descripteur
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ */
+static void printFd( const char* name, int fd, const cmd_t cmds[], int cmdCount );
+
+/*
+ * Affiche l'index d'une commande enchainee
+ *
+ * name : nom de l'enchainement
+ * next : la commande enchainee
+ * cmds : tableau des commandes
+ */
+static void printLink( const char* name, const cmd_t* next, const cmd_t cmds[] );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int optimizePlan( cmd_t cmds[], int cmdCount )
+{
+    // Nombre de reecritures effectuees
+    int rewrites = 0;
+
+    // Une fonction definie par la ligne peut remplacer les commandes reecrites ("cat", "true"...) : la ligne
+    // n'est pas optimisee
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        if( cmds[i].funcDef != NULL ) return( rewrites );
+    }
+
+    // Pour chaque commande (les commandes des groupes sont traitees comme les autres)
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        cmd_t* cmd = cmds + i;
+        if( cmd->elided ) continue;
+
+        // Suppression des redirections inutiles (et des fichiers qu'elles ont ouverts), puis des commandes inutiles
+        rewrites += dropDeadRedirections( cmd );
+        rewrites += dropUnusedFiles( cmd );
+        rewrites += elideCat( cmd );
+        rewrites += foldConstant( cmd );
+    }
+
+    return( rewrites );
+}
+
+
+void getPlanStats( const cmd_t cmds[], int cmdCount, PlanStats* stats )
+{
+    stats->pipes = 0;
+    stats->fds = 0;
+    stats->forks = 0;
+    stats->threads = 0;
+
+    // Pour chaque commande
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        const cmd_t* cmd = cmds + i;
+
+        // Pipe dont la commande est la sortie
+        if( cmd->fdpipe[0] != -1 )
+        {
+            ++stats->pipes;
+            stats->fds += 2;
+        }
+
+        // Fichiers ouverts par la commande (ceux deja comptes pour une commande precedente sont ignores, les
+        // listes des commandes pouvant avoir ete fusionnees)
+        for( int iFd = 0; iFd < MAX_CMD_SIZE && cmd->fdclose[iFd] != -1; ++iFd )
+        {
+            int counted = 0;
+            for( int j = 0; j < i && ! counted; ++j )
+            {
+                for( int jFd = 0; jFd < MAX_CMD_SIZE && cmds[j].fdclose[jFd] != -1 && ! counted; ++jFd )
+                {
+                    counted = ( cmds[j].fdclose[jFd] == cmd->fdclose[iFd] );
+                }
+            }
+            if( ! counted ) ++stats->fds;
+        }
+
+        // Processus cree pour la commande : aucun pour les commandes supprimees, 'exit', les definitions de
+        // fonctions, ainsi que les builtins, groupes '{ ... ; }' et appels de fonctions executes dans le minishell,
+        // et les etapes executees dans des threads
+        const int inShell = ( ( isShellBuiltin( cmd->path ) || findFunction( cmd->path ) != NULL ||
+                                cmd->group == GROUP_CURRENT ) && cmd->wait && ! isInPipeline( cmd ) );
+        if( cmd->elided || inShell || cmd->funcDef != NULL || strcmp( cmd->path, "exit" ) == 0 ) continue;
+        if( canRunStage( cmd ) ) ++stats->threads;
+        else ++stats->forks;
+    }
+}
+
+
+void printPlan( const cmd_t cmds[], int cmdCount )
+{
+    // Pour chaque commande
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        const cmd_t* cmd = cmds + i;
+
+        // Profondeur de la commande (nombre de groupes qui la contiennent)
+        int depth = 0;
+        for( int j = 0; j < i; ++j )
+        {
+            if( cmds[j].group != GROUP_NONE && cmd < cmds[j].groupEnd ) ++depth;
+        }
+
+        // Index et commande
+        printf( "  [%d] %*s%s", i, 2 * depth, "", cmd->path );
+        for( int iArg = 1; iArg < cmd->argc; ++iArg ) printf( " %s", cmd->argv[iArg] );
+        if( ! cmd->wait ) printf( " &" );
+        if( cmd->group != GROUP_NONE )
+        {
+            printf( " (commandes [%d..%d])", i + 1, (int)( cmd->groupEnd - cmds ) - 1 );
+        }
+
+        // Commande supprimee
+        if( cmd->elided )
+        {
+            printf( "  supprimee (code %d)", cmd->status );
+        }
+        else if( canRunStage( cmd ) )
+        {
+            printf( "  thread" );
+        }
+
+        // Redirections
+        printFd( "in", cmd->in, cmds, cmdCount );
+        printFd( "out", cmd->out, cmds, cmdCount );
+        for( int iOut = 0; iOut < cmd->fanoutCount; ++iOut ) printFd( "out", cmd->fanoutFds[iOut], cmds, cmdCount );
+        printFd( "err", cmd->err, cmds, cmdCount );
+        for( int iDup = 0; iDup < cmd->fddupCount; ++iDup )
+        {
+            const char* file = getDryRunFile( cmd->fddup[iDup][1] );
+            if( cmd->fddup[iDup][1] == FD_CLOSED ) printf( "  %d>&-", cmd->fddup[iDup][0] );
+            else if( file != NULL ) printf( "  %d>&%d(%s)", cmd->fddup[iDup][0], cmd->fddup[iDup][1], file );
+            else printf( "  %d>&%d", cmd->fddup[iDup][0], cmd->fddup[iDup][1] );
+        }
+
+        // Enchainements
+        if( cmd->next != NULL ) printLink( "->", cmd->next, cmds );
+        if( cmd->nextSuccess != NULL ) printLink( "succes->", cmd->nextSuccess, cmds );
+        if( cmd->nextFailure != NULL ) printLink( "echec->", cmd->nextFailure, cmds );
+        if( cmd->nextCmdLink == LINK_PIPE ) printf( "  |" );
+        printf( "\n" );
+    }
+
+    // Statistiques
+    PlanStats stats;
+    getPlanStats( cmds, cmdCount, &stats );
+    printf( "  pipes: %d, descripteurs: %d, processus: %d, threads: %d\n", stats.pipes, stats.fds, stats.forks,
+            stats.threads );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int elideCat( cmd_t* cmd )
+{
+    // "cat FICHIER" en debut de pipeline, dont la sortie (non redirigee) est le pipe
+    cmd_t* reader = cmd->nextSuccess;
+    if( strcmp( cmd->path, "cat" ) != 0 || isBuiltin( cmd->path ) || findFunction( cmd->path ) != NULL ||
+        cmd->group != GROUP_NONE ||
+        cmd->argc != 2 || cmd->argv[1][0] == '-' || cmd->fddupCount != 0 || cmd->pipePrev != NULL ||
+        cmd->nextCmdLink != LINK_PIPE || reader == NULL || reader->pipePrev != cmd || reader->fanoutCount != 0 ||
+        cmd->out != reader->fdpipe[1] || reader->in != reader->fdpipe[0] )
+    {
+        return( 0 );
+    }
+
+    // Si les 2 etapes s'executent dans des threads, la commande suivante, seule, devrait au contraire etre
+    // executee par un processus
+    if( canRunStage( cmd ) && canRunStage( reader ) && reader->nextCmdLink != LINK_PIPE ) return( 0 );
+
+    // Le fichier doit etre un fichier ordinaire (sinon, les erreurs de lecture seraient celles de la commande
+    // suivante, et non plus de cat). S'il ne peut pas etre ouvert, cat est execute et signale l'erreur.
+    const int fd = open( cmd->argv[1], O_RDONLY );
+    if( fd == -1 ) return( 0 );
+    struct stat fileStat;
+    if( fstat( fd, &fileStat ) == -1 || ! S_ISREG( fileStat.st_mode ) )
+    {
+        close( fd );
+        return( 0 );
+    }
+
+    // Le pipe est remplace par le fichier, a refermer apres l'execution comme les autres fichiers de redirection
+    close( reader->fdpipe[0] );
+    close( reader->fdpipe[1] );
+    reader->fdpipe[0] = -1;
+    reader->fdpipe[1] = -1;
+    reader->in = fd;
+    reader->pipePrev = NULL;
+    int index = 0;
+    while( reader->fdclose[index] != -1 ) ++index;
+    reader->fdclose[index] = fd;
+
+    // La commande cat n'est pas executee, et enchaine sur la commande suivante comme si elle avait reussi
+    cmd->elided = 1;
+    cmd->status = 0;
+    cmd->out = -1;
+    cmd->nextCmdLink = LINK_AND;
+
+    return( 1 );
+}
+
+
+static int dropDeadRedirections( cmd_t* cmd )
+{
+    // Nombre de redirections supprimees
+    int dropped = 0;
+
+    // Entree/sortie/erreur standards
+    int* stdFds[3] = { &cmd->in, &cmd->out, &cmd->err };
+    for( int fd = STDIN_FILENO; fd <= STDERR_FILENO; ++fd )
+    {
+        if( *stdFds[fd] != -1 && isOverwritten( cmd, fd, -1 ) )
+        {
+            *stdFds[fd] = -1;
+            ++dropped;
+        }
+    }
+
+    // Duplications, dans l'ordre de la ligne de commande
+    int i = 0;
+    while( i < cmd->fddupCount )
+    {
+        const int target = cmd->fddup[i][0];
+        const int source = cmd->fddup[i][1];
+        if( ( target == source && target <= STDERR_FILENO ) || isOverwritten( cmd, target, i ) )
+        {
+            // Suppression de la duplication
+            memmove( cmd->fddup + i, cmd->fddup + i + 1, ( cmd->fddupCount - i - 1 ) * sizeof( cmd->fddup[0] ) );
+            --cmd->fddupCount;
+            ++dropped;
+            continue;
+        }
+
+        // Duplication suivante
+        ++i;
+    }
+
+    return( dropped );
+}
+
+
+static int isOverwritten( const cmd_t* cmd, int fd, int position )
+{
+    // Pour chaque duplication suivante
+    for( int i = position + 1; i < cmd->fddupCount; ++i )
+    {
+        // Le descripteur est utilise avant d'etre ecrase
+        if( cmd->fddup[i][1] == fd ) return( 0 );
+
+        // Le descripteur est ecrase
+        if( cmd->fddup[i][0] == fd ) return( 1 );
+    }
+
+    return( 0 );
+}
+
+
+static int dropUnusedFiles( cmd_t* cmd )
+{
+    // Nombre de fichiers refermes
+    int dropped = 0;
+
+    // Pour chaque fichier ouvert par la commande
+    int i = 0;
+    while( i < MAX_CMD_SIZE && cmd->fdclose[i] != -1 )
+    {
+        if( ! isFdUsed( cmd, cmd->fdclose[i] ) )
+        {
+            // Fermeture du fichier, et suppression de la liste (qui reste terminee par -1)
+            close( cmd->fdclose[i] );
+            int last = i;
+            while( last + 1 < MAX_CMD_SIZE && cmd->fdclose[last + 1] != -1 ) ++last;
+            memmove( cmd->fdclose + i, cmd->fdclose + i + 1, ( last - i ) * sizeof( cmd->fdclose[0] ) );
+            cmd->fdclose[last] = -1;
+            ++dropped;
+            continue;
+        }
+
+        // Fichier suivant
+        ++i;
+    }
+
+    return( dropped );
+}
+
+
+static int isFdUsed( const cmd_t* cmd, int fd )
+{
+    // Entree/sortie/erreur standards
+    if( cmd->in == fd || cmd->out == fd || cmd->err == fd ) return( 1 );
+
+    // Duplications
+    for( int i = 0; i < cmd->fddupCount; ++i )
+    {
+        if( cmd->fddup[i][0] == fd || cmd->fddup[i][1] == fd ) return( 1 );
+    }
+
+    return( 0 );
+}
+
+
+static int foldConstant( cmd_t* cmd )
+{
+    // "true &&" ou "false ||", au premier plan et hors pipeline
+    const int isTrue = ( strcmp( cmd->path, "true" ) == 0 );
+    const int isFalse = ( strcmp( cmd->path, "false" ) == 0 );
+    if( ! ( ( isTrue && cmd->nextCmdLink == LINK_AND ) || ( isFalse && cmd->nextCmdLink == LINK_OR ) ) ||
+        isBuiltin( cmd->path ) || findFunction( cmd->path ) != NULL || cmd->group != GROUP_NONE || ! cmd->wait ||
+        isInPipeline( cmd ) )
+    {
+        return( 0 );
+    }
+
+    // La commande n'est pas executee, et enchaine directement sur la commande suivante
+    cmd->elided = 1;
+    cmd->status = ( isTrue ? 0 : 1 );
+
+    return( 1 );
+}
+
+
+static int isInPipeline( const cmd_t* cmd )
+{
+    return( cmd->pipePrev != NULL || cmd->nextCmdLink == LINK_PIPE );
+}
+
+
+static void printFd( const char* name, int fd, const cmd_t cmds[], int cmdCount )
+{
+    if( fd == -1 ) return;
+
+    // Recherche du descripteur parmi les pipes de la ligne de commande
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        if( fd == cmds[i].fdpipe[0] || fd == cmds[i].fdpipe[1] )
+        {
+            printf( "  %s=pipe(%d)", name, fd );
+            return;
+        }
+    }
+
+    // Fichier de redirection (dont le nom est connu pour une ligne analysee a blanc)
+    const char* file = getDryRunFile( fd );
+    if( file != NULL ) printf( "  %s=%d(%s)", name, fd, file );
+    else printf( "  %s=%d", name, fd );
+}
+
+
+static void printLink( const char* name, const cmd_t* next, const cmd_t cmds[] )
+{
+    printf( "  %s[%d]", name, (int)( next - cmds ) );
+}
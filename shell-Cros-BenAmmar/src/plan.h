@@ -0,0 +1,79 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Plan d'execution d'une ligne de commande : le tableau des commandes construit par parseCmd(), avec leurs
+ *  redirections et leurs enchainements.
+ *
+ *  Avant son execution, le plan est reecrit pour eviter des processus, pipes et duplications inutiles (option
+ *  "optimize") :
+ *  - "cat FICHIER | CMD" devient "CMD < FICHIER" (pour un fichier ordinaire)
+ *  - les redirections d'un descripteur ecrasees par une redirection ulterieure du meme descripteur (sans avoir
+ *    servi entre-temps), ainsi que les duplications d'un descripteur standard sur lui-meme, sont supprimees ; les
+ *    fichiers qu'elles avaient ouverts sont refermes ("CMD > a > b" cree a, comme bash, mais ne le garde pas
+ *    ouvert)
+ *  - "true &&" et "false ||" sont supprimes (leur code de retour est connu a l'avance)
+ *  Les commandes supprimees restent dans le tableau (pour ne pas modifier les enchainements), mais ne sont
+ *  pas executees.
+ *
+ *  La builtin 'explain' affiche le plan d'une ligne de commande, avant et apres optimisation, sans l'executer :
+ *  la ligne est analysee a blanc (voir setDryRunParse()), ses fichiers de redirection ne sont donc ni crees ni
+ *  tronques.
+ */
+
+#ifndef _PLAN_H_
+#define _PLAN_H_
+
+#include "cmd.h"
+
+
+// Statistiques d'un plan d'execution
+//
+// pipes : nombre de pipes crees
+// fds : nombre de descripteurs ouverts par le minishell (fichiers de redirection et pipes)
+// forks : nombre max de processus crees (si toutes les commandes sont executees)
+// threads : nombre d'etapes de pipeline executees dans des threads du minishell (voir stage.h)
+typedef struct
+{
+    int pipes;
+    int fds;
+    int forks;
+    int threads;
+} PlanStats;
+
+
+/*
+ * Optimise le plan d'execution d'une ligne de commande. Les fichiers ouverts par l'optimisation sont ajoutes
+ * aux fichiers a refermer des commandes.
+ *
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ * retourne le nombre de reecritures effectuees
+ */
+int optimizePlan( cmd_t cmds[], int cmdCount );
+
+/*
+ * Calcule les statistiques d'un plan d'execution
+ *
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ * stats : en sortie, statistiques du plan
+ */
+void getPlanStats( const cmd_t cmds[], int cmdCount, PlanStats* stats );
+
+/*
+ * Affiche un plan d'execution : une ligne par commande (avec ses redirections et ses enchainements), puis les
+ * statistiques du plan
+ *
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ */
+void printPlan( const cmd_t cmds[], int cmdCount );
+
+
+#endif // _PLAN_H_
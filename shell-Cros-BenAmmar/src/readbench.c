@@ -0,0 +1,255 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : lineread.h
+ *
+ *  Mesure de la lecture ligne par ligne de la builtin 'read' : la lecture par blocs (voir lineread.h) d'un fichier
+ *  ordinaire et d'un pipe du minishell est comparee a la lecture octet par octet. Un fichier d'un million de lignes
+ *  (par defaut) est genere, et le nombre de lignes et d'octets lus est verifie pour chaque mode de lecture.
+ *
+ *  Usage : minishell-readbench [-n LIGNES]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "lineread.h"
+
+
+// Codes d'erreur
+enum ReadbenchError
+{
+    READBENCH_OK = 0,           // Pas d'erreur
+    READBENCH_BAD_ARGS = 1,     // Erreur d'utilisation (arguments)
+    READBENCH_IO_ERROR,         // Creation ou lecture du fichier impossible
+    READBENCH_MISMATCH          // Lignes lues differentes des lignes ecrites
+};
+
+// Resultat d'une lecture : nombre de lignes et d'octets lus
+typedef struct
+{
+    long lines;
+    long bytes;
+} ReadResult;
+
+
+/*
+ * Retourne l'heure courante (horloge monotone) en nano-secondes
+ */
+static long long nowNs( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec * 1000000000LL + ts.tv_nsec );
+}
+
+
+/*
+ * Lecture de reference : ligne par ligne, octet par octet (comme un 'read' sans tampon)
+ */
+static int referenceReadLine( int fd, char* line, size_t size, size_t* length )
+{
+    *length = 0;
+    for( ;; )
+    {
+        char c = '\0';
+        const ssize_t count = read( fd, &c, 1 );
+        if( count <= 0 ) return( count == 0 ? LINEREAD_EOF : LINEREAD_IO_ERROR );
+        if( c == '\n' ) return( LINEREAD_OK );
+        if( *length + 1 < size ) line[( *length )++] = c;
+    }
+}
+
+
+/*
+ * Lit toutes les lignes d'un descripteur
+ *
+ * fd : le descripteur
+ * reference : vrai pour la lecture de reference, faux pour readInputLine()
+ * result : en sortie, nombre de lignes et d'octets lus
+ * retourne la duree de la lecture en nano-secondes, ou -1 en cas d'erreur
+ */
+static long long readAll( int fd, int reference, ReadResult* result )
+{
+    char line[1024];
+    size_t length = 0;
+    result->lines = 0;
+    result->bytes = 0;
+
+    const long long start = nowNs();
+    for( ;; )
+    {
+        const int status = ( reference ? referenceReadLine( fd, line, sizeof( line ), &length )
+                                       : readInputLine( fd, '\n', line, sizeof( line ), &length ) );
+        if( status == LINEREAD_IO_ERROR ) return( -1 );
+        if( status == LINEREAD_EOF ) break;
+        ++result->lines;
+        result->bytes += length;
+    }
+
+    return( nowNs() - start );
+}
+
+
+/*
+ * Lit toutes les lignes d'un fichier, transmis par un processus via un pipe
+ *
+ * path : le fichier
+ * shellPipe : vrai si le pipe est declare comme pipe du minishell (lecture par blocs)
+ * reference : vrai pour la lecture de reference
+ * result : en sortie, nombre de lignes et d'octets lus
+ * retourne la duree de la lecture en nano-secondes, ou -1 en cas d'erreur
+ */
+static long long readFromPipe( const char* path, int shellPipe, int reference, ReadResult* result )
+{
+    int pipeFD[2];
+    if( pipe( pipeFD ) == -1 ) return( -1 );
+    if( shellPipe ) addShellPipe( pipeFD[0] );
+
+    // Le processus ecrivain recopie le fichier dans le pipe
+    const pid_t pid = fork();
+    if( pid == 0 )
+    {
+        close( pipeFD[0] );
+        const int fd = open( path, O_RDONLY );
+        char buffer[65536];
+        ssize_t count = 0;
+        while( fd != -1 && ( count = read( fd, buffer, sizeof( buffer ) ) ) > 0 )
+        {
+            if( write( pipeFD[1], buffer, count ) != count ) break;
+        }
+        _exit( 0 );
+    }
+    close( pipeFD[1] );
+
+    const long long duration = ( pid != -1 ? readAll( pipeFD[0], reference, result ) : -1 );
+    close( pipeFD[0] );
+    if( pid != -1 ) waitpid( pid, NULL, 0 );
+
+    return( duration );
+}
+
+
+/*
+ * Genere le fichier de lignes mesure
+ *
+ * fd : descripteur du fichier
+ * lineCount : nombre de lignes
+ * expected : en sortie, nombre de lignes et d'octets (hors fins de ligne) ecrits
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int generateFile( int fd, long lineCount, ReadResult* expected )
+{
+    FILE* file = fdopen( dup( fd ), "w" );
+    if( file == NULL ) return( READBENCH_IO_ERROR );
+
+    expected->lines = lineCount;
+    expected->bytes = 0;
+    for( long i = 0; i < lineCount; ++i )
+    {
+        expected->bytes += fprintf( file, "%ld user_%ld /home/user_%ld %ld\n", i, i % 1000, i % 1000, i * 7 ) - 1;
+    }
+
+    return( fclose( file ) == 0 ? READBENCH_OK : READBENCH_IO_ERROR );
+}
+
+
+/*
+ * Affiche le resultat d'une mesure, et verifie les lignes lues
+ *
+ * name : nom du mode de lecture
+ * duration : duree de la lecture (ns)
+ * referenceNs : duree de la lecture de reference (ns), ou 0
+ * result : lignes et octets lus
+ * expected : lignes et octets attendus
+ * retourne 0 si les lignes lues sont correctes, sinon un code d'erreur
+ */
+static int report( const char* name, long long duration, long long referenceNs, const ReadResult* result,
+                   const ReadResult* expected )
+{
+    if( duration < 0 )
+    {
+        perror( "ERREUR - Lecture impossible" );
+        return( READBENCH_IO_ERROR );
+    }
+    if( result->lines != expected->lines || result->bytes != expected->bytes )
+    {
+        fprintf( stderr, "ERREUR - %s : %ld lignes, %ld octets lus (%ld lignes, %ld octets attendus)\n", name,
+                 result->lines, result->bytes, expected->lines, expected->bytes );
+        return( READBENCH_MISMATCH );
+    }
+
+    printf( "%-30s %8.1f ns/ligne", name, (double)duration / result->lines );
+    if( referenceNs > 0 ) printf( " (x%.1f)", (double)referenceNs / duration );
+    printf( "\n" );
+
+    return( READBENCH_OK );
+}
+
+
+/*
+ * Fonction principale du programme
+ */
+int main( int argc, char* argv[] )
+{
+    // Options
+    long lineCount = 1000000;
+    if( argc == 3 && strcmp( argv[1], "-n" ) == 0 ) lineCount = atol( argv[2] );
+    else if( argc != 1 ) lineCount = 0;
+    if( lineCount <= 0 )
+    {
+        fprintf( stderr, "Usage: %s [-n LIGNES]\n", argv[0] );
+        return( READBENCH_BAD_ARGS );
+    }
+
+    // Fichier mesure (supprime en fin de mesure)
+    char path[] = "/tmp/minishell-readbench-XXXXXX";
+    const int fd = mkstemp( path );
+    ReadResult expected;
+    if( fd == -1 || generateFile( fd, lineCount, &expected ) != READBENCH_OK )
+    {
+        perror( "ERREUR - Creation du fichier impossible" );
+        if( fd != -1 ) unlink( path );
+        return( READBENCH_IO_ERROR );
+    }
+    printf( "Fichier : %ld lignes, %ld octets\n", expected.lines, expected.bytes + expected.lines );
+
+    // Fichier ordinaire : reference, puis lecture par blocs
+    ReadResult result;
+    lseek( fd, 0, SEEK_SET );
+    const long long referenceNs = readAll( fd, 1, &result );
+    int status = report( "fichier, octet par octet", referenceNs, 0, &result, &expected );
+    if( status == READBENCH_OK )
+    {
+        lseek( fd, 0, SEEK_SET );
+        status = report( "fichier, par blocs", readAll( fd, 0, &result ), referenceNs, &result, &expected );
+    }
+
+    // Pipe : pipe inconnu (octet par octet), puis pipe du minishell (par blocs)
+    long long pipeNs = 0;
+    if( status == READBENCH_OK )
+    {
+        pipeNs = readFromPipe( path, 0, 0, &result );
+        status = report( "pipe, octet par octet", pipeNs, 0, &result, &expected );
+    }
+    if( status == READBENCH_OK )
+    {
+        status = report( "pipe du minishell, par blocs", readFromPipe( path, 1, 0, &result ), pipeNs, &result,
+                         &expected );
+    }
+
+    unlink( path );
+    close( fd );
+    return( status );
+}
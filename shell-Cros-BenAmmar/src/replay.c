@@ -0,0 +1,559 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : shell.h parser.h cmd.h ringbuf.h
+ *
+ *  Capture et rejeu des lignes de commande d'une session (implementation)
+ */
+
+#include "replay.h"
+#include "shell.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// En-tete d'un fichier de capture
+#define CAPTURE_MAGIC       "MSHCAP1\n"
+#define CAPTURE_MAGIC_SIZE  8
+
+// Types d'enregistrements (voir replay.h)
+#define RECORD_START        't'
+#define RECORD_CWD          'c'
+#define RECORD_SETENV       's'
+#define RECORD_UNSETENV     'u'
+#define RECORD_LINE         'l'
+
+// Taille max d'un entier code (64 bits, 7 bits par octet)
+#define MAX_VARINT_SIZE     10
+
+// Durees mesurees pendant un rejeu (une liste par mesure)
+//
+// values : durees, en nanosecondes
+// count : nombre de durees
+// capacity : taille allouee de la liste
+typedef struct
+{
+    int64_t* values;
+    size_t count;
+    size_t capacity;
+} SampleList;
+
+// Variables d'environnement
+
+extern char** environ;
+
+// Fichier de capture (ou NULL si la capture n'est pas active)
+static FILE* captureFile = NULL;
+
+// Heure de la derniere ligne capturee (horloge monotone, en nanosecondes)
+static int64_t lastCaptureTime = 0;
+
+// Repertoire courant lors de la derniere ligne capturee
+static char lastCaptureCwd[MAX_LINE_SIZE] = {'\0'};
+
+// Variables d'environnement lors de la derniere ligne capturee ("NOM=VALEUR")
+static char** envSnapshot = NULL;
+static int envSnapshotCount = 0;
+
+// Vrai si un rejeu est en cours
+static int replaying = 0;
+
+// Durees mesurees pendant le rejeu
+static SampleList samples[REPLAY_SAMPLE_LAST];
+
+// Duree de la mise en forme de la ligne en cours de rejeu (ajoutee a la duree de son parsing)
+static int64_t pendingFormatDuration = 0;
+
+/*
+ * Retourne l'heure courante d'une horloge, en nanosecondes
+ *
+ * clock : l'horloge (CLOCK_MONOTONIC ou CLOCK_REALTIME)
+ */
+static int64_t getTime( clockid_t clock );
+
+/*
+ * Ecrit un enregistrement dans le fichier de capture
+ *
+ * type : type de l'enregistrement
+ * prefix : entier ecrit au debut des donnees (ou -1 si pas d'entier)
+ * data : donnees de l'enregistrement
+ * length : longueur des donnees
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int writeRecord( char type, int64_t prefix, const char* data, size_t length );
+
+/*
+ * Ecrit les modifications des variables d'environnement depuis la derniere ligne capturee, et met a jour la
+ * copie des variables
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int writeEnvDiff( void );
+
+/*
+ * Teste si une variable d'environnement ("NOM=VALEUR") fait partie de la copie des variables
+ *
+ * var : la variable
+ * retourne 1 si la variable (avec la meme valeur) fait partie de la copie, sinon 0
+ */
+static int isInEnvSnapshot( const char* var );
+
+/*
+ * Code un entier sur un nombre variable d'octets
+ *
+ * value : l'entier (positif)
+ * buffer : en sortie, l'entier code (au plus MAX_VARINT_SIZE octets)
+ * retourne le nombre d'octets utilises
+ */
+static size_t encodeVarint( uint64_t value, unsigned char* buffer );
+
+/*
+ * Decode un entier code sur un nombre variable d'octets
+ *
+ * data : donnees a decoder
+ * length : longueur des donnees
+ * value : en sortie, l'entier decode
+ * retourne le nombre d'octets lus, ou 0 si les donnees sont incorrectes
+ */
+static size_t decodeVarint( const unsigned char* data, size_t length, uint64_t* value );
+
+/*
+ * Lit un enregistrement du fichier de capture
+ *
+ * file : le fichier
+ * type : en sortie, type de l'enregistrement
+ * data : buffer des donnees (agrandi si besoin, termine par un caractere nul)
+ * capacity : taille allouee du buffer
+ * length : en sortie, longueur des donnees
+ * retourne 1 si un enregistrement a ete lu, 0 en fin de fichier, ou -1 si le fichier est incorrect
+ */
+static int readRecord( FILE* file, char* type, char** data, size_t* capacity, size_t* length );
+
+/*
+ * Rejoue une ligne de commande
+ *
+ * shell : le moteur d'execution
+ * line : la ligne, telle que saisie
+ * failed : en sortie, vrai si la ligne est en erreur (parsing ou code de retour)
+ * retourne 1 si la ligne termine le rejeu ('exit'), sinon 0
+ */
+static int replayLine( Shell* shell, const char* line, int* failed );
+
+/*
+ * Comparaison de deux durees (pour qsort)
+ */
+static int compareDurations( const void* a, const void* b );
+
+/*
+ * Affiche les percentiles d'une liste de durees
+ *
+ * label : nom des durees
+ * list : les durees (triees par cette fonction)
+ */
+static void printPercentiles( const char* label, SampleList* list );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int startCapture( const char* path )
+{
+    captureFile = fopen( path, "wb" );
+    if( captureFile == NULL ) return( REPLAY_OPEN_FAILED );
+
+    // En-tete, et heure de debut de la capture
+    lastCaptureTime = getTime( CLOCK_MONOTONIC );
+    if( fwrite( CAPTURE_MAGIC, 1, CAPTURE_MAGIC_SIZE, captureFile ) != CAPTURE_MAGIC_SIZE ||
+        writeRecord( RECORD_START, getTime( CLOCK_REALTIME ) / 1000, "", 0 ) != REPLAY_OK ||
+        fflush( captureFile ) != 0 )
+    {
+        fclose( captureFile );
+        captureFile = NULL;
+        return( REPLAY_WRITE_FAILED );
+    }
+
+    return( REPLAY_OK );
+}
+
+
+int captureLine( const char* line )
+{
+    if( captureFile == NULL ) return( REPLAY_OK );
+
+    // Repertoire courant, s'il a change
+    char cwd[MAX_LINE_SIZE];
+    if( getcwd( cwd, sizeof( cwd ) ) != NULL && strcmp( cwd, lastCaptureCwd ) != 0 )
+    {
+        if( writeRecord( RECORD_CWD, -1, cwd, strlen( cwd ) ) != REPLAY_OK ) return( REPLAY_WRITE_FAILED );
+        strcpy( lastCaptureCwd, cwd );
+    }
+
+    // Modifications des variables d'environnement
+    if( writeEnvDiff() != REPLAY_OK ) return( REPLAY_WRITE_FAILED );
+
+    // Ligne, avec le delai depuis la ligne precedente (le fichier est vide a chaque ligne, pour ne rien perdre si
+    // le minishell est interrompu)
+    const int64_t now = getTime( CLOCK_MONOTONIC );
+    const int64_t delay = ( now - lastCaptureTime ) / 1000;
+    lastCaptureTime = now;
+    if( writeRecord( RECORD_LINE, delay, line, strlen( line ) ) != REPLAY_OK || fflush( captureFile ) != 0 )
+    {
+        return( REPLAY_WRITE_FAILED );
+    }
+
+    return( REPLAY_OK );
+}
+
+
+int runReplay( const char* path, int paced )
+{
+    FILE* file = fopen( path, "rb" );
+    if( file == NULL ) return( REPLAY_OPEN_FAILED );
+
+    // Verification de l'en-tete
+    char magic[CAPTURE_MAGIC_SIZE];
+    if( fread( magic, 1, CAPTURE_MAGIC_SIZE, file ) != CAPTURE_MAGIC_SIZE ||
+        memcmp( magic, CAPTURE_MAGIC, CAPTURE_MAGIC_SIZE ) != 0 )
+    {
+        fclose( file );
+        return( REPLAY_BAD_FILE );
+    }
+
+    // Moteur d'execution des lignes de commande
+    Shell shell;
+    initShell( &shell );
+    replaying = 1;
+
+    // Lecture des enregistrements
+    char* data = NULL;
+    size_t capacity = 0;
+    size_t length = 0;
+    char type = '\0';
+    int lineCount = 0;
+    int failureCount = 0;
+    int status = REPLAY_OK;
+    const int64_t start = getTime( CLOCK_MONOTONIC );
+    int64_t lineTime = start;
+    while( 1 )
+    {
+        const int result = readRecord( file, &type, &data, &capacity, &length );
+        if( result == 0 ) break;
+        if( result == -1 )
+        {
+            status = REPLAY_BAD_FILE;
+            break;
+        }
+
+        // Environnement de la ligne suivante
+        if( type == RECORD_CWD )
+        {
+            if( chdir( data ) == -1 ) fprintf( stderr, "ERREUR - Repertoire %s : %s\n", data, strerror( errno ) );
+        }
+        else if( type == RECORD_SETENV )
+        {
+            char* value = strchr( data, '=' );
+            if( value != NULL )
+            {
+                *value = '\0';
+                setenv( data, value + 1, 1 );
+            }
+        }
+        else if( type == RECORD_UNSETENV )
+        {
+            unsetenv( data );
+        }
+
+        // Ligne de commande
+        else if( type == RECORD_LINE )
+        {
+            uint64_t delay = 0;
+            const size_t delaySize = decodeVarint( (const unsigned char*)data, length, &delay );
+            if( delaySize == 0 )
+            {
+                status = REPLAY_BAD_FILE;
+                break;
+            }
+
+            // Au rythme d'origine, attente de l'heure de la ligne
+            lineTime += delay * 1000;
+            const int64_t wait = lineTime - getTime( CLOCK_MONOTONIC );
+            if( paced && wait > 0 )
+            {
+                const struct timespec duration = { wait / 1000000000, wait % 1000000000 };
+                nanosleep( &duration, NULL );
+            }
+
+            // Execution de la ligne
+            int failed = 0;
+            const int isExit = replayLine( &shell, data + delaySize, &failed );
+            if( isExit ) break;
+            ++lineCount;
+            failureCount += failed;
+        }
+    }
+    const double elapsed = ( getTime( CLOCK_MONOTONIC ) - start ) / 1e9;
+    replaying = 0;
+    free( data );
+    fclose( file );
+
+    // Statistiques
+    fflush( stdout );
+    printf( "Lignes         : %d (%d en erreur)\n", lineCount, failureCount );
+    printf( "Duree          : %.3f s\n", elapsed );
+    printf( "Debit          : %.1f lignes/s\n", elapsed > 0 ? lineCount / elapsed : 0.0 );
+    printPercentiles( "Parsing", samples + REPLAY_PARSE );
+    printPercentiles( "Lancement", samples + REPLAY_SPAWN );
+    for( int i = 0; i < REPLAY_SAMPLE_LAST; ++i )
+    {
+        free( samples[i].values );
+        memset( samples + i, 0, sizeof( SampleList ) );
+    }
+
+    return( status );
+}
+
+
+int64_t getReplayTime( void )
+{
+    return( replaying ? getTime( CLOCK_MONOTONIC ) : 0 );
+}
+
+
+void recordReplaySample( int sample, int64_t startTime )
+{
+    if( ! replaying || startTime == 0 ) return;
+
+    // Agrandissement eventuel de la liste
+    SampleList* list = samples + sample;
+    if( list->count == list->capacity )
+    {
+        const size_t capacity = ( list->capacity == 0 ? 1024 : list->capacity * 2 );
+        int64_t* values = (int64_t*)realloc( list->values, capacity * sizeof( int64_t ) );
+        if( values == NULL ) return;
+        list->values = values;
+        list->capacity = capacity;
+    }
+
+    // Duree (la mise en forme de la ligne fait partie du parsing)
+    int64_t duration = getTime( CLOCK_MONOTONIC ) - startTime;
+    if( sample == REPLAY_PARSE )
+    {
+        duration += pendingFormatDuration;
+        pendingFormatDuration = 0;
+    }
+    list->values[list->count++] = duration;
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static int64_t getTime( clockid_t clock )
+{
+    struct timespec ts;
+    clock_gettime( clock, &ts );
+    return( (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec );
+}
+
+
+static int writeRecord( char type, int64_t prefix, const char* data, size_t length )
+{
+    // Entier eventuel au debut des donnees
+    unsigned char prefixBytes[MAX_VARINT_SIZE];
+    const size_t prefixSize = ( prefix >= 0 ? encodeVarint( prefix, prefixBytes ) : 0 );
+
+    // Type, longueur des donnees, puis donnees
+    unsigned char header[1 + MAX_VARINT_SIZE];
+    header[0] = type;
+    const size_t headerSize = 1 + encodeVarint( prefixSize + length, header + 1 );
+    if( fwrite( header, 1, headerSize, captureFile ) != headerSize ||
+        fwrite( prefixBytes, 1, prefixSize, captureFile ) != prefixSize ||
+        fwrite( data, 1, length, captureFile ) != length )
+    {
+        return( REPLAY_WRITE_FAILED );
+    }
+
+    return( REPLAY_OK );
+}
+
+
+static int writeEnvDiff( void )
+{
+    // Variables ajoutees ou modifiees
+    int count = 0;
+    for( char** var = environ; *var != NULL; ++var, ++count )
+    {
+        if( ! isInEnvSnapshot( *var ) && writeRecord( RECORD_SETENV, -1, *var, strlen( *var ) ) != REPLAY_OK )
+        {
+            return( REPLAY_WRITE_FAILED );
+        }
+    }
+
+    // Variables supprimees
+    for( int i = 0; i < envSnapshotCount; ++i )
+    {
+        char name[MAX_LINE_SIZE];
+        const size_t nameLength = strcspn( envSnapshot[i], "=" );
+        if( nameLength >= sizeof( name ) ) continue;
+        memcpy( name, envSnapshot[i], nameLength );
+        name[nameLength] = '\0';
+        if( getenv( name ) == NULL && writeRecord( RECORD_UNSETENV, -1, name, nameLength ) != REPLAY_OK )
+        {
+            return( REPLAY_WRITE_FAILED );
+        }
+    }
+
+    // Nouvelle copie des variables
+    for( int i = 0; i < envSnapshotCount; ++i ) free( envSnapshot[i] );
+    free( envSnapshot );
+    envSnapshot = (char**)malloc( ( count + 1 ) * sizeof( char* ) );
+    envSnapshotCount = 0;
+    for( int i = 0; envSnapshot != NULL && i < count; ++i )
+    {
+        envSnapshot[envSnapshotCount] = strdup( environ[i] );
+        if( envSnapshot[envSnapshotCount] != NULL ) ++envSnapshotCount;
+    }
+
+    return( REPLAY_OK );
+}
+
+
+static int isInEnvSnapshot( const char* var )
+{
+    for( int i = 0; i < envSnapshotCount; ++i )
+    {
+        if( strcmp( envSnapshot[i], var ) == 0 ) return( 1 );
+    }
+
+    return( 0 );
+}
+
+
+static size_t encodeVarint( uint64_t value, unsigned char* buffer )
+{
+    // 7 bits par octet, le bit de poids fort indiquant qu'un octet suit
+    size_t size = 0;
+    do
+    {
+        buffer[size] = value & 0x7F;
+        value >>= 7;
+        if( value != 0 ) buffer[size] |= 0x80;
+        ++size;
+    }
+    while( value != 0 );
+
+    return( size );
+}
+
+
+static size_t decodeVarint( const unsigned char* data, size_t length, uint64_t* value )
+{
+    *value = 0;
+    for( size_t i = 0; i < length && i < MAX_VARINT_SIZE; ++i )
+    {
+        *value |= (uint64_t)( data[i] & 0x7F ) << ( 7 * i );
+        if( ( data[i] & 0x80 ) == 0 ) return( i + 1 );
+    }
+
+    // Entier incomplet
+    return( 0 );
+}
+
+
+static int readRecord( FILE* file, char* type, char** data, size_t* capacity, size_t* length )
+{
+    // Type (fin de fichier normale avant un enregistrement)
+    const int c = fgetc( file );
+    if( c == EOF ) return( 0 );
+    *type = c;
+
+    // Longueur des donnees
+    unsigned char lengthBytes[MAX_VARINT_SIZE];
+    size_t lengthSize = 0;
+    do
+    {
+        const int byte = fgetc( file );
+        if( byte == EOF ) return( -1 );
+        lengthBytes[lengthSize++] = byte;
+    }
+    while( ( lengthBytes[lengthSize - 1] & 0x80 ) != 0 && lengthSize < MAX_VARINT_SIZE );
+    uint64_t recordLength = 0;
+    if( decodeVarint( lengthBytes, lengthSize, &recordLength ) == 0 || recordLength > 16 * 1024 * 1024 ) return( -1 );
+
+    // Donnees (terminees par un caractere nul)
+    if( recordLength + 1 > *capacity )
+    {
+        char* buffer = (char*)realloc( *data, recordLength + 1 );
+        if( buffer == NULL ) return( -1 );
+        *data = buffer;
+        *capacity = recordLength + 1;
+    }
+    if( fread( *data, 1, recordLength, file ) != recordLength ) return( -1 );
+    ( *data )[recordLength] = '\0';
+    *length = recordLength;
+
+    return( 1 );
+}
+
+
+static int replayLine( Shell* shell, const char* line, int* failed )
+{
+    *failed = 0;
+
+    // Mise en forme de la ligne (comme lors de la saisie)
+    char cmdLine[MAX_LINE_SIZE];
+    snprintf( cmdLine, sizeof( cmdLine ), "%s", line );
+    const int64_t formatStart = getTime( CLOCK_MONOTONIC );
+    if( formatCmdLine( cmdLine ) != PARSER_OK )
+    {
+        *failed = 1;
+        return( 0 );
+    }
+    pendingFormatDuration = getTime( CLOCK_MONOTONIC ) - formatStart;
+    if( strlen( cmdLine ) == 0 ) return( 0 );
+
+    // La commande 'exit' termine le rejeu (et non le minishell, pour afficher les statistiques)
+    if( strcmp( cmdLine, "exit" ) == 0 || strncmp( cmdLine, "exit ", 5 ) == 0 ) return( 1 );
+
+    // Decoupage, parsing et execution
+    int cmdStatus = 0;
+    const int status = runCmdLine( shell, cmdLine, &cmdStatus );
+    *failed = ( status != 0 || cmdStatus != 0 );
+
+    return( 0 );
+}
+
+
+static int compareDurations( const void* a, const void* b )
+{
+    const int64_t da = *(const int64_t*)a;
+    const int64_t db = *(const int64_t*)b;
+    return( da < db ? -1 : ( da > db ? 1 : 0 ) );
+}
+
+
+static void printPercentiles( const char* label, SampleList* list )
+{
+    if( list->count == 0 )
+    {
+        printf( "%-9s (us) : aucune mesure\n", label );
+        return;
+    }
+
+    const size_t count = list->count;
+    qsort( list->values, count, sizeof( int64_t ), compareDurations );
+    printf( "%-9s (us) : p50 = %.1f, p90 = %.1f, p99 = %.1f, max = %.1f (%zu mesures)\n", label,
+            list->values[count / 2] / 1e3, list->values[count * 9 / 10] / 1e3, list->values[count * 99 / 100] / 1e3,
+            list->values[count - 1] / 1e3, count );
+}
@@ -0,0 +1,94 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Capture et rejeu des lignes de commande d'une session, pour mesurer les performances du minishell sur un
+ *  trafic reel et reproductible.
+ *
+ *  En mode capture (option --capture FICHIER), chaque ligne saisie est enregistree telle que recue, avec son
+ *  heure, le repertoire courant et les modifications des variables d'environnement depuis la ligne precedente.
+ *  En mode rejeu (option --replay FICHIER), les lignes sont re-executees par le moteur du minishell, le plus
+ *  vite possible ou au rythme d'origine, puis le debit (lignes/s) et les percentiles de latence du parsing et
+ *  du lancement des commandes sont affiches.
+ *
+ *  Format du fichier (binaire) : l'en-tete "MSHCAP1\n", puis une suite d'enregistrements composes d'un type (un
+ *  octet), de la longueur des donnees et des donnees. Les entiers (longueurs, heures) sont codes sur un nombre
+ *  variable d'octets (7 bits par octet, le bit de poids fort indiquant qu'un octet suit).
+ *  - 't' : heure de debut de la capture, en microsecondes depuis le 01/01/1970 (un entier)
+ *  - 'c' : nouveau repertoire courant
+ *  - 's' : variable d'environnement ajoutee ou modifiee ("NOM=VALEUR")
+ *  - 'u' : variable d'environnement supprimee ("NOM")
+ *  - 'l' : ligne de commande : delai depuis la ligne precedente (ou le debut de la capture), en microsecondes
+ *          (un entier), puis la ligne
+ */
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdint.h>
+
+
+// Codes d'erreur
+enum ReplayError
+{
+    REPLAY_OK = 0,              // Pas d'erreur
+    REPLAY_OPEN_FAILED = 160,   // Impossible d'ouvrir le fichier de capture
+    REPLAY_WRITE_FAILED,        // Echec d'ecriture du fichier de capture
+    REPLAY_BAD_FILE             // Fichier de capture incorrect
+};
+
+// Durees mesurees pendant un rejeu
+enum ReplaySample
+{
+    REPLAY_PARSE = 0,           // Mise en forme, decoupage et parsing d'une ligne
+    REPLAY_SPAWN,               // Lancement d'une commande (creation de son processus ou de son thread)
+    REPLAY_SAMPLE_LAST          // Marque la derniere mesure
+};
+
+
+/*
+ * Active la capture des lignes de commande
+ *
+ * path : chemin du fichier de capture (cree ou ecrase)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int startCapture( const char* path );
+
+/*
+ * Enregistre une ligne de commande saisie (rien n'est fait si la capture n'est pas active)
+ *
+ * line : la ligne, telle que saisie
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int captureLine( const char* line );
+
+/*
+ * Rejoue les lignes d'un fichier de capture, puis affiche les statistiques du rejeu
+ *
+ * path : chemin du fichier de capture
+ * paced : si vrai, les lignes sont rejouees au rythme d'origine, sinon le plus vite possible
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int runReplay( const char* path, int paced );
+
+/*
+ * Retourne l'heure courante (horloge monotone, en nanosecondes) pour mesurer une duree, ou 0 si aucun rejeu
+ * n'est en cours
+ */
+int64_t getReplayTime( void );
+
+/*
+ * Enregistre une duree mesuree pendant un rejeu (rien n'est fait si aucun rejeu n'est en cours)
+ *
+ * sample : la mesure (ReplaySample)
+ * startTime : heure de debut de la mesure (voir getReplayTime())
+ */
+void recordReplaySample( int sample, int64_t startTime );
+
+
+#endif // _REPLAY_H_
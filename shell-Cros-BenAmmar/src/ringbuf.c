@@ -0,0 +1,133 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances :
+ *
+ *  Buffer circulaire de taille fixe (implementation)
+ */
+
+#include "ringbuf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Ecrit la totalite d'une zone memoire sur un descripteur
+ *
+ * fd : descripteur de destination
+ * data : donnees a ecrire
+ * length : nombre d'octets a ecrire
+ */
+static void writeAll( int fd, const char* data, size_t length );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+RingBuffer* createRingBuffer( size_t capacity )
+{
+    // Allocation de la structure et de sa zone memoire
+    RingBuffer* ring = (RingBuffer*)malloc( sizeof( RingBuffer ) );
+    if( ring == NULL ) return( NULL );
+    ring->data = (char*)malloc( capacity );
+    if( ring->data == NULL )
+    {
+        free( ring );
+        return( NULL );
+    }
+
+    // Buffer vide
+    ring->capacity = capacity;
+    ring->start = 0;
+    ring->length = 0;
+    ring->dropped = 0;
+
+    return( ring );
+}
+
+
+void freeRingBuffer( RingBuffer* ring )
+{
+    if( ring == NULL ) return;
+    free( ring->data );
+    free( ring );
+}
+
+
+void writeRingBuffer( RingBuffer* ring, const char* data, size_t length )
+{
+    // Si les donnees sont plus grandes que le buffer, seule leur fin est conservee
+    if( length > ring->capacity )
+    {
+        ring->dropped += ring->length + length - ring->capacity;
+        data += length - ring->capacity;
+        length = ring->capacity;
+        ring->start = 0;
+        ring->length = 0;
+    }
+
+    // Si besoin, on libere de la place en ecrasant les octets les plus anciens
+    const size_t freeSpace = ring->capacity - ring->length;
+    if( length > freeSpace )
+    {
+        const size_t overwritten = length - freeSpace;
+        ring->start = ( ring->start + overwritten ) % ring->capacity;
+        ring->length -= overwritten;
+        ring->dropped += overwritten;
+    }
+
+    // Copie des donnees apres le plus recent octet (en deux fois si on atteint la fin de la zone memoire)
+    const size_t end = ( ring->start + ring->length ) % ring->capacity;
+    const size_t firstPart = ( length < ring->capacity - end ? length : ring->capacity - end );
+    memcpy( ring->data + end, data, firstPart );
+    memcpy( ring->data, data + firstPart, length - firstPart );
+    ring->length += length;
+}
+
+
+int fillRingBuffer( RingBuffer* ring, int fd )
+{
+    // Lecture tant que des donnees sont disponibles
+    char buff[4096];
+    while( 1 )
+    {
+        const ssize_t length = read( fd, buff, sizeof( buff ) );
+        if( length > 0 ) writeRingBuffer( ring, buff, length );
+        else if( length == 0 ) return( 1 );
+        else if( errno != EINTR ) return( 0 );
+    }
+}
+
+
+void dumpRingBuffer( const RingBuffer* ring, int fd )
+{
+    // Ecriture en deux fois si les donnees atteignent la fin de la zone memoire
+    const size_t firstPart = ( ring->length < ring->capacity - ring->start ? ring->length : ring->capacity - ring->start );
+    writeAll( fd, ring->data + ring->start, firstPart );
+    writeAll( fd, ring->data, ring->length - firstPart );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void writeAll( int fd, const char* data, size_t length )
+{
+    while( length > 0 )
+    {
+        const ssize_t written = write( fd, data, length );
+        if( written == -1 && errno == EINTR ) continue;
+        if( written <= 0 ) return;
+        data += written;
+        length -= written;
+    }
+}
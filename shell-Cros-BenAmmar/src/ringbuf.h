@@ -0,0 +1,82 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Buffer circulaire de taille fixe : lorsque le buffer est plein, les octets les plus anciens sont ecrases
+ *  par les nouveaux (seule la fin des donnees ecrites est conservee).
+ */
+
+#ifndef _RINGBUF_H_
+#define _RINGBUF_H_
+
+#include <stddef.h>
+
+
+/*
+ * Structure de donnees associee a un buffer circulaire
+ *
+ * data : zone memoire du buffer
+ * capacity : taille de la zone memoire
+ * start : index du plus ancien octet conserve
+ * length : nombre d'octets conserves
+ * dropped : nombre d'octets ecrases depuis la creation du buffer
+ */
+typedef struct
+{
+    char* data;
+    size_t capacity;
+    size_t start;
+    size_t length;
+    size_t dropped;
+} RingBuffer;
+
+
+/*
+ * Cree un buffer circulaire vide
+ *
+ * capacity : taille du buffer (en octets)
+ * retourne le buffer cree, ou NULL en cas d'erreur d'allocation
+ */
+RingBuffer* createRingBuffer( size_t capacity );
+
+/*
+ * Detruit un buffer circulaire
+ *
+ * ring : buffer a detruire (peut etre NULL)
+ */
+void freeRingBuffer( RingBuffer* ring );
+
+/*
+ * Ajoute des donnees dans le buffer (les plus anciennes sont ecrasees si besoin)
+ *
+ * ring : le buffer
+ * data : donnees a ajouter
+ * length : nombre d'octets a ajouter
+ */
+void writeRingBuffer( RingBuffer* ring, const char* data, size_t length );
+
+/*
+ * Lit en une fois, sans attente, toutes les donnees disponibles sur un descripteur non-bloquant et les
+ * ajoute dans le buffer.
+ *
+ * ring : le buffer
+ * fd : descripteur a lire (en mode non-bloquant)
+ * retourne 1 si la fin de fichier a ete atteinte, 0 sinon
+ */
+int fillRingBuffer( RingBuffer* ring, int fd );
+
+/*
+ * Ecrit le contenu du buffer (du plus ancien au plus recent octet) sur un descripteur
+ *
+ * ring : le buffer
+ * fd : descripteur de destination
+ */
+void dumpRingBuffer( const RingBuffer* ring, int fd );
+
+
+#endif // _RINGBUF_H_
@@ -0,0 +1,318 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : parser.h
+ *
+ *  Classification des caracteres d'une ligne de commande (implementation)
+ */
+
+#include "scan.h"
+
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Classes de caracteres (voir ScanMask)
+#define CLASS_BLANK         0x01
+#define CLASS_SPACE         0x02
+#define CLASS_SEPARATOR     0x04
+#define CLASS_DOLLAR        0x08
+
+// Classe de chaque caractere, pour la classification caractere par caractere
+static const unsigned char CHAR_CLASSES[256] =
+{
+    [' '] = CLASS_BLANK | CLASS_SPACE,
+    ['\t'] = CLASS_BLANK,
+    [';'] = CLASS_SEPARATOR,
+    ['|'] = CLASS_SEPARATOR,
+    ['&'] = CLASS_SEPARATOR,
+    ['<'] = CLASS_SEPARATOR,
+    ['>'] = CLASS_SEPARATOR,
+    ['('] = CLASS_SEPARATOR,
+    [')'] = CLASS_SEPARATOR,
+    ['$'] = CLASS_DOLLAR
+};
+
+// Fonction de classification d'un jeu d'instructions : classe un bloc de 64 caracteres, dont les bits forment
+// le mot 'word' des masques
+typedef void (*ScanChunk)( const char* chunk, size_t word, ScanMask* mask );
+
+// Jeu d'instructions courant, et choix (unique) du jeu d'instructions par defaut. Les passes du parsing peuvent
+// s'executer dans plusieurs threads (etapes de pipeline, moteur integre)
+static atomic_int scanMode = SCAN_SCALAR;
+static pthread_once_t scanModeOnce = PTHREAD_ONCE_INIT;
+
+/*
+ * Choisit le jeu d'instructions le plus rapide disponible (appelee une seule fois, via pthread_once())
+ */
+static void initScanMode( void );
+
+/*
+ * Classe un bloc de caracteres un par un
+ */
+static void scanScalar( const char* chunk, size_t word, ScanMask* mask );
+
+#ifdef SCAN_X86
+/*
+ * Classe un bloc de caracteres 16 par 16 (SSE2)
+ */
+static void scanSse2( const char* chunk, size_t word, ScanMask* mask );
+
+/*
+ * Classe un bloc de caracteres 32 par 32 (AVX2)
+ */
+static void scanAvx2( const char* chunk, size_t word, ScanMask* mask );
+#endif
+
+/*
+ * Teste si un jeu d'instructions est disponible sur le processeur
+ *
+ * mode : le jeu d'instructions (ScanMode)
+ * retourne 1 si le jeu d'instructions est disponible, sinon 0
+ */
+static int isScanModeSupported( int mode );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+void scanLine( const char* str, size_t length, ScanMask* mask )
+{
+    // Fonction de classification du jeu d'instructions
+    const int mode = getScanMode();
+    ScanChunk scanChunk = scanScalar;
+#ifdef SCAN_X86
+    if( mode == SCAN_SSE2 ) scanChunk = scanSse2;
+    else if( mode == SCAN_AVX2 ) scanChunk = scanAvx2;
+#else
+    (void)mode;
+#endif
+
+    // Classification des blocs complets (chaque bloc donne un mot complet des masques : ils n'ont pas besoin
+    // d'etre initialises)
+    if( length > MAX_LINE_SIZE - 1 ) length = MAX_LINE_SIZE - 1;
+    mask->length = length;
+    size_t word = 0;
+    for( ; ( word + 1 ) * 64 <= length; ++word ) scanChunk( str + word * 64, word, mask );
+
+    // Le dernier bloc, incomplet, est complete par des caracteres nuls (qui n'appartiennent a aucune classe)
+    if( word * 64 < length )
+    {
+        char last[64] = { '\0' };
+        memcpy( last, str + word * 64, length - word * 64 );
+        scanChunk( last, word, mask );
+    }
+}
+
+
+size_t nextScanBit( const uint64_t bits[], size_t from, size_t length )
+{
+    if( from >= length ) return( length );
+
+    // Bits du premier mot, a partir de la position de depart
+    size_t word = from / 64;
+    uint64_t current = bits[word] & ( ~0ULL << ( from % 64 ) );
+
+    // Mots suivants, jusqu'au premier bit leve
+    while( current == 0 )
+    {
+        if( ++word * 64 >= length ) return( length );
+        current = bits[word];
+    }
+
+    const size_t position = word * 64 + __builtin_ctzll( current );
+    return( position < length ? position : length );
+}
+
+
+size_t nextScanGap( const uint64_t bits[], size_t from, size_t length )
+{
+    if( from >= length ) return( length );
+
+    // Meme recherche que nextScanBit(), sur le complement du masque
+    size_t word = from / 64;
+    uint64_t current = ~bits[word] & ( ~0ULL << ( from % 64 ) );
+    while( current == 0 )
+    {
+        if( ++word * 64 >= length ) return( length );
+        current = ~bits[word];
+    }
+
+    const size_t position = word * 64 + __builtin_ctzll( current );
+    return( position < length ? position : length );
+}
+
+
+int getScanMode( void )
+{
+    // Au premier appel, choix du jeu d'instructions le plus rapide disponible
+    pthread_once( &scanModeOnce, initScanMode );
+    return( atomic_load_explicit( &scanMode, memory_order_relaxed ) );
+}
+
+
+int setScanMode( int mode )
+{
+    if( mode < 0 || mode >= SCAN_LAST || ! isScanModeSupported( mode ) ) return( SCAN_UNSUPPORTED );
+
+    // Le choix par defaut ne doit pas remplacer ensuite le jeu d'instructions demande
+    pthread_once( &scanModeOnce, initScanMode );
+    atomic_store_explicit( &scanMode, mode, memory_order_relaxed );
+
+    return( SCAN_OK );
+}
+
+
+const char* getScanModeName( int mode )
+{
+    static const char* NAMES[SCAN_LAST] = { "scalar", "sse2", "avx2" };
+    return( mode >= 0 && mode < SCAN_LAST ? NAMES[mode] : "?" );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void initScanMode( void )
+{
+    // Du jeu d'instructions le plus recent au plus ancien
+    int mode = SCAN_LAST - 1;
+    while( mode > SCAN_SCALAR && ! isScanModeSupported( mode ) ) --mode;
+    atomic_store_explicit( &scanMode, mode, memory_order_relaxed );
+}
+
+
+static void scanScalar( const char* chunk, size_t word, ScanMask* mask )
+{
+    uint64_t blanks = 0;
+    uint64_t spaces = 0;
+    uint64_t separators = 0;
+    uint64_t dollars = 0;
+    for( int i = 0; i < 64; ++i )
+    {
+        // Classe du caractere (la plupart n'appartiennent a aucune classe)
+        const unsigned char classes = CHAR_CLASSES[(unsigned char)chunk[i]];
+        if( classes == 0 ) continue;
+
+        // Bit du caractere dans les masques de ses classes
+        const uint64_t bit = 1ULL << i;
+        if( classes & CLASS_BLANK ) blanks |= bit;
+        if( classes & CLASS_SPACE ) spaces |= bit;
+        if( classes & CLASS_SEPARATOR ) separators |= bit;
+        if( classes & CLASS_DOLLAR ) dollars |= bit;
+    }
+
+    mask->blanks[word] = blanks;
+    mask->spaces[word] = spaces;
+    mask->separators[word] = separators;
+    mask->dollars[word] = dollars;
+}
+
+
+#ifdef SCAN_X86
+__attribute__(( target( "sse2" ) ))
+static void scanSse2( const char* chunk, size_t word, ScanMask* mask )
+{
+    uint64_t blanks = 0;
+    uint64_t spaces = 0;
+    uint64_t separators = 0;
+    uint64_t dollars = 0;
+    for( int i = 0; i < 64; i += 16 )
+    {
+        const __m128i chars = _mm_loadu_si128( (const __m128i*)( chunk + i ) );
+
+        // Comparaison des 16 caracteres avec chaque caractere des classes
+        const __m128i isSpace = _mm_cmpeq_epi8( chars, _mm_set1_epi8( ' ' ) );
+        const __m128i isBlank = _mm_or_si128( isSpace, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\t' ) ) );
+        __m128i isSeparator = _mm_cmpeq_epi8( chars, _mm_set1_epi8( ';' ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '|' ) ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '&' ) ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '<' ) ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '>' ) ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( '(' ) ) );
+        isSeparator = _mm_or_si128( isSeparator, _mm_cmpeq_epi8( chars, _mm_set1_epi8( ')' ) ) );
+        const __m128i isDollar = _mm_cmpeq_epi8( chars, _mm_set1_epi8( '$' ) );
+
+        // Un bit par caractere
+        blanks |= (uint64_t)(uint16_t)_mm_movemask_epi8( isBlank ) << i;
+        spaces |= (uint64_t)(uint16_t)_mm_movemask_epi8( isSpace ) << i;
+        separators |= (uint64_t)(uint16_t)_mm_movemask_epi8( isSeparator ) << i;
+        dollars |= (uint64_t)(uint16_t)_mm_movemask_epi8( isDollar ) << i;
+    }
+
+    mask->blanks[word] = blanks;
+    mask->spaces[word] = spaces;
+    mask->separators[word] = separators;
+    mask->dollars[word] = dollars;
+}
+
+
+__attribute__(( target( "avx2" ) ))
+static void scanAvx2( const char* chunk, size_t word, ScanMask* mask )
+{
+    uint64_t blanks = 0;
+    uint64_t spaces = 0;
+    uint64_t separators = 0;
+    uint64_t dollars = 0;
+    for( int i = 0; i < 64; i += 32 )
+    {
+        const __m256i chars = _mm256_loadu_si256( (const __m256i*)( chunk + i ) );
+
+        // Comparaison des 32 caracteres avec chaque caractere des classes
+        const __m256i isSpace = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ' ' ) );
+        const __m256i isBlank = _mm256_or_si256( isSpace, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\t' ) ) );
+        __m256i isSeparator = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ';' ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '|' ) ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '&' ) ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '<' ) ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '>' ) ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '(' ) ) );
+        isSeparator = _mm256_or_si256( isSeparator, _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ')' ) ) );
+        const __m256i isDollar = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '$' ) );
+
+        // Un bit par caractere
+        blanks |= (uint64_t)(uint32_t)_mm256_movemask_epi8( isBlank ) << i;
+        spaces |= (uint64_t)(uint32_t)_mm256_movemask_epi8( isSpace ) << i;
+        separators |= (uint64_t)(uint32_t)_mm256_movemask_epi8( isSeparator ) << i;
+        dollars |= (uint64_t)(uint32_t)_mm256_movemask_epi8( isDollar ) << i;
+    }
+
+    mask->blanks[word] = blanks;
+    mask->spaces[word] = spaces;
+    mask->separators[word] = separators;
+    mask->dollars[word] = dollars;
+}
+#endif
+
+
+static int isScanModeSupported( int mode )
+{
+    switch( mode )
+    {
+        case SCAN_SCALAR:
+            return( 1 );
+
+#ifdef SCAN_X86
+        // Instructions detectees par CPUID
+        case SCAN_SSE2:
+            return( __builtin_cpu_supports( "sse2" ) );
+        case SCAN_AVX2:
+            return( __builtin_cpu_supports( "avx2" ) );
+#endif
+
+        default:
+            return( 0 );
+    }
+}
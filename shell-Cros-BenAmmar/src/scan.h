@@ -0,0 +1,116 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Classification des caracteres d'une ligne de commande, utilisee par les passes du parsing (clean(),
+ *  showSeparators(), substEnv()) pour sauter directement d'un caractere significatif au suivant.
+ *
+ *  La ligne est classee en une seule passe, par blocs de 64 caracteres (un mot de chaque masque), eux-memes
+ *  traites 32 caracteres a la fois (AVX2), 16 caracteres a la fois (SSE2), ou caractere par caractere sur les
+ *  processeurs qui ne disposent pas de ces instructions. Le jeu d'instructions est choisi a l'execution (CPUID),
+ *  une seule fois. Pour chaque classe de caracteres, le resultat est un masque de bits : le bit i est leve si le
+ *  caractere i de la ligne appartient a la classe.
+ */
+
+#ifndef _SCAN_H_
+#define _SCAN_H_
+
+#include "parser.h"
+
+#include <stdint.h>
+
+
+// Nombre de mots de 64 bits d'un masque (un bit par caractere d'une ligne)
+#define SCAN_WORDS      ( ( MAX_LINE_SIZE + 63 ) / 64 )
+
+// Code d'erreur
+enum ScanError
+{
+    SCAN_OK = 0,                // Pas d'erreur
+    SCAN_UNSUPPORTED = 150      // Jeu d'instructions non disponible sur ce processeur
+};
+
+// Jeux d'instructions utilisables pour la classification
+enum ScanMode
+{
+    SCAN_SCALAR = 0,            // Caractere par caractere
+    SCAN_SSE2,                  // Par blocs de 16 caracteres
+    SCAN_AVX2,                  // Par blocs de 32 caracteres
+    SCAN_LAST                   // Marque le dernier jeu d'instructions
+};
+
+// Masques des classes de caracteres d'une ligne :
+// - blanks : espaces et tabulations
+// - spaces : espaces
+// - separators : premiers caracteres des separateurs (";", "|", "&", "<", ">", "(", ")"). Les parentheses n'y sont
+//   que des candidats : leur role depend de leur position dans la ligne (voir showSeparators())
+// - dollars : debuts de variables d'environnement ("$")
+// - length : longueur de la ligne classee
+typedef struct
+{
+    uint64_t blanks[SCAN_WORDS];
+    uint64_t spaces[SCAN_WORDS];
+    uint64_t separators[SCAN_WORDS];
+    uint64_t dollars[SCAN_WORDS];
+    size_t length;
+} ScanMask;
+
+
+/*
+ * Classe les caracteres d'une ligne
+ *
+ * str : la ligne (au plus MAX_LINE_SIZE - 1 caracteres)
+ * length : longueur de la ligne
+ * mask : en sortie, masques des classes de caracteres
+ */
+void scanLine( const char* str, size_t length, ScanMask* mask );
+
+/*
+ * Recherche le prochain caractere d'une classe
+ *
+ * bits : masque de la classe (un des masques d'un ScanMask)
+ * from : position de depart de la recherche
+ * length : longueur de la ligne
+ * retourne la position du premier caractere de la classe a partir de 'from', ou 'length' s'il n'y en a pas
+ */
+size_t nextScanBit( const uint64_t bits[], size_t from, size_t length );
+
+/*
+ * Recherche le prochain caractere qui n'appartient pas a une classe
+ *
+ * bits : masque de la classe (un des masques d'un ScanMask)
+ * from : position de depart de la recherche
+ * length : longueur de la ligne
+ * retourne la position du premier caractere hors de la classe a partir de 'from', ou 'length' s'il n'y en a pas
+ */
+size_t nextScanGap( const uint64_t bits[], size_t from, size_t length );
+
+/*
+ * Retourne le jeu d'instructions utilise pour la classification (ScanMode). Avec SCAN_SCALAR, les passes du
+ * parsing n'utilisent pas la classification : elles parcourent la ligne caractere par caractere, ce qui est plus
+ * rapide que la classification sans instructions vectorielles.
+ */
+int getScanMode( void );
+
+/*
+ * Choisit le jeu d'instructions utilise pour la classification (par defaut, le plus rapide disponible)
+ *
+ * mode : le jeu d'instructions (ScanMode)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int setScanMode( int mode );
+
+/*
+ * Retourne le nom d'un jeu d'instructions ("scalar", "sse2", "avx2")
+ *
+ * mode : le jeu d'instructions (ScanMode)
+ */
+const char* getScanModeName( int mode );
+
+
+#endif // _SCAN_H_
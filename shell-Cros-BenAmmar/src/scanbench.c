@@ -0,0 +1,405 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : parser.h scan.h
+ *
+ *  Mesure des passes de formatage d'une ligne de commande (clean(), showSeparators(), substEnv()) : les passes
+ *  pilotees par les masques de classification (avec chaque jeu d'instructions disponible) sont comparees aux
+ *  passes d'origine, qui parcourent la ligne caractere par caractere. Les resultats des passes sont verifies.
+ *  Sans instructions vectorielles ("scalar"), les passes du parsing parcourent elles aussi la ligne caractere par
+ *  caractere (voir getScanMode()) : la ligne "scalar" mesure donc ces passes.
+ *
+ *  Usage : minishell-scanbench [-n ITERATIONS] [LIGNE]
+ *  (sans LIGNE, une longue ligne generee, comparable a celles produites par programme, est utilisee)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "parser.h"
+#include "scan.h"
+
+
+// Codes d'erreur
+enum ScanbenchError
+{
+    SCANBENCH_OK = 0,           // Pas d'erreur
+    SCANBENCH_BAD_ARGS = 1,     // Erreur d'utilisation (arguments)
+    SCANBENCH_MISMATCH          // Resultat different de celui des passes de reference
+};
+
+
+/*
+ * Retourne l'heure courante (horloge monotone) en nano-secondes
+ */
+static long long nowNs( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( ts.tv_sec * 1000000000LL + ts.tv_nsec );
+}
+
+
+/*
+ * Recherche un operateur de redirection au debut d'une chaine (reference, voir parser.c)
+ */
+static int referenceGetRedirection( const char* str, char* op )
+{
+    // Operateurs de redirection, les plus longs en premier
+    static const char* OPERATORS[] = { "<&", "<", ">>", ">&", ">", NULL };
+
+    // Recherche de l'operateur
+    for( const char** pOp = OPERATORS; *pOp != NULL; ++pOp )
+    {
+        if( strncmp( str, *pOp, strlen( *pOp ) ) == 0 )
+        {
+            strcpy( op, *pOp );
+            return( strlen( *pOp ) );
+        }
+    }
+
+    // Pas d'operateur
+    op[0] = '\0';
+    return( 0 );
+}
+
+
+/*
+ * Passes du parsing avant la classification par masques (parcours caractere par caractere), utilisees comme
+ * reference pour les mesures et pour verifier les resultats
+ */
+static void referenceClean( char* str )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Flag qui dit si un separateur espace/tabulation est en cours de traitement
+    int sepInProgress = 0;
+
+    // Pour chaque caractere du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Si le caractere est un espace ou une tabulation
+        if( buff[iBuff] == ' ' || buff[iBuff] == '\t' )
+        {
+            // Si pas de separateur en cours de traitement
+            if( ! sepInProgress )
+            {
+                // On recopie un espace (unique)
+                str[iStr++] = ' ';
+
+                // On leve le flag, de sorte a ignorer d'eventuels espaces/tabulations qui suivraient
+                sepInProgress = 1;
+            }
+        }
+        else
+        {
+            // Caractere normal : on le recopie, et on descend le flag
+            str[iStr++] = buff[iBuff];
+            sepInProgress = 0;
+        }
+
+        // Passage au caractere suivant
+        ++iBuff;
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+
+}
+
+
+static void referenceShowSeparators( char* str )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Tant qu'on est pas a la fin du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Separateur eventuel a mettre en evidence (pas plus de 3 caracteres)
+        char sep[4] = {'\0'};
+
+        // Suivant le caractere courant, s'il correspond au premier caractere d'un separateur, alors on
+        // verifie tous les separateurs potentiels qui commence par ce caractere, du plus long au plus
+        // court afin d'eviter de detruire un separateur compose de plusieurs caracteres. Si un separateur
+        // est detecte, il est copie dans la variable 'sep'
+        switch( buff[iBuff] )
+        {
+            // On traite uniquement ";"
+            case ';':
+                strcpy( sep, ";" );
+                break;
+
+            // On traite "(" ou ")"
+            case '(':
+            case ')':
+                sep[0] = buff[iBuff];
+                break;
+
+            // On traite "||" ou "|+" ou "|"
+            case '|':
+                if( strncmp( buff + iBuff, "||", 2 ) == 0 )
+                    strcpy( sep, "||" );
+                else if( strncmp( buff + iBuff, "|+", 2 ) == 0 )
+                    strcpy( sep, "|+" );
+                else
+                    strcpy( sep, "|" );
+                break;
+
+            // On traite "&>>" ou "&>" ou "&&" ou "&"
+            case '&':
+                if( strncmp( buff + iBuff, "&>>", 3 ) == 0 )
+                    strcpy( sep, "&>>" );
+                else if( strncmp( buff + iBuff, "&>", 2 ) == 0 )
+                    strcpy( sep, "&>" );
+                else if( strncmp( buff + iBuff, "&&", 2 ) == 0 )
+                    strcpy( sep, "&&" );
+                else
+                    strcpy( sep, "&" );
+                break;
+
+            // On traite "<&", "<", ">>", ">&" ou ">"
+            case '<':
+            case '>':
+                referenceGetRedirection( buff + iBuff, sep );
+                break;
+
+            // On traite "N<&", "N<", "N>>", "N>&" ou "N>", le numero de descripteur N (un chiffre) devant etre
+            // en debut de mot
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9':
+                if( ( iBuff == 0 || buff[iBuff - 1] == ' ' ) && referenceGetRedirection( buff + iBuff + 1, sep + 1 ) )
+                    sep[0] = buff[iBuff];
+                else
+                    // Pas de separateur. Caractere suivant...
+                    str[iStr++] = buff[iBuff++];
+                break;
+
+            // Pas de separateur a la position courante. On copie le caractere et on passe au suivant
+            default:
+                str[iStr++] = buff[iBuff++];
+                continue;
+        }
+
+        // Si on a un separateur a traiter
+        if( strlen( sep ) != 0 )
+        {
+            // Si le caractere precedent n'est pas un espace, on le rajoute au resultat
+            if( iBuff > 0 && buff[iBuff - 1] != ' ' ) str[iStr++] = ' ';
+
+            // On recopie le separateur
+            memcpy( str + iStr, sep, strlen( sep ) );
+            iStr += strlen( sep ) ;
+            iBuff += strlen( sep ) ;
+
+            // S'il n'y a pas d'espace apres le separateur, on le rajoute au resultat
+            if( buff[iBuff] != ' ' ) str[iStr++] = ' ';
+        }
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+}
+
+
+static int referenceSubstEnv( char* str )
+{
+    // Copie de la chaine initiale dans un buffer (la chaine initiale va accueillir le resultat)
+    char buff[MAX_LINE_SIZE];
+    strcpy( buff, str );
+
+
+    // Index des caracteres courants dans chaque chaine (buffer et resultat)
+    int iBuff = 0;
+    int iStr = 0;
+
+    // Tant qu'on est pas a la fin du buffer
+    while( buff[iBuff] != '\0' )
+    {
+        // Si on est sur le debut d'une variable d'environnement
+        if( buff[iBuff] == '$' )
+        {
+            // Index du debut du nom de la variable (apres le $)
+            int iBegin = ++iBuff;
+
+            // Recherche de l'index de la fin du nom de la variable (premier espace ou fin de chaine)
+            int iEnd = iBegin;
+            while( buff[iEnd] != ' ' && buff[iEnd] != '\0' ) ++iEnd;
+
+            // Si le nom de la variable est vide (longueur nulle), on retourne une erreur
+            const int nameLength = iEnd - iBegin;
+            if( nameLength == 0 ) return( PARSER_BAD_NAME );
+
+            // Copie du nom de la variable
+            char varName[MAX_LINE_SIZE];
+            memcpy( varName, buff + iBegin, nameLength );
+            varName[nameLength] = '\0';
+
+            // Recherche de la valeur de la variable
+            char* varValue = getenv( varName );
+
+            // Si la variable n'existe pas
+            if( varValue == NULL )
+            {
+                // On ignore la variable, et on met a jour l'index du buffer
+                iBuff += nameLength;
+            }
+            else
+            {
+                // La variable existe, on substitue sa valeur dans la chaine resultat
+                const int valueLength= strlen( varValue );
+                memcpy( str + iStr, varValue, valueLength );
+
+                // On met a jour les index
+                iBuff += nameLength;
+                iStr += valueLength;
+            }
+        }
+        else
+        {
+            // Sinon, on recopie simplement le caractere
+            str[iStr++] = buff[iBuff++];
+        }
+    }
+
+    // Caractere de terminaison
+    str[iStr] = '\0';
+
+    return( PARSER_OK );
+}
+
+
+/*
+ * Formate une ligne avec les passes de reference ou avec les passes pilotees par les masques
+ *
+ * line : ligne a formater
+ * result : en sortie, la ligne formatee
+ * reference : vrai pour les passes de reference
+ * retourne le code d'erreur de la substitution des variables
+ */
+static int formatLine( const char* line, char* result, int reference )
+{
+    strcpy( result, line );
+    if( reference )
+    {
+        referenceClean( result );
+        referenceShowSeparators( result );
+        return( referenceSubstEnv( result ) );
+    }
+
+    clean( result );
+    showSeparators( result );
+    return( substEnv( result, NULL ) );
+}
+
+
+/*
+ * Genere une longue ligne de commande, comparable a celles produites par programme
+ *
+ * line : en sortie, la ligne generee
+ */
+static void generateLine( char* line )
+{
+    line[0] = '\0';
+    for( int i = 0; ; ++i )
+    {
+        char segment[128];
+        snprintf( segment, sizeof( segment ),
+                  "%sjob_%d --input=$HOME  data_%d.csv\t--level %d 2>>err_%d.log|filter -v x%d",
+                  i > 0 ? "&&" : "", i, i, i % 7, i, i );
+        if( strlen( line ) + strlen( segment ) >= MAX_LINE_SIZE / 3 ) break;
+        strcat( line, segment );
+    }
+}
+
+
+/*
+ * Fonction principale du programme
+ */
+int main( int argc, char* argv[] )
+{
+    // Options
+    int iterations = 200000;
+    const char* userLine = NULL;
+    for( int iArg = 1; iArg < argc; ++iArg )
+    {
+        if( strcmp( argv[iArg], "-n" ) == 0 && iArg + 1 < argc ) iterations = atoi( argv[++iArg] );
+        else if( userLine == NULL ) userLine = argv[iArg];
+        else iterations = 0;
+    }
+    if( iterations <= 0 || ( userLine != NULL && strlen( userLine ) >= MAX_LINE_SIZE / 3 ) )
+    {
+        fprintf( stderr, "Usage: %s [-n ITERATIONS] [LIGNE]\n", argv[0] );
+        return( SCANBENCH_BAD_ARGS );
+    }
+
+    // Ligne mesuree (les passes peuvent l'allonger : elle est limitee au tiers d'une ligne)
+    char line[MAX_LINE_SIZE];
+    if( userLine != NULL ) strcpy( line, userLine );
+    else generateLine( line );
+    printf( "Ligne : %zu caracteres, %d iterations\n", strlen( line ), iterations );
+
+    // Resultat de reference
+    char expected[MAX_LINE_SIZE];
+    const int expectedStatus = formatLine( line, expected, 1 );
+    char result[MAX_LINE_SIZE];
+
+    // Mesure des passes de reference
+    long long start = nowNs();
+    for( int i = 0; i < iterations; ++i ) formatLine( line, result, 1 );
+    const double referenceNs = (double)( nowNs() - start ) / iterations;
+    printf( "%-12s passes: %8.1f ns/ligne\n", "reference", referenceNs );
+
+    // Pour chaque jeu d'instructions disponible
+    for( int mode = 0; mode < SCAN_LAST; ++mode )
+    {
+        if( setScanMode( mode ) != SCAN_OK ) continue;
+
+        // Verification du resultat
+        if( formatLine( line, result, 0 ) != expectedStatus || strcmp( result, expected ) != 0 )
+        {
+            fprintf( stderr, "ERREUR - Resultat different de la reference (%s) :\n  %s\n  %s\n",
+                     getScanModeName( mode ), expected, result );
+            return( SCANBENCH_MISMATCH );
+        }
+
+        // Mesure de la classification seule
+        ScanMask mask;
+        const size_t length = strlen( line );
+        start = nowNs();
+        for( int i = 0; i < iterations; ++i )
+        {
+            scanLine( line, length, &mask );
+            __asm__ __volatile__( "" : : "r"( &mask ) : "memory" );
+        }
+        const double scanNs = (double)( nowNs() - start ) / iterations;
+
+        // Mesure des passes
+        start = nowNs();
+        for( int i = 0; i < iterations; ++i ) formatLine( line, result, 0 );
+        const double passesNs = (double)( nowNs() - start ) / iterations;
+        printf( "%-12s passes: %8.1f ns/ligne (x%.2f), classification: %6.1f ns/ligne\n",
+                getScanModeName( mode ), passesNs, referenceNs / passesNs, scanNs );
+    }
+
+    return( SCANBENCH_OK );
+}
@@ -0,0 +1,352 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : frame.h shell.h zygote.h
+ *
+ *  Mode serveur du minishell (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "server.h"
+#include "shell.h"
+#include "zygote.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Sert une connexion : les lignes de commande recues sont executees une par une, jusqu'a la fermeture de la
+ * connexion par le client.
+ *
+ * conn : socket de la connexion
+ * useZygote : si vrai, un zygote est cree pour la connexion
+ */
+static void serveClient( int conn, int useZygote );
+
+/*
+ * Execute une ligne de commande recue, avec les entrees/sorties standards specifiees, et remplit le resultat.
+ *
+ * shell : moteur d'execution de la connexion
+ * cmdLine : ligne de commande a executer
+ * stdFds : descripteurs des entree, sortie et erreur standards a utiliser pour les commandes
+ * result : en sortie, resultat de l'execution
+ */
+static void runReceivedLine( Shell* shell, char* cmdLine, const int stdFds[3], FrameResult* result );
+
+/*
+ * Processus relais du mode "stream" : les donnees lues sur les pipes de sortie et d'erreur des commandes sont
+ * renvoyees au client dans des trames FRAME_STDOUT et FRAME_STDERR, jusqu'a la fermeture des deux pipes.
+ *
+ * conn : socket de la connexion
+ * outFd : sortie du pipe associe a la sortie standard des commandes
+ * errFd : sortie du pipe associe a l'erreur standard des commandes
+ */
+static void relayOutputs( int conn, int outFd, int errFd );
+
+/*
+ * Synchronisation avec la terminaison des commandes en background de la connexion (sans attente)
+ */
+static void reapBgCmds( void );
+
+/*
+ * Conversion d'une duree en micro-secondes
+ */
+static int64_t toMicroseconds( const struct timeval* tv );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int runServer( const char* socketPath, int useZygote )
+{
+    // Adresse de la socket d'ecoute
+    struct sockaddr_un addr;
+    memset( &addr, 0, sizeof( addr ) );
+    addr.sun_family = AF_UNIX;
+    if( strlen( socketPath ) >= sizeof( addr.sun_path ) )
+    {
+        fprintf( stderr, "ERREUR - Chemin de socket trop long : %s\n", socketPath );
+        return( SERVER_SOCKET_FAILED );
+    }
+    strcpy( addr.sun_path, socketPath );
+
+    // Creation de la socket d'ecoute (une eventuelle socket existante est remplacee). Les sockets sont placees
+    // hors des descripteurs utilisables dans les redirections.
+    const int listenSock = moveShellFd( socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 ) );
+    unlink( socketPath );
+    if( listenSock == -1 || bind( listenSock, (struct sockaddr*)&addr, sizeof( addr ) ) == -1 ||
+        listen( listenSock, SOMAXCONN ) == -1 )
+    {
+        perror( "ERREUR - Impossible de creer la socket d'ecoute" );
+        return( SERVER_SOCKET_FAILED );
+    }
+
+    // Les processus de service des connexions sont detruits automatiquement a leur terminaison
+    signal( SIGCHLD, SIG_IGN );
+
+    // Boucle d'acceptation des connexions
+    while( 1 )
+    {
+        // Attente d'une nouvelle connexion
+        const int conn = moveShellFd( accept4( listenSock, NULL, NULL, SOCK_CLOEXEC ) );
+        if( conn == -1 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED ) continue;
+            perror( "ERREUR - accept" );
+            return( SERVER_SOCKET_FAILED );
+        }
+
+        // Chaque connexion est servie par un processus dedie
+        switch( fork() )
+        {
+            // Erreur
+            case -1:
+                perror( "ERREUR - fork" );
+                break;
+
+            // Processus de service de la connexion
+            case 0:
+                // Le processus doit pouvoir se synchroniser avec ses propres commandes
+                signal( SIGCHLD, SIG_DFL );
+                close( listenSock );
+                serveClient( conn, useZygote );
+                _exit( 0 );
+
+            // Processus d'ecoute
+            default:
+                break;
+        }
+
+        // La connexion est geree par le processus de service
+        close( conn );
+    }
+
+    return( SERVER_OK );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void serveClient( int conn, int useZygote )
+{
+    // Creation de l'eventuel zygote, avant l'initialisation du moteur d'execution
+    if( useZygote && startZygote() != ZYGOTE_OK ) fprintf( stderr, "ERREUR - Impossible de creer le zygote\n" );
+
+    // Moteur d'execution de la connexion
+    static Shell shell;
+    initShell( &shell );
+
+    // Boucle de reception des lignes de commande
+    while( 1 )
+    {
+        // Reception d'une trame
+        FrameHeader header;
+        char cmdLine[MAX_LINE_SIZE] = {'\0'};
+        int fds[MAX_FRAME_FDS];
+        int fdCount = 0;
+        const int status = recvFrame( conn, &header, cmdLine, MAX_LINE_SIZE - 1, fds, &fdCount );
+        if( status == FRAME_CLOSED || status == FRAME_IO_FAILED ) break;
+
+        // Resultat de l'execution de la ligne
+        FrameResult result;
+        memset( &result, 0, sizeof( result ) );
+
+        // Verification de la trame
+        if( status != FRAME_OK || header.type != FRAME_LINE || ( fdCount != 0 && fdCount != 3 ) )
+        {
+            result.error = SERVER_BAD_FRAME;
+            for( int i = 0; i < fdCount; ++i ) close( fds[i] );
+        }
+
+        // Mode "descripteurs" : les commandes utilisent directement les descripteurs recus
+        else if( fdCount == 3 )
+        {
+            cmdLine[header.length] = '\0';
+            runReceivedLine( &shell, cmdLine, fds, &result );
+        }
+
+        // Mode "stream" : les sorties des commandes sont renvoyees au client par un processus relais
+        else
+        {
+            cmdLine[header.length] = '\0';
+            int outPipe[2] = {-1, -1};
+            int errPipe[2] = {-1, -1};
+            const int devNull = open( "/dev/null", O_RDONLY | O_CLOEXEC );
+            pid_t relay = -1;
+            if( devNull != -1 && pipe2( outPipe, O_CLOEXEC ) != -1 && pipe2( errPipe, O_CLOEXEC ) != -1 )
+            {
+                relay = fork();
+                if( relay == 0 )
+                {
+                    close( outPipe[1] );
+                    close( errPipe[1] );
+                    relayOutputs( conn, outPipe[0], errPipe[0] );
+                    _exit( 0 );
+                }
+            }
+
+            // Execution de la ligne avec les entrees des pipes comme sortie et erreur standards
+            if( relay > 0 )
+            {
+                close( outPipe[0] );
+                close( errPipe[0] );
+                // Les commandes en background ne conservent pas les pipes, qu'elles tiendraient ouverts jusqu'a
+                // leur terminaison : leurs sorties non redirigees vont vers /dev/null
+                const int bgNull = moveShellFd( open( "/dev/null", O_WRONLY | O_CLOEXEC ) );
+                setBgCmdOutput( bgNull );
+                const int stdFds[3] = { devNull, outPipe[1], errPipe[1] };
+                runReceivedLine( &shell, cmdLine, stdFds, &result );
+                setBgCmdOutput( -1 );
+                if( bgNull != -1 ) close( bgNull );
+
+                // Le relais se termine a la fermeture des pipes par les commandes au premier plan
+                waitpid( relay, NULL, 0 );
+            }
+            else
+            {
+                result.error = SERVER_IO_FAILED;
+                if( devNull != -1 ) close( devNull );
+                for( int i = 0; i < 2; ++i )
+                {
+                    if( outPipe[i] != -1 ) close( outPipe[i] );
+                    if( errPipe[i] != -1 ) close( errPipe[i] );
+                }
+            }
+        }
+
+        // Envoi du resultat
+        if( sendFrame( conn, FRAME_RESULT, &result, sizeof( result ), NULL, 0 ) != FRAME_OK ) break;
+
+        // Synchronisation avec les eventuelles commandes en background terminees
+        reapBgCmds();
+    }
+
+    close( conn );
+}
+
+
+static void runReceivedLine( Shell* shell, char* cmdLine, const int stdFds[3], FrameResult* result )
+{
+    // Installation des entree/sortie/erreur standards des commandes (les descripteurs recus sont refermes)
+    int savedFds[3];
+    for( int i = 0; i < 3; ++i )
+    {
+        savedFds[i] = fcntl( i, F_DUPFD_CLOEXEC, MAX_CMD_FD );
+        dup2( stdFds[i], i );
+        close( stdFds[i] );
+    }
+
+    // Mesures avant execution
+    struct timespec start, end;
+    struct rusage usageBefore, usageAfter;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    getrusage( RUSAGE_CHILDREN, &usageBefore );
+
+    // Mise en forme et execution de la ligne
+    int status = formatCmdLine( cmdLine );
+    if( status == PARSER_OK && strlen( cmdLine ) > 0 )
+    {
+        int cmdStatus = 0;
+        status = runCmdLine( shell, cmdLine, &cmdStatus );
+        result->status = cmdStatus;
+    }
+    result->error = status;
+
+    // Mesures apres execution (seules les commandes terminees et attendues sont comptabilisees)
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    getrusage( RUSAGE_CHILDREN, &usageAfter );
+    result->wallUs = ( end.tv_sec - start.tv_sec ) * 1000000LL + ( end.tv_nsec - start.tv_nsec ) / 1000;
+    result->userUs = toMicroseconds( &usageAfter.ru_utime ) - toMicroseconds( &usageBefore.ru_utime );
+    result->systemUs = toMicroseconds( &usageAfter.ru_stime ) - toMicroseconds( &usageBefore.ru_stime );
+    result->maxRssKb = usageAfter.ru_maxrss;
+
+    // Restauration des entree/sortie/erreur standards (les messages du minishell sont d'abord vides)
+    fflush( stdout );
+    fflush( stderr );
+    for( int i = 0; i < 3; ++i )
+    {
+        dup2( savedFds[i], i );
+        close( savedFds[i] );
+    }
+}
+
+
+static void relayOutputs( int conn, int outFd, int errFd )
+{
+    // Pipes surveilles, et types de trames associes
+    struct pollfd pfds[2] = { { outFd, POLLIN, 0 }, { errFd, POLLIN, 0 } };
+    const uint32_t types[2] = { FRAME_STDOUT, FRAME_STDERR };
+    int openCount = 2;
+
+    // Tant qu'un des pipes est ouvert
+    while( openCount > 0 )
+    {
+        if( poll( pfds, 2, -1 ) == -1 )
+        {
+            if( errno == EINTR ) continue;
+            break;
+        }
+
+        // Pour chaque pipe pret
+        for( int i = 0; i < 2; ++i )
+        {
+            if( pfds[i].fd == -1 || pfds[i].revents == 0 ) continue;
+
+            // Lecture des donnees disponibles et envoi au client
+            char buff[16384];
+            const ssize_t length = read( pfds[i].fd, buff, sizeof( buff ) );
+            if( length > 0 )
+            {
+                if( sendFrame( conn, types[i], buff, length, NULL, 0 ) != FRAME_OK ) return;
+            }
+            else if( length == 0 || errno != EINTR )
+            {
+                // Pipe ferme : plus rien a relayer
+                close( pfds[i].fd );
+                pfds[i].fd = -1;
+                --openCount;
+            }
+        }
+    }
+}
+
+
+static void reapBgCmds( void )
+{
+    // Synchronisation avec chaque processus termine
+    while( 1 )
+    {
+        pid_t pid = waitpid( -1, NULL, WNOHANG );
+        if( pid <= 0 ) pid = zygoteReap( NULL );
+        if( pid <= 0 ) break;
+
+        // Liberation de la commande en background correspondante
+        freeBgCmd( removeBgCmd( pid ) );
+    }
+}
+
+
+static int64_t toMicroseconds( const struct timeval* tv )
+{
+    return( tv->tv_sec * 1000000LL + tv->tv_usec );
+}
@@ -0,0 +1,87 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Mode serveur du minishell : reception des lignes de commande sur une socket Unix.
+ *
+ *  Protocole (toutes les valeurs sont dans l'ordre des octets de la machine, la socket etant locale) :
+ *  - Chaque message est une trame composee d'un entete FrameHeader suivi de 'length' octets de donnees.
+ *  - Le client envoie des trames FRAME_LINE contenant une ligne de commande (sans '\n' final). Trois
+ *    descripteurs de fichiers (entree, sortie et erreur standards des commandes) peuvent etre joints a
+ *    l'entete via SCM_RIGHTS : les commandes de la ligne les utilisent alors directement.
+ *  - Si aucun descripteur n'est joint, l'entree standard des commandes est /dev/null, et leurs sorties sont
+ *    renvoyees au client dans des trames FRAME_STDOUT et FRAME_STDERR.
+ *    Les sorties non redirigees d'une commande lancee en background ne sont pas relayees (elles sont capturees
+ *    si l'option "bgcapture" est active, sinon envoyees vers /dev/null) : la trame de resultat est envoyee des
+ *    la fin des commandes au premier plan.
+ *  - Chaque ligne se termine par une trame FRAME_RESULT contenant une structure FrameResult.
+ *
+ *  Chaque connexion est servie par un processus dedie : plusieurs clients sont donc servis en parallele, et
+ *  chacun dispose de son propre etat (repertoire courant, variables d'environnement).
+ */
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stdint.h>
+
+#include "frame.h"
+
+
+// Codes d'erreur
+enum ServerError
+{
+    SERVER_OK = 0,              // Pas d'erreur
+    SERVER_SOCKET_FAILED = 60,  // Impossible de creer la socket d'ecoute
+    SERVER_BAD_FRAME,           // Trame incorrecte (type inconnu ou ligne trop longue)
+    SERVER_IO_FAILED            // Echec de mise en place des entrees/sorties d'une ligne de commande
+};
+
+// Types de trames
+enum FrameType
+{
+    FRAME_LINE = 1,             // Client -> serveur : ligne de commande a executer
+    FRAME_STDOUT,               // Serveur -> client : donnees ecrites sur la sortie standard
+    FRAME_STDERR,               // Serveur -> client : donnees ecrites sur l'erreur standard
+    FRAME_RESULT                // Serveur -> client : resultat de l'execution de la ligne
+};
+
+/*
+ * Donnees d'une trame FRAME_RESULT
+ *
+ * status : code de retour de la derniere commande executee
+ * error : code d'erreur du minishell (parsing, trame incorrecte...), ou 0
+ * wallUs : duree d'execution de la ligne (micro-secondes)
+ * userUs : temps CPU utilisateur consomme par les commandes de la ligne (micro-secondes)
+ * systemUs : temps CPU systeme consomme par les commandes de la ligne (micro-secondes)
+ * maxRssKb : taille max de memoire residente atteinte par les commandes (kilo-octets)
+ */
+typedef struct
+{
+    int32_t status;
+    int32_t error;
+    int64_t wallUs;
+    int64_t userUs;
+    int64_t systemUs;
+    int64_t maxRssKb;
+} FrameResult;
+
+
+/*
+ * Lance le minishell en mode serveur : les connexions sont acceptees sur la socket specifiee (qui est
+ * recreee si elle existe deja), et chaque connexion est servie par un processus dedie. Cette fonction
+ * ne rend la main qu'en cas d'erreur.
+ *
+ * socketPath : chemin de la socket Unix d'ecoute
+ * useZygote : si vrai, chaque processus de service cree son propre zygote (voir zygote.h)
+ * retourne un code d'erreur
+ */
+int runServer( const char* socketPath, int useZygote );
+
+
+#endif // _SERVER_H_
@@ -0,0 +1,344 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : parser.h cmd.h expand.h memstat.h metrics.h options.h plan.h replay.h
+ *
+ *  Traitement d'une ligne de commande complete (implementation)
+ */
+
+#include "shell.h"
+#include "expand.h"
+#include "memstat.h"
+#include "metrics.h"
+#include "options.h"
+#include "plan.h"
+#include "replay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+/*
+ * Reinitialisation des variables avant une nouvelle ligne de commande.
+ *
+ * cmdWords : tableau des mots consituant la ligne de commande
+ * cmds : tableau des commandes
+ */
+static void reinit( char* cmdWords[], cmd_t* cmds );
+
+/*
+ * Teste si un file descriptor est deja stocke dans un tableau
+ *
+ * fd : le file descriptor a rechercher
+ * fds : le tableau de file descriptors
+ * maxIndex : index de la premiere entree libre dans le tableau
+ * retourne 1 si le file descriptor est deja present dans le tableau, 0 sinon
+ */
+static int fdIsAlreadyStored( int fd, const int fds[], int maxIndex );
+
+/*
+ * Mise a jour de la liste des fichier ouverts qui doivent etre refermes.
+ *
+ * Dans un premier temps, la fonction construit un tableau global qui fusionne les tableaux 'fdclose' de
+ * totes les commandes, de sorte a construire la liste globale de tous les fichiers ouverts (et a refermer).
+ * Dans un deuxieme temps, cette liste globale vient ecraser le tableau 'fdclose' de chaque commande, de sorte
+ * à ce que les processus d'execution associes refermeent egalement ces fichiers ouverts, dont ils ont herites
+ * lors du fork.
+ *
+ * A noter que cette liste ne gere pas les pipes, qui sont traites par ailleurs via le champ 'fdpipe' des commandes.
+ *
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ * allFDs : en sortie, tableau des fichiers ouverts
+ */
+static void updateFDClose( cmd_t cmds[], int cmdCount, int allFDs[] );
+
+/*
+ * Referme tous les fichiers d'une liste de file descriptors (terminee par -1)
+ *
+ * allFDs : liste des fichiers ouverts
+ */
+static void closeFiles( const int allFDs[] );
+
+/*
+ * Referme les pipes encore ouverts dans le minishell (ceux des commandes qui n'ont pas ete executees)
+ *
+ * cmds : tableau des commandes
+ * cmdCount : nombre de commandes utilisees
+ */
+static void closePipes( cmd_t cmds[], int cmdCount );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+void initShell( Shell* shell )
+{
+    // Initialisation du contenu des tableaux
+    for( int i = 0; i < MAX_CMD_SIZE; ++i )
+    {
+        // Tableau de mots
+        shell->cmdWords[i] = NULL;
+
+        // Liste des arguments de la commande #i, et fonctions definie et re-executee ('watch'). Cela est necessaire
+        // car la fonction initCmd() libere la memoire des arguments de cette liste, qui est allouee via memAlloc(),
+        // ainsi que les fonctions.
+        cmd_t* cmd = shell->cmds + i;
+        cmd->argv = NULL;
+        cmd->argc = 0;
+        cmd->argvCapacity = 0;
+        cmd->funcDef = NULL;
+        cmd->watchBody = NULL;
+    }
+
+    // Aucune ligne analysee
+    shell->cmdCount = 0;
+    shell->allFDs[0] = -1;
+    shell->explain = 0;
+}
+
+
+int formatCmdLine( char* cmdLine )
+{
+    // Trim de la saisie
+    trim( cmdLine );
+
+    // Si rien n'a ete saisi, on retourne
+    if( strlen( cmdLine ) == 0 ) return( PARSER_OK );
+
+    // Suppression des doublons
+    clean( cmdLine );
+
+    // Mise en evidence des separateurs
+    showSeparators( cmdLine );
+
+    return( PARSER_OK );
+}
+
+
+int parseCmdLine( Shell* shell, char* cmdLine )
+{
+    // Reinitialisation avant la nouvelle ligne de commande
+    reinit( shell->cmdWords, shell->cmds );
+    shell->cmdCount = 0;
+    shell->allFDs[0] = -1;
+
+    // On decoupe la ligne de commande en mots
+    const int64_t parseStart = getMetricsTime();
+    const int64_t replayParseStart = getReplayTime();
+    strcut( cmdLine, ' ', shell->cmdWords );
+    //printf( "Tokens :\n" );
+    //int i = 0;
+    //while( shell->cmdWords[i] ) { printf( "- %s\n", shell->cmdWords[i++] ); }
+
+    // La builtin 'explain' affiche le plan d'execution du reste de la ligne de commande, sans l'executer
+    shell->explain = ( shell->cmdWords[0] != NULL && strcmp( shell->cmdWords[0], "explain" ) == 0 );
+
+    // Construction des commandes a partir des mots de la ligne de commande (la ligne expliquee est analysee a
+    // blanc : ses fichiers de redirection ne sont pas ouverts)
+    if( shell->explain ) setDryRunParse( 1 );
+    const int parseStatus = parseCmd( shell->cmdWords + shell->explain, shell->cmds, &shell->cmdCount );
+    if( shell->explain ) setDryRunParse( 0 );
+
+    // Les repertoires lus pour l'expansion des motifs ne sont conserves que le temps de la ligne
+    clearExpandCache();
+    recordParse( parseStart );
+    recordReplaySample( REPLAY_PARSE, replayParseStart );
+    //printf( "Commandes :\n" );
+    //for( int i = 0; i < shell->cmdCount; ++i ) printCmd( shell->cmds + i );
+
+    // Optimisation du plan d'execution
+    if( parseStatus == 0 )
+    {
+        if( shell->explain )
+        {
+            printf( "Plan initial :\n" );
+            printPlan( shell->cmds, shell->cmdCount );
+        }
+        if( getOption( OPTION_OPTIMIZE ) ) optimizePlan( shell->cmds, shell->cmdCount );
+    }
+
+    // Mise a jour de la liste des fichiers ouverts (et a refermer apres execution)
+    updateFDClose( shell->cmds, shell->cmdCount, shell->allFDs );
+
+    // En cas d'erreur de parsing, on referme les fichiers et pipes deja ouverts (le moteur peut etre utilise
+    // pour plusieurs lignes de commande successives)
+    if( parseStatus != 0 )
+    {
+        recordCommandError( shell->cmdWords[0] != NULL ? shell->cmdWords[0] : "", parseStatus );
+        releaseCmdLine( shell );
+    }
+
+    return( parseStatus );
+}
+
+
+int execCmdLine( Shell* shell )
+{
+    // Avec 'explain', le plan optimise est affiche a la place de l'execution
+    if( shell->explain )
+    {
+        printf( "Plan optimise :\n" );
+        printPlan( shell->cmds, shell->cmdCount );
+        releaseCmdLine( shell );
+        return( 0 );
+    }
+
+    // Execution des commandes dans l'ordre etabli lors du parsing
+    const int status = execCmdList( shell->cmds );
+
+    // On referme tous les fichiers ouverts, ainsi que les pipes des commandes qui n'ont pas ete executees
+    releaseCmdLine( shell );
+
+    return( status );
+}
+
+
+void releaseCmdLine( Shell* shell )
+{
+    // Les commandes restent consultables, mais leurs fichiers et pipes ne peuvent plus etre refermes
+    closeFiles( shell->allFDs );
+    closePipes( shell->cmds, shell->cmdCount );
+    shell->allFDs[0] = -1;
+}
+
+
+void freeShell( Shell* shell )
+{
+    // Destruction des mots, et des arguments des commandes
+    reinit( shell->cmdWords, shell->cmds );
+    for( int i = 0; i < MAX_CMD_SIZE; ++i )
+    {
+        memFree( shell->cmds[i].argv );
+        shell->cmds[i].argv = NULL;
+        shell->cmds[i].argvCapacity = 0;
+    }
+}
+
+
+int runCmdLine( Shell* shell, char* cmdLine, int* status )
+{
+    // Aucune commande executee pour l'instant
+    *status = 0;
+
+    // Decoupage et analyse de la ligne de commande
+    const int parseStatus = parseCmdLine( shell, cmdLine );
+    if( parseStatus != 0 ) return( parseStatus );
+
+    // On desactive le callback sur la terminaison des processus fils (commandes en background)
+    void (*onChildCompletion)( int ) = signal( SIGCHLD, SIG_DFL );
+
+    // Execution des commandes dans l'ordre etabli lors du parsing
+    *status = execCmdLine( shell );
+
+    // On resactive le callback sur la terminaison des processus fils (commandes en background)
+    signal( SIGCHLD, onChildCompletion );
+
+    return( 0 );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void reinit( char* cmdWords[], cmd_t* cmds )
+{
+    // Pour chaque element des tableaux (ils ont la meme taille)
+    for( int i = 0; i < MAX_CMD_SIZE; ++i ) {
+
+        // Si un mot existe
+        if( cmdWords[i] != NULL )
+        {
+            // Destruction et reinitialisation du mot
+            memFree( cmdWords[i] );
+            cmdWords[i] = NULL;
+        }
+
+        // Reinitialisation de la commande
+        initCmd( cmds + i );
+    }
+}
+
+
+static int fdIsAlreadyStored( int fd, const int fds[], int maxIndex )
+{
+    // Pour chaque element du tableau
+    for( int i = 0; i < maxIndex; ++i )
+    {
+        // Si l'element correspond a celui recherche, l'element est trouve
+        if( fds[i] == fd ) return( 1 );
+    }
+
+    // L'element n'existe pas dans le tableau
+    return( 0 );
+}
+
+
+static void updateFDClose( cmd_t cmds[], int cmdCount, int allFDs[] )
+{
+    // Index de la prochaine entree du tableau a utiliser
+    int iNextFD = 0;
+
+    // On construit la liste globale des file descriptors. Pour chaque commande...
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        // On merge la liste de file descriptors de la commande avec la liste globale
+        const cmd_t* cmd = cmds + i;
+        int iFD = 0;
+        while( cmd->fdclose[iFD] != -1 )
+        {
+            // Si le file descriptor n'est pas deja stocke dans la liste globale
+            if( ! fdIsAlreadyStored( cmd->fdclose[iFD], allFDs, iNextFD ) )
+            {
+                // On rajoute le file descriptor dans la liste globale
+                allFDs[iNextFD++] = cmd->fdclose[iFD];
+            }
+
+            // File descriptor suivant
+            ++iFD;
+        }
+    }
+
+    // On marque la fin du tableau avec un -1
+    allFDs[iNextFD++] = -1;
+
+    // On doit maintenant mettre a jour la liste des fichiers a refermer pour chaque commande
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        // On recopie le tableau global dans la commande
+        cmd_t* cmd = cmds + i;
+        memcpy( cmd->fdclose, allFDs, iNextFD * sizeof( int ) );
+    }
+}
+
+
+static void closeFiles( const int allFDs[] )
+{
+    int i = 0;
+    while( i < MAX_CMD_SIZE && allFDs[i] != -1 )
+    {
+        // Fermeture du fichier, et passage au descripteur suivant
+        close( allFDs[i++] );
+    }
+}
+
+
+static void closePipes( cmd_t cmds[], int cmdCount )
+{
+    for( int i = 0; i < cmdCount; ++i )
+    {
+        if( cmds[i].fdpipe[0] != -1 ) close( cmds[i].fdpipe[0] );
+        if( cmds[i].fdpipe[1] != -1 ) close( cmds[i].fdpipe[1] );
+        cmds[i].fdpipe[0] = -1;
+        cmds[i].fdpipe[1] = -1;
+    }
+}
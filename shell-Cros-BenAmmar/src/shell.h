@@ -0,0 +1,104 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Traitement d'une ligne de commande complete (mise en forme, decoupage, parsing et execution). Ce moteur
+ *  est partage par le mode interactif et par le mode serveur du minishell.
+ */
+
+#ifndef _SHELL_H_
+#define _SHELL_H_
+
+#include "parser.h"
+#include "cmd.h"
+
+
+/*
+ * Structure de donnees associee au moteur d'execution des lignes de commande.
+ *
+ * cmdWords : tableau des mots consituant la ligne de commande (fini par NULL)
+ * cmds : tableau des commandes a executer
+ * cmdCount : nombre de commandes de la ligne analysee
+ * allFDs : fichiers ouverts lors de l'analyse, a refermer apres l'execution (liste terminee par -1)
+ * explain : vrai si la ligne analysee commence par la builtin 'explain' (le plan est affiche, pas execute)
+ */
+typedef struct
+{
+    char* cmdWords[MAX_CMD_SIZE];
+    cmd_t cmds[MAX_CMD_SIZE];
+    int cmdCount;
+    int allFDs[MAX_CMD_SIZE];
+    int explain;
+} Shell;
+
+
+/*
+ * Initialise le moteur d'execution (tableaux de mots et de commandes vides)
+ *
+ * shell : le moteur a initialiser
+ */
+void initShell( Shell* shell );
+
+/*
+ * Mise en forme d'une ligne de commande :
+ * - Suppression des espaces en debut et en fin de ligne
+ * - Ajout d'eventuels espaces autour des connecteurs (; ! || && & ...)
+ * - Suppression des doublons d'espaces
+ * Les variables sont substituees plus tard, mot par mot, lors de l'analyse (voir parseCmd())
+ *
+ * cmdLine : la ligne de commande a mettre en forme (modifiee)
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int formatCmdLine( char* cmdLine );
+
+/*
+ * Decoupe et analyse une ligne de commande mise en forme, et optimise son plan d'execution. En cas d'erreur,
+ * les fichiers et pipes deja ouverts sont refermes. Sinon, la ligne doit etre executee (execCmdLine()) ou
+ * abandonnee (releaseCmdLine()).
+ *
+ * shell : le moteur d'execution
+ * cmdLine : la ligne de commande mise en forme (modifiee)
+ * retourne 0 en cas de succes, sinon le code d'erreur de parsing (voir parseCmd())
+ */
+int parseCmdLine( Shell* shell, char* cmdLine );
+
+/*
+ * Execute la ligne de commande analysee (ou affiche son plan optimise, avec 'explain'), puis referme ses
+ * fichiers et pipes.
+ *
+ * shell : le moteur d'execution
+ * retourne le code de retour de la derniere commande executee
+ */
+int execCmdLine( Shell* shell );
+
+/*
+ * Abandonne la ligne de commande analysee sans l'executer (ses fichiers et pipes sont refermes)
+ *
+ * shell : le moteur d'execution
+ */
+void releaseCmdLine( Shell* shell );
+
+/*
+ * Libere la memoire allouee par le moteur d'execution (mots et arguments des commandes)
+ *
+ * shell : le moteur d'execution
+ */
+void freeShell( Shell* shell );
+
+/*
+ * Decoupe, analyse et execute une ligne de commande mise en forme.
+ *
+ * shell : le moteur d'execution
+ * cmdLine : la ligne de commande mise en forme (modifiee)
+ * status : en sortie, code de retour de la derniere commande executee
+ * retourne 0 en cas de succes, sinon le code d'erreur de parsing (voir parseCmd())
+ */
+int runCmdLine( Shell* shell, char* cmdLine, int* status );
+
+
+#endif // _SHELL_H_
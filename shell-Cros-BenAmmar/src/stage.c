@@ -0,0 +1,992 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h func.h options.h
+ *
+ *  Etapes de pipeline executees dans des threads du minishell (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "stage.h"
+#include "func.h"
+#include "options.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Taille du buffer en memoire entre 2 etapes (puissance de 2)
+#define STAGE_RING_SIZE     ( 64 * 1024 )
+
+// Taille du buffer d'ecriture d'une etape, et des blocs lus
+#define STAGE_BUFFER_SIZE   4096
+
+// Nombre max de descripteurs utilises simultanement par les threads des etapes
+#define MAX_STAGE_FDS       64
+
+// Code de retour d'une etape dont la sortie est fermee (comme un processus termine par SIGPIPE)
+#define STAGE_BROKEN_PIPE   ( 128 + SIGPIPE )
+
+// Buffer en memoire entre 2 etapes, avec un seul producteur et un seul consommateur. Les compteurs 'head' et
+// 'tail' ne font que croitre (modulo 2^32) : leur difference donne le nombre d'octets disponibles. Une etape
+// qui doit attendre (buffer vide ou plein) s'endort sur un compteur d'evenements (futex), incremente par l'autre
+// etape uniquement si elle a signale son attente.
+//
+// head : nombre d'octets ecrits par le producteur
+// tail : nombre d'octets lus par le consommateur
+// writerClosed : vrai si le producteur a termine (fin de fichier pour le consommateur)
+// readerClosed : vrai si le consommateur a termine (les ecritures du producteur echouent)
+// dataSeq, readerWaiting : evenements attendus par le consommateur (donnees ecrites, ou fin du producteur)
+// spaceSeq, writerWaiting : evenements attendus par le producteur (donnees lues, ou fin du consommateur)
+// refs : nombre d'etapes qui utilisent encore le buffer (il est libere par la derniere)
+// data : donnees
+typedef struct
+{
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_int writerClosed;
+    atomic_int readerClosed;
+    atomic_uint dataSeq;
+    atomic_int readerWaiting;
+    atomic_uint spaceSeq;
+    atomic_int writerWaiting;
+    atomic_int refs;
+    char data[STAGE_RING_SIZE];
+} StageRing;
+
+struct Stage;
+
+// Etape prise en charge :
+// - name : nom de la commande
+// - accepts : teste si les arguments de la commande sont pris en charge
+// - run : execute l'etape (dans son thread), et retourne son code de retour
+typedef struct
+{
+    const char* name;
+    int (*accepts)( const cmd_t* cmd );
+    int (*run)( struct Stage* stage );
+} StageBuiltin;
+
+// Etape en cours d'execution dans un thread :
+// - thread : le thread
+// - builtin : l'etape executee
+// - argc, argv : arguments de la commande
+// - inFd, inRing : entree de l'etape (un descripteur, ou le buffer de l'etape precedente)
+// - outFd, outRing : sortie de l'etape (un descripteur, ou le buffer de l'etape suivante)
+// - errFd : erreur standard de l'etape
+// - output, outputLength : buffer d'ecriture de l'etape
+// - outputBroken : vrai si la sortie a ete fermee par l'etape suivante
+// - status : code de retour de l'etape (une fois terminee)
+typedef struct Stage
+{
+    pthread_t thread;
+    const StageBuiltin* builtin;
+    int argc;
+    char** argv;
+    int inFd;
+    StageRing* inRing;
+    int outFd;
+    StageRing* outRing;
+    int errFd;
+    char output[STAGE_BUFFER_SIZE];
+    size_t outputLength;
+    int outputBroken;
+    int status;
+} Stage;
+
+/*
+ * Implementations des etapes. Les fonctions 'accepts' testent les arguments d'une commande, et les fonctions
+ * 'run' executent l'etape et retournent son code de retour.
+ */
+static int acceptEcho( const cmd_t* cmd );
+static int runEcho( Stage* stage );
+static int acceptCat( const cmd_t* cmd );
+static int runCat( Stage* stage );
+static int acceptHead( const cmd_t* cmd );
+static int runHead( Stage* stage );
+static int acceptWc( const cmd_t* cmd );
+static int runWc( Stage* stage );
+
+// Liste des etapes prises en charge
+static const StageBuiltin ALL_STAGES[] =
+{
+    { "echo", acceptEcho, runEcho },
+    { "cat", acceptCat, runCat },
+    { "head", acceptHead, runHead },
+    { "wc", acceptWc, runWc }
+};
+static const int STAGE_COUNT = sizeof( ALL_STAGES ) / sizeof( StageBuiltin );
+
+// Descripteurs utilises par les threads des etapes (descripteur + 1, ou 0 si l'entree est libre)
+static atomic_int stageFds[MAX_STAGE_FDS];
+
+/*
+ * Thread d'execution d'une etape
+ *
+ * arg : l'etape
+ * retourne NULL
+ */
+static void* runStageThread( void* arg );
+
+/*
+ * Recherche une etape prise en charge
+ *
+ * name : nom de la commande
+ * retourne l'etape, ou NULL si la commande n'est pas prise en charge
+ */
+static const StageBuiltin* findStageBuiltin( const char* name );
+
+/*
+ * Lit des donnees de l'entree d'une etape
+ *
+ * stage : l'etape
+ * buffer : buffer de lecture
+ * size : taille du buffer
+ * retourne le nombre d'octets lus, 0 en fin de fichier, ou -1 en cas d'erreur
+ */
+static ssize_t readInput( Stage* stage, char* buffer, size_t size );
+
+/*
+ * Ecrit des donnees sur la sortie d'une etape (via son buffer d'ecriture)
+ *
+ * stage : l'etape
+ * data : donnees a ecrire
+ * length : nombre d'octets a ecrire
+ * retourne 0 en cas de succes, ou -1 si la sortie est fermee
+ */
+static int writeOutput( Stage* stage, const char* data, size_t length );
+
+/*
+ * Vide le buffer d'ecriture d'une etape
+ *
+ * stage : l'etape
+ * retourne 0 en cas de succes, ou -1 si la sortie est fermee
+ */
+static int flushOutput( Stage* stage );
+
+/*
+ * Recopie l'entree d'une etape (ou un fichier) sur sa sortie
+ *
+ * stage : l'etape
+ * fd : descripteur a recopier, ou -1 pour l'entree de l'etape
+ * retourne 0 en cas de succes, 1 en cas d'erreur de lecture, ou -1 si la sortie est fermee
+ */
+static int copyInput( Stage* stage, int fd );
+
+/*
+ * Affiche un message d'erreur sur l'erreur standard d'une etape
+ *
+ * stage : l'etape
+ * format : format du message (comme printf)
+ */
+static void printStageError( Stage* stage, const char* format, ... );
+
+/*
+ * Lit un nombre de lignes ("N") pour l'etape head
+ *
+ * str : la chaine a lire
+ * count : en sortie, le nombre lu
+ * retourne 1 si la chaine est un nombre, sinon 0
+ */
+static int parseLineCount( const char* str, long* count );
+
+/*
+ * Analyse les arguments de l'etape head ("head [-n N | -nN | -N] [FICHIER]")
+ *
+ * argc, argv : arguments de la commande
+ * count : en sortie, nombre de lignes a afficher
+ * file : en sortie, fichier a lire, ou NULL pour l'entree de l'etape
+ * retourne 1 si les arguments sont pris en charge, sinon 0
+ */
+static int parseHeadArgs( int argc, char* const argv[], long* count, const char** file );
+
+/*
+ * Teste si un argument est une option de l'etape echo ("-n", "-e", "-E", eventuellement combinees)
+ *
+ * arg : l'argument
+ * retourne 1 si l'argument est une option, sinon 0
+ */
+static int isEchoOption( const char* arg );
+
+/*
+ * Cree une copie d'un descripteur pour le thread d'une etape (fermee automatiquement lors d'un exec, et
+ * enregistree pour etre refermee dans les processus fils)
+ *
+ * fd : le descripteur a copier
+ * retourne la copie, ou -1 en cas d'erreur
+ */
+static int dupStageFd( int fd );
+
+/*
+ * Referme une copie de descripteur d'une etape (voir dupStageFd())
+ *
+ * fd : le descripteur (remis a -1 ; rien n'est fait s'il vaut deja -1)
+ */
+static void closeStageFd( int* fd );
+
+/*
+ * Cree un buffer en memoire entre 2 etapes
+ *
+ * retourne le buffer, ou NULL en cas d'erreur
+ */
+static StageRing* createRing( void );
+
+/*
+ * Lit des donnees d'un buffer (cote consommateur), en attendant si le buffer est vide
+ *
+ * ring : le buffer
+ * buffer : buffer de lecture
+ * size : taille du buffer de lecture
+ * retourne le nombre d'octets lus, ou 0 si le producteur a termine et que le buffer est vide
+ */
+static ssize_t readRing( StageRing* ring, char* buffer, size_t size );
+
+/*
+ * Ecrit des donnees dans un buffer (cote producteur), en attendant si le buffer est plein
+ *
+ * ring : le buffer
+ * data : donnees a ecrire
+ * length : nombre d'octets a ecrire
+ * retourne 0 en cas de succes, ou -1 si le consommateur a termine
+ */
+static int writeRing( StageRing* ring, const char* data, size_t length );
+
+/*
+ * Termine l'utilisation d'un buffer par le producteur ou le consommateur (l'autre etape en est prevenue), et le
+ * libere s'il n'est plus utilise
+ *
+ * ring : le buffer
+ * writer : vrai pour le producteur, faux pour le consommateur
+ */
+static void closeRing( StageRing* ring, int writer );
+
+/*
+ * Reveille l'etape qui attend un evenement, si elle a signale son attente
+ *
+ * waiting : flag d'attente de l'etape
+ * seq : compteur d'evenements attendu par l'etape
+ */
+static void notifyRing( atomic_int* waiting, atomic_uint* seq );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int canRunStage( const cmd_t* cmd )
+{
+    // Commande ordinaire d'un pipeline (pas un appel de fonction, ni une commande d'un corps de fonction dont les
+    // arguments restent a traiter), sans duplication de descripteur ni delai (un thread ne peut pas etre
+    // interrompu)
+    if( ! getOption( OPTION_THREAD_STAGES ) || cmd->group != GROUP_NONE || cmd->elided || cmd->fddupCount != 0 ||
+        cmd->timeout != 0 || cmd->source != NULL || findFunction( cmd->path ) != NULL ||
+        ( cmd->pipePrev == NULL && cmd->nextCmdLink != LINK_PIPE ) )
+    {
+        return( 0 );
+    }
+
+    // Le pipeline doit s'executer au premier plan (le minishell attend sa derniere etape)
+    const cmd_t* last = cmd;
+    while( last->nextCmdLink == LINK_PIPE && last->nextSuccess != NULL ) last = last->nextSuccess;
+    if( ! last->wait ) return( 0 );
+
+    // La derniere etape ne peut pas etre attendue dans un thread si un processus du pipeline a un delai a faire
+    // respecter pendant cette attente (voir deadline.h)
+    if( cmd->nextCmdLink != LINK_PIPE )
+    {
+        for( const cmd_t* prev = cmd->pipePrev; prev != NULL; prev = prev->pipePrev )
+        {
+            if( prev->pid > 0 && prev->deadline != 0 ) return( 0 );
+        }
+    }
+
+    // Etape et arguments pris en charge
+    const StageBuiltin* builtin = findStageBuiltin( cmd->path );
+    return( builtin != NULL && builtin->accepts( cmd ) );
+}
+
+
+int startStage( cmd_t* cmd )
+{
+    Stage* stage = (Stage*)calloc( 1, sizeof( Stage ) );
+    if( stage == NULL ) return( STAGE_START_FAILED );
+    stage->builtin = findStageBuiltin( cmd->path );
+    stage->argc = cmd->argc;
+    stage->argv = cmd->argv;
+    stage->inFd = -1;
+    stage->outFd = -1;
+    stage->errFd = -1;
+
+    // Entree : le buffer de l'etape precedente si elle s'execute dans un thread et ecrit dans un buffer, sinon
+    // l'entree standard de la commande
+    const cmd_t* prev = cmd->pipePrev;
+    if( prev != NULL && prev->stage != NULL && prev->stage->outRing != NULL )
+    {
+        stage->inRing = prev->stage->outRing;
+    }
+    else
+    {
+        stage->inFd = dupStageFd( cmd->in != -1 ? cmd->in : STDIN_FILENO );
+    }
+
+    // Sortie : un buffer si l'etape suivante s'execute aussi dans un thread (et lit bien le pipe), sinon la sortie
+    // standard de la commande
+    cmd_t* next = ( cmd->nextCmdLink == LINK_PIPE ? cmd->nextSuccess : NULL );
+    if( next != NULL && canRunStage( next ) && cmd->out == next->fdpipe[1] && next->in == next->fdpipe[0] )
+    {
+        stage->outRing = createRing();
+
+        // Le pipe entre les 2 etapes n'est plus utilise
+        if( stage->outRing != NULL )
+        {
+            close( next->fdpipe[0] );
+            close( next->fdpipe[1] );
+            next->fdpipe[0] = -1;
+            next->fdpipe[1] = -1;
+            next->in = -1;
+            cmd->out = -1;
+        }
+    }
+    else
+    {
+        stage->outFd = dupStageFd( cmd->out != -1 ? cmd->out : STDOUT_FILENO );
+    }
+    stage->errFd = dupStageFd( cmd->err != -1 ? cmd->err : STDERR_FILENO );
+
+    // Les messages deja produits par le minishell sont ecrits avant ceux de l'etape
+    fflush( stdout );
+    fflush( stderr );
+
+    // Creation du thread. Il ne recoit aucun signal : ceux destines au minishell sont traites par le thread
+    // principal, et une ecriture dans un pipe ferme echoue (EPIPE) au lieu de terminer le minishell.
+    int status = -1;
+    if( ( stage->inFd != -1 || stage->inRing != NULL ) && ( stage->outFd != -1 || stage->outRing != NULL ) &&
+        stage->errFd != -1 )
+    {
+        sigset_t allSignals;
+        sigset_t savedMask;
+        sigfillset( &allSignals );
+        pthread_sigmask( SIG_SETMASK, &allSignals, &savedMask );
+        status = pthread_create( &stage->thread, NULL, runStageThread, stage );
+        pthread_sigmask( SIG_SETMASK, &savedMask, NULL );
+    }
+
+    // En cas d'erreur, l'etape precedente ne peut plus ecrire dans le buffer
+    if( status != 0 )
+    {
+        closeStageFd( &stage->inFd );
+        closeStageFd( &stage->outFd );
+        closeStageFd( &stage->errFd );
+        if( stage->inRing != NULL ) closeRing( stage->inRing, 0 );
+        if( stage->outRing != NULL ) closeRing( stage->outRing, 1 );
+        free( stage );
+        return( STAGE_START_FAILED );
+    }
+
+    cmd->stage = stage;
+    return( STAGE_OK );
+}
+
+
+int joinStage( cmd_t* cmd )
+{
+    // Synchronisation avec la fin du thread, et liberation de l'etape
+    Stage* stage = cmd->stage;
+    pthread_join( stage->thread, NULL );
+    const int status = stage->status;
+    free( stage );
+    cmd->stage = NULL;
+
+    return( status );
+}
+
+
+void closeStageFds( void )
+{
+    for( int i = 0; i < MAX_STAGE_FDS; ++i )
+    {
+        const int fd = atomic_load( stageFds + i ) - 1;
+        if( fd != -1 ) close( fd );
+    }
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void* runStageThread( void* arg )
+{
+    Stage* stage = (Stage*)arg;
+
+    // Execution de l'etape, et ecriture de ses dernieres donnees. Comme un processus termine par SIGPIPE,
+    // une etape dont la sortie a ete fermee echoue.
+    int status = stage->builtin->run( stage );
+    flushOutput( stage );
+    if( stage->outputBroken ) status = STAGE_BROKEN_PIPE;
+
+    // Fermeture de l'entree et de la sortie (fin de fichier pour l'etape suivante)
+    closeStageFd( &stage->inFd );
+    closeStageFd( &stage->outFd );
+    closeStageFd( &stage->errFd );
+    if( stage->inRing != NULL ) closeRing( stage->inRing, 0 );
+    if( stage->outRing != NULL ) closeRing( stage->outRing, 1 );
+
+    // Les pointeurs vers les buffers sont conserves : l'etape suivante peut ne pas encore avoir ete lancee (le
+    // buffer reste alloue tant qu'elle ne l'a pas utilise)
+    stage->status = status;
+    return( NULL );
+}
+
+
+static const StageBuiltin* findStageBuiltin( const char* name )
+{
+    for( int i = 0; i < STAGE_COUNT; ++i )
+    {
+        if( strcmp( ALL_STAGES[i].name, name ) == 0 ) return( ALL_STAGES + i );
+    }
+
+    return( NULL );
+}
+
+
+static ssize_t readInput( Stage* stage, char* buffer, size_t size )
+{
+    // Lecture du buffer de l'etape precedente
+    if( stage->inRing != NULL ) return( readRing( stage->inRing, buffer, size ) );
+
+    // Lecture du descripteur (relancee si interrompue)
+    ssize_t count = -1;
+    do { count = read( stage->inFd, buffer, size ); } while( count == -1 && errno == EINTR );
+
+    return( count );
+}
+
+
+static int writeOutput( Stage* stage, const char* data, size_t length )
+{
+    if( stage->outputBroken ) return( -1 );
+
+    // Si les donnees ne tiennent pas dans le buffer, il est vide d'abord
+    if( stage->outputLength + length > STAGE_BUFFER_SIZE )
+    {
+        if( flushOutput( stage ) == -1 ) return( -1 );
+
+        // Les donnees plus grandes que le buffer sont ecrites directement
+        if( length > STAGE_BUFFER_SIZE )
+        {
+            while( length > 0 )
+            {
+                const size_t chunk = ( length > STAGE_BUFFER_SIZE ? STAGE_BUFFER_SIZE : length );
+                memcpy( stage->output, data, chunk );
+                stage->outputLength = chunk;
+                if( flushOutput( stage ) == -1 ) return( -1 );
+                data += chunk;
+                length -= chunk;
+            }
+            return( 0 );
+        }
+    }
+
+    // Ajout des donnees dans le buffer
+    memcpy( stage->output + stage->outputLength, data, length );
+    stage->outputLength += length;
+
+    return( 0 );
+}
+
+
+static int flushOutput( Stage* stage )
+{
+    if( stage->outputBroken ) return( -1 );
+
+    // Ecriture dans le buffer de l'etape suivante
+    const char* data = stage->output;
+    size_t length = stage->outputLength;
+    stage->outputLength = 0;
+    if( stage->outRing != NULL )
+    {
+        if( length > 0 && writeRing( stage->outRing, data, length ) == -1 ) stage->outputBroken = 1;
+        return( stage->outputBroken ? -1 : 0 );
+    }
+
+    // Ecriture sur le descripteur (relancee si interrompue ou partielle)
+    while( length > 0 )
+    {
+        const ssize_t count = write( stage->outFd, data, length );
+        if( count == -1 && errno == EINTR ) continue;
+        if( count <= 0 )
+        {
+            stage->outputBroken = 1;
+            return( -1 );
+        }
+        data += count;
+        length -= count;
+    }
+
+    return( 0 );
+}
+
+
+static int copyInput( Stage* stage, int fd )
+{
+    char buffer[STAGE_BUFFER_SIZE];
+    while( 1 )
+    {
+        // Lecture d'un bloc
+        ssize_t count = -1;
+        if( fd == -1 ) count = readInput( stage, buffer, sizeof( buffer ) );
+        else do { count = read( fd, buffer, sizeof( buffer ) ); } while( count == -1 && errno == EINTR );
+        if( count == 0 ) return( 0 );
+        if( count == -1 ) return( 1 );
+
+        // Ecriture du bloc
+        if( writeOutput( stage, buffer, count ) == -1 ) return( -1 );
+    }
+}
+
+
+static void printStageError( Stage* stage, const char* format, ... )
+{
+    va_list args;
+    va_start( args, format );
+    vdprintf( stage->errFd, format, args );
+    va_end( args );
+}
+
+
+static int isEchoOption( const char* arg )
+{
+    return( arg[0] == '-' && arg[1] != '\0' && strspn( arg + 1, "neE" ) == strlen( arg + 1 ) );
+}
+
+
+static int acceptEcho( const cmd_t* cmd )
+{
+    // Les sequences d'echappement (options -e et -E) ne sont pas prises en charge
+    for( int i = 1; i < cmd->argc && isEchoOption( cmd->argv[i] ); ++i )
+    {
+        if( strpbrk( cmd->argv[i], "eE" ) != NULL ) return( 0 );
+    }
+
+    return( 1 );
+}
+
+
+static int runEcho( Stage* stage )
+{
+    // Options (-n uniquement) : pas de retour a la ligne final
+    int newLine = 1;
+    int i = 1;
+    while( i < stage->argc && isEchoOption( stage->argv[i] ) )
+    {
+        newLine = 0;
+        ++i;
+    }
+
+    // Arguments, separes par des espaces
+    for( int first = i; i < stage->argc; ++i )
+    {
+        if( i > first && writeOutput( stage, " ", 1 ) == -1 ) return( STAGE_BROKEN_PIPE );
+        if( writeOutput( stage, stage->argv[i], strlen( stage->argv[i] ) ) == -1 ) return( STAGE_BROKEN_PIPE );
+    }
+    if( newLine && writeOutput( stage, "\n", 1 ) == -1 ) return( STAGE_BROKEN_PIPE );
+
+    return( 0 );
+}
+
+
+static int acceptCat( const cmd_t* cmd )
+{
+    // Pas d'options ("-" designe l'entree standard)
+    for( int i = 1; i < cmd->argc; ++i )
+    {
+        if( cmd->argv[i][0] == '-' && cmd->argv[i][1] != '\0' ) return( 0 );
+    }
+
+    return( 1 );
+}
+
+
+static int runCat( Stage* stage )
+{
+    // Sans fichier, recopie de l'entree
+    if( stage->argc == 1 ) return( copyInput( stage, -1 ) == 0 ? 0 : 1 );
+
+    // Sinon, recopie de chaque fichier
+    int status = 0;
+    for( int i = 1; i < stage->argc; ++i )
+    {
+        const char* file = stage->argv[i];
+        int result = 0;
+        if( strcmp( file, "-" ) == 0 )
+        {
+            result = copyInput( stage, -1 );
+        }
+        else
+        {
+            const int fd = open( file, O_RDONLY | O_CLOEXEC );
+            if( fd == -1 )
+            {
+                printStageError( stage, "cat: %s: %s\n", file, strerror( errno ) );
+                status = 1;
+                continue;
+            }
+            result = copyInput( stage, fd );
+            if( result == 1 ) printStageError( stage, "cat: %s: %s\n", file, strerror( errno ) );
+            close( fd );
+        }
+
+        // Sortie fermee : inutile de continuer
+        if( result == -1 ) return( STAGE_BROKEN_PIPE );
+        if( result == 1 ) status = 1;
+    }
+
+    return( status );
+}
+
+
+static int parseLineCount( const char* str, long* count )
+{
+    if( *str == '\0' || strspn( str, "0123456789" ) != strlen( str ) ) return( 0 );
+    *count = strtol( str, NULL, 10 );
+
+    return( 1 );
+}
+
+
+static int parseHeadArgs( int argc, char* const argv[], long* count, const char** file )
+{
+    *count = 10;
+    *file = NULL;
+
+    // Nombre de lignes : "-n N", "-nN" ou "-N"
+    int i = 1;
+    if( i < argc && strcmp( argv[i], "-n" ) == 0 )
+    {
+        if( i + 1 >= argc || ! parseLineCount( argv[i + 1], count ) ) return( 0 );
+        i += 2;
+    }
+    else if( i < argc && strncmp( argv[i], "-n", 2 ) == 0 )
+    {
+        if( ! parseLineCount( argv[i] + 2, count ) ) return( 0 );
+        ++i;
+    }
+    else if( i < argc && argv[i][0] == '-' && argv[i][1] != '\0' )
+    {
+        if( ! parseLineCount( argv[i] + 1, count ) ) return( 0 );
+        ++i;
+    }
+
+    // Fichier eventuel (un seul)
+    if( i < argc && argv[i][0] != '-' ) *file = argv[i++];
+
+    return( i == argc );
+}
+
+
+static int acceptHead( const cmd_t* cmd )
+{
+    long count = 0;
+    const char* file = NULL;
+    return( parseHeadArgs( cmd->argc, cmd->argv, &count, &file ) );
+}
+
+
+static int runHead( Stage* stage )
+{
+    long count = 0;
+    const char* file = NULL;
+    parseHeadArgs( stage->argc, stage->argv, &count, &file );
+
+    // Ouverture du fichier eventuel
+    int fd = -1;
+    if( file != NULL )
+    {
+        fd = open( file, O_RDONLY | O_CLOEXEC );
+        if( fd == -1 )
+        {
+            printStageError( stage, "head: cannot open '%s' for reading: %s\n", file, strerror( errno ) );
+            return( 1 );
+        }
+    }
+
+    // Recopie des premieres lignes. La lecture s'arrete des qu'elles sont ecrites.
+    char buffer[STAGE_BUFFER_SIZE];
+    int status = 0;
+    while( count > 0 )
+    {
+        ssize_t length = -1;
+        if( fd == -1 ) length = readInput( stage, buffer, sizeof( buffer ) );
+        else do { length = read( fd, buffer, sizeof( buffer ) ); } while( length == -1 && errno == EINTR );
+        if( length <= 0 )
+        {
+            status = ( length == 0 ? 0 : 1 );
+            break;
+        }
+
+        // Recherche de la fin de la derniere ligne a ecrire dans le bloc
+        ssize_t end = 0;
+        while( end < length && count > 0 )
+        {
+            if( buffer[end++] == '\n' ) --count;
+        }
+        if( writeOutput( stage, buffer, end ) == -1 )
+        {
+            status = STAGE_BROKEN_PIPE;
+            break;
+        }
+    }
+
+    if( fd != -1 ) close( fd );
+    return( status );
+}
+
+
+static int acceptWc( const cmd_t* cmd )
+{
+    // Lecture du pipeline uniquement (pas de fichier), avec les options -l, -w et -c
+    if( cmd->pipePrev == NULL ) return( 0 );
+    for( int i = 1; i < cmd->argc; ++i )
+    {
+        const char* arg = cmd->argv[i];
+        if( arg[0] != '-' || arg[1] == '\0' || strspn( arg + 1, "lwc" ) != strlen( arg + 1 ) ) return( 0 );
+    }
+
+    return( 1 );
+}
+
+
+static int runWc( Stage* stage )
+{
+    // Compteurs affiches (tous par defaut)
+    int showLines = 0;
+    int showWords = 0;
+    int showBytes = 0;
+    for( int i = 1; i < stage->argc; ++i )
+    {
+        if( strchr( stage->argv[i], 'l' ) != NULL ) showLines = 1;
+        if( strchr( stage->argv[i], 'w' ) != NULL ) showWords = 1;
+        if( strchr( stage->argv[i], 'c' ) != NULL ) showBytes = 1;
+    }
+    if( ! showLines && ! showWords && ! showBytes ) showLines = showWords = showBytes = 1;
+
+    // Comptage
+    long lines = 0;
+    long words = 0;
+    long bytes = 0;
+    int inWord = 0;
+    char buffer[STAGE_BUFFER_SIZE];
+    ssize_t length = 0;
+    while( ( length = readInput( stage, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        bytes += length;
+        for( ssize_t i = 0; i < length; ++i )
+        {
+            const unsigned char c = buffer[i];
+            if( c == '\n' ) ++lines;
+            if( isspace( c ) ) inWord = 0;
+            else if( ! inWord )
+            {
+                inWord = 1;
+                ++words;
+            }
+        }
+    }
+
+    // Affichage (comme wc : un compteur seul n'est pas aligne)
+    char line[64];
+    int lineLength = 0;
+    const long counts[3] = { lines, words, bytes };
+    const int shown[3] = { showLines, showWords, showBytes };
+    const int countShown = showLines + showWords + showBytes;
+    for( int i = 0; i < 3; ++i )
+    {
+        if( ! shown[i] ) continue;
+        lineLength += snprintf( line + lineLength, sizeof( line ) - lineLength, "%s%*ld", lineLength > 0 ? " " : "",
+                                countShown > 1 ? 7 : 0, counts[i] );
+    }
+    line[lineLength++] = '\n';
+    if( writeOutput( stage, line, lineLength ) == -1 ) return( STAGE_BROKEN_PIPE );
+
+    return( length == -1 ? 1 : 0 );
+}
+
+
+static int dupStageFd( int fd )
+{
+    // Copie du descripteur, hors des descripteurs utilisables dans les redirections
+    const int copy = fcntl( fd, F_DUPFD_CLOEXEC, MAX_CMD_FD );
+    if( copy == -1 ) return( -1 );
+
+    // Enregistrement de la copie dans une entree libre
+    for( int i = 0; i < MAX_STAGE_FDS; ++i )
+    {
+        int free = 0;
+        if( atomic_compare_exchange_strong( stageFds + i, &free, copy + 1 ) ) return( copy );
+    }
+
+    // Plus d'entree libre
+    close( copy );
+    return( -1 );
+}
+
+
+static void closeStageFd( int* fd )
+{
+    if( *fd == -1 ) return;
+
+    // L'entree est liberee avant la fermeture du descripteur : un processus fils cree entre-temps le referme
+    // lui-meme (il en a une copie)
+    for( int i = 0; i < MAX_STAGE_FDS; ++i )
+    {
+        int registered = *fd + 1;
+        if( atomic_compare_exchange_strong( stageFds + i, &registered, 0 ) ) break;
+    }
+    close( *fd );
+    *fd = -1;
+}
+
+
+static StageRing* createRing( void )
+{
+    StageRing* ring = (StageRing*)malloc( sizeof( StageRing ) );
+    if( ring == NULL ) return( NULL );
+
+    // Buffer vide, utilise par le producteur et le consommateur
+    atomic_init( &ring->head, 0 );
+    atomic_init( &ring->tail, 0 );
+    atomic_init( &ring->writerClosed, 0 );
+    atomic_init( &ring->readerClosed, 0 );
+    atomic_init( &ring->dataSeq, 0 );
+    atomic_init( &ring->readerWaiting, 0 );
+    atomic_init( &ring->spaceSeq, 0 );
+    atomic_init( &ring->writerWaiting, 0 );
+    atomic_init( &ring->refs, 2 );
+
+    return( ring );
+}
+
+
+static ssize_t readRing( StageRing* ring, char* buffer, size_t size )
+{
+    const unsigned tail = atomic_load_explicit( &ring->tail, memory_order_relaxed );
+    while( 1 )
+    {
+        // Le compteur d'evenements est lu avant l'etat du buffer : un evenement posterieur reveille l'attente
+        const unsigned seq = atomic_load( &ring->dataSeq );
+        const unsigned head = atomic_load( &ring->head );
+
+        // Donnees disponibles : recopie (en 2 fois si elles font le tour du buffer)
+        if( head != tail )
+        {
+            size_t count = head - tail;
+            if( count > size ) count = size;
+            const size_t start = tail & ( STAGE_RING_SIZE - 1 );
+            const size_t first = ( count < STAGE_RING_SIZE - start ? count : STAGE_RING_SIZE - start );
+            memcpy( buffer, ring->data + start, first );
+            memcpy( buffer + first, ring->data, count - first );
+
+            // La place liberee est signalee au producteur
+            atomic_store( &ring->tail, tail + count );
+            notifyRing( &ring->writerWaiting, &ring->spaceSeq );
+            return( count );
+        }
+
+        // Producteur termine : fin de fichier si ses dernieres donnees (ecrites avant sa fin) ont ete lues
+        if( atomic_load( &ring->writerClosed ) )
+        {
+            if( atomic_load( &ring->head ) == tail ) return( 0 );
+            continue;
+        }
+
+        // Sinon, attente d'un evenement (apres avoir signale l'attente, l'etat est reverifie)
+        atomic_store( &ring->readerWaiting, 1 );
+        if( atomic_load( &ring->head ) == tail && ! atomic_load( &ring->writerClosed ) )
+        {
+            syscall( SYS_futex, &ring->dataSeq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0 );
+        }
+        atomic_store( &ring->readerWaiting, 0 );
+    }
+}
+
+
+static int writeRing( StageRing* ring, const char* data, size_t length )
+{
+    unsigned head = atomic_load_explicit( &ring->head, memory_order_relaxed );
+    while( length > 0 )
+    {
+        // Le consommateur a termine : les donnees ne seront jamais lues
+        const unsigned seq = atomic_load( &ring->spaceSeq );
+        if( atomic_load( &ring->readerClosed ) ) return( -1 );
+
+        // Place disponible : recopie (en 2 fois si elle fait le tour du buffer)
+        const unsigned tail = atomic_load( &ring->tail );
+        size_t count = STAGE_RING_SIZE - ( head - tail );
+        if( count > 0 )
+        {
+            if( count > length ) count = length;
+            const size_t start = head & ( STAGE_RING_SIZE - 1 );
+            const size_t first = ( count < STAGE_RING_SIZE - start ? count : STAGE_RING_SIZE - start );
+            memcpy( ring->data + start, data, first );
+            memcpy( ring->data, data + first, count - first );
+
+            // Les donnees sont signalees au consommateur
+            head += count;
+            atomic_store( &ring->head, head );
+            notifyRing( &ring->readerWaiting, &ring->dataSeq );
+            data += count;
+            length -= count;
+            continue;
+        }
+
+        // Sinon, attente d'un evenement (apres avoir signale l'attente, l'etat est reverifie)
+        atomic_store( &ring->writerWaiting, 1 );
+        if( atomic_load( &ring->tail ) == tail && ! atomic_load( &ring->readerClosed ) )
+        {
+            syscall( SYS_futex, &ring->spaceSeq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0 );
+        }
+        atomic_store( &ring->writerWaiting, 0 );
+    }
+
+    return( 0 );
+}
+
+
+static void closeRing( StageRing* ring, int writer )
+{
+    // L'autre etape est prevenue (meme si elle n'a pas signale d'attente)
+    atomic_store( writer ? &ring->writerClosed : &ring->readerClosed, 1 );
+    atomic_uint* seq = ( writer ? &ring->dataSeq : &ring->spaceSeq );
+    atomic_fetch_add( seq, 1 );
+    syscall( SYS_futex, seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+
+    // Liberation par la derniere etape
+    if( atomic_fetch_sub( &ring->refs, 1 ) == 1 ) free( ring );
+}
+
+
+static void notifyRing( atomic_int* waiting, atomic_uint* seq )
+{
+    if( atomic_load( waiting ) )
+    {
+        atomic_fetch_add( seq, 1 );
+        syscall( SYS_futex, seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+    }
+}
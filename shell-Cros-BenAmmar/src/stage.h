@@ -0,0 +1,75 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Etapes de pipeline executees dans des threads du minishell (option "threadstages").
+ *
+ *  Dans un pipeline au premier plan, les etapes "echo", "cat", "head" et "wc" (avec des arguments simples) sont
+ *  executees par un thread du minishell plutot que par un processus : elles ne coutent pas de fork. Deux etapes
+ *  voisines executees dans des threads communiquent par un buffer circulaire en memoire (un producteur, un
+ *  consommateur, sans verrou) plutot que par un pipe du noyau. Aux limites avec les processus du pipeline, le
+ *  pipe cree lors du parsing est utilise.
+ *
+ *  Une etape dont les arguments ne sont pas pris en charge (options non supportees) est executee normalement,
+ *  par le programme correspondant.
+ *
+ *  Les descripteurs utilises par les threads sont des copies (fermees automatiquement lors d'un exec), que le
+ *  minishell peut donc refermer comme pour une etape executee par un processus. Les processus fils du minishell
+ *  les referment des leur creation (voir closeStageFds()).
+ */
+
+#ifndef _STAGE_H_
+#define _STAGE_H_
+
+#include "cmd.h"
+
+
+// Codes d'erreur
+enum StageError
+{
+    STAGE_OK = 0,               // Pas d'erreur
+    STAGE_START_FAILED = 140    // Echec de creation du thread (ou du buffer) d'une etape
+};
+
+
+/*
+ * Teste si une commande peut etre executee dans un thread du minishell (etape prise en charge d'un pipeline au
+ * premier plan, option "threadstages" active)
+ *
+ * cmd : la commande
+ * retourne 1 si la commande peut etre executee dans un thread, sinon 0
+ */
+int canRunStage( const cmd_t* cmd );
+
+/*
+ * Lance l'execution d'une etape de pipeline dans un thread du minishell. L'etape lit la sortie de l'etape
+ * precedente si celle-ci est aussi executee dans un thread, sinon son entree standard (en general le pipe).
+ * Si l'etape suivante peut aussi etre executee dans un thread, le pipe qui les relie est remplace par un buffer
+ * en memoire.
+ *
+ * cmd : la commande (voir canRunStage())
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int startStage( cmd_t* cmd );
+
+/*
+ * Se synchronise avec la fin d'une etape executee dans un thread, et libere ses ressources
+ *
+ * cmd : la commande
+ * retourne le code de retour de l'etape
+ */
+int joinStage( cmd_t* cmd );
+
+/*
+ * Referme, dans un processus fils du minishell, les descripteurs utilises par les threads des etapes en cours
+ * d'execution (les threads n'existent pas dans le processus fils)
+ */
+void closeStageFds( void );
+
+
+#endif // _STAGE_H_
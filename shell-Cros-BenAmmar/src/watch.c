@@ -0,0 +1,431 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : cmd.h parser.h ringbuf.h
+ *
+ *  Re-execution d'une ligne de commande a chaque modification de fichiers (implementation)
+ */
+
+#include "watch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Delai par defaut sans evenement avant une execution (en millisecondes)
+#define WATCH_DEFAULT_DEBOUNCE  100
+
+// Attente maximale avant une execution, en nombre de delais, si les evenements ne cessent pas
+#define WATCH_MAX_DELAY_FACTOR  10
+
+// Nombre max de chemins surveilles (option --paths)
+#define WATCH_MAX_PATHS         64
+
+// Evenements surveilles dans chaque repertoire
+#define WATCH_MASK              ( IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB )
+
+// Message d'utilisation de la builtin 'watch'
+static const char* WATCH_USAGE = "ERREUR - Usage: watch [--paths CHEMIN...] [--debounce MS] -- LIGNE\n";
+
+// Repertoire surveille :
+// - wd : descripteur de surveillance inotify (-1 si la surveillance a pris fin)
+// - path : chemin du repertoire
+// - name : nom du fichier surveille dans le repertoire, ou NULL pour tout le repertoire (et ses sous-repertoires)
+typedef struct
+{
+    int wd;
+    char* path;
+    char* name;
+} WatchEntry;
+
+// Surveillance en cours :
+// - fd : descripteur inotify
+// - entries : repertoires surveilles
+// - count : nombre de repertoires surveilles
+// - capacity : taille allouee de la liste des repertoires
+typedef struct
+{
+    int fd;
+    WatchEntry* entries;
+    int count;
+    int capacity;
+} Watcher;
+
+// Vrai si SIGINT a ete recu pendant la surveillance
+static volatile sig_atomic_t interrupted = 0;
+
+/*
+ * Gestionnaire de SIGINT pendant la surveillance
+ *
+ * sig : le signal
+ */
+static void onInterrupt( int sig );
+
+/*
+ * Ajoute un chemin a surveiller : un repertoire avec ses sous-repertoires, ou un fichier par son repertoire
+ *
+ * watcher : la surveillance
+ * path : le chemin
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addPath( Watcher* watcher, const char* path );
+
+/*
+ * Surveille un repertoire et ses sous-repertoires (hors repertoires caches)
+ *
+ * watcher : la surveillance
+ * path : le repertoire
+ * retourne 0 en cas de succes (pour le repertoire lui-meme), sinon un code d'erreur
+ */
+static int addTree( Watcher* watcher, const char* path );
+
+/*
+ * Surveille un repertoire
+ *
+ * watcher : la surveillance
+ * path : le repertoire
+ * name : nom du seul fichier surveille dans le repertoire, ou NULL pour tout le repertoire
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int addWatch( Watcher* watcher, const char* path, const char* name );
+
+/*
+ * Attend une modification des chemins surveilles, puis regroupe les evenements qui la suivent
+ *
+ * watcher : la surveillance
+ * debounce : delai sans evenement qui termine le regroupement (en millisecondes)
+ * retourne le nombre d'evenements regroupes, ou -1 si la surveillance est interrompue
+ */
+static int waitChanges( Watcher* watcher, long debounce );
+
+/*
+ * Lit les evenements disponibles, et surveille les repertoires crees
+ *
+ * watcher : la surveillance
+ * retourne le nombre d'evenements qui concernent les chemins surveilles
+ */
+static int readEvents( Watcher* watcher );
+
+/*
+ * Retourne l'heure de l'horloge monotone, en millisecondes
+ */
+static int64_t getTimeMs( void );
+
+/*
+ * Termine une surveillance (descripteur inotify et liste des repertoires)
+ *
+ * watcher : la surveillance
+ */
+static void freeWatcher( Watcher* watcher );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int runWatch( cmd_t* cmd )
+{
+    // La ligne a re-executer est analysee avec la commande (elle suit "--")
+    if( cmd->watchBody == NULL )
+    {
+        fprintf( stderr, "%s", WATCH_USAGE );
+        return( WATCH_BAD_ARGS );
+    }
+
+    // Decodage des options
+    const char* paths[WATCH_MAX_PATHS];
+    int pathCount = 0;
+    long debounce = WATCH_DEFAULT_DEBOUNCE;
+    for( int i = 1; i < cmd->argc; ++i )
+    {
+        // Chemins surveilles, jusqu'a l'option suivante
+        int valid = 1;
+        if( strcmp( cmd->argv[i], "--paths" ) == 0 && i + 1 < cmd->argc )
+        {
+            while( i + 1 < cmd->argc && strncmp( cmd->argv[i + 1], "--", 2 ) != 0 && pathCount < WATCH_MAX_PATHS )
+            {
+                paths[pathCount++] = cmd->argv[++i];
+            }
+        }
+
+        // Delai de regroupement des evenements
+        else if( strcmp( cmd->argv[i], "--debounce" ) == 0 && i + 1 < cmd->argc )
+        {
+            char* end = NULL;
+            debounce = strtol( cmd->argv[++i], &end, 10 );
+            valid = ( *end == '\0' && end != cmd->argv[i] && debounce >= 0 );
+        }
+        else
+        {
+            valid = 0;
+        }
+
+        // Option inconnue ou incomplete
+        if( ! valid )
+        {
+            fprintf( stderr, "%s", WATCH_USAGE );
+            return( WATCH_BAD_ARGS );
+        }
+    }
+    if( pathCount == 0 ) paths[pathCount++] = ".";
+
+    // Surveillance des chemins
+    Watcher watcher = { inotify_init1( IN_NONBLOCK | IN_CLOEXEC ), NULL, 0, 0 };
+    if( watcher.fd == -1 )
+    {
+        fprintf( stderr, "ERREUR - Initialisation d'inotify impossible (%s)\n", strerror( errno ) );
+        return( WATCH_INOTIFY_ERROR );
+    }
+    for( int i = 0; i < pathCount; ++i )
+    {
+        if( addPath( &watcher, paths[i] ) == WATCH_OK ) continue;
+        freeWatcher( &watcher );
+        return( WATCH_INOTIFY_ERROR );
+    }
+
+    // SIGINT termine la surveillance plutot que le minishell (les appels systeme interrompus sont repris, sauf
+    // l'attente des evenements)
+    struct sigaction action;
+    struct sigaction previous;
+    memset( &action, 0, sizeof( action ) );
+    action.sa_handler = onInterrupt;
+    action.sa_flags = SA_RESTART;
+    sigemptyset( &action.sa_mask );
+    interrupted = 0;
+    sigaction( SIGINT, &action, &previous );
+
+    // Execution de la ligne, puis a chaque modification (les evenements recus pendant une execution declenchent
+    // l'execution suivante)
+    int status = 0;
+    int events = 0;
+    for( int run = 1; ! interrupted; ++run )
+    {
+        if( run > 1 ) fprintf( stderr, "watch : %d evenement(s), execution %d\n", events, run );
+        status = execWatchBody( cmd );
+        fflush( stdout );
+        if( interrupted || ( events = waitChanges( &watcher, debounce ) ) < 0 ) break;
+    }
+
+    // Fin de la surveillance
+    sigaction( SIGINT, &previous, NULL );
+    freeWatcher( &watcher );
+    return( status );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void onInterrupt( int sig )
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+
+static int addPath( Watcher* watcher, const char* path )
+{
+    // Repertoire
+    struct stat st;
+    if( stat( path, &st ) == 0 && S_ISDIR( st.st_mode ) ) return( addTree( watcher, path ) );
+
+    // Fichier (existant ou non) : surveille par son repertoire
+    char dir[PATH_MAX];
+    const char* slash = strrchr( path, '/' );
+    if( slash == NULL ) strcpy( dir, "." );
+    else if( slash == path ) strcpy( dir, "/" );
+    else snprintf( dir, sizeof( dir ), "%.*s", (int)( slash - path ), path );
+    const char* name = ( slash == NULL ? path : slash + 1 );
+    if( name[0] == '\0' )
+    {
+        fprintf( stderr, "ERREUR - Surveillance impossible : %s\n", path );
+        return( WATCH_BAD_ARGS );
+    }
+
+    return( addWatch( watcher, dir, name ) );
+}
+
+
+static int addTree( Watcher* watcher, const char* path )
+{
+    // Le repertoire lui-meme
+    const int status = addWatch( watcher, path, NULL );
+    if( status != WATCH_OK ) return( status );
+
+    // Ses sous-repertoires (les liens symboliques ne sont pas suivis)
+    DIR* stream = opendir( path );
+    struct dirent* entry = NULL;
+    while( stream != NULL && ( entry = readdir( stream ) ) != NULL )
+    {
+        if( entry->d_name[0] == '.' ) continue;
+        char child[PATH_MAX];
+        struct stat st;
+        snprintf( child, sizeof( child ), "%s/%s", path, entry->d_name );
+        if( entry->d_type == DT_DIR || ( entry->d_type == DT_UNKNOWN && lstat( child, &st ) == 0 &&
+                                         S_ISDIR( st.st_mode ) ) )
+        {
+            addTree( watcher, child );
+        }
+    }
+    if( stream != NULL ) closedir( stream );
+
+    return( WATCH_OK );
+}
+
+
+static int addWatch( Watcher* watcher, const char* path, const char* name )
+{
+    // Surveillance du repertoire (un repertoire deja surveille garde le meme descripteur)
+    const int wd = inotify_add_watch( watcher->fd, path, WATCH_MASK );
+    if( wd == -1 )
+    {
+        fprintf( stderr, "ERREUR - Surveillance impossible : %s (%s)\n", path, strerror( errno ) );
+        return( WATCH_INOTIFY_ERROR );
+    }
+
+    // Agrandissement de la liste des repertoires si besoin
+    if( watcher->count == watcher->capacity )
+    {
+        const int capacity = ( watcher->capacity == 0 ? 16 : watcher->capacity * 2 );
+        WatchEntry* entries = (WatchEntry*)realloc( watcher->entries, capacity * sizeof( WatchEntry ) );
+        if( entries == NULL ) return( WATCH_INOTIFY_ERROR );
+        watcher->entries = entries;
+        watcher->capacity = capacity;
+    }
+
+    // Ajout du repertoire
+    WatchEntry* entry = watcher->entries + watcher->count++;
+    entry->wd = wd;
+    entry->path = strdup( path );
+    entry->name = ( name != NULL ? strdup( name ) : NULL );
+
+    return( WATCH_OK );
+}
+
+
+static int waitChanges( Watcher* watcher, long debounce )
+{
+    struct pollfd pollFd = { watcher->fd, POLLIN, 0 };
+    int events = 0;
+    int64_t first = 0;
+    while( ! interrupted )
+    {
+        // Avant le premier evenement, attente sans limite ; ensuite, attente d'un silence de 'debounce'
+        // millisecondes, sans depasser l'attente maximale depuis le premier evenement
+        int timeout = -1;
+        if( events > 0 )
+        {
+            const int64_t remaining = first + debounce * WATCH_MAX_DELAY_FACTOR - getTimeMs();
+            if( remaining <= 0 ) return( events );
+            timeout = (int)( debounce < remaining ? debounce : remaining );
+        }
+
+        // Attente (interrompue par les signaux, SIGCHLD compris)
+        const int ready = poll( &pollFd, 1, timeout );
+        if( ready == -1 && errno == EINTR ) continue;
+        if( ready == -1 ) return( -1 );
+        if( ready == 0 ) return( events );
+
+        // Lecture des evenements
+        const int count = readEvents( watcher );
+        if( count > 0 && events == 0 ) first = getTimeMs();
+        events += count;
+    }
+
+    return( -1 );
+}
+
+
+static int readEvents( Watcher* watcher )
+{
+    // Tampon aligne comme les evenements
+    char buffer[4096] __attribute__(( aligned( __alignof__( struct inotify_event ) ) ));
+    int events = 0;
+    ssize_t length = 0;
+    while( ( length = read( watcher->fd, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        const char* position = buffer;
+        while( position < buffer + length )
+        {
+            const struct inotify_event* event = (const struct inotify_event*)position;
+            position += sizeof( struct inotify_event ) + event->len;
+
+            // Evenements perdus (file pleine) : on considere qu'il y a eu une modification
+            if( event->mask & IN_Q_OVERFLOW )
+            {
+                ++events;
+                continue;
+            }
+
+            // Repertoires concernes par l'evenement
+            const char* name = ( event->len > 0 ? event->name : "" );
+            for( int i = 0; i < watcher->count; ++i )
+            {
+                WatchEntry* entry = watcher->entries + i;
+                if( entry->wd != event->wd ) continue;
+
+                // Fin de la surveillance du repertoire (repertoire supprime)
+                if( event->mask & IN_IGNORED )
+                {
+                    entry->wd = -1;
+                    continue;
+                }
+
+                // Fichier surveille par son repertoire
+                if( entry->name != NULL )
+                {
+                    if( strcmp( entry->name, name ) == 0 ) ++events;
+                    continue;
+                }
+
+                // Repertoire surveille en entier (hors fichiers caches), et repertoires crees (la liste des
+                // repertoires peut alors etre reallouee)
+                if( name[0] == '.' ) continue;
+                ++events;
+                if( ( event->mask & IN_ISDIR ) && ( event->mask & ( IN_CREATE | IN_MOVED_TO ) ) )
+                {
+                    char path[PATH_MAX];
+                    snprintf( path, sizeof( path ), "%s/%s", entry->path, name );
+                    addTree( watcher, path );
+                }
+            }
+        }
+    }
+
+    return( events );
+}
+
+
+static int64_t getTimeMs( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000 );
+}
+
+
+static void freeWatcher( Watcher* watcher )
+{
+    for( int i = 0; i < watcher->count; ++i )
+    {
+        free( watcher->entries[i].path );
+        free( watcher->entries[i].name );
+    }
+    free( watcher->entries );
+    close( watcher->fd );
+}
@@ -0,0 +1,56 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Re-execution d'une ligne de commande a chaque modification de fichiers : builtin
+ *  'watch [--paths CHEMIN...] [--debounce MS] -- LIGNE'.
+ *
+ *  La ligne qui suit "--" (jusqu'a la fin de la ligne de commande, separateurs compris) est analysee une seule
+ *  fois, comme le corps d'une fonction (voir func.h) : ses commandes modeles sont conservees par la commande
+ *  'watch', et seuls leurs arguments (variables, motifs, redirections) sont traites a chaque execution. 'watch'
+ *  n'est reconnue qu'en dehors des groupes et des corps de fonctions.
+ *
+ *  La ligne est executee une premiere fois, puis a chaque modification des chemins surveilles (repertoire
+ *  courant par defaut) signalee par inotify : un repertoire est surveille avec ses sous-repertoires (y compris
+ *  ceux crees ensuite), un fichier par l'intermediaire de son repertoire (il peut donc etre remplace, ou ne pas
+ *  encore exister). Les fichiers et repertoires caches (nom commencant par '.') sont ignores.
+ *
+ *  Les evenements sont regroupes : une execution n'est lancee qu'apres --debounce millisecondes sans nouvel
+ *  evenement (100 par defaut), et au plus tard apres 10 fois ce delai si les evenements ne cessent pas. Les
+ *  executions ne se chevauchent pas : les modifications survenues pendant une execution declenchent une seule
+ *  execution suivante (la ligne ne doit donc pas modifier les chemins surveilles). 'watch' se termine sur Ctrl-C
+ *  (SIGINT, recu aussi par les commandes en cours au premier plan), apres la fin de l'execution en cours, et
+ *  retourne le code de retour de la derniere execution.
+ */
+
+#ifndef _WATCH_H_
+#define _WATCH_H_
+
+#include "cmd.h"
+
+
+// Codes d'erreur
+enum WatchError
+{
+    WATCH_OK = 0,               // Pas d'erreur
+    WATCH_BAD_ARGS = 270,       // Erreur d'utilisation (arguments) de la builtin 'watch'
+    WATCH_INOTIFY_ERROR         // Surveillance des chemins impossible
+};
+
+
+/*
+ * Execute la builtin 'watch' (dans le processus du minishell) : execute la ligne qui suit "--", puis la
+ * re-execute a chaque modification des chemins surveilles, jusqu'a la reception de SIGINT
+ *
+ * cmd : la commande 'watch' (ses arguments sont les options, la ligne est dans 'watchBody')
+ * retourne le code de retour de la derniere execution de la ligne, ou un code d'erreur
+ */
+int runWatch( cmd_t* cmd );
+
+
+#endif // _WATCH_H_
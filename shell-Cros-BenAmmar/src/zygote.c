@@ -0,0 +1,482 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : frame.h cmd.h metrics.h placement.h
+ *
+ *  Zygote de lancement des commandes externes (implementation)
+ */
+
+#define _GNU_SOURCE
+
+#include "zygote.h"
+#include "frame.h"
+#include "cmd.h"
+#include "metrics.h"
+#include "placement.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+
+//--- Declaration des types et fonctions locales ---------------------------------------------------------------
+
+// Taille max d'une demande de lancement (arguments et environnement compris)
+#define MAX_SPAWN_REQUEST   ( 256 * 1024 )
+
+// Nombre max de processus du zygote en cours d'execution
+#define MAX_ZYGOTE_CHILDREN 1024
+
+// Variables d'environnement du minishell
+extern char** environ;
+
+// Socket de communication avec le zygote (ou -1 si le zygote n'est pas actif)
+static int zygoteSock = -1;
+
+// Processus crees par le zygote et pas encore attendus. Pour chacun, on memorise s'il est termine et son
+// code de terminaison (les terminaisons arrivent dans un ordre quelconque)
+static struct
+{
+    pid_t pid;
+    int exited;
+    int status;
+} zygoteChildren[MAX_ZYGOTE_CHILDREN];
+static int zygoteChildCount = 0;
+
+// Dans le zygote : processus dont la terminaison doit etre signalee au minishell par SIGCHLD
+static pid_t notifiedPids[MAX_ZYGOTE_CHILDREN];
+static int notifiedPidCount = 0;
+
+/*
+ * Boucle principale du zygote : traitement des demandes de lancement, et signalement des terminaisons.
+ *
+ * sock : socket de communication avec le minishell
+ */
+static void zygoteLoop( int sock );
+
+/*
+ * Lancement d'une commande dans le zygote
+ *
+ * sock : socket de communication avec le minishell
+ * request : demande de lancement recue
+ * fds : entree, sortie et erreur standards de la commande
+ */
+static void spawnCmd( int sock, char* request, const int fds[3] );
+
+/*
+ * Reception et traitement d'une trame du zygote (cote minishell)
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+static int readZygoteFrame( pid_t* spawnedPid );
+
+/*
+ * Recherche un processus cree par le zygote
+ *
+ * pid : PID du processus
+ * retourne l'index du processus dans la table, ou -1 s'il n'est pas trouve
+ */
+static int findZygoteChild( pid_t pid );
+
+/*
+ * Retire un processus de la table des processus crees par le zygote
+ *
+ * index : index du processus dans la table
+ */
+static void removeZygoteChild( int index );
+
+/*
+ * Calcule la taille d'une demande de lancement (hors repertoire courant)
+ *
+ * argv : arguments de la commande (termines par NULL)
+ * header : en sortie, nombres d'arguments et de variables d'environnement mis a jour
+ * retourne la taille de la demande, en octets
+ */
+static size_t getSpawnRequestLength( char* const argv[], SpawnRequest* header );
+
+
+//--- Implementation des fonctions publiques -------------------------------------------------------------------
+
+int startZygote( void )
+{
+    // Paire de sockets de communication
+    int socks[2] = {-1, -1};
+    if( socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, socks ) == -1 ) return( ZYGOTE_START_FAILED );
+
+    // Creation du zygote
+    switch( fork() )
+    {
+        // Erreur
+        case -1:
+            close( socks[0] );
+            close( socks[1] );
+            return( ZYGOTE_START_FAILED );
+
+        // Zygote
+        case 0:
+            close( socks[0] );
+            zygoteLoop( socks[1] );
+            _exit( 0 );
+
+        // Minishell
+        default:
+            close( socks[1] );
+
+            // La socket est placee hors des descripteurs utilisables dans les redirections
+            zygoteSock = moveShellFd( socks[0] );
+            if( zygoteSock == -1 ) return( ZYGOTE_START_FAILED );
+            break;
+    }
+
+    return( ZYGOTE_OK );
+}
+
+
+int isZygoteActive( void )
+{
+    return( zygoteSock != -1 );
+}
+
+
+void detachZygote( void )
+{
+    // Fermeture de la copie de la socket (le zygote ne la voit pas se fermer tant que le minishell l'utilise)
+    if( zygoteSock != -1 ) close( zygoteSock );
+    zygoteSock = -1;
+
+    // Les processus deja crees par le zygote sont attendus par le minishell
+    zygoteChildCount = 0;
+}
+
+
+int zygoteCanSpawn( char* const argv[] )
+{
+    // Le repertoire courant est compte avec sa taille max
+    SpawnRequest header = { -1, 0, 0, 0 };
+    return( isZygoteActive() && zygoteChildCount < MAX_ZYGOTE_CHILDREN &&
+            getSpawnRequestLength( argv, &header ) + MAX_LINE_SIZE <= MAX_SPAWN_REQUEST );
+}
+
+
+pid_t zygoteSpawn( char* const argv[], const int stdFds[3], int pipeStage, int notify )
+{
+    // La table des processus ne doit pas etre pleine
+    if( zygoteChildCount >= MAX_ZYGOTE_CHILDREN ) return( -1 );
+
+    // Repertoire courant (le zygote ne suit pas les changements de repertoire du minishell)
+    char cwd[MAX_LINE_SIZE];
+    if( getcwd( cwd, sizeof( cwd ) ) == NULL ) strcpy( cwd, "." );
+
+    // Entete de la demande
+    SpawnRequest header = { pipeStage, notify, 0, 0 };
+    const size_t length = getSpawnRequestLength( argv, &header ) + strlen( cwd ) + 1;
+    if( length > MAX_SPAWN_REQUEST ) return( -1 );
+
+    // Construction de la demande : entete, repertoire courant, arguments et environnement
+    char* request = (char*)malloc( length );
+    if( request == NULL ) return( -1 );
+    char* p = request;
+    memcpy( p, &header, sizeof( header ) );
+    p = stpcpy( p + sizeof( header ), cwd ) + 1;
+    for( uint32_t i = 0; i < header.argc; ++i ) p = stpcpy( p, argv[i] ) + 1;
+    for( uint32_t i = 0; i < header.envc; ++i ) p = stpcpy( p, environ[i] ) + 1;
+
+    // Envoi de la demande
+    const int status = sendFrame( zygoteSock, ZYGOTE_SPAWN, request, length, stdFds, 3 );
+    free( request );
+    if( status != FRAME_OK ) return( -1 );
+
+    // Attente du PID (des terminaisons d'autres processus peuvent arriver avant)
+    pid_t pid = 0;
+    while( pid == 0 )
+    {
+        if( readZygoteFrame( &pid ) != ZYGOTE_OK ) return( -1 );
+    }
+    if( pid == -1 ) return( -1 );
+
+    // Enregistrement du nouveau processus
+    zygoteChildren[zygoteChildCount].pid = pid;
+    zygoteChildren[zygoteChildCount].exited = 0;
+    zygoteChildren[zygoteChildCount].status = 0;
+    ++zygoteChildCount;
+
+    return( pid );
+}
+
+
+int isZygoteChild( pid_t pid )
+{
+    return( zygoteSock != -1 && findZygoteChild( pid ) != -1 );
+}
+
+
+pid_t zygoteWait( pid_t pid, int* status )
+{
+    // Le processus doit avoir ete cree par le zygote
+    int index = findZygoteChild( pid );
+    if( index == -1 ) return( -1 );
+
+    // Reception des trames jusqu'a la terminaison du processus
+    while( ! zygoteChildren[index].exited )
+    {
+        if( readZygoteFrame( NULL ) != ZYGOTE_OK ) return( -1 );
+        index = findZygoteChild( pid );
+    }
+
+    // Le processus est attendu : il est retire de la table
+    if( status != NULL ) *status = zygoteChildren[index].status;
+    removeZygoteChild( index );
+
+    return( pid );
+}
+
+
+pid_t zygoteReap( int* status )
+{
+    // Si le zygote n'est pas actif, aucun processus
+    if( zygoteSock == -1 ) return( 0 );
+
+    // Reception des trames deja disponibles
+    struct pollfd pfd = { zygoteSock, POLLIN, 0 };
+    while( poll( &pfd, 1, 0 ) > 0 )
+    {
+        if( readZygoteFrame( NULL ) != ZYGOTE_OK ) break;
+    }
+
+    // Recherche d'un processus termine
+    for( int i = 0; i < zygoteChildCount; ++i )
+    {
+        if( zygoteChildren[i].exited )
+        {
+            const pid_t pid = zygoteChildren[i].pid;
+            if( status != NULL ) *status = zygoteChildren[i].status;
+            removeZygoteChild( i );
+            return( pid );
+        }
+    }
+
+    return( 0 );
+}
+
+
+//--- Implementation des fonctions locales ---------------------------------------------------------------------
+
+static void zygoteLoop( int sock )
+{
+    // Les terminaisons des processus sont recues via un signalfd (et non via un callback)
+    sigset_t mask;
+    sigemptyset( &mask );
+    sigaddset( &mask, SIGCHLD );
+    sigprocmask( SIG_BLOCK, &mask, NULL );
+    signal( SIGCHLD, SIG_DFL );
+    const int sigFd = signalfd( -1, &mask, SFD_CLOEXEC );
+
+    // Buffer de reception des demandes (sans lui, le zygote se termine : ses lancements echouent ensuite, comme
+    // s'il avait ete arrete)
+    char* request = (char*)malloc( MAX_SPAWN_REQUEST );
+    if( request == NULL ) return;
+
+    // Boucle de traitement des evenements
+    struct pollfd pfds[2] = { { sock, POLLIN, 0 }, { sigFd, POLLIN, 0 } };
+    while( 1 )
+    {
+        if( poll( pfds, 2, -1 ) == -1 )
+        {
+            if( errno == EINTR ) continue;
+            break;
+        }
+
+        // Demande de lancement
+        if( pfds[0].revents != 0 )
+        {
+            FrameHeader header;
+            int fds[MAX_FRAME_FDS];
+            int fdCount = 0;
+            const int status = recvFrame( sock, &header, request, MAX_SPAWN_REQUEST - 1, fds, &fdCount );
+
+            // Fin du minishell : le zygote se termine
+            if( status == FRAME_CLOSED || status == FRAME_IO_FAILED ) break;
+
+            // Lancement de la commande
+            if( status == FRAME_OK && header.type == ZYGOTE_SPAWN && fdCount == 3 )
+            {
+                spawnCmd( sock, request, fds );
+            }
+            else
+            {
+                const int32_t pid = -1;
+                sendFrame( sock, ZYGOTE_PID, &pid, sizeof( pid ), NULL, 0 );
+            }
+
+            // Les descripteurs ne sont plus utiles dans le zygote
+            for( int i = 0; i < fdCount; ++i ) close( fds[i] );
+        }
+
+        // Terminaison d'un ou plusieurs processus
+        if( pfds[1].revents != 0 )
+        {
+            struct signalfd_siginfo info;
+            if( read( sigFd, &info, sizeof( info ) ) <= 0 ) continue;
+
+            // Signalement de chaque processus termine
+            int notify = 0;
+            SpawnExit spawnExit;
+            while( ( spawnExit.pid = waitpid( -1, &spawnExit.status, WNOHANG ) ) > 0 )
+            {
+                sendFrame( sock, ZYGOTE_EXIT, &spawnExit, sizeof( spawnExit ), NULL, 0 );
+
+                // Si la commande etait en background, le minishell doit etre prevenu
+                for( int i = 0; i < notifiedPidCount; ++i )
+                {
+                    if( notifiedPids[i] == spawnExit.pid )
+                    {
+                        notifiedPids[i] = notifiedPids[--notifiedPidCount];
+                        notify = 1;
+                        break;
+                    }
+                }
+            }
+
+            // Le minishell est prevenu comme pour ses propres processus fils
+            if( notify ) kill( getppid(), SIGCHLD );
+        }
+    }
+}
+
+
+static void spawnCmd( int sock, char* request, const int fds[3] )
+{
+    // Decodage de la demande
+    SpawnRequest header;
+    memcpy( &header, request, sizeof( header ) );
+    char* p = request + sizeof( header );
+    const char* cwd = p;
+    p += strlen( p ) + 1;
+    char** argv = (char**)malloc( ( header.argc + 1 ) * sizeof( char* ) );
+    char** envp = (char**)malloc( ( header.envc + 1 ) * sizeof( char* ) );
+    if( argv == NULL || envp == NULL )
+    {
+        // Echec signale au minishell comme un echec de creation du processus
+        free( argv );
+        free( envp );
+        const int32_t pid = -1;
+        sendFrame( sock, ZYGOTE_PID, &pid, sizeof( pid ), NULL, 0 );
+        return;
+    }
+    for( uint32_t i = 0; i < header.argc; ++i, p += strlen( p ) + 1 ) argv[i] = p;
+    for( uint32_t i = 0; i < header.envc; ++i, p += strlen( p ) + 1 ) envp[i] = p;
+    argv[header.argc] = NULL;
+    envp[header.envc] = NULL;
+
+    // Creation du processus d'execution
+    const int32_t pid = fork();
+    if( pid == 0 )
+    {
+        // Retour au masque de signaux par defaut
+        sigset_t mask;
+        sigemptyset( &mask );
+        sigprocmask( SIG_SETMASK, &mask, NULL );
+
+        // Redirection des entree/sortie/erreur
+        for( int i = 0; i < 3; ++i ) dup2( fds[i], i );
+
+        // Repertoire courant, environnement et placement du minishell
+        if( chdir( cwd ) == -1 ) perror( "ERREUR - chdir" );
+        environ = envp;
+        if( header.pipeStage >= 0 ) pinPipeStage( header.pipeStage );
+
+        // Execution du binaire de la commande
+        execvp( argv[0], argv );
+        fprintf( stderr, "ERREUR - Echec d'execution de la commande %s\n", argv[0] );
+        reportExecFailure();
+        _exit( CMD_EXEC_FAILED );
+    }
+
+    free( argv );
+    free( envp );
+
+    // Memorisation des processus dont la terminaison doit etre signalee
+    if( pid > 0 && header.notify && notifiedPidCount < MAX_ZYGOTE_CHILDREN ) notifiedPids[notifiedPidCount++] = pid;
+
+    // Envoi du PID au minishell
+    sendFrame( sock, ZYGOTE_PID, &pid, sizeof( pid ), NULL, 0 );
+}
+
+
+static int readZygoteFrame( pid_t* spawnedPid )
+{
+    // Reception de la trame
+    FrameHeader header;
+    char data[sizeof( SpawnExit )];
+    int fds[MAX_FRAME_FDS];
+    int fdCount = 0;
+    if( recvFrame( zygoteSock, &header, data, sizeof( data ), fds, &fdCount ) != FRAME_OK )
+    {
+        return( ZYGOTE_IO_FAILED );
+    }
+
+    // PID d'un processus cree
+    if( header.type == ZYGOTE_PID && spawnedPid != NULL )
+    {
+        int32_t pid = -1;
+        memcpy( &pid, data, sizeof( pid ) );
+        *spawnedPid = pid;
+    }
+
+    // Terminaison d'un processus
+    else if( header.type == ZYGOTE_EXIT )
+    {
+        SpawnExit spawnExit;
+        memcpy( &spawnExit, data, sizeof( spawnExit ) );
+        const int index = findZygoteChild( spawnExit.pid );
+        if( index != -1 )
+        {
+            zygoteChildren[index].exited = 1;
+            zygoteChildren[index].status = spawnExit.status;
+        }
+    }
+
+    return( ZYGOTE_OK );
+}
+
+
+static int findZygoteChild( pid_t pid )
+{
+    for( int i = 0; i < zygoteChildCount; ++i )
+    {
+        if( zygoteChildren[i].pid == pid ) return( i );
+    }
+
+    return( -1 );
+}
+
+
+static void removeZygoteChild( int index )
+{
+    // Le dernier processus de la table prend la place du processus retire
+    zygoteChildren[index] = zygoteChildren[--zygoteChildCount];
+}
+
+
+static size_t getSpawnRequestLength( char* const argv[], SpawnRequest* header )
+{
+    // Entete, puis arguments et variables d'environnement (avec leur '\0')
+    size_t length = sizeof( SpawnRequest );
+    for( header->argc = 0; argv[header->argc] != NULL; ++header->argc ) length += strlen( argv[header->argc] ) + 1;
+    for( header->envc = 0; environ[header->envc] != NULL; ++header->envc ) length += strlen( environ[header->envc] ) + 1;
+
+    return( length );
+}
@@ -0,0 +1,144 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Zygote : processus auxiliaire cree au demarrage du minishell (avant que sa memoire ne grossisse), et qui
+ *  cree a sa place les processus d'execution des commandes externes. Un fork() depuis ce petit processus
+ *  coute moins cher qu'un fork() depuis le minishell.
+ *
+ *  Le minishell et le zygote communiquent par trames (voir frame.h) sur une paire de sockets :
+ *  - ZYGOTE_SPAWN (minishell -> zygote) : demande de lancement d'une commande. Les donnees contiennent une
+ *    structure SpawnRequest suivie du repertoire courant, des arguments et des variables d'environnement
+ *    (chaines terminees par '\0'). Les entree, sortie et erreur standards sont jointes via SCM_RIGHTS.
+ *  - ZYGOTE_PID (zygote -> minishell) : PID du processus cree (ou -1 en cas d'echec du fork).
+ *  - ZYGOTE_EXIT (zygote -> minishell) : terminaison d'un processus (structure SpawnExit). Pour les commandes
+ *    en background, le zygote envoie egalement un signal SIGCHLD au minishell, pour qu'elles soient traitees
+ *    comme les processus fils directs.
+ */
+
+#ifndef _ZYGOTE_H_
+#define _ZYGOTE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+
+// Codes d'erreur
+enum ZygoteError
+{
+    ZYGOTE_OK = 0,              // Pas d'erreur
+    ZYGOTE_START_FAILED = 80,   // Impossible de creer le zygote
+    ZYGOTE_IO_FAILED            // Erreur de communication avec le zygote
+};
+
+// Types de trames echangees avec le zygote
+enum ZygoteFrameType
+{
+    ZYGOTE_SPAWN = 1,           // Demande de lancement d'une commande
+    ZYGOTE_PID,                 // PID du processus cree
+    ZYGOTE_EXIT                 // Terminaison d'un processus
+};
+
+/*
+ * Entete d'une demande de lancement de commande
+ *
+ * pipeStage : index de la commande dans son pipeline (pour la repartition sur les coeurs), ou -1
+ * notify : flag indiquant si le minishell doit recevoir SIGCHLD a la terminaison (commande en background)
+ * argc : nombre d'arguments
+ * envc : nombre de variables d'environnement
+ */
+typedef struct
+{
+    int32_t pipeStage;
+    int32_t notify;
+    uint32_t argc;
+    uint32_t envc;
+} SpawnRequest;
+
+/*
+ * Terminaison d'un processus cree par le zygote
+ *
+ * pid : PID du processus
+ * status : code de terminaison (au format de waitpid())
+ */
+typedef struct
+{
+    int32_t pid;
+    int32_t status;
+} SpawnExit;
+
+
+/*
+ * Cree le zygote. Cette fonction doit etre appelee le plus tot possible, pour que le zygote herite d'un
+ * espace memoire reduit.
+ *
+ * retourne 0 en cas de succes, sinon un code d'erreur
+ */
+int startZygote( void );
+
+/*
+ * Teste si le zygote est actif
+ *
+ * retourne 1 si le zygote est actif, sinon 0
+ */
+int isZygoteActive( void );
+
+/*
+ * Dans un processus fils du minishell qui lance lui-meme des commandes (groupe de commandes), renonce a
+ * l'utilisation du zygote, qui reste a la disposition du minishell
+ */
+void detachZygote( void );
+
+/*
+ * Teste si le zygote peut lancer une commande (zygote actif, table des processus non pleine, et demande de
+ * lancement pas trop longue)
+ *
+ * argv : arguments de la commande (termines par NULL)
+ * retourne 1 si la commande peut etre lancee par le zygote, sinon 0
+ */
+int zygoteCanSpawn( char* const argv[] );
+
+/*
+ * Demande au zygote de lancer une commande externe
+ *
+ * argv : arguments de la commande (termines par NULL)
+ * stdFds : descripteurs des entree, sortie et erreur standards de la commande
+ * pipeStage : index de la commande dans son pipeline, ou -1
+ * notify : si vrai, le minishell recoit SIGCHLD a la terminaison du processus
+ * retourne le PID du processus cree, ou -1 en cas d'erreur
+ */
+pid_t zygoteSpawn( char* const argv[], const int stdFds[3], int pipeStage, int notify );
+
+/*
+ * Teste si un processus a ete cree par le zygote (et n'a pas encore ete attendu)
+ *
+ * pid : PID du processus
+ * retourne 1 si le processus a ete cree par le zygote, sinon 0
+ */
+int isZygoteChild( pid_t pid );
+
+/*
+ * Se synchronise avec la terminaison d'un processus cree par le zygote (equivalent de waitpid())
+ *
+ * pid : PID du processus
+ * status : en sortie, code de terminaison du processus
+ * retourne le PID du processus, ou -1 en cas d'erreur
+ */
+pid_t zygoteWait( pid_t pid, int* status );
+
+/*
+ * Recupere, sans attente, la terminaison d'un processus cree par le zygote (equivalent de
+ * waitpid( -1, status, WNOHANG ))
+ *
+ * status : en sortie, code de terminaison du processus
+ * retourne le PID d'un processus termine, ou 0 si aucun processus n'est termine
+ */
+pid_t zygoteReap( int* status );
+
+
+#endif // _ZYGOTE_H_
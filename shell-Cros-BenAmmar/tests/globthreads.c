@@ -0,0 +1,184 @@
+/*
+ *  Projet minishell - Licence 3 Info - PSI 2023
+ *
+ *  Nom :               CROS		BEN AMMAR
+ *  Prénom :            Bryan		Nader
+ *  Num. étudiant :     22110106	22101740
+ *  Groupe de projet :  Groupe 1
+ *  Date :              30/10/2023
+ *
+ *  Dependances : libminishell.h
+ *
+ *  Test de l'expansion des motifs de noms de fichiers dans plusieurs threads : chaque thread analyse et execute
+ *  en boucle (avec libminishell) un 'echo' du motif de tous les fichiers de son propre repertoire, et verifie la
+ *  liste des fichiers affichee. Les repertoires sont crees (puis supprimes) dans un repertoire temporaire.
+ *
+ *  Usage : test-globthreads
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "libminishell.h"
+
+
+// Nombre de threads (un repertoire par thread), de fichiers par repertoire, et d'executions par thread
+#define THREAD_COUNT    4
+#define FILE_COUNT      200
+#define RUN_COUNT       50
+
+// Taille max de la sortie d'une execution
+#define OUTPUT_SIZE     32768
+
+// Codes d'erreur
+enum GlobthreadsError
+{
+    GLOBTHREADS_OK = 0,         // Pas d'erreur
+    GLOBTHREADS_SETUP_ERROR = 1,// Creation des repertoires impossible
+    GLOBTHREADS_MISMATCH        // Liste de fichiers incorrecte
+};
+
+// Repertoire d'un thread, sortie attendue, et nombre d'executions incorrectes
+typedef struct
+{
+    char dir[256];
+    char expected[OUTPUT_SIZE];
+    int failures;
+} GlobThread;
+
+
+/*
+ * Execute une ligne de commande avec libminishell, et recupere sa sortie standard
+ *
+ * cmdLine : la ligne de commande
+ * output : en sortie, la sortie standard de la ligne (au plus OUTPUT_SIZE - 1 caracteres)
+ * retourne 0 en cas de succes, sinon -1
+ */
+static int runLine( const char* cmdLine, char* output )
+{
+    // La sortie est recueillie dans un pipe (assez grand pour la sortie complete)
+    int pipeFd[2];
+    if( pipe( pipeFd ) == -1 ) return( -1 );
+    fcntl( pipeFd[1], F_SETPIPE_SZ, OUTPUT_SIZE );
+
+    // Analyse et execution
+    MinishellPlan* plan = NULL;
+    int status = -1;
+    int error = minishellParse( cmdLine, &plan );
+    if( error == MINISHELL_OK )
+    {
+        const MinishellIo io = { -1, pipeFd[1], -1, NULL };
+        error = minishellRun( plan, &io, &status );
+    }
+    minishellFreePlan( plan );
+    close( pipeFd[1] );
+
+    // Lecture de la sortie
+    size_t length = 0;
+    ssize_t count = 0;
+    while( length < OUTPUT_SIZE - 1 && ( count = read( pipeFd[0], output + length, OUTPUT_SIZE - 1 - length ) ) > 0 )
+    {
+        length += count;
+    }
+    output[length] = '\0';
+    close( pipeFd[0] );
+
+    return( error == MINISHELL_OK && status == 0 ? 0 : -1 );
+}
+
+
+/*
+ * Thread de test : execute RUN_COUNT fois l'echo du motif de son repertoire, et compte les sorties incorrectes
+ */
+static void* runGlobThread( void* arg )
+{
+    GlobThread* thread = (GlobThread*)arg;
+    char cmdLine[512];
+    snprintf( cmdLine, sizeof( cmdLine ), "echo %s/*", thread->dir );
+
+    char* output = (char*)malloc( OUTPUT_SIZE );
+    for( int i = 0; output != NULL && i < RUN_COUNT; ++i )
+    {
+        if( runLine( cmdLine, output ) != 0 || strcmp( output, thread->expected ) != 0 ) ++thread->failures;
+    }
+    if( output == NULL ) thread->failures = RUN_COUNT;
+    free( output );
+
+    return( NULL );
+}
+
+
+/*
+ * Fonction principale du programme
+ */
+int main( void )
+{
+    // Repertoire temporaire
+    char root[] = "/tmp/minishell-globthreads-XXXXXX";
+    if( mkdtemp( root ) == NULL ) return( GLOBTHREADS_SETUP_ERROR );
+
+    // Un repertoire par thread, et la sortie attendue de l'echo du motif (noms dans l'ordre alphabetique)
+    static GlobThread threads[THREAD_COUNT];
+    int status = GLOBTHREADS_OK;
+    for( int t = 0; t < THREAD_COUNT && status == GLOBTHREADS_OK; ++t )
+    {
+        GlobThread* thread = threads + t;
+        snprintf( thread->dir, sizeof( thread->dir ), "%s/d%d", root, t );
+        if( mkdir( thread->dir, 0700 ) == -1 ) status = GLOBTHREADS_SETUP_ERROR;
+        size_t length = 0;
+        for( int f = 0; f < FILE_COUNT && status == GLOBTHREADS_OK; ++f )
+        {
+            char path[512];
+            snprintf( path, sizeof( path ), "%s/t%d_file_%03d", thread->dir, t, f );
+            const int fd = open( path, O_WRONLY | O_CREAT | O_EXCL, 0600 );
+            if( fd == -1 ) status = GLOBTHREADS_SETUP_ERROR;
+            else close( fd );
+            length += snprintf( thread->expected + length, OUTPUT_SIZE - length, "%s%s", f > 0 ? " " : "", path );
+        }
+        snprintf( thread->expected + length, OUTPUT_SIZE - length, "\n" );
+    }
+
+    // Executions en parallele
+    pthread_t ids[THREAD_COUNT];
+    int started = 0;
+    for( ; status == GLOBTHREADS_OK && started < THREAD_COUNT; ++started )
+    {
+        if( pthread_create( ids + started, NULL, runGlobThread, threads + started ) != 0 ) break;
+    }
+    int failures = 0;
+    for( int t = 0; t < started; ++t )
+    {
+        pthread_join( ids[t], NULL );
+        failures += threads[t].failures;
+    }
+    if( status == GLOBTHREADS_OK && started < THREAD_COUNT ) status = GLOBTHREADS_SETUP_ERROR;
+
+    // Suppression des fichiers et repertoires
+    for( int t = 0; t < THREAD_COUNT; ++t )
+    {
+        for( int f = 0; f < FILE_COUNT; ++f )
+        {
+            char path[512];
+            snprintf( path, sizeof( path ), "%s/t%d_file_%03d", threads[t].dir, t, f );
+            unlink( path );
+        }
+        rmdir( threads[t].dir );
+    }
+    rmdir( root );
+
+    // Bilan
+    if( status != GLOBTHREADS_OK )
+    {
+        fprintf( stderr, "ERREUR - Creation des repertoires de test impossible\n" );
+        return( status );
+    }
+    printf( "globthreads : %d executions incorrectes sur %d\n", failures, THREAD_COUNT * RUN_COUNT );
+    return( failures == 0 ? GLOBTHREADS_OK : GLOBTHREADS_MISMATCH );
+}
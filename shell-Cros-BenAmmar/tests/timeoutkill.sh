@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+#  Projet minishell - Licence 3 Info - PSI 2023
+#
+#  Nom :               CROS		BEN AMMAR
+#  Prénom :            Bryan		Nader
+#  Num. étudiant :     22110106	22101740
+#  Groupe de projet :  Groupe 1
+#  Date :              30/10/2023
+#
+#  Test de l'escalade du builtin 'timeout' : un processus qui ignore SIGTERM doit etre tue par SIGKILL apres le
+#  second delai (-k), et non rester en vie jusqu'a sa fin.
+#
+#  Usage : tests/timeoutkill.sh [MINISHELL]
+#
+
+minishell=${1:-./minishell}
+
+# Script temporaire qui ignore SIGTERM et dort 5 secondes
+script=$(mktemp /tmp/minishell-timeoutkill-XXXXXX) || exit 1
+trap 'rm -f "$script"' EXIT
+printf '#!/bin/sh\ntrap "" TERM\nsleep 5\n' > "$script"
+chmod +x "$script"
+
+# Execution avec 0.2 seconde de delai puis 0.2 seconde avant SIGKILL (duree mesuree en secondes entieres)
+start=$(date +%s)
+printf 'timeout 0.2 -k 0.2 %s\n' "$script" | "$minishell" > /dev/null 2>&1
+elapsed=$(( $(date +%s) - start ))
+
+# Le processus doit avoir ete tue bien avant la fin de son sommeil
+if [ "$elapsed" -ge 3 ]
+then
+    echo "ECHEC - timeout -k : le processus a survecu ${elapsed} secondes" >&2
+    exit 1
+fi
+echo "OK - timeout -k : processus tue en moins de 3 secondes"